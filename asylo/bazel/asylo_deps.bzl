@@ -96,6 +96,16 @@ cc_library(
             strip_prefix = "gflags-2.2.1",
         )
 
+    # Google Benchmark. Used by the benchmark suite.
+    if "com_github_google_benchmark" not in native.existing_rules():
+        native.http_archive(
+            name = "com_github_google_benchmark",
+            # Release v1.4.1
+            urls = ["https://github.com/google/benchmark/archive/v1.4.1.tar.gz"],
+            sha256 = "f8e525db3c42efc9c7f3bc5176a8fa893a9a9920bbd08cef30fb56a51854d60d",
+            strip_prefix = "benchmark-1.4.1",
+        )
+
 def asylo_deps():
     """Macro to include Asylo's critical dependencies in a WORKSPACE."""
 
@@ -18,8 +18,10 @@
 
 #include "asylo/crypto/aes_gcm_siv.h"
 
+#include <openssl/mem.h>
 #include <openssl/rand.h>
 #include <string>
+#include <utility>
 
 #include "absl/strings/str_cat.h"
 #include "asylo/crypto/util/bssl_util.h"
@@ -37,4 +39,117 @@ Status AesGcmSivNonceGenerator::NextNonce(
   return Status::OkStatus();
 }
 
+StatusOr<std::unique_ptr<AesGcmSivKeyedCryptor>> AesGcmSivKeyedCryptor::Create(
+    ByteContainerView key, size_t message_size_limit,
+    NonceGenerator<kAesGcmSivNonceSize> *nonce_generator) {
+  // Take ownership of |nonce_generator| before any early returns.
+  std::unique_ptr<AesGcmSivKeyedCryptor> cryptor(
+      new AesGcmSivKeyedCryptor(message_size_limit, nonce_generator));
+
+  EVP_AEAD const *&aead = cryptor->aead_;
+  if (key.size() == EVP_AEAD_key_length(EVP_aead_aes_128_gcm_siv())) {
+    aead = EVP_aead_aes_128_gcm_siv();
+  } else if (key.size() == EVP_AEAD_key_length(EVP_aead_aes_256_gcm_siv())) {
+    aead = EVP_aead_aes_256_gcm_siv();
+  } else {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  absl::StrCat("Key size ", key.size(), " is invalid"));
+  }
+
+  if (cryptor->nonce_generator_->nonce_size() != EVP_AEAD_nonce_length(aead)) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "NonceGenerator produces nonces of incorrect length");
+  }
+
+  if (EVP_AEAD_CTX_init(&cryptor->context_, aead, key.data(), key.size(),
+                        EVP_AEAD_max_tag_len(aead), nullptr) != 1) {
+    return Status(
+        error::GoogleError::INTERNAL,
+        absl::StrCat("EVP_AEAD_CTX_init failed: ", BsslLastErrorString()));
+  }
+  cryptor->context_initialized_ = true;
+
+  if (cryptor->nonce_generator_->uses_key_id()) {
+    SHA256(key.data(), key.size(), cryptor->key_id_.data());
+  }
+  return std::move(cryptor);
+}
+
+AesGcmSivKeyedCryptor::AesGcmSivKeyedCryptor(
+    size_t message_size_limit,
+    NonceGenerator<kAesGcmSivNonceSize> *nonce_generator)
+    : message_size_limit_{message_size_limit},
+      nonce_generator_{nonce_generator},
+      key_id_(SHA256_DIGEST_LENGTH) {}
+
+AesGcmSivKeyedCryptor::~AesGcmSivKeyedCryptor() {
+  if (context_initialized_) {
+    // EVP_AEAD_CTX_cleanup() frees and cleanses the expanded key.
+    EVP_AEAD_CTX_cleanup(&context_);
+  }
+  OPENSSL_cleanse(key_id_.data(), key_id_.size());
+}
+
+Status AesGcmSivKeyedCryptor::Seal(ByteContainerView additional_data,
+                                   ByteContainerView plaintext,
+                                   std::string *nonce,
+                                   std::string *ciphertext) const {
+  if (additional_data.size() + plaintext.size() > message_size_limit_) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "Message size is too large");
+  }
+
+  UnsafeBytes<kAesGcmSivNonceSize> nonce_copy;
+  Status status = nonce_generator_->NextNonce(key_id_, &nonce_copy);
+  if (!status.ok()) {
+    return status;
+  }
+  nonce->assign(reinterpret_cast<const char *>(nonce_copy.data()),
+                nonce_copy.size());
+
+  ciphertext->resize(plaintext.size() +
+                     EVP_AEAD_max_overhead(aead_));
+  size_t ciphertext_length = 0;
+  if (EVP_AEAD_CTX_seal(&context_,
+                        reinterpret_cast<uint8_t *>(&ciphertext->front()),
+                        &ciphertext_length, ciphertext->size(),
+                        nonce_copy.data(), nonce_copy.size(), plaintext.data(),
+                        plaintext.size(), additional_data.data(),
+                        additional_data.size()) != 1) {
+    return Status(
+        error::GoogleError::INTERNAL,
+        absl::StrCat("EVP_AEAD_CTX_seal failed: ", BsslLastErrorString()));
+  }
+  ciphertext->resize(ciphertext_length);
+  return Status::OkStatus();
+}
+
+Status AesGcmSivKeyedCryptor::Open(ByteContainerView additional_data,
+                                   ByteContainerView ciphertext,
+                                   ByteContainerView nonce,
+                                   CleansingVector<uint8_t> *plaintext) const {
+  if (nonce.size() != kAesGcmSivNonceSize) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "|nonce| has incorrect length");
+  }
+
+  // Copy the supplied nonce so that it cannot change while it is being used.
+  UnsafeBytes<kAesGcmSivNonceSize> nonce_copy(nonce.data(), nonce.size());
+
+  plaintext->resize(ciphertext.size());
+  size_t plaintext_length = 0;
+  if (EVP_AEAD_CTX_open(&context_, plaintext->data(), &plaintext_length,
+                        plaintext->size(), nonce_copy.data(),
+                        nonce_copy.size(), ciphertext.data(),
+                        ciphertext.size(), additional_data.data(),
+                        additional_data.size()) != 1) {
+    plaintext->clear();
+    return Status(
+        error::GoogleError::INTERNAL,
+        absl::StrCat("EVP_AEAD_CTX_open failed: ", BsslLastErrorString()));
+  }
+  plaintext->resize(plaintext_length);
+  return Status::OkStatus();
+}
+
 }  // namespace asylo
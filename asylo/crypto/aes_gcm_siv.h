@@ -26,6 +26,7 @@
 
 #include "absl/strings/str_cat.h"
 #include "asylo/crypto/nonce_generator.h"
+#include "asylo/crypto/util/byte_container_view.h"
 #include "asylo/crypto/util/bssl_util.h"
 #include "asylo/crypto/util/bytes.h"
 #include "asylo/util/logging.h"
@@ -344,6 +345,83 @@ class AesGcmSivCryptor {
   std::unique_ptr<NonceGenerator<kAesGcmSivNonceSize>> nonce_generator_;
 };
 
+/// An AES GCM SIV cryptor that is bound to a single key. Unlike
+/// AesGcmSivCryptor, which initializes and tears down an AEAD context on every
+/// call, AesGcmSivKeyedCryptor expands its key once at construction and reuses
+/// the resulting context for every Seal() and Open() operation. It is intended
+/// for callers that repeatedly seal or open data with the same key.
+///
+/// The key schedule held by an AesGcmSivKeyedCryptor is cleansed when the
+/// object is destroyed. If the NonceGenerator passed to Create() is
+/// thread-safe, then the constructed object is also thread-safe.
+class AesGcmSivKeyedCryptor {
+ public:
+  /// Creates an AesGcmSivKeyedCryptor that uses `key`, enforces the input
+  /// `message_size_limit`, and utilizes `nonce_generator` to generate nonces.
+  ///
+  /// \param key The 128-bit or 256-bit key used by the cryptor.
+  /// \param message_size_limit Maximum message size supported by this cryptor.
+  /// \param nonce_generator A NonceGenerator that is used by the cryptor for
+  ///        generating nonces. The cryptor takes ownership of
+  ///        `nonce_generator`.
+  /// \return The created cryptor, or a non-OK Status if `key` has an invalid
+  ///         size or the cryptor could not be initialized.
+  static StatusOr<std::unique_ptr<AesGcmSivKeyedCryptor>> Create(
+      ByteContainerView key, size_t message_size_limit,
+      NonceGenerator<kAesGcmSivNonceSize> *nonce_generator);
+
+  AesGcmSivKeyedCryptor(const AesGcmSivKeyedCryptor &other) = delete;
+  AesGcmSivKeyedCryptor &operator=(const AesGcmSivKeyedCryptor &other) = delete;
+
+  ~AesGcmSivKeyedCryptor();
+
+  /// Implements AEAD Authenticated Encryption (a.k.a.\ seal) functionality
+  /// with the key this cryptor was created with.
+  ///
+  /// \param additional_data Authenticated data for the seal operation.
+  /// \param plaintext The plaintext to be encrypted.
+  /// \param[out] nonce Nonce used in this sealing operation.
+  /// \param[out] ciphertext The ciphertext generated by the
+  ///             authenticated-encryption operation. The ciphertext is written
+  ///             directly into `ciphertext`, reusing its existing capacity.
+  /// \return A non-OK Status if an error is encountered.
+  Status Seal(ByteContainerView additional_data, ByteContainerView plaintext,
+              std::string *nonce, std::string *ciphertext) const;
+
+  /// Implements AEAD Authenticated Decryption (a.k.a.\ open) functionality
+  /// with the key this cryptor was created with.
+  ///
+  /// \param additional_data Authenticated data for the open operation.
+  /// \param ciphertext The ciphertext to be decrypted.
+  /// \param nonce Nonce used in this open operation.
+  /// \param[out] plaintext The plaintext generated by the
+  ///             authenticated-decryption operation.
+  /// \return A non-OK Status if an error is encountered.
+  Status Open(ByteContainerView additional_data, ByteContainerView ciphertext,
+              ByteContainerView nonce,
+              CleansingVector<uint8_t> *plaintext) const;
+
+ private:
+  AesGcmSivKeyedCryptor(size_t message_size_limit,
+                        NonceGenerator<kAesGcmSivNonceSize> *nonce_generator);
+
+  const size_t message_size_limit_;
+  std::unique_ptr<NonceGenerator<kAesGcmSivNonceSize>> nonce_generator_;
+
+  // The SHA-256 digest of the key, passed to |nonce_generator_| if it uses key
+  // ids. Empty (all zeros) otherwise.
+  std::vector<uint8_t> key_id_;
+
+  // The AEAD algorithm selected by the key size.
+  EVP_AEAD const *aead_ = nullptr;
+
+  // The AEAD context holding the expanded key. EVP_AEAD_CTX_seal() and
+  // EVP_AEAD_CTX_open() do not modify the context, so it can be shared by
+  // concurrent callers.
+  EVP_AEAD_CTX context_;
+  bool context_initialized_ = false;
+};
+
 }  // namespace asylo
 
 #endif  // ASYLO_CRYPTO_AES_GCM_SIV_H_
@@ -18,6 +18,7 @@
 
 #include "asylo/crypto/aes_gcm_siv.h"
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -25,6 +26,7 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/strings/escaping.h"
+#include "asylo/util/cleansing_types.h"
 #include "asylo/crypto/nonce_generator.h"
 #include "asylo/crypto/util/byte_container_view.h"
 #include "asylo/crypto/util/bytes.h"
@@ -35,6 +37,8 @@
 namespace asylo {
 namespace {
 
+using ::testing::Not;
+
 // Test vector with a 128-bit key from the AES GCM SIV spec
 // (https://tools.ietf.org/html/draft-irtf-cfrg-gcmsiv-05).
 const char plaintext1_hex[] =
@@ -207,5 +211,108 @@ TYPED_TEST(TypedAesGcmSivTest, KeySize256) {
       std::equal(plaintext.cbegin(), plaintext.cend(), decrypted.cbegin()));
 }
 
+// Verifies that AesGcmSivKeyedCryptor produces the same output as
+// AesGcmSivCryptor for the AES GCM SIV spec test vectors.
+TEST(AesGcmSivTest, KeyedCryptorTestVectors) {
+  auto key1 = InstantiateSafeBytes<sizeof(key1_hex)>(key1_hex);
+  auto plaintext1 =
+      InstantiateSafeBytes<sizeof(plaintext1_hex)>(plaintext1_hex);
+  auto aad1 = absl::HexStringToBytes(aad1_hex);
+  auto nonce1 = absl::HexStringToBytes(nonce1_hex);
+  auto ciphertext1 = absl::HexStringToBytes(ciphertext1_hex);
+
+  auto cryptor_result = AesGcmSivKeyedCryptor::Create(
+      key1, kMessageSizeLimit, new FixedNonceGenerator(nonce1));
+  ASSERT_THAT(cryptor_result, IsOk());
+  std::unique_ptr<AesGcmSivKeyedCryptor> cryptor =
+      std::move(cryptor_result).ValueOrDie();
+
+  std::string tmp_nonce1;
+  std::string tmp_ciphertext1;
+  ASSERT_THAT(cryptor->Seal(aad1, plaintext1, &tmp_nonce1, &tmp_ciphertext1),
+              IsOk());
+  EXPECT_EQ(nonce1, tmp_nonce1);
+  EXPECT_EQ(ciphertext1, tmp_ciphertext1);
+
+  CleansingVector<uint8_t> tmp_plaintext1;
+  ASSERT_THAT(cryptor->Open(aad1, ciphertext1, nonce1, &tmp_plaintext1),
+              IsOk());
+  EXPECT_EQ(ByteContainerView(plaintext1), ByteContainerView(tmp_plaintext1));
+
+  auto key2 = InstantiateSafeBytes<sizeof(key2_hex)>(key2_hex);
+  auto plaintext2 =
+      InstantiateSafeBytes<sizeof(plaintext2_hex)>(plaintext2_hex);
+  auto aad2 = absl::HexStringToBytes(aad2_hex);
+  auto nonce2 = absl::HexStringToBytes(nonce2_hex);
+  auto ciphertext2 = absl::HexStringToBytes(ciphertext2_hex);
+
+  cryptor_result = AesGcmSivKeyedCryptor::Create(
+      key2, kMessageSizeLimit, new FixedNonceGenerator(nonce2));
+  ASSERT_THAT(cryptor_result, IsOk());
+  cryptor = std::move(cryptor_result).ValueOrDie();
+
+  std::string tmp_nonce2;
+  std::string tmp_ciphertext2;
+  ASSERT_THAT(cryptor->Seal(aad2, plaintext2, &tmp_nonce2, &tmp_ciphertext2),
+              IsOk());
+  EXPECT_EQ(nonce2, tmp_nonce2);
+  EXPECT_EQ(ciphertext2, tmp_ciphertext2);
+
+  CleansingVector<uint8_t> tmp_plaintext2;
+  ASSERT_THAT(cryptor->Open(aad2, ciphertext2, nonce2, &tmp_plaintext2),
+              IsOk());
+  EXPECT_EQ(ByteContainerView(plaintext2), ByteContainerView(tmp_plaintext2));
+}
+
+// Verifies that a single AesGcmSivKeyedCryptor can seal and open many messages,
+// and that it rejects tampered ciphertexts.
+TEST(AesGcmSivTest, KeyedCryptorReusesKey) {
+  constexpr int kNumMessages = 16;
+
+  std::string key(32, 'k');
+  auto cryptor_result = AesGcmSivKeyedCryptor::Create(
+      key, kMessageSizeLimit, new AesGcmSivNonceGenerator());
+  ASSERT_THAT(cryptor_result, IsOk());
+  std::unique_ptr<AesGcmSivKeyedCryptor> cryptor =
+      std::move(cryptor_result).ValueOrDie();
+
+  std::string aad(kAdditionalDataSize, 'a');
+  std::string nonce;
+  std::string ciphertext;
+  CleansingVector<uint8_t> decrypted;
+  for (int i = 0; i < kNumMessages; ++i) {
+    std::string plaintext(kPlaintextSize * i, static_cast<char>(i));
+    ASSERT_THAT(cryptor->Seal(aad, plaintext, &nonce, &ciphertext), IsOk());
+    ASSERT_EQ(ciphertext.size(), plaintext.size() + 16);
+
+    ASSERT_THAT(cryptor->Open(aad, ciphertext, nonce, &decrypted), IsOk());
+    EXPECT_EQ(ByteContainerView(plaintext), ByteContainerView(decrypted));
+
+    ciphertext[0] ^= 1;
+    EXPECT_THAT(cryptor->Open(aad, ciphertext, nonce, &decrypted),
+                Not(IsOk()));
+  }
+}
+
+// Verifies that AesGcmSivKeyedCryptor enforces the key size and message size
+// limits.
+TEST(AesGcmSivTest, KeyedCryptorEnforcesLimits) {
+  EXPECT_THAT(AesGcmSivKeyedCryptor::Create(std::string(24, 'k'),
+                                            kMessageSizeLimit,
+                                            new AesGcmSivNonceGenerator()),
+              Not(IsOk()));
+
+  auto cryptor_result = AesGcmSivKeyedCryptor::Create(
+      std::string(16, 'k'), kMessageSizeLimit, new AesGcmSivNonceGenerator());
+  ASSERT_THAT(cryptor_result, IsOk());
+
+  std::string plaintext(kMessageSizeLimit + 1, 'p');
+  std::string nonce;
+  std::string ciphertext;
+  EXPECT_THAT(
+      cryptor_result.ValueOrDie()->Seal("", plaintext, &nonce, &ciphertext),
+      Not(IsOk()));
+}
+
 }  // namespace
 }  // namespace asylo
@@ -371,9 +371,7 @@ Status EkepHandshaker::GetTranscriptHash(std::string *transcript_hash) {
 void EkepHandshaker::UpdateTranscriptWithOutgoingBytes(
     const char *outgoing_bytes, int outgoing_bytes_size) {
   if (outgoing_bytes_size > 0) {
-    google::protobuf::io::ArrayInputStream sent_bytes(outgoing_bytes,
-                                            outgoing_bytes_size);
-    transcript_.Add(&sent_bytes);
+    transcript_.Add(outgoing_bytes, outgoing_bytes_size);
   }
 }
 
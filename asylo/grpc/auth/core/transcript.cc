@@ -38,7 +38,10 @@ bool Transcript::SetHasher(HashInterface *hasher) {
   hasher_.reset(hasher);
   hasher_->Init();
   hasher_->Update(bytes_to_hash_.data(), bytes_to_hash_.size());
-  bytes_to_hash_.clear();
+
+  // The buffer is never used again once the hash function is set, so release
+  // its storage rather than just clearing it.
+  std::string().swap(bytes_to_hash_);
   return true;
 }
 
@@ -36,7 +36,9 @@ namespace asylo {
 // necessary to save these earlier frames in their raw form until the
 // ciphersuite has been determined. This class provides the functionality
 // necessary for caching earlier frames and delaying the hashing operation until
-// a hashing function is set.
+// a hashing function is set. Once the hash function is set, all further bytes
+// are passed directly to the hash function without being copied, and the
+// internal cache of earlier frames is released.
 //
 // A Transcript can be updated via the Add method. The hash of the current
 // transcript can be retrieved through a call to Hash. Before calling Hash, it
@@ -53,6 +55,9 @@ class Transcript {
   // Adds the entire contents of |input| to the transcript hash.
   void Add(google::protobuf::io::ZeroCopyInputStream *input);
 
+  // Adds |len| bytes from |data| to the transcript hash.
+  void Add(const void *data, size_t len);
+
   // Sets |hasher| as the hash function to use for hashing the transcript.
   // Returns false if a hash function has already been set. Takes ownership of
   // |hasher|.
@@ -64,9 +69,6 @@ class Transcript {
   bool Hash(std::string *digest);
 
  private:
-  // Adds |len| bytes from |data| to the transcript hash.
-  void Add(const void *data, size_t len);
-
   // An internal buffer of bytes to hash. Once |hasher_| is set, all bytes from
   // this buffer are added to the hashing object and the buffer is cleared.
   std::string bytes_to_hash_;
@@ -147,6 +147,28 @@ TYPED_TEST(TranscriptTest, AddBytesAndHash) {
   EXPECT_EQ(running_hash2, running_hash3);
 }
 
+// Verify that adding raw bytes produces the same hash as adding the same bytes
+// through an input stream, both before and after the hash function is set.
+TYPED_TEST(TranscriptTest, AddRawBytesSameAsStream) {
+  Transcript transcript1;
+  Transcript transcript2;
+
+  AddFromString(kData1, &transcript1);
+  EXPECT_TRUE(transcript1.SetHasher(new TypeParam()));
+  AddFromString(kData2, &transcript1);
+
+  transcript2.Add(kData1, strlen(kData1));
+  EXPECT_TRUE(transcript2.SetHasher(new TypeParam()));
+  transcript2.Add(kData2, strlen(kData2));
+
+  std::string running_hash1;
+  std::string running_hash2;
+  ASSERT_TRUE(transcript1.Hash(&running_hash1));
+  ASSERT_TRUE(transcript2.Hash(&running_hash2));
+
+  EXPECT_EQ(running_hash1, running_hash2);
+}
+
 }  // namespace
 }  // namespace auth
 }  // namespace grpc
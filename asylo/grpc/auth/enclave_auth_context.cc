@@ -18,6 +18,8 @@
 
 #include "asylo/grpc/auth/enclave_auth_context.h"
 
+#include <vector>
+
 #include <google/protobuf/io/coded_stream.h>
 #include "absl/strings/str_cat.h"
 #include "asylo/grpc/auth/core/enclave_grpc_security_constants.h"
@@ -79,7 +81,9 @@ StatusOr<EnclaveAuthContext> EnclaveAuthContext::CreateFromAuthContext(
 
 EnclaveAuthContext::EnclaveAuthContext(EnclaveIdentities identities,
                                        RecordProtocol record_protocol)
-    : identities_(std::move(identities)), record_protocol_(record_protocol) {}
+    : identities_(std::move(identities)),
+      record_protocol_(record_protocol),
+      parsed_identities_cache_(std::make_shared<ParsedIdentitiesCache>()) {}
 
 RecordProtocol EnclaveAuthContext::GetRecordProtocol() const {
   return record_protocol_;
@@ -106,4 +110,21 @@ StatusOr<const EnclaveIdentity *> EnclaveAuthContext::FindEnclaveIdentity(
   return &*it;
 }
 
+StatusOr<bool> EnclaveAuthContext::EvaluateAcl(
+    const IdentityAclEvaluator &evaluator) const {
+  return evaluator.Evaluate(GetParsedIdentities());
+}
+
+const ParsedEnclaveIdentities &EnclaveAuthContext::GetParsedIdentities()
+    const {
+  absl::MutexLock lock(&parsed_identities_cache_->mu);
+  if (!parsed_identities_cache_->parsed_identities) {
+    parsed_identities_cache_->parsed_identities =
+        ParsedEnclaveIdentities::Create(std::vector<EnclaveIdentity>(
+            identities_.identities().cbegin(),
+            identities_.identities().cend()));
+  }
+  return *parsed_identities_cache_->parsed_identities;
+}
+
 }  // namespace asylo
@@ -19,10 +19,13 @@
 #ifndef ASYLO_GRPC_AUTH_ENCLAVE_AUTH_CONTEXT_H_
 #define ASYLO_GRPC_AUTH_ENCLAVE_AUTH_CONTEXT_H_
 
+#include <memory>
 #include <string>
 
+#include "absl/synchronization/mutex.h"
 #include "asylo/grpc/auth/core/handshake.pb.h"
 #include "asylo/identity/identity.pb.h"
+#include "asylo/identity/identity_acl_evaluator.h"
 #include "asylo/util/statusor.h"
 #include "include/grpcpp/server_context.h"
 
@@ -72,7 +75,29 @@ class EnclaveAuthContext {
   StatusOr<const EnclaveIdentity *> FindEnclaveIdentity(
       const EnclaveIdentityDescription &description) const;
 
+  /// Evaluates whether the authenticated peer's identities satisfy the ACL
+  /// compiled into `evaluator`.
+  ///
+  /// The peer's identities are parsed on the first call and the parsed
+  /// identities are reused by all subsequent calls on this object and on any
+  /// copies of it.
+  ///
+  /// \param evaluator A compiled identity ACL.
+  /// \return A bool indicating whether the ACL evaluated to true, or a non-OK
+  ///         Status if any of the peer's identities could not be evaluated.
+  StatusOr<bool> EvaluateAcl(const IdentityAclEvaluator &evaluator) const;
+
  private:
+  // Lazily-parsed peer identities, shared between copies of an
+  // EnclaveAuthContext.
+  struct ParsedIdentitiesCache {
+    absl::Mutex mu;
+    std::unique_ptr<ParsedEnclaveIdentities> parsed_identities GUARDED_BY(mu);
+  };
+
+  // Returns the parsed form of identities_, parsing them if necessary.
+  const ParsedEnclaveIdentities &GetParsedIdentities() const;
+
   // Creates an EnclaveAuthContext for the given peer's |identities| and the
   // session |record_protocol|.
   EnclaveAuthContext(EnclaveIdentities identities,
@@ -83,6 +108,9 @@ class EnclaveAuthContext {
 
   // Secure transport record protocol.
   const RecordProtocol record_protocol_;
+
+  // Cache of the parsed form of identities_.
+  std::shared_ptr<ParsedIdentitiesCache> parsed_identities_cache_;
 };
 
 }  // namespace asylo
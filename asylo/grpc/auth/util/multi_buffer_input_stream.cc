@@ -116,8 +116,14 @@ auto MultiBufferInputStream::ByteCount() const
 }
 
 void MultiBufferInputStream::AddBuffer(const char *data, size_t size) {
-  std::vector<char> *buffer = new std::vector<char>(data, data + size);
-  buffers_.emplace_back(std::unique_ptr<std::vector<char>>(buffer));
+  if (free_buffers_.empty()) {
+    std::vector<char> *buffer = new std::vector<char>(data, data + size);
+    buffers_.emplace_back(std::unique_ptr<std::vector<char>>(buffer));
+  } else {
+    // Reuse a previously-trimmed buffer. Splicing does not invalidate current_.
+    buffers_.splice(buffers_.cend(), free_buffers_, free_buffers_.cbegin());
+    buffers_.back()->assign(data, data + size);
+  }
 
   // Adjust the current_ pointer in case it was pointing at the end of the list.
   if (current_ == buffers_.cend()) {
@@ -131,7 +137,7 @@ void MultiBufferInputStream::AddBuffer(const char *data, size_t size) {
 void MultiBufferInputStream::TrimFront() {
   // Remove all buffers up to the current buffer.
   while (buffers_.cbegin() != current_) {
-    buffers_.pop_front();
+    RecycleFrontBuffer();
   }
 
   if (current_ == buffers_.cend()) {
@@ -141,7 +147,7 @@ void MultiBufferInputStream::TrimFront() {
   } else if (current_->get()->size() == offset_) {
     // The current buffer has been entirely consumed. Remove it.
     current_++;
-    buffers_.pop_front();
+    RecycleFrontBuffer();
 
     // Update the offsets.
     offset_ = 0;
@@ -192,4 +198,12 @@ int MultiBufferInputStream::RemainingByteCount() const {
   return size_ - bytes_read_;
 }
 
+void MultiBufferInputStream::RecycleFrontBuffer() {
+  if (free_buffers_.size() < kMaxFreeBuffers) {
+    free_buffers_.splice(free_buffers_.cend(), buffers_, buffers_.cbegin());
+  } else {
+    buffers_.pop_front();
+  }
+}
+
 }  // namespace asylo
@@ -51,6 +51,11 @@ using google::protobuf::io::ZeroCopyInputStream;
 // Instead, buffers are added to the stream via the AddBuffer() method. This is
 // the only time that data is copied.
 //
+// Buffers that are trimmed from the front of the stream are retained (up to a
+// small fixed number) and reused by subsequent calls to AddBuffer(), so a
+// long-lived stream that repeatedly receives and consumes similarly-sized
+// chunks of data does not allocate new storage for each chunk.
+//
 // This class is thread-compatible.
 class MultiBufferInputStream : public ZeroCopyInputStream {
  public:
@@ -94,8 +99,20 @@ class MultiBufferInputStream : public ZeroCopyInputStream {
  private:
   using BufferList = std::list<std::unique_ptr<std::vector<char>>>;
 
+  // The maximum number of trimmed buffers kept in free_buffers_ for reuse.
+  static constexpr size_t kMaxFreeBuffers = 4;
+
+  // Moves the first buffer in buffers_ to free_buffers_, or releases it if
+  // free_buffers_ is full.
+  void RecycleFrontBuffer();
+
   BufferList buffers_;
 
+  // Buffers that have been trimmed from the stream and can be reused by
+  // AddBuffer(). Buffers are moved between lists by splicing, so recycling a
+  // buffer does not allocate a new list node.
+  BufferList free_buffers_;
+
   // Iterator pointing to the current buffer.
   BufferList::const_iterator current_;
 
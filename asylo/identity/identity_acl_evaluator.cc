@@ -18,8 +18,12 @@
 
 #include "asylo/identity/identity_acl_evaluator.h"
 
+#include <algorithm>
+#include <utility>
+
 #include <google/protobuf/repeated_field.h>
 #include "absl/strings/str_cat.h"
+#include "asylo/platform/common/static_map.h"
 #include "asylo/util/status.h"
 
 namespace asylo {
@@ -135,6 +139,18 @@ StatusOr<bool> EvaluateAclExpectation(
   return false;
 }
 
+// Returns the matcher registered for |description|, or nullptr if there is none.
+const NamedIdentityExpectationMatcher *FindMatcher(
+    const EnclaveIdentityDescription &description) {
+  auto matcher_it = IdentityExpectationMatcherMap::GetValue(
+      NamedIdentityExpectationMatcher::GetMatcherName(description)
+          .ValueOrDie());
+  if (matcher_it == IdentityExpectationMatcherMap::value_end()) {
+    return nullptr;
+  }
+  return &*matcher_it;
+}
+
 }  // namespace
 
 StatusOr<bool> EvaluateIdentityAcl(
@@ -156,4 +172,214 @@ StatusOr<bool> EvaluateIdentityAcl(
   }
 }
 
+std::unique_ptr<ParsedEnclaveIdentities> ParsedEnclaveIdentities::Create(
+    const std::vector<EnclaveIdentity> &identities) {
+  std::unique_ptr<ParsedEnclaveIdentities> parsed_identities(
+      new ParsedEnclaveIdentities());
+  parsed_identities->entries_.reserve(identities.size());
+
+  for (const EnclaveIdentity &identity : identities) {
+    Entry entry;
+    entry.matcher = FindMatcher(identity.description());
+    if (entry.matcher == nullptr) {
+      entry.status = Status(
+          error::GoogleError::INTERNAL,
+          absl::StrCat("No matcher exists for identity with description ",
+                       identity.description().ShortDebugString()));
+    } else {
+      auto parse_result = entry.matcher->ParseIdentity(identity);
+      if (parse_result.ok()) {
+        entry.parsed = std::move(parse_result).ValueOrDie();
+      } else {
+        entry.status = parse_result.status();
+      }
+    }
+    parsed_identities->entries_.push_back(std::move(entry));
+  }
+
+  return parsed_identities;
+}
+
+StatusOr<std::unique_ptr<IdentityAclEvaluator>> IdentityAclEvaluator::Create(
+    const IdentityAclPredicate &acl) {
+  std::unique_ptr<IdentityAclEvaluator> evaluator(new IdentityAclEvaluator());
+  int cost;
+  Status status = evaluator->Compile(acl, &evaluator->root_, &cost);
+  if (!status.ok()) {
+    return status;
+  }
+  return std::move(evaluator);
+}
+
+StatusOr<bool> IdentityAclEvaluator::Evaluate(
+    const ParsedEnclaveIdentities &identities) const {
+  return EvaluateNode(root_, identities);
+}
+
+StatusOr<bool> IdentityAclEvaluator::Evaluate(
+    const std::vector<EnclaveIdentity> &identities) const {
+  return Evaluate(*ParsedEnclaveIdentities::Create(identities));
+}
+
+Status IdentityAclEvaluator::Compile(const IdentityAclPredicate &predicate,
+                                     int *index, int *cost) {
+  Node node;
+  node.first_child = 0;
+  node.num_children = 0;
+  node.matcher = nullptr;
+
+  switch (predicate.item_case()) {
+    case IdentityAclPredicate::kAclGroup: {
+      const IdentityAclGroup &acl_group = predicate.acl_group();
+      if (acl_group.predicates().empty()) {
+        return Status(error::GoogleError::INVALID_ARGUMENT,
+                      "ACL predicate groups cannot be empty");
+      }
+      switch (acl_group.type()) {
+        case IdentityAclGroup::OR:
+          node.type = Node::Type::OR;
+          break;
+        case IdentityAclGroup::AND:
+          node.type = Node::Type::AND;
+          break;
+        case IdentityAclGroup::NOT:
+          if (acl_group.predicates_size() != 1) {
+            return Status(error::GoogleError::INVALID_ARGUMENT,
+                          "NOT predicate groups must have exactly one element");
+          }
+          node.type = Node::Type::NOT;
+          break;
+        default:
+          return Status(
+              error::GoogleError::INVALID_ARGUMENT,
+              absl::StrCat("Unknown acl_group type: ", acl_group.type()));
+      }
+
+      // Compile all children first so that their indices can be stored
+      // contiguously in children_.
+      std::vector<std::pair<int, int>> children;  // (cost, index)
+      *cost = 0;
+      for (const IdentityAclPredicate &child : acl_group.predicates()) {
+        int child_index;
+        int child_cost;
+        Status status = Compile(child, &child_index, &child_cost);
+        if (!status.ok()) {
+          return status;
+        }
+        children.emplace_back(child_cost, child_index);
+        *cost += child_cost;
+      }
+
+      // Unless a matcher fails, the result of an OR or AND group does not
+      // depend on the order in which its predicates are evaluated, so evaluate
+      // the cheapest ones first. Reordering can change whether a failing
+      // expectation is reached before the group short-circuits, which the
+      // class comment documents.
+      std::stable_sort(children.begin(), children.end(),
+                       [](const std::pair<int, int> &lhs,
+                          const std::pair<int, int> &rhs) {
+                         return lhs.first < rhs.first;
+                       });
+
+      node.first_child = children_.size();
+      node.num_children = children.size();
+      for (const auto &child : children) {
+        children_.push_back(child.second);
+      }
+      break;
+    }
+    case IdentityAclPredicate::kExpectation: {
+      const EnclaveIdentityExpectation &expectation = predicate.expectation();
+      node.type = Node::Type::EXPECTATION;
+      node.matcher =
+          FindMatcher(expectation.reference_identity().description());
+      if (node.matcher == nullptr) {
+        return Status(error::GoogleError::INTERNAL,
+                      absl::StrCat("No matcher exists for matching expectation "
+                                   "with reference-identity description ",
+                                   expectation.reference_identity()
+                                       .description()
+                                       .ShortDebugString()));
+      }
+      auto parse_result = node.matcher->ParseExpectation(expectation);
+      if (!parse_result.ok()) {
+        return parse_result.status();
+      }
+      node.expectation = std::move(parse_result).ValueOrDie();
+      *cost = 1;
+      break;
+    }
+    case IdentityAclPredicate::ITEM_NOT_SET:
+      return Status(
+          error::GoogleError::INVALID_ARGUMENT,
+          "Invalid ACL predicate: must be either a group or an expectation.");
+    default:
+      return Status(error::GoogleError::INVALID_ARGUMENT,
+                    absl::StrCat("Unknown acl item: ", predicate.item_case()));
+  }
+
+  *index = nodes_.size();
+  nodes_.push_back(std::move(node));
+  return Status::OkStatus();
+}
+
+StatusOr<bool> IdentityAclEvaluator::EvaluateNode(
+    int index, const ParsedEnclaveIdentities &identities) const {
+  const Node &node = nodes_[index];
+  if (node.type == Node::Type::EXPECTATION) {
+    return EvaluateExpectation(node, identities);
+  }
+
+  // OR groups short-circuit on the first true predicate and AND groups on the
+  // first false one. A NOT group has exactly one predicate, so treating it
+  // like an OR group and negating the result is correct.
+  const bool short_circuit_value = node.type != Node::Type::AND;
+  for (int i = 0; i < node.num_children; ++i) {
+    const StatusOr<bool> result =
+        EvaluateNode(children_[node.first_child + i], identities);
+    if (!result.ok()) {
+      return result;
+    }
+
+    if (result.ValueOrDie() == short_circuit_value) {
+      return node.type == Node::Type::OR;
+    }
+  }
+
+  return node.type != Node::Type::OR;
+}
+
+StatusOr<bool> IdentityAclEvaluator::EvaluateExpectation(
+    const Node &node, const ParsedEnclaveIdentities &identities) const {
+  for (const ParsedEnclaveIdentities::Entry &entry : identities.entries_) {
+    // An identity whose description differs from the expectation's
+    // reference-identity description cannot match it, so it only fails the
+    // evaluation if no matcher recognizes it at all. This is consistent with
+    // DelegatingIdentityExpectationMatcher, which does not parse such an
+    // identity.
+    if (entry.matcher != node.matcher) {
+      if (entry.matcher == nullptr) {
+        return entry.status;
+      }
+      continue;
+    }
+
+    if (!entry.status.ok()) {
+      return entry.status;
+    }
+
+    const StatusOr<bool> result =
+        node.matcher->MatchParsed(*entry.parsed, *node.expectation);
+    if (!result.ok()) {
+      return result;
+    }
+
+    if (result.ValueOrDie()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 }  // namespace asylo
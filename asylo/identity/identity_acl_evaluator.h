@@ -19,9 +19,14 @@
 #ifndef ASYLO_IDENTITY_IDENTITY_ACL_EVALUATOR_H_
 #define ASYLO_IDENTITY_IDENTITY_ACL_EVALUATOR_H_
 
+#include <memory>
+#include <vector>
+
 #include "asylo/identity/identity.pb.h"
 #include "asylo/identity/identity_acl.pb.h"
 #include "asylo/identity/identity_expectation_matcher.h"
+#include "asylo/identity/named_identity_expectation_matcher.h"
+#include "asylo/util/status.h"
 #include "asylo/util/statusor.h"
 
 namespace asylo {
@@ -50,6 +55,145 @@ StatusOr<bool> EvaluateIdentityAcl(
     const std::vector<EnclaveIdentity> &identities,
     const IdentityAclPredicate &acl, const IdentityExpectationMatcher &matcher);
 
+/// A list of enclave identities, each parsed once by the
+/// `NamedIdentityExpectationMatcher` registered for its description.
+///
+/// A `ParsedEnclaveIdentities` object can be evaluated against any number of
+/// `IdentityAclEvaluator`s without re-parsing the identities. It is immutable
+/// and therefore thread-safe.
+class ParsedEnclaveIdentities {
+ public:
+  /// Parses each of `identities`.
+  ///
+  /// An identity that has no registered matcher, or that its matcher fails to
+  /// parse, does not cause this method to fail. Instead, the error is
+  /// reported by any evaluation that needs to match that identity, which is
+  /// consistent with `EvaluateIdentityAcl()`.
+  ///
+  /// \param identities The identities to parse.
+  /// \return The parsed identities.
+  static std::unique_ptr<ParsedEnclaveIdentities> Create(
+      const std::vector<EnclaveIdentity> &identities);
+
+ private:
+  friend class IdentityAclEvaluator;
+
+  // A single parsed identity.
+  struct Entry {
+    // The matcher that parsed the identity, or nullptr if no matcher is
+    // registered for the identity's description.
+    const NamedIdentityExpectationMatcher *matcher;
+
+    // The parsed identity. Only valid if |status| is OK.
+    std::unique_ptr<NamedIdentityExpectationMatcher::ParsedIdentity> parsed;
+
+    // The result of looking up the matcher and parsing the identity.
+    Status status;
+  };
+
+  ParsedEnclaveIdentities() = default;
+
+  std::vector<Entry> entries_;
+};
+
+/// An immutable, pre-compiled form of an identity ACL.
+///
+/// Compiling an ACL validates its structure once, looks up the
+/// `NamedIdentityExpectationMatcher` for each expectation, and parses every
+/// expectation into its matcher-specific form. Evaluating the compiled ACL then
+/// only walks a flat array of nodes and calls
+/// `NamedIdentityExpectationMatcher::MatchParsed()`. Within each `AND` and `OR`
+/// group, predicates are reordered so that cheaper predicates (those containing
+/// fewer expectations) are evaluated first, which lets the group short-circuit
+/// before evaluating expensive nested groups.
+///
+/// When no matcher reports an error, evaluating a compiled ACL gives the same
+/// result as calling `EvaluateIdentityAcl()` with a
+/// `DelegatingIdentityExpectationMatcher`. Malformed or unrecognized
+/// expectations are reported by Create() rather than at evaluation time. If
+/// matching an identity against an expectation fails, the two evaluations may
+/// disagree: because the predicates of a group are evaluated in a different
+/// order, a group may short-circuit before or after reaching the failing
+/// expectation. Evaluate() can then return a result where
+/// `EvaluateIdentityAcl()` returns an error, or the reverse. Callers must treat
+/// an error from either as a failure to evaluate the ACL.
+///
+/// An `IdentityAclEvaluator` is thread-safe.
+class IdentityAclEvaluator {
+ public:
+  /// Compiles `acl` into an evaluator.
+  ///
+  /// `acl` must satisfy the constraints described in `EvaluateIdentityAcl()`,
+  /// and each of its expectations must be recognized and successfully parsed
+  /// by a registered `NamedIdentityExpectationMatcher`.
+  ///
+  /// \param acl The ACL to compile.
+  /// \return The compiled evaluator, or a non-OK Status if `acl` is invalid.
+  static StatusOr<std::unique_ptr<IdentityAclEvaluator>> Create(
+      const IdentityAclPredicate &acl);
+
+  /// Evaluates whether `identities` satisfies the compiled ACL.
+  ///
+  /// \param identities The parsed identities to match against the ACL.
+  /// \return A bool indicating whether the ACL evaluated to true, or a non-OK
+  ///         Status if any of the identities that had to be matched is
+  ///         unrecognized or malformed.
+  StatusOr<bool> Evaluate(const ParsedEnclaveIdentities &identities) const;
+
+  /// Parses `identities` and evaluates whether they satisfy the compiled ACL.
+  /// Callers that evaluate the same identities repeatedly should create a
+  /// `ParsedEnclaveIdentities` once and use the overload above instead.
+  ///
+  /// \param identities A list of identities to match against the ACL.
+  /// \return A bool indicating whether the ACL evaluated to true, or a non-OK
+  ///         Status if any of the identities that had to be matched is
+  ///         unrecognized or malformed.
+  StatusOr<bool> Evaluate(const std::vector<EnclaveIdentity> &identities) const;
+
+ private:
+  // A node of the compiled ACL.
+  struct Node {
+    enum class Type { OR, AND, NOT, EXPECTATION };
+
+    Type type;
+
+    // For group nodes, the range [first_child, first_child + num_children) of
+    // children_ that holds the indices of this node's children, in evaluation
+    // order.
+    int first_child;
+    int num_children;
+
+    // For expectation nodes, the matcher that parsed the expectation and the
+    // parsed expectation.
+    const NamedIdentityExpectationMatcher *matcher;
+    std::unique_ptr<NamedIdentityExpectationMatcher::ParsedExpectation>
+        expectation;
+  };
+
+  IdentityAclEvaluator() = default;
+
+  // Compiles |predicate| and its descendants, appending them to nodes_. On
+  // success, sets |index| to the index of the node for |predicate| and |cost|
+  // to the number of expectation nodes in its subtree.
+  Status Compile(const IdentityAclPredicate &predicate, int *index, int *cost);
+
+  // Evaluates the node at |index| against |identities|.
+  StatusOr<bool> EvaluateNode(int index,
+                              const ParsedEnclaveIdentities &identities) const;
+
+  // Evaluates the expectation node |node| against |identities|.
+  StatusOr<bool> EvaluateExpectation(
+      const Node &node, const ParsedEnclaveIdentities &identities) const;
+
+  // All nodes of the compiled ACL. The root is nodes_[root_].
+  std::vector<Node> nodes_;
+
+  // Child indices of all group nodes.
+  std::vector<int> children_;
+
+  int root_;
+};
+
 }  // namespace asylo
 
 #endif  // ASYLO_IDENTITY_IDENTITY_ACL_EVALUATOR_H_
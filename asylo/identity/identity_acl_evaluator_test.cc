@@ -0,0 +1,347 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/identity/identity_acl_evaluator.h"
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "asylo/identity/delegating_identity_expectation_matcher.h"
+#include "asylo/identity/identity.pb.h"
+#include "asylo/identity/identity_acl.pb.h"
+#include "asylo/identity/named_identity_expectation_matcher.h"
+#include "asylo/platform/common/static_map.h"
+#include "asylo/test/util/status_matchers.h"
+#include "asylo/util/statusor.h"
+
+namespace asylo {
+namespace {
+
+using ::testing::Not;
+
+// The number of distinct identity strings used by the randomized tests.
+constexpr int kNumIdentityValues = 8;
+
+// Makes an identity description whose authority_type string is constructed
+// based on the template parameter |C|.
+template <char C>
+EnclaveIdentityDescription MakeDescription() {
+  EnclaveIdentityDescription description;
+  description.set_identity_type(UNKNOWN_IDENTITY);
+  description.set_authority_type(std::string(4, C));
+  return description;
+}
+
+// Makes an identity whose description().authority_type() string is constructed
+// based on the template parameter |C|.
+template <char C>
+EnclaveIdentity MakeIdentity(std::string id) {
+  EnclaveIdentity identity;
+  *identity.mutable_description() = MakeDescription<C>();
+  identity.set_identity(std::move(id));
+  return identity;
+}
+
+// Makes an expectation whose
+// reference_identity().description().authority_type() string is constructed
+// based on the template parameter |C|.
+template <char C>
+IdentityAclPredicate MakeExpectationPredicate(std::string id) {
+  IdentityAclPredicate predicate;
+  *predicate.mutable_expectation()->mutable_reference_identity() =
+      MakeIdentity<C>(std::move(id));
+  return predicate;
+}
+
+// Matcher whose Description().authority_type() string is constructed based on
+// the template parameter |C|, and which considers an identity to match an
+// expectation if the identity simply equals the expectation's reference
+// identity. Identities and expectations whose identity string is "malformed"
+// are rejected, identities as soon as they are parsed.
+template <char C>
+class TestMatcher final : public NamedIdentityExpectationMatcher {
+ public:
+  TestMatcher() = default;
+  ~TestMatcher() override = default;
+
+  EnclaveIdentityDescription Description() const override {
+    return MakeDescription<C>();
+  }
+
+  // Keeps the default representation, so the other parsing methods need not be
+  // overridden.
+  StatusOr<std::unique_ptr<ParsedIdentity>> ParseIdentity(
+      const EnclaveIdentity &identity) const override {
+    if (identity.identity() == "malformed") {
+      return Status(error::GoogleError::INVALID_ARGUMENT, "Malformed");
+    }
+    return NamedIdentityExpectationMatcher::ParseIdentity(identity);
+  }
+
+  StatusOr<bool> Match(
+      const EnclaveIdentity &identity,
+      const EnclaveIdentityExpectation &expectation) const override {
+    if (identity.identity() == "malformed" ||
+        expectation.reference_identity().identity() == "malformed") {
+      return Status(error::GoogleError::INVALID_ARGUMENT, "Malformed");
+    }
+    return identity.identity() == expectation.reference_identity().identity();
+  }
+};
+
+using TestMatcherA = TestMatcher<'A'>;
+using TestMatcherB = TestMatcher<'B'>;
+
+// Static registration of TestMatcher<'A'>.
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(IdentityExpectationMatcherMap,
+                                     TestMatcherA);
+
+// Static registration of TestMatcher<'B'>.
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(IdentityExpectationMatcherMap,
+                                     TestMatcherB);
+
+// Makes a group predicate of |type| containing |predicates|.
+IdentityAclPredicate MakeGroup(
+    IdentityAclGroup::GroupType type,
+    const std::vector<IdentityAclPredicate> &predicates) {
+  IdentityAclPredicate group;
+  group.mutable_acl_group()->set_type(type);
+  for (const IdentityAclPredicate &predicate : predicates) {
+    *group.mutable_acl_group()->add_predicates() = predicate;
+  }
+  return group;
+}
+
+// Makes a random, well-formed ACL containing |num_predicates| expectations
+// nested in groups of random types.
+IdentityAclPredicate MakeRandomAcl(int num_predicates, std::mt19937 *gen) {
+  std::uniform_int_distribution<int> value_dist(0, kNumIdentityValues - 1);
+  std::uniform_int_distribution<int> coin(0, 1);
+  if (num_predicates == 1) {
+    std::string id = std::to_string(value_dist(*gen));
+    return coin(*gen) ? MakeExpectationPredicate<'A'>(id)
+                      : MakeExpectationPredicate<'B'>(id);
+  }
+
+  std::uniform_int_distribution<int> type_dist(0, 2);
+  IdentityAclGroup::GroupType type =
+      static_cast<IdentityAclGroup::GroupType>(type_dist(*gen));
+  if (type == IdentityAclGroup::NOT) {
+    return MakeGroup(type, {MakeRandomAcl(num_predicates, gen)});
+  }
+
+  std::uniform_int_distribution<int> split_dist(1, num_predicates - 1);
+  int split = split_dist(*gen);
+  return MakeGroup(type, {MakeRandomAcl(split, gen),
+                          MakeRandomAcl(num_predicates - split, gen)});
+}
+
+// Tests that a compiled nested ACL evaluates identically to
+// EvaluateIdentityAcl() with a DelegatingIdentityExpectationMatcher.
+TEST(IdentityAclEvaluatorTest, CompiledAclMatchesUncompiledEvaluation) {
+  constexpr int kNumAcls = 20;
+  constexpr int kNumPredicates = 50;
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> value_dist(0, kNumIdentityValues - 1);
+  DelegatingIdentityExpectationMatcher matcher;
+
+  for (int i = 0; i < kNumAcls; ++i) {
+    IdentityAclPredicate acl = MakeRandomAcl(kNumPredicates, &gen);
+    auto evaluator_result = IdentityAclEvaluator::Create(acl);
+    ASSERT_THAT(evaluator_result, IsOk());
+    std::unique_ptr<IdentityAclEvaluator> evaluator =
+        std::move(evaluator_result).ValueOrDie();
+
+    for (int j = 0; j < kNumIdentityValues; ++j) {
+      std::vector<EnclaveIdentity> identities = {
+          MakeIdentity<'A'>(std::to_string(value_dist(gen))),
+          MakeIdentity<'B'>(std::to_string(value_dist(gen)))};
+
+      StatusOr<bool> expected = EvaluateIdentityAcl(identities, acl, matcher);
+      ASSERT_THAT(expected, IsOk());
+
+      StatusOr<bool> actual = evaluator->Evaluate(
+          *ParsedEnclaveIdentities::Create(identities));
+      ASSERT_THAT(actual, IsOk());
+      EXPECT_EQ(actual.ValueOrDie(), expected.ValueOrDie());
+    }
+  }
+}
+
+// Tests that one set of parsed identities can be evaluated against several
+// compiled ACLs.
+TEST(IdentityAclEvaluatorTest, ParsedIdentitiesCanBeReused) {
+  std::unique_ptr<ParsedEnclaveIdentities> identities =
+      ParsedEnclaveIdentities::Create({MakeIdentity<'A'>("foo")});
+
+  auto match_result =
+      IdentityAclEvaluator::Create(MakeExpectationPredicate<'A'>("foo"));
+  ASSERT_THAT(match_result, IsOk());
+  auto mismatch_result = IdentityAclEvaluator::Create(
+      MakeGroup(IdentityAclGroup::NOT, {MakeExpectationPredicate<'A'>("foo")}));
+  ASSERT_THAT(mismatch_result, IsOk());
+
+  for (int i = 0; i < 2; ++i) {
+    StatusOr<bool> result = match_result.ValueOrDie()->Evaluate(*identities);
+    ASSERT_THAT(result, IsOk());
+    EXPECT_TRUE(result.ValueOrDie());
+
+    result = mismatch_result.ValueOrDie()->Evaluate(*identities);
+    ASSERT_THAT(result, IsOk());
+    EXPECT_FALSE(result.ValueOrDie());
+  }
+}
+
+// Tests that an identity does not match an expectation with a different
+// description.
+TEST(IdentityAclEvaluatorTest, DescriptionMismatchDoesNotMatch) {
+  auto evaluator_result =
+      IdentityAclEvaluator::Create(MakeExpectationPredicate<'B'>("foo"));
+  ASSERT_THAT(evaluator_result, IsOk());
+
+  StatusOr<bool> result =
+      evaluator_result.ValueOrDie()->Evaluate({MakeIdentity<'A'>("foo")});
+  ASSERT_THAT(result, IsOk());
+  EXPECT_FALSE(result.ValueOrDie());
+}
+
+// Tests that malformed ACLs are rejected when they are compiled.
+TEST(IdentityAclEvaluatorTest, CreateFailsWithMalformedAcl) {
+  EXPECT_THAT(IdentityAclEvaluator::Create(IdentityAclPredicate()),
+              Not(IsOk()));
+  EXPECT_THAT(IdentityAclEvaluator::Create(MakeGroup(IdentityAclGroup::AND, {})),
+              Not(IsOk()));
+  EXPECT_THAT(IdentityAclEvaluator::Create(MakeGroup(
+                  IdentityAclGroup::NOT, {MakeExpectationPredicate<'A'>("foo"),
+                                          MakeExpectationPredicate<'A'>("bar")})),
+              Not(IsOk()));
+}
+
+// Tests that expectations that are unrecognized or malformed are rejected when
+// they are compiled.
+TEST(IdentityAclEvaluatorTest, CreateFailsWithInvalidExpectation) {
+  EXPECT_THAT(
+      IdentityAclEvaluator::Create(MakeExpectationPredicate<'C'>("foo")),
+      Not(IsOk()));
+}
+
+// Tests that evaluation fails if an identity that has to be matched has no
+// registered matcher.
+TEST(IdentityAclEvaluatorTest, EvaluateFailsWithUnrecognizedIdentity) {
+  auto evaluator_result =
+      IdentityAclEvaluator::Create(MakeExpectationPredicate<'A'>("foo"));
+  ASSERT_THAT(evaluator_result, IsOk());
+
+  EXPECT_THAT(
+      evaluator_result.ValueOrDie()->Evaluate({MakeIdentity<'C'>("foo")}),
+      Not(IsOk()));
+}
+
+// Tests that evaluation fails if the matcher reports an error.
+TEST(IdentityAclEvaluatorTest, EvaluateFailsIfMatcherFails) {
+  auto evaluator_result =
+      IdentityAclEvaluator::Create(MakeExpectationPredicate<'A'>("foo"));
+  ASSERT_THAT(evaluator_result, IsOk());
+
+  EXPECT_THAT(
+      evaluator_result.ValueOrDie()->Evaluate({MakeIdentity<'A'>("malformed")}),
+      Not(IsOk()));
+}
+
+// Tests that a malformed identity does not fail the evaluation of an
+// expectation of an unrelated authority that another identity matches.
+TEST(IdentityAclEvaluatorTest, MalformedIdentityOfOtherAuthorityIsIgnored) {
+  auto evaluator_result =
+      IdentityAclEvaluator::Create(MakeExpectationPredicate<'A'>("foo"));
+  ASSERT_THAT(evaluator_result, IsOk());
+
+  const std::vector<EnclaveIdentity> identities = {
+      MakeIdentity<'B'>("malformed"), MakeIdentity<'A'>("foo")};
+  StatusOr<bool> result = evaluator_result.ValueOrDie()->Evaluate(identities);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_TRUE(result.ValueOrDie());
+
+  // The uncompiled evaluation agrees.
+  DelegatingIdentityExpectationMatcher matcher;
+  result = EvaluateIdentityAcl(identities, MakeExpectationPredicate<'A'>("foo"),
+                               matcher);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_TRUE(result.ValueOrDie());
+}
+
+// Tests that a failing matcher in an OR group can make the compiled and
+// uncompiled evaluations disagree, since the compiled ACL evaluates the cheaper
+// predicate first. The expectation "malformed" compiles, but matching it fails.
+TEST(IdentityAclEvaluatorTest, FailingMatcherInOrGroupDependsOnOrder) {
+  const std::vector<EnclaveIdentity> identities = {MakeIdentity<'A'>("foo")};
+  DelegatingIdentityExpectationMatcher matcher;
+
+  // The nested group matches before the failing expectation is reached in the
+  // original order, but the failing expectation is cheaper.
+  IdentityAclPredicate acl = MakeGroup(
+      IdentityAclGroup::OR,
+      {MakeGroup(IdentityAclGroup::AND, {MakeExpectationPredicate<'A'>("foo"),
+                                         MakeExpectationPredicate<'A'>("foo")}),
+       MakeExpectationPredicate<'A'>("malformed")});
+  auto evaluator_result = IdentityAclEvaluator::Create(acl);
+  ASSERT_THAT(evaluator_result, IsOk());
+
+  StatusOr<bool> result = EvaluateIdentityAcl(identities, acl, matcher);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_TRUE(result.ValueOrDie());
+  EXPECT_THAT(evaluator_result.ValueOrDie()->Evaluate(identities), Not(IsOk()));
+
+  // The nested group fails in the original order, but the cheaper expectation
+  // matches first in the compiled ACL.
+  acl = MakeGroup(
+      IdentityAclGroup::OR,
+      {MakeGroup(IdentityAclGroup::AND,
+                 {MakeExpectationPredicate<'A'>("malformed"),
+                  MakeExpectationPredicate<'A'>("foo")}),
+       MakeExpectationPredicate<'A'>("foo")});
+  evaluator_result = IdentityAclEvaluator::Create(acl);
+  ASSERT_THAT(evaluator_result, IsOk());
+
+  EXPECT_THAT(EvaluateIdentityAcl(identities, acl, matcher), Not(IsOk()));
+  result = evaluator_result.ValueOrDie()->Evaluate(identities);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_TRUE(result.ValueOrDie());
+
+  // Without the failing expectation, both evaluations agree.
+  acl = MakeGroup(
+      IdentityAclGroup::OR,
+      {MakeGroup(IdentityAclGroup::AND, {MakeExpectationPredicate<'A'>("bar"),
+                                         MakeExpectationPredicate<'A'>("foo")}),
+       MakeExpectationPredicate<'A'>("foo")});
+  evaluator_result = IdentityAclEvaluator::Create(acl);
+  ASSERT_THAT(evaluator_result, IsOk());
+
+  result = EvaluateIdentityAcl(identities, acl, matcher);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_TRUE(result.ValueOrDie());
+  result = evaluator_result.ValueOrDie()->Evaluate(identities);
+  ASSERT_THAT(result, IsOk());
+  EXPECT_TRUE(result.ValueOrDie());
+}
+
+}  // namespace
+}  // namespace asylo
@@ -20,10 +20,57 @@
 
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "asylo/crypto/util/byte_container_util.h"
 #include "asylo/crypto/util/byte_container_view.h"
 
 namespace asylo {
+namespace {
+
+// The ParsedIdentity used by the default implementation of ParseIdentity().
+class ProtoParsedIdentity
+    : public NamedIdentityExpectationMatcher::ParsedIdentity {
+ public:
+  explicit ProtoParsedIdentity(const EnclaveIdentity &identity)
+      : identity(identity) {}
+
+  const EnclaveIdentity identity;
+};
+
+// The ParsedExpectation used by the default implementation of
+// ParseExpectation().
+class ProtoParsedExpectation
+    : public NamedIdentityExpectationMatcher::ParsedExpectation {
+ public:
+  explicit ProtoParsedExpectation(const EnclaveIdentityExpectation &expectation)
+      : expectation(expectation) {}
+
+  const EnclaveIdentityExpectation expectation;
+};
+
+}  // namespace
+
+StatusOr<std::unique_ptr<NamedIdentityExpectationMatcher::ParsedIdentity>>
+NamedIdentityExpectationMatcher::ParseIdentity(
+    const EnclaveIdentity &identity) const {
+  return std::unique_ptr<ParsedIdentity>(
+      absl::make_unique<ProtoParsedIdentity>(identity));
+}
+
+StatusOr<std::unique_ptr<NamedIdentityExpectationMatcher::ParsedExpectation>>
+NamedIdentityExpectationMatcher::ParseExpectation(
+    const EnclaveIdentityExpectation &expectation) const {
+  return std::unique_ptr<ParsedExpectation>(
+      absl::make_unique<ProtoParsedExpectation>(expectation));
+}
+
+StatusOr<bool> NamedIdentityExpectationMatcher::MatchParsed(
+    const ParsedIdentity &identity,
+    const ParsedExpectation &expectation) const {
+  return Match(static_cast<const ProtoParsedIdentity &>(identity).identity,
+               static_cast<const ProtoParsedExpectation &>(expectation)
+                   .expectation);
+}
 
 StatusOr<std::string> NamedIdentityExpectationMatcher::GetMatcherName(
     const EnclaveIdentityDescription &description) {
@@ -19,6 +19,7 @@
 #ifndef ASYLO_IDENTITY_NAMED_IDENTITY_EXPECTATION_MATCHER_H_
 #define ASYLO_IDENTITY_NAMED_IDENTITY_EXPECTATION_MATCHER_H_
 
+#include <memory>
 #include <string>
 
 #include "asylo/identity/identity.pb.h"
@@ -55,6 +56,44 @@ class NamedIdentityExpectationMatcher : public IdentityExpectationMatcher {
   // description, the matcher returns a non-ok status.
   virtual EnclaveIdentityDescription Description() const = 0;
 
+  // An opaque, matcher-specific representation of an identity that has been
+  // parsed by ParseIdentity(). A ParsedIdentity may only be passed back to the
+  // matcher that created it.
+  class ParsedIdentity {
+   public:
+    virtual ~ParsedIdentity() = default;
+  };
+
+  // An opaque, matcher-specific representation of an expectation that has been
+  // parsed by ParseExpectation(). A ParsedExpectation may only be passed back
+  // to the matcher that created it.
+  class ParsedExpectation {
+   public:
+    virtual ~ParsedExpectation() = default;
+  };
+
+  // Parses |identity| into a form that can be matched any number of times with
+  // MatchParsed() without being parsed again. Returns a non-ok status if
+  // |identity| is not recognized by this matcher or is malformed.
+  //
+  // The default implementations of ParseIdentity(), ParseExpectation(), and
+  // MatchParsed() retain copies of the protos and defer to Match(). A subclass
+  // that overrides any one of these three methods must override all of them.
+  virtual StatusOr<std::unique_ptr<ParsedIdentity>> ParseIdentity(
+      const EnclaveIdentity &identity) const;
+
+  // Parses |expectation| into a form that can be matched any number of times
+  // with MatchParsed() without being parsed again. Returns a non-ok status if
+  // |expectation| is not recognized by this matcher or is malformed.
+  virtual StatusOr<std::unique_ptr<ParsedExpectation>> ParseExpectation(
+      const EnclaveIdentityExpectation &expectation) const;
+
+  // Evaluates whether |identity| matches |expectation|. Both arguments must
+  // have been created by this matcher.
+  virtual StatusOr<bool> MatchParsed(
+      const ParsedIdentity &identity,
+      const ParsedExpectation &expectation) const;
+
   // Converts |description| to a name that can be used as a unique identifier
   // for a NamedIdentityExpectationMatcher that handles identities/expectations
   // of this description.
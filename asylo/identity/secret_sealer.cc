@@ -39,6 +39,73 @@ Status SecretSealer::Reseal(const SealedSecret &old_sealed_secret,
               unsealed_secret, new_sealed_secret);
 }
 
+Status SecretSealer::SealBatch(
+    const SealedSecretHeader &header,
+    const std::vector<ByteContainerView> &additional_authenticated_data,
+    const std::vector<ByteContainerView> &secrets,
+    SealedSecretBatch *sealed_batch) {
+  if (additional_authenticated_data.size() != secrets.size()) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "Number of additional authenticated data items does not "
+                  "match the number of secrets");
+  }
+
+  sealed_batch->Clear();
+  sealed_batch->mutable_entries()->Reserve(secrets.size());
+  SealedSecret sealed_secret;
+  if (secrets.empty()) {
+    // Seal an empty secret so that an empty batch carries (and validates) the
+    // same header that Seal() would have produced.
+    Status status = Seal(header, /*additional_authenticated_data=*/"",
+                         /*secret=*/"", &sealed_secret);
+    if (!status.ok()) {
+      return status;
+    }
+    sealed_batch->set_sealed_secret_header(
+        sealed_secret.sealed_secret_header());
+    return Status::OkStatus();
+  }
+  for (size_t i = 0; i < secrets.size(); ++i) {
+    Status status = Seal(header, additional_authenticated_data[i], secrets[i],
+                         &sealed_secret);
+    if (!status.ok()) {
+      sealed_batch->Clear();
+      return status;
+    }
+    if (i == 0) {
+      sealed_batch->set_sealed_secret_header(
+          sealed_secret.sealed_secret_header());
+    }
+    SealedSecretBatch::Entry *entry = sealed_batch->add_entries();
+    entry->set_iv(sealed_secret.iv());
+    entry->set_additional_authenticated_data(
+        sealed_secret.additional_authenticated_data());
+    entry->set_secret_ciphertext(sealed_secret.secret_ciphertext());
+  }
+  return Status::OkStatus();
+}
+
+Status SecretSealer::UnsealBatch(
+    const SealedSecretBatch &sealed_batch,
+    std::vector<CleansingVector<uint8_t>> *secrets) {
+  secrets->resize(sealed_batch.entries_size());
+  SealedSecret sealed_secret;
+  sealed_secret.set_sealed_secret_header(sealed_batch.sealed_secret_header());
+  for (int i = 0; i < sealed_batch.entries_size(); ++i) {
+    const SealedSecretBatch::Entry &entry = sealed_batch.entries(i);
+    sealed_secret.set_iv(entry.iv());
+    sealed_secret.set_additional_authenticated_data(
+        entry.additional_authenticated_data());
+    sealed_secret.set_secret_ciphertext(entry.secret_ciphertext());
+    Status status = Unseal(sealed_secret, &(*secrets)[i]);
+    if (!status.ok()) {
+      secrets->clear();
+      return status;
+    }
+  }
+  return Status::OkStatus();
+}
+
 StatusOr<std::string> SecretSealer::GenerateSealerId(SealingRootType type,
                                                 const std::string &name) {
   std::string serialized;
@@ -102,6 +102,42 @@ class SecretSealer {
                         const SealedSecretHeader &new_header,
                         SealedSecret *new_sealed_secret);
 
+  /// Seals several secrets under a single header.
+  ///
+  /// Each secret is sealed with its own IV, and is bound to the header and to
+  /// its own additional authenticated data exactly as it would be by Seal().
+  /// Combining `sealed_batch->sealed_secret_header()` with any one entry
+  /// therefore yields a SealedSecret that Unseal() accepts. The base class
+  /// implements this method by calling Seal() for each secret. A derived class
+  /// of SecretSealer may choose to further optimize this method, for example by
+  /// validating the header and deriving the sealing key only once. An empty
+  /// batch still carries the header, which is validated as for Seal().
+  ///
+  /// \param header The metadata to guide the sealing.
+  /// \param additional_authenticated_data Unencrypted data that is bundled with
+  ///        each sealed secret. Must have the same size as `secrets`.
+  /// \param secrets The data to encrypt and seal.
+  /// \param[out] sealed_batch The output sealed secrets.
+  /// \return A non-OK status if sealing any of the secrets fails.
+  virtual Status SealBatch(
+      const SealedSecretHeader &header,
+      const std::vector<ByteContainerView> &additional_authenticated_data,
+      const std::vector<ByteContainerView> &secrets,
+      SealedSecretBatch *sealed_batch);
+
+  /// Unseals all secrets in `sealed_batch` and writes them to `secrets`, in
+  /// the order of the entries in `sealed_batch`.
+  ///
+  /// The base class implements this method by calling Unseal() for each
+  /// entry. A derived class of SecretSealer may choose to further optimize
+  /// this method.
+  ///
+  /// \param sealed_batch The input secrets to unseal.
+  /// \param[out] secrets The destination for the unsealed secrets.
+  /// \return A non-OK Status if unsealing any of the secrets fails.
+  virtual Status UnsealBatch(const SealedSecretBatch &sealed_batch,
+                             std::vector<CleansingVector<uint8_t>> *secrets);
+
   /// Combines the specified sealing root type and sealing root name
   /// to form a string. The combined string uniquely identifies the SecretSealer
   /// responsible for handling secrets associated with the particular
@@ -18,6 +18,7 @@
 
 #include "asylo/identity/sgx/code_identity_util.h"
 
+#include <openssl/cipher.h>
 #include <openssl/cmac.h>
 #include <string>
 
@@ -400,5 +401,82 @@ Status VerifyHardwareReport(const Report &report) {
   return Status::OkStatus();
 }
 
+constexpr size_t CachingReportVerifier::kDefaultCapacity;
+
+CachingReportVerifier::CachingReportVerifier(size_t capacity)
+    : capacity_(capacity > 0 ? capacity : 1), use_count_(0) {}
+
+Status CachingReportVerifier::Verify(const Report &report) {
+  absl::MutexLock lock(&mu_);
+  StatusOr<Entry *> entry_result = GetEntry(report.keyid);
+  if (!entry_result.ok()) {
+    return entry_result.status();
+  }
+  CMAC_CTX *cmac_context = entry_result.ValueOrDie()->cmac_context.get();
+
+  // As in VerifyHardwareReport(), the KEYID and MAC fields are not included
+  // in the MAC computation.
+  SafeBytes<sizeof(report.mac)> actual_mac;
+  size_t mac_size;
+  if (CMAC_Reset(cmac_context) != 1 ||
+      CMAC_Update(cmac_context, reinterpret_cast<const uint8_t *>(&report),
+                  offsetof(Report, keyid)) != 1 ||
+      CMAC_Final(cmac_context, actual_mac.data(), &mac_size) != 1 ||
+      mac_size != actual_mac.size()) {
+    return Status(
+        error::GoogleError::INTERNAL,
+        absl::StrCat("CMAC computation failed: ", BsslLastErrorString()));
+  }
+
+  // Inequality operator on a SafeBytes object performs a constant-time
+  // comparison, which is required for MAC verification.
+  if (actual_mac != report.mac) {
+    return Status(error::GoogleError::INTERNAL, "MAC verification failed");
+  }
+  return Status::OkStatus();
+}
+
+size_t CachingReportVerifier::CachedKeyCount() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+StatusOr<CachingReportVerifier::Entry *> CachingReportVerifier::GetEntry(
+    const UnsafeBytes<kKeyrequestKeyidSize> &keyid) {
+  auto lru_it = entries_.begin();
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->keyid == keyid) {
+      it->last_use = ++use_count_;
+      return &*it;
+    }
+    if (it->last_use < lru_it->last_use) {
+      lru_it = it;
+    }
+  }
+
+  AlignedHardwareKeyPtr report_key;
+  Status status = GetReportKey(keyid, report_key.get());
+  if (!status.ok()) {
+    return status;
+  }
+
+  bssl::UniquePtr<CMAC_CTX> cmac_context(CMAC_CTX_new());
+  if (!cmac_context ||
+      CMAC_Init(cmac_context.get(), report_key->data(), report_key->size(),
+                EVP_aes_128_cbc(), /*engine=*/nullptr) != 1) {
+    return Status(
+        error::GoogleError::INTERNAL,
+        absl::StrCat("CMAC initialization failed: ", BsslLastErrorString()));
+  }
+
+  // Freeing a CMAC context cleanses the key material it holds, so evicting an
+  // entry is sufficient to erase its key.
+  if (entries_.size() >= capacity_) {
+    entries_.erase(lru_it);
+  }
+  entries_.push_back(Entry{keyid, std::move(cmac_context), ++use_count_});
+  return &entries_.back();
+}
+
 }  // namespace sgx
 }  // namespace asylo
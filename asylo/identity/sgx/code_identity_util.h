@@ -19,6 +19,11 @@
 #ifndef ASYLO_IDENTITY_SGX_CODE_IDENTITY_UTIL_H_
 #define ASYLO_IDENTITY_SGX_CODE_IDENTITY_UTIL_H_
 
+#include <openssl/cmac.h>
+#include <cstdint>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
 #include "asylo/identity/identity.pb.h"
 #include "asylo/identity/sgx/code_identity.pb.h"
 #include "asylo/identity/sgx/code_identity_constants.h"
@@ -128,6 +133,61 @@ void SetTargetinfoFromSelfIdentity(Targetinfo *tinfo);
 // Verifies the hardware report |report|.
 Status VerifyHardwareReport(const Report &report);
 
+// CachingReportVerifier verifies hardware reports in the same way as
+// VerifyHardwareReport(), but caches the REPORT key for each KEYID it has seen
+// in the form of an initialized CMAC context. Verifying a report whose KEYID is
+// cached neither fetches the REPORT key from the hardware nor re-runs the AES
+// key schedule.
+//
+// At most |capacity| keys are cached. When the cache is full, the
+// least-recently-used key is evicted. Cached key material is cleansed when it
+// is evicted and when the verifier is destroyed.
+//
+// The REPORT key for a KEYID depends on the identity of the enclave that
+// requests it, so a CachingReportVerifier must not be shared between enclaves.
+//
+// This class is thread-safe.
+class CachingReportVerifier {
+ public:
+  // The default number of cached REPORT keys. The KEYID of reports generated on
+  // a platform rarely changes, so a small cache suffices.
+  static constexpr size_t kDefaultCapacity = 4;
+
+  explicit CachingReportVerifier(size_t capacity = kDefaultCapacity);
+
+  CachingReportVerifier(const CachingReportVerifier &other) = delete;
+  CachingReportVerifier &operator=(const CachingReportVerifier &other) = delete;
+
+  // Verifies the hardware report |report|.
+  Status Verify(const Report &report) LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of REPORT keys that are currently cached.
+  size_t CachedKeyCount() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  // A cached REPORT key.
+  struct Entry {
+    UnsafeBytes<kKeyrequestKeyidSize> keyid;
+
+    // A CMAC context initialized with the REPORT key for |keyid|.
+    bssl::UniquePtr<CMAC_CTX> cmac_context;
+
+    // The value of use_count_ when this entry was last used.
+    uint64_t last_use;
+  };
+
+  // Returns the cache entry for |keyid|, fetching the REPORT key and adding a
+  // new entry if necessary.
+  StatusOr<Entry *> GetEntry(const UnsafeBytes<kKeyrequestKeyidSize> &keyid)
+      EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const size_t capacity_;
+
+  mutable absl::Mutex mu_;
+  std::vector<Entry> entries_ GUARDED_BY(mu_);
+  uint64_t use_count_ GUARDED_BY(mu_);
+};
+
 namespace internal {
 
 // Verifies whether |identity| is compatible with |spec|. This function is
@@ -915,6 +915,89 @@ TEST_F(CodeIdentityUtilTest, VerifyHardwareReportBadReport) {
   EXPECT_THAT(VerifyHardwareReport(*report), Not(IsOk()));
 }
 
+TEST_F(CodeIdentityUtilTest, CachingReportVerifierPositive) {
+  AlignedTargetinfoPtr tinfo;
+  SetTargetinfoFromSelfIdentity(tinfo.get());
+
+  CachingReportVerifier verifier;
+  for (int i = 0; i < 3; ++i) {
+    AlignedReportPtr report;
+    AlignedReportdataPtr data;
+    *data = TrivialRandomObject<Reportdata>();
+    ASSERT_TRUE(GetHardwareReport(*tinfo, *data, report.get()));
+    EXPECT_THAT(verifier.Verify(*report), IsOk());
+  }
+
+  // All reports share the enclave's KEYID, so only one key is cached.
+  EXPECT_EQ(verifier.CachedKeyCount(), 1);
+}
+
+TEST_F(CodeIdentityUtilTest, CachingReportVerifierWrongTarget) {
+  AlignedTargetinfoPtr tinfo;
+  AlignedReportPtr report;
+  AlignedReportdataPtr data;
+  *data = TrivialRandomObject<Reportdata>();
+  CachingReportVerifier verifier;
+
+  // Verify a valid report first so that the REPORT key is cached.
+  SetTargetinfoFromSelfIdentity(tinfo.get());
+  ASSERT_TRUE(GetHardwareReport(*tinfo, *data, report.get()));
+  ASSERT_THAT(verifier.Verify(*report), IsOk());
+
+  // Verify that corrupting MEASUREMENT results in an unverifiable report.
+  tinfo->measurement[0] ^= 0xFFFF;
+  ASSERT_TRUE(GetHardwareReport(*tinfo, *data, report.get()));
+  EXPECT_THAT(verifier.Verify(*report), Not(IsOk()));
+}
+
+TEST_F(CodeIdentityUtilTest, CachingReportVerifierBadReport) {
+  AlignedTargetinfoPtr tinfo;
+  SetTargetinfoFromSelfIdentity(tinfo.get());
+
+  AlignedReportPtr report;
+  AlignedReportdataPtr data;
+  *data = TrivialRandomObject<Reportdata>();
+  ASSERT_TRUE(GetHardwareReport(*tinfo, *data, report.get()));
+  CachingReportVerifier verifier;
+  ASSERT_THAT(verifier.Verify(*report), IsOk());
+
+  // Corrupt the REPORT by flipping the first byte of MRENCLAVE.
+  report->mrenclave[0] ^= 0xFFFF;
+  EXPECT_THAT(verifier.Verify(*report), Not(IsOk()));
+}
+
+TEST_F(CodeIdentityUtilTest, CachingReportVerifierEvictsKeys) {
+  constexpr size_t kCapacity = 2;
+  constexpr int kNumKeyids = 4;
+
+  AlignedTargetinfoPtr tinfo;
+  SetTargetinfoFromSelfIdentity(tinfo.get());
+
+  FakeEnclave *current_enclave = FakeEnclave::GetCurrentEnclave();
+  const UnsafeBytes<kReportKeyidSize> original_keyid =
+      current_enclave->get_report_keyid();
+
+  CachingReportVerifier verifier(kCapacity);
+  std::vector<AlignedReportPtr> reports(kNumKeyids);
+  for (int i = 0; i < kNumKeyids; ++i) {
+    current_enclave->set_report_keyid(
+        TrivialRandomObject<UnsafeBytes<kReportKeyidSize>>());
+    AlignedReportdataPtr data;
+    *data = TrivialRandomObject<Reportdata>();
+    ASSERT_TRUE(GetHardwareReport(*tinfo, *data, reports[i].get()));
+    EXPECT_THAT(verifier.Verify(*reports[i]), IsOk());
+    EXPECT_LE(verifier.CachedKeyCount(), kCapacity);
+  }
+
+  // Reports whose keys were evicted can still be verified.
+  for (const AlignedReportPtr &report : reports) {
+    EXPECT_THAT(verifier.Verify(*report), IsOk());
+  }
+  EXPECT_EQ(verifier.CachedKeyCount(), kCapacity);
+
+  current_enclave->set_report_keyid(original_keyid);
+}
+
 }  // namespace
 }  // namespace sgx
 }  // namespace asylo
@@ -39,6 +39,28 @@ namespace internal {
 
 const char *const kSgxLocalSecretSealerRootName = "SGX";
 
+namespace {
+
+// Populates all fields of |req| except KEYID, which GenerateCryptorKey() sets
+// separately for each hardware subkey.
+void PopulateKeyrequest(const UnsafeBytes<kCpusvnSize> &cpusvn,
+                        const CodeIdentityExpectation &sgx_expectation,
+                        Keyrequest *req) {
+  req->keyname = KeyrequestKeyname::SEAL_KEY;
+  req->keypolicy = ConvertMatchSpecToKeypolicy(sgx_expectation.match_spec());
+  req->isvsvn =
+      sgx_expectation.reference_identity().signer_assigned_identity().isvsvn();
+  req->reserved1.fill(0);
+  req->cpusvn = cpusvn;
+  ConvertSecsAttributeRepresentation(
+      sgx_expectation.match_spec().attributes_match_mask(),
+      &req->attributemask);
+  req->miscmask = sgx_expectation.match_spec().miscselect_match_mask();
+  req->reserved2.fill(0);
+}
+
+}  // namespace
+
 Status ParseKeyGenerationParamsFromSealedSecretHeader(
     const SealedSecretHeader &header, UnsafeBytes<kCpusvnSize> *cpusvn,
     CipherSuite *cipher_suite, CodeIdentityExpectation *sgx_expectation) {
@@ -100,6 +122,18 @@ uint16_t ConvertMatchSpecToKeypolicy(const CodeIdentityMatchSpec &spec) {
   return policy;
 }
 
+std::string GetKeyGenerationParamsId(
+    CipherSuite cipher_suite, const UnsafeBytes<kCpusvnSize> &cpusvn,
+    const CodeIdentityExpectation &sgx_expectation) {
+  AlignedKeyrequestPtr req;
+  PopulateKeyrequest(cpusvn, sgx_expectation, req.get());
+  req->keyid.fill(0);
+
+  std::string id = CipherSuite_Name(cipher_suite);
+  id.append(reinterpret_cast<const char *>(req.get()), sizeof(Keyrequest));
+  return id;
+}
+
 Status GenerateCryptorKey(CipherSuite cipher_suite, const std::string &key_id,
                           const UnsafeBytes<kCpusvnSize> &cpusvn,
                           const CodeIdentityExpectation &sgx_expectation,
@@ -115,18 +149,8 @@ Status GenerateCryptorKey(CipherSuite cipher_suite, const std::string &key_id,
 
   // Create and populate an aligned KEYREQUEST structure.
   AlignedKeyrequestPtr req;
-  req->keyname = KeyrequestKeyname::SEAL_KEY;
-  req->keypolicy = ConvertMatchSpecToKeypolicy(sgx_expectation.match_spec());
-  req->isvsvn =
-      sgx_expectation.reference_identity().signer_assigned_identity().isvsvn();
-  req->reserved1.fill(0);
-  req->cpusvn = cpusvn;
-  ConvertSecsAttributeRepresentation(
-      sgx_expectation.match_spec().attributes_match_mask(),
-      &req->attributemask);
   // req->keyid is populated uniquely on each call to GetHardwareKey().
-  req->miscmask = sgx_expectation.match_spec().miscselect_match_mask();
-  req->reserved2.fill(0);
+  PopulateKeyrequest(cpusvn, sgx_expectation, req.get());
 
   // The |req->keyid| field is populated to uniquely identify each of the
   // hardware subkeys. This is done by constructing a sub-key-specific
@@ -19,6 +19,8 @@
 #ifndef ASYLO_IDENTITY_SGX_LOCAL_SECRET_SEALER_HELPERS_H_
 #define ASYLO_IDENTITY_SGX_LOCAL_SECRET_SEALER_HELPERS_H_
 
+#include <string>
+
 #include "asylo/crypto/util/bytes.h"
 #include "asylo/identity/sealed_secret.pb.h"
 #include "asylo/identity/sgx/code_identity.pb.h"
@@ -42,6 +44,15 @@ Status ParseKeyGenerationParamsFromSealedSecretHeader(
 // Converts |spec| to the KEYPOLICY bit vector defined in the Intel SDM.
 uint16_t ConvertMatchSpecToKeypolicy(const CodeIdentityMatchSpec &spec);
 
+// Returns a string that identifies the KEYREQUEST fields that
+// GenerateCryptorKey() derives from |cipher_suite|, |cpusvn|, and
+// |sgx_expectation|. Calls to GenerateCryptorKey() with the same key_id and
+// key_size, and whose parameters map to the same string, produce the same key.
+// The returned string contains no secret material.
+std::string GetKeyGenerationParamsId(
+    CipherSuite cipher_suite, const UnsafeBytes<kCpusvnSize> &cpusvn,
+    const CodeIdentityExpectation &sgx_expectation);
+
 // Generates the key used by the AEAD Cryptor to perform the Seal or the Open
 // operation.
 Status GenerateCryptorKey(CipherSuite cipher_suite, const std::string &key_id,
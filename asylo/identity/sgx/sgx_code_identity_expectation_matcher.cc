@@ -18,9 +18,29 @@
 
 #include "asylo/identity/sgx/sgx_code_identity_expectation_matcher.h"
 
+#include "absl/memory/memory.h"
+#include "asylo/identity/sgx/code_identity.pb.h"
 #include "asylo/identity/sgx/code_identity_util.h"
 
 namespace asylo {
+namespace {
+
+// An SGX code identity parsed by SgxCodeIdentityExpectationMatcher.
+class SgxParsedIdentity
+    : public NamedIdentityExpectationMatcher::ParsedIdentity {
+ public:
+  sgx::CodeIdentity code_identity;
+};
+
+// An SGX code-identity expectation parsed by
+// SgxCodeIdentityExpectationMatcher.
+class SgxParsedExpectation
+    : public NamedIdentityExpectationMatcher::ParsedExpectation {
+ public:
+  sgx::CodeIdentityExpectation code_identity_expectation;
+};
+
+}  // namespace
 
 StatusOr<bool> SgxCodeIdentityExpectationMatcher::Match(
     const EnclaveIdentity &identity,
@@ -44,6 +64,39 @@ StatusOr<bool> SgxCodeIdentityExpectationMatcher::Match(
                                          code_identity_expectation);
 }
 
+StatusOr<std::unique_ptr<NamedIdentityExpectationMatcher::ParsedIdentity>>
+SgxCodeIdentityExpectationMatcher::ParseIdentity(
+    const EnclaveIdentity &identity) const {
+  auto parsed_identity = absl::make_unique<SgxParsedIdentity>();
+  Status status =
+      sgx::ParseSgxIdentity(identity, &parsed_identity->code_identity);
+  if (!status.ok()) {
+    return status;
+  }
+  return std::unique_ptr<ParsedIdentity>(std::move(parsed_identity));
+}
+
+StatusOr<std::unique_ptr<NamedIdentityExpectationMatcher::ParsedExpectation>>
+SgxCodeIdentityExpectationMatcher::ParseExpectation(
+    const EnclaveIdentityExpectation &expectation) const {
+  auto parsed_expectation = absl::make_unique<SgxParsedExpectation>();
+  Status status = sgx::ParseSgxExpectation(
+      expectation, &parsed_expectation->code_identity_expectation);
+  if (!status.ok()) {
+    return status;
+  }
+  return std::unique_ptr<ParsedExpectation>(std::move(parsed_expectation));
+}
+
+StatusOr<bool> SgxCodeIdentityExpectationMatcher::MatchParsed(
+    const ParsedIdentity &identity,
+    const ParsedExpectation &expectation) const {
+  return sgx::MatchIdentityToExpectation(
+      static_cast<const SgxParsedIdentity &>(identity).code_identity,
+      static_cast<const SgxParsedExpectation &>(expectation)
+          .code_identity_expectation);
+}
+
 EnclaveIdentityDescription SgxCodeIdentityExpectationMatcher::Description()
     const {
   EnclaveIdentityDescription description;
@@ -19,6 +19,8 @@
 #ifndef ASYLO_IDENTITY_SGX_SGX_CODE_IDENTITY_EXPECTATION_MATCHER_H_
 #define ASYLO_IDENTITY_SGX_SGX_CODE_IDENTITY_EXPECTATION_MATCHER_H_
 
+#include <memory>
+
 #include "asylo/identity/identity.pb.h"
 #include "asylo/identity/named_identity_expectation_matcher.h"
 
@@ -39,6 +41,17 @@ class SgxCodeIdentityExpectationMatcher final
 
   // From the NamedIdentityExpectationMatcher interface.
   EnclaveIdentityDescription Description() const override;
+
+  // From the NamedIdentityExpectationMatcher interface. These methods parse
+  // the serialized SGX code identity and expectation once, so that repeated
+  // matches only need to run sgx::MatchIdentityToExpectation().
+  StatusOr<std::unique_ptr<ParsedIdentity>> ParseIdentity(
+      const EnclaveIdentity &identity) const override;
+  StatusOr<std::unique_ptr<ParsedExpectation>> ParseExpectation(
+      const EnclaveIdentityExpectation &expectation) const override;
+  StatusOr<bool> MatchParsed(
+      const ParsedIdentity &identity,
+      const ParsedExpectation &expectation) const override;
 };
 
 }  // namespace asylo
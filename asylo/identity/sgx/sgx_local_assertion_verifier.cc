@@ -162,7 +162,7 @@ Status SgxLocalAssertionVerifier::Verify(const std::string &user_data,
   // architecture and was copied into the assertion byte-for-byte, so is safe to
   // restore the REPORT structure directly from the deserialized LocalAssertion.
   report = TrivialObjectFromBinaryString<sgx::Report>(local_assertion.report());
-  Status status = sgx::VerifyHardwareReport(report);
+  Status status = report_verifier_.Verify(report);
   if (!status.ok()) {
     return status;
   }
@@ -22,6 +22,7 @@
 #include "asylo/identity/enclave_assertion_verifier.h"
 
 #include "absl/synchronization/mutex.h"
+#include "asylo/identity/sgx/code_identity_util.h"
 
 namespace asylo {
 
@@ -76,6 +77,10 @@ class SgxLocalAssertionVerifier final : public EnclaveAssertionVerifier {
 
   // A mutex that guards the initialized_ member.
   mutable absl::Mutex initialized_mu_;
+
+  // Verifies the hardware REPORTs in incoming assertions. Caches REPORT keys so
+  // that verifying an assertion does not require an EGETKEY in the common case.
+  mutable sgx::CachingReportVerifier report_verifier_;
 };
 
 }  // namespace asylo
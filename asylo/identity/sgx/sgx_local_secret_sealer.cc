@@ -19,6 +19,7 @@
 #include "asylo/identity/sgx/sgx_local_secret_sealer.h"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -37,8 +38,10 @@ namespace asylo {
 
 constexpr size_t kAes256GcmSivKeySize = 32;
 
-std::unique_ptr<SgxLocalSecretSealer>
-SgxLocalSecretSealer::CreateMrenclaveSecretSealer() {
+namespace {
+
+// Returns an expectation that matches the MRENCLAVE of the current enclave.
+sgx::CodeIdentityExpectation MrenclaveExpectation() {
   sgx::CodeIdentityMatchSpec spec;
   sgx::SetDefaultMatchSpec(&spec);
 
@@ -49,25 +52,51 @@ SgxLocalSecretSealer::CreateMrenclaveSecretSealer() {
   spec.set_is_mrsigner_match_required(false);
   sgx::CodeIdentityExpectation expectation;
   sgx::SetExpectation(spec, sgx::GetSelfIdentity()->identity, &expectation);
-  return absl::WrapUnique<SgxLocalSecretSealer>(
-      new SgxLocalSecretSealer(expectation));
+  return expectation;
 }
 
-std::unique_ptr<SgxLocalSecretSealer>
-SgxLocalSecretSealer::CreateMrsignerSecretSealer() {
+// Returns an expectation that matches the MRSIGNER of the current enclave.
+sgx::CodeIdentityExpectation MrsignerExpectation() {
   sgx::CodeIdentityMatchSpec spec;
   sgx::SetDefaultMatchSpec(&spec);
   sgx::CodeIdentityExpectation expectation;
   sgx::SetExpectation(spec, sgx::GetSelfIdentity()->identity, &expectation);
+  return expectation;
+}
+
+}  // namespace
+
+constexpr size_t SgxLocalSecretSealer::kMaxCachedKeys;
+
+std::unique_ptr<SgxLocalSecretSealer>
+SgxLocalSecretSealer::CreateMrenclaveSecretSealer() {
+  return absl::WrapUnique<SgxLocalSecretSealer>(
+      new SgxLocalSecretSealer(MrenclaveExpectation(), /*max_cached_keys=*/0));
+}
+
+std::unique_ptr<SgxLocalSecretSealer>
+SgxLocalSecretSealer::CreateMrsignerSecretSealer() {
+  return absl::WrapUnique<SgxLocalSecretSealer>(
+      new SgxLocalSecretSealer(MrsignerExpectation(), /*max_cached_keys=*/0));
+}
+
+std::unique_ptr<SgxLocalSecretSealer>
+SgxLocalSecretSealer::CreateCachingMrenclaveSecretSealer() {
   return absl::WrapUnique<SgxLocalSecretSealer>(
-      new SgxLocalSecretSealer(expectation));
+      new SgxLocalSecretSealer(MrenclaveExpectation(), kMaxCachedKeys));
+}
+
+std::unique_ptr<SgxLocalSecretSealer>
+SgxLocalSecretSealer::CreateCachingMrsignerSecretSealer() {
+  return absl::WrapUnique<SgxLocalSecretSealer>(
+      new SgxLocalSecretSealer(MrsignerExpectation(), kMaxCachedKeys));
 }
 
 SgxLocalSecretSealer::SgxLocalSecretSealer(
-    const sgx::CodeIdentityExpectation &default_client_acl)
-    : cryptor_{new AesGcmSivCryptor(kMaxAesGcmSivMessageSize,
-                                    new AesGcmSivNonceGenerator())},
-      default_client_acl_{default_client_acl} {}
+    const sgx::CodeIdentityExpectation &default_client_acl,
+    size_t max_cached_keys)
+    : default_client_acl_{default_client_acl},
+      max_cached_keys_{max_cached_keys} {}
 
 SealingRootType SgxLocalSecretSealer::RootType() const { return LOCAL; }
 
@@ -133,17 +162,15 @@ Status SgxLocalSecretSealer::Seal(
                                        additional_authenticated_data};
   SerializeByteContainers(views, &final_additional_data);
 
-  CleansingVector<uint8_t> key;
-  status = sgx::internal::GenerateCryptorKey(cipher_suite, "default_key_id",
-                                             cpusvn, sgx_expectation,
-                                             kAes256GcmSivKeySize, &key);
-  if (!status.ok()) {
-    return status;
+  StatusOr<std::shared_ptr<const AesGcmSivKeyedCryptor>> cryptor_result =
+      GetCryptor(cipher_suite, cpusvn, sgx_expectation);
+  if (!cryptor_result.ok()) {
+    return cryptor_result.status();
   }
 
-  return cryptor_->Seal(key, final_additional_data, secret,
-                        sealed_secret->mutable_iv(),
-                        sealed_secret->mutable_secret_ciphertext());
+  return cryptor_result.ValueOrDie()->Seal(
+      final_additional_data, secret, sealed_secret->mutable_iv(),
+      sealed_secret->mutable_secret_ciphertext());
 }
 
 Status SgxLocalSecretSealer::Unseal(const SealedSecret &sealed_secret,
@@ -169,17 +196,176 @@ Status SgxLocalSecretSealer::Unseal(const SealedSecret &sealed_secret,
       sealed_secret.additional_authenticated_data()};
   SerializeByteContainers(views, &final_additional_data);
 
+  StatusOr<std::shared_ptr<const AesGcmSivKeyedCryptor>> cryptor_result =
+      GetCryptor(cipher_suite, cpusvn, sgx_expectation);
+  if (!cryptor_result.ok()) {
+    return cryptor_result.status();
+  }
+
+  return cryptor_result.ValueOrDie()->Open(final_additional_data,
+                                           sealed_secret.secret_ciphertext(),
+                                           sealed_secret.iv(), secret);
+}
+
+Status SgxLocalSecretSealer::SealBatch(
+    const SealedSecretHeader &header,
+    const std::vector<ByteContainerView> &additional_authenticated_data,
+    const std::vector<ByteContainerView> &secrets,
+    SealedSecretBatch *sealed_batch) {
+  if (additional_authenticated_data.size() != secrets.size()) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "Number of additional authenticated data items does not "
+                  "match the number of secrets");
+  }
+
+  UnsafeBytes<sgx::kCpusvnSize> cpusvn;
+  sgx::CipherSuite cipher_suite;
+  sgx::CodeIdentityExpectation sgx_expectation;
+  Status status = sgx::internal::ParseKeyGenerationParamsFromSealedSecretHeader(
+      header, &cpusvn, &cipher_suite, &sgx_expectation);
+  if (!status.ok()) {
+    return status;
+  }
+
+  StatusOr<std::shared_ptr<const AesGcmSivKeyedCryptor>> cryptor_result =
+      GetCryptor(cipher_suite, cpusvn, sgx_expectation);
+  if (!cryptor_result.ok()) {
+    return cryptor_result.status();
+  }
+  const AesGcmSivKeyedCryptor &cryptor = *cryptor_result.ValueOrDie();
+
+  sealed_batch->Clear();
+  if (!header.SerializeToString(sealed_batch->mutable_sealed_secret_header())) {
+    return Status(error::GoogleError::INTERNAL,
+                  "Header serialization to std::string failed");
+  }
+  sealed_batch->mutable_entries()->Reserve(secrets.size());
+
+  // Each secret is bound to the header and its own additional authenticated
+  // data exactly as in Seal(), so that every entry can also be unsealed
+  // individually.
+  std::string final_additional_data;
+  for (size_t i = 0; i < secrets.size(); ++i) {
+    SealedSecretBatch::Entry *entry = sealed_batch->add_entries();
+    entry->set_additional_authenticated_data(
+        reinterpret_cast<const char *>(additional_authenticated_data[i].data()),
+        additional_authenticated_data[i].size());
+
+    std::vector<ByteContainerView> views{sealed_batch->sealed_secret_header(),
+                                         additional_authenticated_data[i]};
+    status = SerializeByteContainers(views, &final_additional_data);
+    if (!status.ok()) {
+      sealed_batch->Clear();
+      return status;
+    }
+
+    status = cryptor.Seal(final_additional_data, secrets[i],
+                          entry->mutable_iv(),
+                          entry->mutable_secret_ciphertext());
+    if (!status.ok()) {
+      sealed_batch->Clear();
+      return status;
+    }
+  }
+  return Status::OkStatus();
+}
+
+Status SgxLocalSecretSealer::UnsealBatch(
+    const SealedSecretBatch &sealed_batch,
+    std::vector<CleansingVector<uint8_t>> *secrets) {
+  SealedSecretHeader header;
+  if (!header.ParseFromString(sealed_batch.sealed_secret_header())) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "Could not parse the sealed secret header");
+  }
+
+  UnsafeBytes<sgx::kCpusvnSize> cpusvn;
+  sgx::CipherSuite cipher_suite;
+  sgx::CodeIdentityExpectation sgx_expectation;
+  Status status = sgx::internal::ParseKeyGenerationParamsFromSealedSecretHeader(
+      header, &cpusvn, &cipher_suite, &sgx_expectation);
+  if (!status.ok()) {
+    return status;
+  }
+
+  StatusOr<std::shared_ptr<const AesGcmSivKeyedCryptor>> cryptor_result =
+      GetCryptor(cipher_suite, cpusvn, sgx_expectation);
+  if (!cryptor_result.ok()) {
+    return cryptor_result.status();
+  }
+  const AesGcmSivKeyedCryptor &cryptor = *cryptor_result.ValueOrDie();
+
+  secrets->resize(sealed_batch.entries_size());
+  std::string final_additional_data;
+  for (int i = 0; i < sealed_batch.entries_size(); ++i) {
+    const SealedSecretBatch::Entry &entry = sealed_batch.entries(i);
+
+    std::vector<ByteContainerView> views{
+        sealed_batch.sealed_secret_header(),
+        entry.additional_authenticated_data()};
+    status = SerializeByteContainers(views, &final_additional_data);
+    if (status.ok()) {
+      status = cryptor.Open(final_additional_data, entry.secret_ciphertext(),
+                            entry.iv(), &(*secrets)[i]);
+    }
+    if (!status.ok()) {
+      secrets->clear();
+      return status;
+    }
+  }
+  return Status::OkStatus();
+}
+
+StatusOr<std::shared_ptr<const AesGcmSivKeyedCryptor>>
+SgxLocalSecretSealer::GetCryptor(
+    sgx::CipherSuite cipher_suite, const UnsafeBytes<sgx::kCpusvnSize> &cpusvn,
+    const sgx::CodeIdentityExpectation &sgx_expectation) {
+  std::string params_id;
+  if (max_cached_keys_ > 0) {
+    params_id = sgx::internal::GetKeyGenerationParamsId(cipher_suite, cpusvn,
+                                                        sgx_expectation);
+    absl::MutexLock lock(&cryptors_mu_);
+    auto it = cryptor_index_.find(params_id);
+    if (it != cryptor_index_.end()) {
+      cryptors_.splice(cryptors_.begin(), cryptors_, it->second);
+      return it->second->cryptor;
+    }
+  }
+
+  // Derive the key outside the lock. If two threads race to derive the same
+  // key, both derive it and the first one to finish populates the cache.
   CleansingVector<uint8_t> key;
-  status = sgx::internal::GenerateCryptorKey(cipher_suite, "default_key_id",
-                                             cpusvn, sgx_expectation,
-                                             kAes256GcmSivKeySize, &key);
+  Status status = sgx::internal::GenerateCryptorKey(
+      cipher_suite, "default_key_id", cpusvn, sgx_expectation,
+      kAes256GcmSivKeySize, &key);
   if (!status.ok()) {
     return status;
   }
+  StatusOr<std::unique_ptr<AesGcmSivKeyedCryptor>> create_result =
+      AesGcmSivKeyedCryptor::Create(key, kMaxAesGcmSivMessageSize,
+                                    new AesGcmSivNonceGenerator());
+  if (!create_result.ok()) {
+    return create_result.status();
+  }
+  std::shared_ptr<const AesGcmSivKeyedCryptor> cryptor =
+      std::move(create_result).ValueOrDie();
+  if (max_cached_keys_ == 0) {
+    return cryptor;
+  }
 
-  return cryptor_->Open(key, final_additional_data,
-                        sealed_secret.secret_ciphertext(), sealed_secret.iv(),
-                        secret);
+  absl::MutexLock lock(&cryptors_mu_);
+  auto it = cryptor_index_.find(params_id);
+  if (it != cryptor_index_.end()) {
+    cryptors_.splice(cryptors_.begin(), cryptors_, it->second);
+    return it->second->cryptor;
+  }
+  if (cryptors_.size() >= max_cached_keys_) {
+    cryptor_index_.erase(cryptors_.back().params_id);
+    cryptors_.pop_back();
+  }
+  cryptors_.push_front({std::move(params_id), cryptor});
+  cryptor_index_.emplace(cryptors_.front().params_id, cryptors_.begin());
+  return cryptor;
 }
 
 }  // namespace asylo
@@ -19,17 +19,28 @@
 #ifndef ASYLO_IDENTITY_SGX_SGX_LOCAL_SECRET_SEALER_H_
 #define ASYLO_IDENTITY_SGX_SGX_LOCAL_SECRET_SEALER_H_
 
+#include <list>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 #include "asylo/crypto/aes_gcm_siv.h"
 #include "asylo/crypto/util/byte_container_view.h"
+#include "asylo/crypto/util/bytes.h"
 #include "asylo/identity/identity.pb.h"
+#include "asylo/identity/sealed_secret.pb.h"
 #include "asylo/identity/secret_sealer.h"
 #include "asylo/identity/sgx/code_identity.pb.h"
+#include "asylo/identity/sgx/identity_key_management_structs.h"
+#include "asylo/identity/sgx/local_sealed_secret.pb.h"
 #include "asylo/identity/util/bit_vector_128.pb.h"
 #include "asylo/identity/util/sha256_hash.pb.h"
 #include "asylo/util/cleansing_types.h"
 #include "asylo/util/status.h"
+#include "asylo/util/statusor.h"
 
 namespace asylo {
 
@@ -109,6 +120,21 @@ namespace asylo {
 /// generated default header. A sealer in either MRENCLAVE or MRSIGNER
 /// configuration can unseal secrets that are sealed by a sealer in either
 /// configuration.
+///
+/// By default, the sealer derives a fresh sealing key from the hardware for
+/// every Seal() and Unseal() call. Sealers that are created by the
+/// CreateCaching*SecretSealer() factory methods instead keep the keys they
+/// derive, along with the AEAD state initialized from them, and reuse them for
+/// subsequent calls whose headers request the same key. This makes sealing many
+/// small secrets considerably cheaper. A caching sealer keeps at most 16 keys,
+/// and evicts the least recently used key when it needs room for another.
+/// Cached keys are cleansed when they are evicted or when the sealer is
+/// destroyed.
+///
+/// Independent of caching, SealBatch() and UnsealBatch() validate the shared
+/// header and derive the sealing key once for the entire batch.
+class SgxLocalSecretSealerForTest;
+
 class SgxLocalSecretSealer : public SecretSealer {
  public:
   /// Creates an SgxLocalSecretSealer that seals secrets to the MRENCLAVE part
@@ -123,6 +149,20 @@ class SgxLocalSecretSealer : public SecretSealer {
   /// \return A smart pointer that owns the created sealer.
   static std::unique_ptr<SgxLocalSecretSealer> CreateMrsignerSecretSealer();
 
+  /// Creates an SgxLocalSecretSealer that seals secrets to the MRENCLAVE part
+  /// of the enclave code identity and caches the sealing keys it derives.
+  ///
+  /// \return A smart pointer that owns the created sealer.
+  static std::unique_ptr<SgxLocalSecretSealer>
+  CreateCachingMrenclaveSecretSealer();
+
+  /// Creates an SgxLocalSecretSealer that seals secrets to the MRSIGNER part of
+  /// the enclave identity and caches the sealing keys it derives.
+  ///
+  /// \return A smart pointer that owns the created sealer.
+  static std::unique_ptr<SgxLocalSecretSealer>
+  CreateCachingMrsignerSecretSealer();
+
   SgxLocalSecretSealer(const SgxLocalSecretSealer &other) = delete;
   virtual ~SgxLocalSecretSealer() = default;
 
@@ -138,8 +178,25 @@ class SgxLocalSecretSealer : public SecretSealer {
               ByteContainerView secret, SealedSecret *sealed_secret) override;
   Status Unseal(const SealedSecret &sealed_secret,
                 CleansingVector<uint8_t> *secret) override;
+  Status SealBatch(
+      const SealedSecretHeader &header,
+      const std::vector<ByteContainerView> &additional_authenticated_data,
+      const std::vector<ByteContainerView> &secrets,
+      SealedSecretBatch *sealed_batch) override;
+  Status UnsealBatch(const SealedSecretBatch &sealed_batch,
+                     std::vector<CleansingVector<uint8_t>> *secrets) override;
 
  private:
+  friend class SgxLocalSecretSealerForTest;
+
+  // A cached cryptor and the identifier of the key it is keyed with.
+  struct CachedCryptor {
+    std::string params_id;
+    std::shared_ptr<const AesGcmSivKeyedCryptor> cryptor;
+  };
+
+  using CachedCryptorList = std::list<CachedCryptor>;
+
   // Maximum size (in bytes) of each protected message (including authenticated
   // data). A protected message may not be larger than 32MB.
   //
@@ -151,15 +208,40 @@ class SgxLocalSecretSealer : public SecretSealer {
   // machine, the key lifetime would reduce to ~256 years.
   static constexpr size_t kMaxAesGcmSivMessageSize = (1 << 25);
 
+  // Maximum number of keys held by a caching sealer. A sealer typically uses a
+  // single key, so this only bounds the memory used by callers that seal with
+  // many different headers.
+  static constexpr size_t kMaxCachedKeys = 16;
+
   // Instantiates LocalSecretSealer that sets client_acl in the default sealed
-  // secret header per |default_client_acl|.
-  SgxLocalSecretSealer(const sgx::CodeIdentityExpectation &default_client_acl);
+  // secret header per |default_client_acl|, and that caches up to
+  // |max_cached_keys| sealing keys.
+  SgxLocalSecretSealer(const sgx::CodeIdentityExpectation &default_client_acl,
+                       size_t max_cached_keys);
 
-  // Cryptor to perform AEAD operations.
-  std::unique_ptr<AesGcmSivCryptor> cryptor_;
+  // Returns a cryptor keyed with the sealing key described by |cipher_suite|,
+  // |cpusvn|, and |sgx_expectation|, deriving the key if it is not cached. When
+  // the cache is full, the least recently used key is evicted.
+  StatusOr<std::shared_ptr<const AesGcmSivKeyedCryptor>> GetCryptor(
+      sgx::CipherSuite cipher_suite,
+      const UnsafeBytes<sgx::kCpusvnSize> &cpusvn,
+      const sgx::CodeIdentityExpectation &sgx_expectation)
+      LOCKS_EXCLUDED(cryptors_mu_);
 
   // The default client ACL for this SecretSealer.
   sgx::CodeIdentityExpectation default_client_acl_;
+
+  // The maximum number of entries in |cryptors_|. Zero disables caching.
+  const size_t max_cached_keys_;
+
+  // Cached cryptors ordered from most to least recently used, and indexed by
+  // the identifier returned by sgx::internal::GetKeyGenerationParamsId().
+  // Cryptors are shared so that an entry can be evicted while another thread is
+  // still using it.
+  absl::Mutex cryptors_mu_;
+  CachedCryptorList cryptors_ GUARDED_BY(cryptors_mu_);
+  std::unordered_map<std::string, CachedCryptorList::iterator> cryptor_index_
+      GUARDED_BY(cryptors_mu_);
 };
 
 }  // namespace asylo
@@ -19,10 +19,15 @@
 #include "asylo/identity/sgx/sgx_local_secret_sealer.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "asylo/crypto/util/byte_container_view.h"
 #include "asylo/crypto/util/bytes.h"
 #include "asylo/crypto/util/trivial_object_util.h"
 #include "asylo/identity/identity.pb.h"
@@ -40,6 +45,38 @@
 #include "asylo/util/statusor.h"
 
 namespace asylo {
+
+// Exposes the key cache of SgxLocalSecretSealer for testing.
+class SgxLocalSecretSealerForTest {
+ public:
+  static constexpr size_t kMaxCachedKeys = SgxLocalSecretSealer::kMaxCachedKeys;
+
+  // Returns the number of keys cached by |sealer|.
+  static size_t NumCachedKeys(SgxLocalSecretSealer *sealer) {
+    absl::MutexLock lock(&sealer->cryptors_mu_);
+    return sealer->cryptor_index_.size();
+  }
+
+  // Returns true if |sealer| caches the key requested by |header|.
+  static bool IsKeyCached(SgxLocalSecretSealer *sealer,
+                          const SealedSecretHeader &header) {
+    UnsafeBytes<sgx::kCpusvnSize> cpusvn;
+    sgx::CipherSuite cipher_suite;
+    sgx::CodeIdentityExpectation sgx_expectation;
+    if (!sgx::internal::ParseKeyGenerationParamsFromSealedSecretHeader(
+             header, &cpusvn, &cipher_suite, &sgx_expectation)
+             .ok()) {
+      return false;
+    }
+    std::string params_id = sgx::internal::GetKeyGenerationParamsId(
+        cipher_suite, cpusvn, sgx_expectation);
+    absl::MutexLock lock(&sealer->cryptors_mu_);
+    return sealer->cryptor_index_.count(params_id) > 0;
+  }
+};
+
+constexpr size_t SgxLocalSecretSealerForTest::kMaxCachedKeys;
+
 namespace {
 
 using ::testing::Not;
@@ -102,6 +139,24 @@ class SgxLocalSecretSealerTest : public ::testing::Test {
     header->set_secret_handling_policy(kTestString);
   }
 
+  // Prepares a header that requests a different sealing key for each value of
+  // |index|, by varying the MISCSELECT bits that the key is bound to.
+  void PrepareSealedSecretHeaderForKey(const SgxLocalSecretSealer &sealer,
+                                       uint32_t index,
+                                       SealedSecretHeader *header) {
+    PrepareSealedSecretHeader(sealer, header);
+    sgx::CodeIdentityExpectation expectation;
+    ASSERT_THAT(
+        sgx::ParseSgxExpectation(header->client_acl().expectation(),
+                                 &expectation),
+        IsOk());
+    expectation.mutable_match_spec()->set_miscselect_match_mask(index);
+    ASSERT_THAT(sgx::SerializeSgxExpectation(
+                    expectation,
+                    header->mutable_client_acl()->mutable_expectation()),
+                IsOk());
+  }
+
   std::unique_ptr<sgx::FakeEnclave> enclave_;
   std::unique_ptr<sgx::FakeEnclave> enclave_copy_different_mrenclave_;
   std::unique_ptr<sgx::FakeEnclave> enclave_copy_different_mrsigner_;
@@ -593,5 +648,283 @@ TEST_F(SgxLocalSecretSealerTest,
   EXPECT_THAT(sealer2->Unseal(sealed_secret, &output_secret), Not(IsOk()));
 }
 
+// Verify that a caching sealer can seal and unseal many secrets, and that its
+// output is interchangeable with that of a non-caching sealer.
+TEST_F(SgxLocalSecretSealerTest, CachingSealerInteroperatesWithNonCaching) {
+  constexpr int kNumSecrets = 8;
+
+  std::unique_ptr<SgxLocalSecretSealer> caching_sealer =
+      SgxLocalSecretSealer::CreateCachingMrsignerSecretSealer();
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateMrsignerSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*caching_sealer, &header);
+
+  for (int i = 0; i < kNumSecrets; ++i) {
+    CleansingVector<uint8_t> input_secret(kTestSecretSize + i, i);
+    std::string input_aad(kTestAad);
+
+    SealedSecret sealed_secret;
+    ASSERT_THAT(
+        caching_sealer->Seal(header, input_aad, input_secret, &sealed_secret),
+        IsOk());
+    CleansingVector<uint8_t> output_secret;
+    ASSERT_THAT(sealer->Unseal(sealed_secret, &output_secret), IsOk());
+    EXPECT_EQ(input_secret, output_secret);
+
+    ASSERT_THAT(sealer->Seal(header, input_aad, input_secret, &sealed_secret),
+                IsOk());
+    output_secret.clear();
+    ASSERT_THAT(caching_sealer->Unseal(sealed_secret, &output_secret),
+                IsOk());
+    EXPECT_EQ(input_secret, output_secret);
+  }
+}
+
+// Verify that a caching sealer holds at most kMaxCachedKeys keys, and that it
+// evicts the least recently used key rather than one that is in use.
+TEST_F(SgxLocalSecretSealerTest, CachingSealerEvictsLeastRecentlyUsedKey) {
+  constexpr size_t kMaxCachedKeys = SgxLocalSecretSealerForTest::kMaxCachedKeys;
+  CleansingVector<uint8_t> input_secret(kTestSecret,
+                                        kTestSecret + kTestSecretSize);
+  std::string input_aad(kTestAad);
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateCachingMrenclaveSecretSealer();
+  std::vector<SealedSecretHeader> headers(kMaxCachedKeys + 1);
+  for (size_t i = 0; i < headers.size(); ++i) {
+    PrepareSealedSecretHeaderForKey(*sealer, i, &headers[i]);
+  }
+
+  // Seal with a new key each time, and with the first key in between so that
+  // it stays the most recently used one.
+  SealedSecret sealed_secret;
+  for (size_t i = 1; i < headers.size(); ++i) {
+    ASSERT_THAT(
+        sealer->Seal(headers[0], input_aad, input_secret, &sealed_secret),
+        IsOk());
+    ASSERT_THAT(
+        sealer->Seal(headers[i], input_aad, input_secret, &sealed_secret),
+        IsOk());
+    EXPECT_LE(SgxLocalSecretSealerForTest::NumCachedKeys(sealer.get()),
+              kMaxCachedKeys);
+  }
+
+  EXPECT_EQ(SgxLocalSecretSealerForTest::NumCachedKeys(sealer.get()),
+            kMaxCachedKeys);
+  EXPECT_TRUE(
+      SgxLocalSecretSealerForTest::IsKeyCached(sealer.get(), headers[0]));
+  EXPECT_FALSE(
+      SgxLocalSecretSealerForTest::IsKeyCached(sealer.get(), headers[1]));
+  for (size_t i = 2; i < headers.size(); ++i) {
+    EXPECT_TRUE(
+        SgxLocalSecretSealerForTest::IsKeyCached(sealer.get(), headers[i]));
+  }
+}
+
+// Verify that a caching sealer still rejects tampered sealed secrets once the
+// key is cached.
+TEST_F(SgxLocalSecretSealerTest, CachingSealerRejectsTamperedSecret) {
+  CleansingVector<uint8_t> input_secret(kTestSecret,
+                                        kTestSecret + kTestSecretSize);
+  std::string input_aad(kTestAad);
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateCachingMrenclaveSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*sealer, &header);
+
+  SealedSecret sealed_secret;
+  ASSERT_THAT(sealer->Seal(header, input_aad, input_secret, &sealed_secret),
+              IsOk());
+
+  SealedSecret tampered_secret = sealed_secret;
+  tampered_secret.set_additional_authenticated_data("tampered");
+  CleansingVector<uint8_t> output_secret;
+  EXPECT_THAT(sealer->Unseal(tampered_secret, &output_secret), Not(IsOk()));
+
+  ASSERT_THAT(sealer->Unseal(sealed_secret, &output_secret), IsOk());
+  EXPECT_EQ(input_secret, output_secret);
+}
+
+// Verify that a caching sealer checks the client ACL against the current
+// enclave even when the requested key is already cached.
+TEST_F(SgxLocalSecretSealerTest, CachingSealerEnforcesAclOnCachedKey) {
+  CleansingVector<uint8_t> input_secret(kTestSecret,
+                                        kTestSecret + kTestSecretSize);
+  std::string input_aad(kTestAad);
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateCachingMrenclaveSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*sealer, &header);
+
+  SealedSecret sealed_secret;
+  ASSERT_THAT(sealer->Seal(header, input_aad, input_secret, &sealed_secret),
+              IsOk());
+
+  // Change the current enclave to an enclave with a different MRENCLAVE value.
+  sgx::FakeEnclave::ExitEnclave();
+  sgx::FakeEnclave::EnterEnclave(*enclave_copy_different_mrenclave_);
+
+  CleansingVector<uint8_t> output_secret;
+  EXPECT_THAT(sealer->Unseal(sealed_secret, &output_secret),
+              StatusIs(error::GoogleError::PERMISSION_DENIED));
+}
+
+// Verify that SealBatch() and UnsealBatch() round-trip a batch of secrets, and
+// that each entry in the batch can also be unsealed individually.
+TEST_F(SgxLocalSecretSealerTest, SealBatchUnsealBatchSuccess) {
+  constexpr int kNumSecrets = 16;
+
+  std::vector<CleansingVector<uint8_t>> input_secrets;
+  std::vector<std::string> input_aads;
+  for (int i = 0; i < kNumSecrets; ++i) {
+    input_secrets.emplace_back(kTestSecretSize + i, i);
+    input_aads.emplace_back(absl::StrCat(kTestAad, i));
+  }
+  std::vector<ByteContainerView> secret_views(input_secrets.cbegin(),
+                                              input_secrets.cend());
+  std::vector<ByteContainerView> aad_views(input_aads.cbegin(),
+                                           input_aads.cend());
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateMrsignerSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*sealer, &header);
+
+  SealedSecretBatch sealed_batch;
+  ASSERT_THAT(sealer->SealBatch(header, aad_views, secret_views, &sealed_batch),
+              IsOk());
+  ASSERT_EQ(sealed_batch.entries_size(), kNumSecrets);
+
+  std::vector<CleansingVector<uint8_t>> output_secrets;
+  ASSERT_THAT(sealer->UnsealBatch(sealed_batch, &output_secrets), IsOk());
+  EXPECT_EQ(input_secrets, output_secrets);
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer2 =
+      SgxLocalSecretSealer::CreateCachingMrsignerSecretSealer();
+  for (int i = 0; i < kNumSecrets; ++i) {
+    const SealedSecretBatch::Entry &entry = sealed_batch.entries(i);
+    EXPECT_EQ(entry.additional_authenticated_data(), input_aads[i]);
+
+    SealedSecret sealed_secret;
+    sealed_secret.set_sealed_secret_header(sealed_batch.sealed_secret_header());
+    sealed_secret.set_iv(entry.iv());
+    sealed_secret.set_additional_authenticated_data(
+        entry.additional_authenticated_data());
+    sealed_secret.set_secret_ciphertext(entry.secret_ciphertext());
+
+    CleansingVector<uint8_t> output_secret;
+    ASSERT_THAT(sealer2->Unseal(sealed_secret, &output_secret), IsOk());
+    EXPECT_EQ(input_secrets[i], output_secret);
+  }
+}
+
+// Verify that batches produced by the generic SecretSealer implementation and
+// by the SgxLocalSecretSealer implementation are interchangeable.
+TEST_F(SgxLocalSecretSealerTest, SealBatchMatchesGenericImplementation) {
+  CleansingVector<uint8_t> input_secret(kTestSecret,
+                                        kTestSecret + kTestSecretSize);
+  std::string input_aad(kTestAad);
+  std::vector<ByteContainerView> secret_views(4, input_secret);
+  std::vector<ByteContainerView> aad_views(4, input_aad);
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateMrenclaveSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*sealer, &header);
+
+  SealedSecretBatch sealed_batch;
+  ASSERT_THAT(sealer->SecretSealer::SealBatch(header, aad_views, secret_views,
+                                              &sealed_batch),
+              IsOk());
+  std::vector<CleansingVector<uint8_t>> output_secrets;
+  ASSERT_THAT(sealer->UnsealBatch(sealed_batch, &output_secrets), IsOk());
+  EXPECT_EQ(output_secrets,
+            std::vector<CleansingVector<uint8_t>>(4, input_secret));
+
+  ASSERT_THAT(sealer->SealBatch(header, aad_views, secret_views, &sealed_batch),
+              IsOk());
+  output_secrets.clear();
+  ASSERT_THAT(sealer->SecretSealer::UnsealBatch(sealed_batch, &output_secrets),
+              IsOk());
+  EXPECT_EQ(output_secrets,
+            std::vector<CleansingVector<uint8_t>>(4, input_secret));
+}
+
+// Verify that an empty batch still carries the sealed secret header, both from
+// the generic SecretSealer implementation and from SgxLocalSecretSealer.
+TEST_F(SgxLocalSecretSealerTest, SealBatchEmptyBatchHasHeader) {
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateMrenclaveSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*sealer, &header);
+  std::string serialized_header;
+  ASSERT_TRUE(header.SerializeToString(&serialized_header));
+
+  SealedSecretBatch generic_batch;
+  ASSERT_THAT(
+      sealer->SecretSealer::SealBatch(header, {}, {}, &generic_batch), IsOk());
+  EXPECT_EQ(generic_batch.entries_size(), 0);
+  EXPECT_EQ(generic_batch.sealed_secret_header(), serialized_header);
+
+  SealedSecretBatch sealed_batch;
+  ASSERT_THAT(sealer->SealBatch(header, {}, {}, &sealed_batch), IsOk());
+  EXPECT_EQ(sealed_batch.entries_size(), 0);
+  EXPECT_EQ(sealed_batch.sealed_secret_header(), serialized_header);
+
+  std::vector<CleansingVector<uint8_t>> output_secrets;
+  ASSERT_THAT(sealer->UnsealBatch(generic_batch, &output_secrets), IsOk());
+  EXPECT_TRUE(output_secrets.empty());
+}
+
+// Verify that SealBatch() fails if the numbers of secrets and additional
+// authenticated data items differ.
+TEST_F(SgxLocalSecretSealerTest, SealBatchFailsWithMismatchedSizes) {
+  CleansingVector<uint8_t> input_secret(kTestSecret,
+                                        kTestSecret + kTestSecretSize);
+  std::string input_aad(kTestAad);
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateMrenclaveSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*sealer, &header);
+
+  SealedSecretBatch sealed_batch;
+  EXPECT_THAT(sealer->SealBatch(header, {input_aad},
+                                {input_secret, input_secret}, &sealed_batch),
+              StatusIs(error::GoogleError::INVALID_ARGUMENT));
+}
+
+// Verify that UnsealBatch() fails if any entry in the batch has been tampered
+// with.
+TEST_F(SgxLocalSecretSealerTest, UnsealBatchFailsWithTamperedEntry) {
+  CleansingVector<uint8_t> input_secret(kTestSecret,
+                                        kTestSecret + kTestSecretSize);
+  std::string input_aad(kTestAad);
+
+  std::unique_ptr<SgxLocalSecretSealer> sealer =
+      SgxLocalSecretSealer::CreateMrenclaveSecretSealer();
+  SealedSecretHeader header;
+  PrepareSealedSecretHeader(*sealer, &header);
+
+  SealedSecretBatch sealed_batch;
+  ASSERT_THAT(sealer->SealBatch(header, {input_aad, input_aad, input_aad},
+                                {input_secret, input_secret, input_secret},
+                                &sealed_batch),
+              IsOk());
+
+  // Swapping the IVs of two entries must be detected.
+  SealedSecretBatch tampered_batch = sealed_batch;
+  tampered_batch.mutable_entries(1)->set_iv(sealed_batch.entries(2).iv());
+  tampered_batch.mutable_entries(2)->set_iv(sealed_batch.entries(1).iv());
+
+  std::vector<CleansingVector<uint8_t>> output_secrets;
+  EXPECT_THAT(sealer->UnsealBatch(tampered_batch, &output_secrets),
+              Not(IsOk()));
+  EXPECT_TRUE(output_secrets.empty());
+}
+
 }  // namespace
 }  // namespace asylo
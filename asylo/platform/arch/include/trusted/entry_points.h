@@ -53,6 +53,25 @@ int __asylo_user_init(const char *name, const char *config, size_t config_len,
 int __asylo_user_run(const char *input, size_t input_len, char **output,
                      size_t *output_len);
 
+// User-defined enclave execution routine which serializes its output into a
+// caller-provided buffer.
+//
+// |output_buffer| must be null or point to |output_buffer_size| bytes of
+// untrusted memory. If the serialized output fits in |output_buffer|, it is
+// written there and *|output| is set to |output_buffer|. Otherwise, the output
+// is returned in a buffer allocated with enc_untrusted_malloc(), exactly as by
+// __asylo_user_run().
+int __asylo_user_run_with_buffer(const char *input, size_t input_len,
+                                 char *output_buffer, size_t output_buffer_size,
+                                 char **output, size_t *output_len);
+
+// User-defined enclave execution routine for a batch of inputs.
+//
+// The input type is asylo::EnclaveInputBatch.
+// The output type is asylo::EnclaveOutputBatch.
+int __asylo_user_run_batch(const char *input, size_t input_len, char **output,
+                           size_t *output_len);
+
 // User-defined enclave finalization routine.
 //
 // The input type is asylo::EnclaveFinal.
@@ -0,0 +1,33 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_HEAP_STATS_H_
+#define ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_HEAP_STATS_H_
+
+#include "asylo/enclave.pb.h"
+
+namespace asylo {
+
+// Returns a snapshot of the usage of the enclave heap. If other threads
+// allocate memory while the snapshot is taken, its fields may not be exactly
+// consistent with each other.
+HeapStats GetHeapStats();
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_HEAP_STATS_H_
@@ -0,0 +1,147 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_HOST_CALL_STATS_H_
+#define ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_HOST_CALL_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "asylo/enclave.pb.h"
+#include "asylo/platform/common/host_call_stats.h"
+
+namespace asylo {
+
+// Enables or disables collection of host call statistics. Collection is
+// disabled by default, and is enabled during initialization if
+// EnclaveConfig.enable_host_call_stats is set.
+void EnableHostCallStats(bool enabled);
+
+// Returns true if host call statistics are being collected.
+bool HostCallStatsEnabled();
+
+// Returns a snapshot of the statistics for every host call. The host calls
+// generated from host_calls.textproto come first, in the order they are listed
+// there, followed by the hand-written host calls in the order of
+// HandWrittenHostCall.
+HostCallStats GetHostCallStats();
+
+// Sets the statistics of every host call to zero.
+void ResetHostCallStats();
+
+// The names of the host calls generated from host_calls.textproto and their
+// counters, indexed in the same order. Defined in the generated host call
+// wrappers.
+extern const char *const kGeneratedHostCallNames[];
+extern HostCallCounters generated_host_call_counters[];
+extern const size_t kNumGeneratedHostCalls;
+
+// The host calls implemented by hand rather than generated from
+// host_calls.textproto. The calls which fetch the addresses of shared resources
+// are not recorded, since the clock used to measure latency is set up through
+// them. The hand-written calls record the bytes they copy for paths, stat
+// buffers, pollfds, data buffers and messages; calls which only pass scalars
+// record none.
+enum class HandWrittenHostCall {
+  kMalloc,
+  kOpen,
+  kPuts,
+  kFcntl,
+  kStat,
+  kFstat,
+  kLstat,
+  kStatDirectory,
+  kWritev,
+  kReadv,
+  kPwritev,
+  kPreadv,
+  kSendfile,
+  kReadWithUntrustedPtr,
+  kWriteWithUntrustedPtr,
+  kSendWithUntrustedPtr,
+  kAccept,
+  kBind,
+  kConnect,
+  kSendmsg,
+  kRecvmsg,
+  kSendmmsg,
+  kRecvmmsg,
+  kInetNtop,
+  kGetaddrinfo,
+  kGetsockopt,
+  kSetsockopt,
+  kGetsockname,
+  kGetpeername,
+  kThreadCreate,
+  kPoll,
+  kGetifaddrs,
+  kSchedGetaffinity,
+  kRegisterSignalHandler,
+  kSigprocmask,
+  kOpenlog,
+  kSyslog,
+  kNanosleep,
+  kClockGettime,
+  kGettimeofday,
+  kPipe,
+  kSysconf,
+  kSleep,
+  kWait3,
+  kHexDump,
+};
+
+// The number of values of HandWrittenHostCall.
+constexpr size_t kNumHandWrittenHostCalls =
+    static_cast<size_t>(HandWrittenHostCall::kHexDump) + 1;
+
+// Records a single host call in a set of counters if host call statistics are
+// enabled. The latency of the call is measured from construction to
+// destruction of the recorder.
+class HostCallRecorder {
+ public:
+  explicit HostCallRecorder(HostCallCounters *counters);
+
+  // Records a call of a hand-written host call.
+  explicit HostCallRecorder(HandWrittenHostCall call);
+
+  ~HostCallRecorder();
+
+  HostCallRecorder(const HostCallRecorder &) = delete;
+  HostCallRecorder &operator=(const HostCallRecorder &) = delete;
+
+  // Returns true if the call is being recorded. Callers should only compute
+  // the number of bytes copied by the call if it is.
+  bool enabled() const { return counters_ != nullptr; }
+
+  // Sets the number of bytes copied for the [in] and [out] parameters of the
+  // call.
+  void set_bytes(uint64_t bytes_in, uint64_t bytes_out) {
+    bytes_in_ = bytes_in;
+    bytes_out_ = bytes_out;
+  }
+
+ private:
+  HostCallCounters *const counters_;
+  const int64_t start_ns_;
+  uint64_t bytes_in_ = 0;
+  uint64_t bytes_out_ = 0;
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_HOST_CALL_STATS_H_
@@ -73,6 +73,9 @@ int enc_untrusted_open(const char *path_name, int flags, ...);
 int enc_untrusted_close(int fd);
 ssize_t enc_untrusted_read(int fd, void *buf, size_t len);
 ssize_t enc_untrusted_write(int fd, const void *buf, size_t len);
+ssize_t enc_untrusted_pread(int fd, void *buf, size_t len, off_t offset);
+ssize_t enc_untrusted_pwrite(int fd, const void *buf, size_t len,
+                             off_t offset);
 int enc_untrusted_puts(const char *str);
 off_t enc_untrusted_lseek(int fd, off_t offset, int whence);
 int enc_untrusted_unlink(const char *path_name);
@@ -84,11 +87,27 @@ int enc_untrusted_link(const char *from, const char *to);
 ssize_t enc_untrusted_readlink(const char *path, char *buf, size_t bufsize);
 int enc_untrusted_stat(const char *pathname, struct stat *stat_buffer);
 int enc_untrusted_lstat(const char *pathname, struct stat *stat_buffer);
+
+// Stats the entries of the directory |path| on the host in a single host call,
+// following symlinks. Stores the NUL-separated names of at most |max_entries|
+// entries in |names|, which holds |names_size| bytes, and their metadata in the
+// same order in |stat_buffers|. Entries which cannot be stat'ed are left out.
+// Returns the number of entries stored, or -1 on error.
+int enc_untrusted_stat_directory(const char *path, struct stat *stat_buffers,
+                                 char *names, size_t names_size,
+                                 int max_entries);
+
 int enc_untrusted_symlink(const char *from, const char *to);
 int enc_untrusted_fstat(int fd, struct stat *stat_buffer);
 int enc_untrusted_isatty(int file);
 ssize_t enc_untrusted_writev(int fd, const struct iovec *iov, int iovcnt);
 ssize_t enc_untrusted_readv(int fd, const struct iovec *iov, int iovcnt);
+ssize_t enc_untrusted_pwritev(int fd, const struct iovec *iov, int iovcnt,
+                              off_t offset);
+ssize_t enc_untrusted_preadv(int fd, const struct iovec *iov, int iovcnt,
+                             off_t offset);
+ssize_t enc_untrusted_sendfile(int out_fd, int in_fd, off_t *offset,
+                               size_t count);
 
 //////////////////////////////////////
 //            Sockets               //
@@ -110,6 +129,11 @@ int enc_untrusted_inet_pton(int af, const char *src, void *dst);
 ssize_t enc_untrusted_send(int sockfd, const void *buf, size_t len, int flags);
 ssize_t enc_untrusted_sendmsg(int sockfd, const struct msghdr *msg, int flags);
 ssize_t enc_untrusted_recvmsg(int sockfd, struct msghdr *msg, int flags);
+int enc_untrusted_sendmmsg(int sockfd, struct mmsghdr *msgvec,
+                           unsigned int vlen, int flags);
+int enc_untrusted_recvmmsg(int sockfd, struct mmsghdr *msgvec,
+                           unsigned int vlen, int flags,
+                           struct timespec *timeout);
 int enc_untrusted_getaddrinfo(const char *node, const char *service,
                               const struct addrinfo *hints,
                               struct addrinfo **res);
@@ -0,0 +1,56 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_UNTRUSTED_STAGING_H_
+#define ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_UNTRUSTED_STAGING_H_
+
+#include <sys/types.h>
+#include <cstddef>
+
+namespace asylo {
+
+// The default value of the untrusted staging threshold, which matches the
+// default of EnclaveConfig.untrusted_staging_threshold_bytes.
+constexpr size_t kDefaultUntrustedStagingThreshold = 16384;
+
+// The largest transfer made through a single staging buffer. Larger reads
+// return after this many bytes, and larger writes are split.
+constexpr size_t kMaxUntrustedStagingSize = 16 * 1024 * 1024;
+
+// Sets the size in bytes at and above which StagedRead, StagedWrite and
+// StagedSend copy data through a pooled buffer in untrusted memory. Zero
+// disables staging. Set during initialization from
+// EnclaveConfig.untrusted_staging_threshold_bytes.
+void SetUntrustedStagingThreshold(size_t threshold);
+
+// Returns the current untrusted staging threshold.
+size_t GetUntrustedStagingThreshold();
+
+// Implement read, write and send on host file descriptors. Transfers smaller
+// than the staging threshold are marshalled by the bridge like
+// enc_untrusted_read, enc_untrusted_write and enc_untrusted_send. Larger
+// transfers are copied once between |buf| and a reusable buffer in untrusted
+// memory, which the host reads into or writes from directly. This avoids
+// marshalling large buffers on the untrusted stack.
+ssize_t StagedRead(int fd, void *buf, size_t count);
+ssize_t StagedWrite(int fd, const void *buf, size_t count);
+ssize_t StagedSend(int sockfd, const void *buf, size_t len, int flags);
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_ARCH_INCLUDE_TRUSTED_UNTRUSTED_STAGING_H_
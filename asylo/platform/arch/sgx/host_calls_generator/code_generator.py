@@ -219,6 +219,56 @@ def comma_separate_arguments(parameters_proto):
   return comma_delimit_items(name_list)
 
 
+def get_pointer_bytes_expression(parameter_proto):
+  """Returns an expression for the number of bytes copied for a pointer.
+
+  The expression evaluates to the number of bytes that the bridge copies across
+  the enclave boundary for the pointer parameter, matching the semantics of its
+  pointer attributes. Null pointers are not copied.
+
+  Args:
+    parameter_proto: a single pointer parameter protocol buffer.
+
+  Returns:
+    A C++ expression string.
+  """
+  name = parameter_proto.name
+  length = 'sizeof(*%s)' % name
+  for attribute_proto in parameter_proto.pointer_attributes:
+    if attribute_proto.attribute == STRING:
+      length = 'strlen(%s) + 1' % name
+    elif attribute_proto.attribute == SIZE:
+      length = attribute_proto.attribute_expression
+  return '(%s ? %s : 0)' % (name, length)
+
+
+def get_bytes_copied_expression(parameters_proto, copy_attribute):
+  """Returns an expression for the number of bytes copied for a host call.
+
+  Args:
+    parameters_proto: the parameter protocol buffers of the host call.
+    copy_attribute: IN or OUT, the direction of the copies to count.
+
+  Returns:
+    A C++ expression string summing the bytes copied for all parameters with
+    the |copy_attribute| pointer attribute, or "0" if there are none.
+  """
+  terms = [
+      get_pointer_bytes_expression(p)
+      for p in parameters_proto
+      if any(a.attribute == copy_attribute for a in p.pointer_attributes)
+  ]
+  return ' + '.join(terms) if terms else '0'
+
+
+def bytes_in_expression(parameters_proto):
+  return get_bytes_copied_expression(parameters_proto, IN)
+
+
+def bytes_out_expression(parameters_proto):
+  return get_bytes_copied_expression(parameters_proto, OUT)
+
+
 def read_input_file(file_name):
   file_path = os.path.join(CODEGEN_PATH, file_name)
   with open(file_path, 'r') as file:
@@ -233,6 +283,8 @@ def fill_template(dictionary, template_file_name):
       'comma_separate_bridge_parameters'] = comma_separate_bridge_parameters
   template.globals['comma_separate_parameters'] = comma_separate_parameters
   template.globals['comma_separate_arguments'] = comma_separate_arguments
+  template.globals['bytes_in_expression'] = bytes_in_expression
+  template.globals['bytes_out_expression'] = bytes_out_expression
   return template.render(dictionary)
 
 
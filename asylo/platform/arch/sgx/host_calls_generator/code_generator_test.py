@@ -118,6 +118,38 @@ class CodeGeneratorTest(TestCase):
         'size_t len',
         code_generator.comma_separate_bridge_parameters(chown_parameters))
 
+  def test_host_call_bytes_copied_without_pointers(self):
+    textproto = ('host_calls { name: "shutdown" return_type: "int" '
+                 'parameters { name: "sockfd" type: "int" } '
+                 'parameters { name: "how" type: "int" }}')
+    host_calls = code_generator.get_host_calls_dictionary(textproto)
+    parameters = _get_parameters_proto(host_calls)
+    self.assertEqual('0', code_generator.bytes_in_expression(parameters))
+    self.assertEqual('0', code_generator.bytes_out_expression(parameters))
+
+  def test_host_call_bytes_copied_with_pointers(self):
+    textproto = ('host_calls { name: "readlink" return_type: "int" '
+                 'parameters { name: "path" type: "const char *" '
+                 'pointer_attributes { attribute: IN } '
+                 'pointer_attributes { attribute: STRING }} '
+                 'parameters { name: "buf" type: "void *" '
+                 'pointer_attributes { attribute: OUT } '
+                 'pointer_attributes { attribute: SIZE '
+                 'attribute_expression: "len" }} '
+                 'parameters { name: "len" type: "size_t" } '
+                 'parameters { name: "status" type: "int *" '
+                 'pointer_attributes { attribute: IN } '
+                 'pointer_attributes { attribute: OUT }} '
+                 'parameters { name: "ptr" type: "void *" '
+                 'pointer_attributes { attribute: USER_CHECK }}}')
+    host_calls = code_generator.get_host_calls_dictionary(textproto)
+    parameters = _get_parameters_proto(host_calls)
+    self.assertEqual(
+        '(path ? strlen(path) + 1 : 0) + (status ? sizeof(*status) : 0)',
+        code_generator.bytes_in_expression(parameters))
+    self.assertEqual('(buf ? len : 0) + (status ? sizeof(*status) : 0)',
+                     code_generator.bytes_out_expression(parameters))
+
   def test_parameter_invalid_pointer_type(self):
     textproto = ('host_calls { name: "strlen" return_type: "int" '
                  'parameters { name: "s" type: "invalid_type" '
@@ -27,6 +27,8 @@
 #include "asylo/enclave.pb.h"
 #include "asylo/util/logging.h"
 #include "asylo/platform/arch/include/trusted/entry_points.h"
+#include "asylo/platform/arch/include/trusted/heap_stats.h"
+#include "asylo/platform/arch/include/trusted/host_call_stats.h"
 #include "asylo/platform/arch/include/trusted/host_calls.h"
 #include "asylo/platform/arch/sgx/trusted/generated_bridge_t.h"
 #include "asylo/platform/common/bridge_types.h"
@@ -72,6 +74,56 @@ int ecall_run(const char *input, bridge_size_t input_len, char **output,
   return result;
 }
 
+// Invokes the enclave run entry-point, writing its output to |output_buffer|
+// when possible. Returns a non-zero error code on failure.
+int ecall_run_with_buffer(const char *input, bridge_size_t input_len,
+                          char *output_buffer, bridge_size_t output_buffer_size,
+                          char **output, bridge_size_t *output_len) {
+  int result = 0;
+  try {
+    result = asylo::__asylo_user_run_with_buffer(
+        input, static_cast<size_t>(input_len), output_buffer,
+        static_cast<size_t>(output_buffer_size), output,
+        static_cast<size_t *>(output_len));
+  } catch (...) {
+    LOG(FATAL) << "Uncaught exception in enclave";
+  }
+
+  return result;
+}
+
+// Serializes the host call statistics of the enclave into untrusted memory.
+// Returns a non-zero error code on failure.
+int ecall_get_host_call_stats(char **output, bridge_size_t *output_len) {
+  std::string serialized;
+  if (!asylo::GetHostCallStats().SerializeToString(&serialized)) {
+    return 1;
+  }
+  *output = static_cast<char *>(enc_untrusted_malloc(serialized.size()));
+  if (!*output) {
+    return 1;
+  }
+  memcpy(*output, serialized.data(), serialized.size());
+  *output_len = static_cast<bridge_size_t>(serialized.size());
+  return 0;
+}
+
+// Serializes the heap statistics of the enclave into untrusted memory. Returns
+// a non-zero error code on failure.
+int ecall_get_heap_stats(char **output, bridge_size_t *output_len) {
+  std::string serialized;
+  if (!asylo::GetHeapStats().SerializeToString(&serialized)) {
+    return 1;
+  }
+  *output = static_cast<char *>(enc_untrusted_malloc(serialized.size()));
+  if (!*output) {
+    return 1;
+  }
+  memcpy(*output, serialized.data(), serialized.size());
+  *output_len = static_cast<bridge_size_t>(serialized.size());
+  return 0;
+}
+
 int ecall_donate_thread() { return asylo::__asylo_threading_donate(); }
 
 // Invokes the enclave signal handling entry-point. Returns a non-zero error
@@ -90,6 +142,22 @@ int ecall_handle_signal(const char *input, bridge_size_t input_len) {
   return result;
 }
 
+// Invokes the enclave batch run entry-point. Returns a non-zero error code on
+// failure.
+int ecall_run_batch(const char *input, bridge_size_t input_len, char **output,
+                    bridge_size_t *output_len) {
+  int result = 0;
+  try {
+    result = asylo::__asylo_user_run_batch(
+        input, static_cast<size_t>(input_len), output,
+        static_cast<size_t *>(output_len));
+  } catch (...) {
+    LOG(FATAL) << "Uncaught exception in enclave";
+  }
+
+  return result;
+}
+
 // Invokes the enclave finalization entry-point. Returns a non-zero error code
 // on failure.
 int ecall_finalize(const char *input, bridge_size_t input_len, char **output,
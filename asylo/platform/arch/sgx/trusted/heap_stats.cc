@@ -0,0 +1,53 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/arch/include/trusted/heap_stats.h"
+
+#include <malloc.h>
+#include <stddef.h>
+
+extern "C" {
+
+// Defined in sbrk.cc.
+extern size_t g_peak_heap_used;
+void enclave_heap_bounds(size_t *max_size, size_t *size);
+
+}  // extern "C"
+
+namespace asylo {
+
+HeapStats GetHeapStats() {
+  // mallinfo() reads the allocator's counters under its lock. The heap bounds
+  // are read afterwards so that they include any memory mallinfo() claimed.
+  struct mallinfo info = mallinfo();
+  size_t max_size;
+  size_t size;
+  enclave_heap_bounds(&max_size, &size);
+
+  HeapStats stats;
+  stats.set_heap_max_size(max_size);
+  stats.set_heap_size(size);
+  stats.set_peak_heap_size(g_peak_heap_used);
+  stats.set_bytes_in_use(info.uordblks);
+  stats.set_bytes_free(info.fordblks);
+  stats.set_free_chunks(info.ordblks);
+  stats.set_largest_free_block(info.keepcost + (max_size - size));
+  return stats;
+}
+
+}  // namespace asylo
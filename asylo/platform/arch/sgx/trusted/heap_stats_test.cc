@@ -0,0 +1,59 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/arch/include/trusted/heap_stats.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+#include "asylo/enclave.pb.h"
+
+namespace asylo {
+namespace {
+
+// Large enough that the allocation cannot be served from free chunks alone.
+constexpr size_t kAllocationSize = 4 * 1024 * 1024;
+
+// Tests that the reported bounds of the heap account for an allocation.
+TEST(HeapStatsTest, BoundsIncludeAllocation) {
+  HeapStats before = GetHeapStats();
+  EXPECT_GT(before.heap_max_size(), 0u);
+  EXPECT_LE(before.heap_size(), before.heap_max_size());
+
+  void *block = malloc(kAllocationSize);
+  ASSERT_NE(block, nullptr);
+  memset(block, 0xa5, kAllocationSize);
+  HeapStats during = GetHeapStats();
+
+  EXPECT_EQ(during.heap_max_size(), before.heap_max_size());
+  EXPECT_GE(during.bytes_in_use(), before.bytes_in_use() + kAllocationSize);
+  EXPECT_GE(during.heap_size(), during.bytes_in_use());
+  EXPECT_LE(during.heap_size(), during.heap_max_size());
+  EXPECT_GE(during.peak_heap_size(), during.heap_size());
+  EXPECT_LE(during.largest_free_block(),
+            during.heap_max_size() - during.bytes_in_use());
+
+  free(block);
+  HeapStats after = GetHeapStats();
+  EXPECT_LE(after.bytes_in_use() + kAllocationSize, during.bytes_in_use());
+  EXPECT_GE(after.peak_heap_size(), during.heap_size());
+}
+
+}  // namespace
+}  // namespace asylo
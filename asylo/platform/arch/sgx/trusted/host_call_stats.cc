@@ -0,0 +1,148 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/arch/include/trusted/host_call_stats.h"
+
+#include <time.h>
+#include <atomic>
+
+#include "asylo/platform/common/time_util.h"
+
+namespace asylo {
+namespace {
+
+std::atomic<bool> host_call_stats_enabled(false);
+
+// The names of the hand-written host calls, indexed by HandWrittenHostCall.
+const char *const kHandWrittenHostCallNames[] = {
+    "malloc",
+    "open",
+    "puts",
+    "fcntl",
+    "stat",
+    "fstat",
+    "lstat",
+    "stat_directory",
+    "writev",
+    "readv",
+    "pwritev",
+    "preadv",
+    "sendfile",
+    "read_with_untrusted_ptr",
+    "write_with_untrusted_ptr",
+    "send_with_untrusted_ptr",
+    "accept",
+    "bind",
+    "connect",
+    "sendmsg",
+    "recvmsg",
+    "sendmmsg",
+    "recvmmsg",
+    "inet_ntop",
+    "getaddrinfo",
+    "getsockopt",
+    "setsockopt",
+    "getsockname",
+    "getpeername",
+    "thread_create",
+    "poll",
+    "getifaddrs",
+    "sched_getaffinity",
+    "register_signal_handler",
+    "sigprocmask",
+    "openlog",
+    "syslog",
+    "nanosleep",
+    "clock_gettime",
+    "gettimeofday",
+    "pipe",
+    "sysconf",
+    "sleep",
+    "wait3",
+    "hex_dump",
+};
+
+static_assert(sizeof(kHandWrittenHostCallNames) /
+                      sizeof(kHandWrittenHostCallNames[0]) ==
+                  kNumHandWrittenHostCalls,
+              "A hand-written host call is missing a name");
+
+HostCallCounters hand_written_host_call_counters[kNumHandWrittenHostCalls];
+
+// Returns the current value of the enclave's monotonic clock in nanoseconds.
+// Reading the clock does not leave the enclave once the clock is set up, except
+// through clock_gettime on the host when the TSC clock cannot be read, which
+// does not recurse into itself.
+int64_t MonotonicNanoseconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return TimeSpecToNanoseconds(&ts);
+}
+
+}  // namespace
+
+void EnableHostCallStats(bool enabled) {
+  host_call_stats_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool HostCallStatsEnabled() {
+  return host_call_stats_enabled.load(std::memory_order_relaxed);
+}
+
+HostCallStats GetHostCallStats() {
+  HostCallStats stats;
+  stats.mutable_host_calls()->Reserve(kNumGeneratedHostCalls +
+                                      kNumHandWrittenHostCalls);
+  for (size_t i = 0; i < kNumGeneratedHostCalls; ++i) {
+    CopyHostCallCounters(kGeneratedHostCallNames[i],
+                         generated_host_call_counters[i],
+                         stats.add_host_calls());
+  }
+  for (size_t i = 0; i < kNumHandWrittenHostCalls; ++i) {
+    CopyHostCallCounters(kHandWrittenHostCallNames[i],
+                         hand_written_host_call_counters[i],
+                         stats.add_host_calls());
+  }
+  return stats;
+}
+
+void ResetHostCallStats() {
+  for (size_t i = 0; i < kNumGeneratedHostCalls; ++i) {
+    ResetHostCallCounters(&generated_host_call_counters[i]);
+  }
+  for (size_t i = 0; i < kNumHandWrittenHostCalls; ++i) {
+    ResetHostCallCounters(&hand_written_host_call_counters[i]);
+  }
+}
+
+HostCallRecorder::HostCallRecorder(HostCallCounters *counters)
+    : counters_(HostCallStatsEnabled() ? counters : nullptr),
+      start_ns_(counters_ ? MonotonicNanoseconds() : 0) {}
+
+HostCallRecorder::HostCallRecorder(HandWrittenHostCall call)
+    : HostCallRecorder(
+          &hand_written_host_call_counters[static_cast<size_t>(call)]) {}
+
+HostCallRecorder::~HostCallRecorder() {
+  if (counters_) {
+    RecordHostCall(bytes_in_, bytes_out_, MonotonicNanoseconds() - start_ns_,
+                   counters_);
+  }
+}
+
+}  // namespace asylo
@@ -0,0 +1,90 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/arch/include/trusted/host_call_stats.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "asylo/enclave.pb.h"
+
+namespace asylo {
+namespace {
+
+// Returns the statistics of the host call named |name| in |stats|, or nullptr
+// if there are none.
+const HostCallStatsEntry *FindHostCall(const HostCallStats &stats,
+                                       const std::string &name) {
+  for (const HostCallStatsEntry &entry : stats.host_calls()) {
+    if (entry.name() == name) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+class HostCallStatsTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    EnableHostCallStats(true);
+    ResetHostCallStats();
+  }
+
+  void TearDown() override { EnableHostCallStats(false); }
+};
+
+// Tests that both generated and hand-written host calls are reported.
+TEST_F(HostCallStatsTest, ReportsAllHostCalls) {
+  HostCallStats stats = GetHostCallStats();
+  size_t num_host_calls = kNumGeneratedHostCalls + kNumHandWrittenHostCalls;
+  EXPECT_EQ(stats.host_calls_size(), static_cast<int>(num_host_calls));
+  EXPECT_NE(FindHostCall(stats, "access"), nullptr);
+  EXPECT_NE(FindHostCall(stats, "stat"), nullptr);
+  EXPECT_NE(FindHostCall(stats, "poll"), nullptr);
+}
+
+// Tests that a call to a hand-written host call is counted with the bytes the
+// bridge copies for it.
+TEST_F(HostCallStatsTest, RecordsHandWrittenHostCall) {
+  struct stat stat_buffer;
+  ASSERT_EQ(stat("/", &stat_buffer), 0);
+
+  HostCallStats stats = GetHostCallStats();
+  const HostCallStatsEntry *entry = FindHostCall(stats, "stat");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->count(), 1);
+  EXPECT_EQ(entry->bytes_in(), 2);
+  EXPECT_GT(entry->bytes_out(), 0);
+}
+
+// Tests that nothing is recorded while statistics are disabled.
+TEST_F(HostCallStatsTest, DisabledRecordsNothing) {
+  EnableHostCallStats(false);
+  struct stat stat_buffer;
+  ASSERT_EQ(stat("/", &stat_buffer), 0);
+
+  HostCallStats stats = GetHostCallStats();
+  const HostCallStatsEntry *entry = FindHostCall(stats, "stat");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->count(), 0);
+}
+
+}  // namespace
+}  // namespace asylo
@@ -30,14 +30,17 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
 #include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "asylo/platform/arch/include/trusted/host_call_stats.h"
 #include "asylo/platform/arch/include/trusted/memory.h"
 #include "asylo/platform/arch/sgx/trusted/generated_bridge_t.h"
 #include "asylo/platform/common/bridge_proto_serializer.h"
@@ -64,6 +67,15 @@ bool CopyToUntrustedMemory(void **addr, void *data, size_t size) {
   return true;
 }
 
+// Returns the number of bytes in the name, control buffer and payload of |msg|.
+size_t MsghdrContentsSize(const struct msghdr *msg) {
+  size_t size = msg->msg_namelen + msg->msg_controllen;
+  for (size_t i = 0; i < msg->msg_iovlen; ++i) {
+    size += msg->msg_iov[i].iov_len;
+  }
+  return size;
+}
+
 // This helper class wraps a bridge_msghdr and does a deep copy of all the
 // buffers to untrusted memory.
 class BridgeMsghdrWrapper {
@@ -72,6 +84,12 @@ class BridgeMsghdrWrapper {
   bridge_msghdr *get_msg();
   bool CopyAllBuffers();
 
+  // Returns the copies of the name and control buffers in untrusted memory
+  // owned by the wrapper, or nullptr if there are none. Unlike the pointers in
+  // get_msg(), these cannot be modified by the host.
+  const void *get_msg_name() const { return msg_name_ptr_.get(); }
+  const void *get_msg_control() const { return msg_control_ptr_.get(); }
+
  private:
   bool CopyMsgName();
   bool CopyMsgIov();
@@ -166,6 +184,155 @@ bool BridgeMsghdrWrapper::CopyAllBuffers() {
   return true;
 }
 
+// The maximum number of messages passed to the host by a single sendmmsg or
+// recvmmsg call. Larger batches are truncated, as on Linux.
+constexpr unsigned int kMaxMmsgVlen = 1024;
+
+// This helper class packs an array of mmsghdr, together with all the buffers
+// they refer to, into a single contiguous buffer in untrusted memory, so that a
+// batch of messages is passed to the host with one allocation. The buffer holds
+// the bridge_mmsghdr array, followed by the bridge_iovec arrays of all the
+// messages, followed by the name, control buffer and payload of each message.
+class BridgeMmsghdrBuffer {
+ public:
+  // Packs the first |vlen| messages of |msgvec|. If |copy_contents| is true,
+  // the names, control buffers and payloads are copied to untrusted memory,
+  // otherwise space is only reserved for them.
+  BridgeMmsghdrBuffer(const struct mmsghdr *msgvec, unsigned int vlen,
+                      bool copy_contents);
+
+  // Returns the packed messages, or nullptr if the buffer could not be
+  // allocated.
+  bridge_mmsghdr *get_msgvec() { return msgvec_; }
+
+  // Returns the total size of the names, control buffers and payloads.
+  size_t contents_size() const { return contents_size_; }
+
+  // Copies the number of bytes sent for the first |count| messages to
+  // |msgvec|.
+  void CopySentLengths(int count, struct mmsghdr *msgvec) const;
+
+  // Copies the lengths, names, control buffers and payloads of the first
+  // |count| messages received by the host to |msgvec|, which must be the array
+  // the buffer was created from. Names and control data longer than the
+  // buffers are truncated, setting MSG_CTRUNC for the latter. Returns false if
+  // the host reported a payload larger than the buffers it was given.
+  bool CopyReceived(int count, struct mmsghdr *msgvec) const;
+
+ private:
+  UntrustedUniquePtr<char> buffer_;
+  bridge_mmsghdr *msgvec_;
+
+  // The start and total size of the names, control buffers and payloads in
+  // |buffer_|.
+  char *contents_;
+  size_t contents_size_;
+};
+
+BridgeMmsghdrBuffer::BridgeMmsghdrBuffer(const struct mmsghdr *msgvec,
+                                         unsigned int vlen, bool copy_contents)
+    : msgvec_(nullptr), contents_(nullptr), contents_size_(0) {
+  size_t num_iovs = 0;
+  for (unsigned int i = 0; i < vlen; ++i) {
+    num_iovs += msgvec[i].msg_hdr.msg_iovlen;
+    contents_size_ += MsghdrContentsSize(&msgvec[i].msg_hdr);
+  }
+  size_t headers_size =
+      vlen * sizeof(bridge_mmsghdr) + num_iovs * sizeof(bridge_iovec);
+  char *buffer = reinterpret_cast<char *>(
+      enc_untrusted_malloc(headers_size + contents_size_));
+  if (!buffer) {
+    return;
+  }
+  buffer_.reset(buffer);
+  msgvec_ = reinterpret_cast<bridge_mmsghdr *>(buffer);
+  contents_ = buffer + headers_size;
+
+  bridge_iovec *next_iov = reinterpret_cast<bridge_iovec *>(msgvec_ + vlen);
+  char *next_byte = contents_;
+  auto place = [&next_byte, copy_contents](const void *data,
+                                           size_t size) -> void * {
+    void *placed = data ? next_byte : nullptr;
+    if (data && copy_contents) {
+      memcpy(placed, data, size);
+    }
+    next_byte += size;
+    return placed;
+  };
+  for (unsigned int i = 0; i < vlen; ++i) {
+    const struct msghdr &msg = msgvec[i].msg_hdr;
+    bridge_msghdr *bridge_msg = &msgvec_[i].msg_hdr;
+    ToBridgeMsgHdr(&msg, bridge_msg);
+    bridge_msg->msg_name = place(msg.msg_name, msg.msg_namelen);
+    bridge_msg->msg_control = place(msg.msg_control, msg.msg_controllen);
+    bridge_msg->msg_iov = next_iov;
+    for (size_t j = 0; j < msg.msg_iovlen; ++j) {
+      next_iov[j].iov_base =
+          place(msg.msg_iov[j].iov_base, msg.msg_iov[j].iov_len);
+      next_iov[j].iov_len = msg.msg_iov[j].iov_len;
+    }
+    next_iov += msg.msg_iovlen;
+    msgvec_[i].msg_len = 0;
+  }
+}
+
+void BridgeMmsghdrBuffer::CopySentLengths(int count,
+                                          struct mmsghdr *msgvec) const {
+  for (int i = 0; i < count; ++i) {
+    msgvec[i].msg_len = msgvec_[i].msg_len;
+  }
+}
+
+bool BridgeMmsghdrBuffer::CopyReceived(int count,
+                                       struct mmsghdr *msgvec) const {
+  // The layout of the buffer is recomputed from |msgvec| rather than read from
+  // the pointers in untrusted memory, which the host could have modified.
+  const char *next_byte = contents_;
+  for (int i = 0; i < count; ++i) {
+    struct msghdr *msg = &msgvec[i].msg_hdr;
+    const bridge_mmsghdr &bridge_mmsg = msgvec_[i];
+    uint64_t namelen = bridge_mmsg.msg_hdr.msg_namelen;
+    uint64_t controllen = bridge_mmsg.msg_hdr.msg_controllen;
+    uint32_t len = bridge_mmsg.msg_len;
+
+    const char *name = next_byte;
+    next_byte += msg->msg_namelen;
+    const char *control = next_byte;
+    next_byte += msg->msg_controllen;
+
+    int msg_flags = bridge_mmsg.msg_hdr.msg_flags;
+    if (msg->msg_name) {
+      namelen = std::min<uint64_t>(namelen, msg->msg_namelen);
+      memcpy(msg->msg_name, name, namelen);
+      msg->msg_namelen = namelen;
+    }
+    if (msg->msg_control) {
+      if (controllen > msg->msg_controllen) {
+        controllen = msg->msg_controllen;
+        msg_flags |= MSG_CTRUNC;
+      }
+      memcpy(msg->msg_control, control, controllen);
+      msg->msg_controllen = controllen;
+    }
+
+    size_t remaining = len;
+    for (size_t j = 0; j < msg->msg_iovlen; ++j) {
+      size_t size = std::min(remaining, msg->msg_iov[j].iov_len);
+      if (size > 0) {
+        memcpy(msg->msg_iov[j].iov_base, next_byte, size);
+      }
+      remaining -= size;
+      next_byte += msg->msg_iov[j].iov_len;
+    }
+    if (remaining > 0) {
+      return false;
+    }
+    msg->msg_flags = msg_flags;
+    msgvec[i].msg_len = len;
+  }
+  return true;
+}
+
 }  // namespace
 }  // namespace asylo
 
@@ -178,6 +345,7 @@ extern "C" {
 ///////////////////////////////////////
 
 void *enc_untrusted_malloc(size_t size) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kMalloc);
   void *result;
   sgx_status_t status =
       ocall_enc_untrusted_malloc(&result, static_cast<bridge_size_t>(size));
@@ -196,6 +364,10 @@ void *enc_untrusted_malloc(size_t size) {
 }
 
 int enc_untrusted_open(const char *path_name, int flags, ...) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kOpen);
+  if (recorder.enabled()) {
+    recorder.set_bytes(strlen(path_name) + 1, 0);
+  }
   uint32_t mode = 0;
   if (flags & O_CREAT) {
     va_list ap;
@@ -216,6 +388,10 @@ int enc_untrusted_open(const char *path_name, int flags, ...) {
 }
 
 int enc_untrusted_puts(const char *str) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kPuts);
+  if (recorder.enabled()) {
+    recorder.set_bytes(strlen(str) + 1, 0);
+  }
   int result;
   sgx_status_t status = ocall_enc_untrusted_puts(&result, str);
   if (status != SGX_SUCCESS) {
@@ -226,6 +402,7 @@ int enc_untrusted_puts(const char *str) {
 }
 
 int FcntlHelper(int fd, int cmd, int64_t arg) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kFcntl);
   int result;
   sgx_status_t status = ocall_enc_untrusted_fcntl(&result, fd, cmd, arg);
   if (status != SGX_SUCCESS) {
@@ -273,6 +450,10 @@ int enc_untrusted_fcntl(int fd, int cmd, ...) {
 }
 
 int enc_untrusted_stat(const char *pathname, struct stat *stat_buffer) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kStat);
+  if (recorder.enabled()) {
+    recorder.set_bytes(strlen(pathname) + 1, sizeof(struct bridge_stat));
+  }
   int result;
   struct bridge_stat bridge_stat_buffer;
   sgx_status_t status =
@@ -286,6 +467,10 @@ int enc_untrusted_stat(const char *pathname, struct stat *stat_buffer) {
 }
 
 int enc_untrusted_fstat(int fd, struct stat *stat_buffer) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kFstat);
+  if (recorder.enabled()) {
+    recorder.set_bytes(0, sizeof(struct bridge_stat));
+  }
   int result;
   struct bridge_stat bridge_stat_buffer;
   sgx_status_t status =
@@ -299,6 +484,10 @@ int enc_untrusted_fstat(int fd, struct stat *stat_buffer) {
 }
 
 int enc_untrusted_lstat(const char *pathname, struct stat *stat_buffer) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kLstat);
+  if (recorder.enabled()) {
+    recorder.set_bytes(strlen(pathname) + 1, sizeof(struct bridge_stat));
+  }
   int result;
   struct bridge_stat bridge_stat_buffer;
   sgx_status_t status =
@@ -311,6 +500,37 @@ int enc_untrusted_lstat(const char *pathname, struct stat *stat_buffer) {
   return result;
 }
 
+int enc_untrusted_stat_directory(const char *path, struct stat *stat_buffers,
+                                 char *names, size_t names_size,
+                                 int max_entries) {
+  if (max_entries < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kStatDirectory);
+  if (recorder.enabled()) {
+    recorder.set_bytes(strlen(path) + 1,
+                       max_entries * sizeof(struct bridge_stat) + names_size);
+  }
+  int result;
+  std::vector<struct bridge_stat> bridge_stat_buffers(max_entries);
+  sgx_status_t status = ocall_enc_untrusted_stat_directory(
+      &result, path, bridge_stat_buffers.data(), names,
+      static_cast<bridge_size_t>(names_size), max_entries);
+  if (status != SGX_SUCCESS) {
+    errno = EINTR;
+    return -1;
+  }
+  if (result > max_entries) {
+    errno = EFAULT;
+    return -1;
+  }
+  for (int i = 0; i < result; ++i) {
+    FromBridgeStat(&bridge_stat_buffers[i], &stat_buffers[i]);
+  }
+  return result;
+}
+
 bool create_untrusted_buffer(const struct iovec *iov, int iovcnt, char **buf,
                              int *size) {
   int tmp_size = 0;
@@ -360,11 +580,13 @@ ssize_t enc_untrusted_writev(int fd, const struct iovec *iov, int iovcnt) {
     return -1;
   }
 
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kWritev);
   char *buf;
   int size;
   if (!serialize_iov(iov, iovcnt, &buf, &size)) {
     return -1;
   }
+  recorder.set_bytes(size, 0);
   asylo::UntrustedUniquePtr<char> tmp(buf);
   bridge_ssize_t ret;
 
@@ -382,6 +604,7 @@ ssize_t enc_untrusted_readv(int fd, const struct iovec *iov, int iovcnt) {
     errno = EINVAL;
     return -1;
   }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kReadv);
   char *buf;
   int size;
   if (!create_untrusted_buffer(iov, iovcnt, &buf, &size)) {
@@ -397,6 +620,84 @@ ssize_t enc_untrusted_readv(int fd, const struct iovec *iov, int iovcnt) {
     return -1;
   }
   fill_iov(buf, ret, iov, iovcnt);
+  recorder.set_bytes(0, ret > 0 ? ret : 0);
+  return static_cast<ssize_t>(ret);
+}
+
+ssize_t enc_untrusted_pwritev(int fd, const struct iovec *iov, int iovcnt,
+                              off_t offset) {
+  if (iovcnt <= 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kPwritev);
+  char *buf;
+  int size;
+  if (!serialize_iov(iov, iovcnt, &buf, &size)) {
+    return -1;
+  }
+  recorder.set_bytes(size, 0);
+  asylo::UntrustedUniquePtr<char> tmp(buf);
+  bridge_ssize_t ret;
+
+  sgx_status_t status = ocall_enc_untrusted_pwrite_with_untrusted_ptr(
+      &ret, fd, buf, size, offset);
+  if (status != SGX_SUCCESS) {
+    errno = EINTR;
+    return -1;
+  }
+  return static_cast<ssize_t>(ret);
+}
+
+ssize_t enc_untrusted_preadv(int fd, const struct iovec *iov, int iovcnt,
+                             off_t offset) {
+  if (iovcnt <= 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kPreadv);
+  char *buf;
+  int size;
+  if (!create_untrusted_buffer(iov, iovcnt, &buf, &size)) {
+    return -1;
+  }
+
+  asylo::UntrustedUniquePtr<char> tmp(buf);
+  bridge_ssize_t ret;
+  sgx_status_t status = ocall_enc_untrusted_pread_with_untrusted_ptr(
+      &ret, fd, buf, size, offset);
+  if (status != SGX_SUCCESS) {
+    errno = EINTR;
+    return -1;
+  }
+  if (ret > 0) {
+    fill_iov(buf, ret, iov, iovcnt);
+    recorder.set_bytes(0, ret);
+  }
+  return static_cast<ssize_t>(ret);
+}
+
+ssize_t enc_untrusted_sendfile(int out_fd, int in_fd, off_t *offset,
+                               size_t count) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSendfile);
+  // The data is moved between host descriptors and never enters the enclave;
+  // only the offset crosses the boundary.
+  if (offset) {
+    recorder.set_bytes(sizeof(int64_t), sizeof(int64_t));
+  }
+  bridge_ssize_t ret;
+  int64_t bridge_offset = offset ? static_cast<int64_t>(*offset) : 0;
+  sgx_status_t status = ocall_enc_untrusted_sendfile(
+      &ret, out_fd, in_fd, offset ? &bridge_offset : nullptr,
+      static_cast<uint64_t>(count));
+  if (status != SGX_SUCCESS) {
+    errno = EINTR;
+    return -1;
+  }
+  if (offset) {
+    *offset = static_cast<off_t>(bridge_offset);
+  }
   return static_cast<ssize_t>(ret);
 }
 
@@ -406,6 +707,7 @@ ssize_t enc_untrusted_readv(int fd, const struct iovec *iov, int iovcnt) {
 
 int enc_untrusted_accept(int sockfd, struct sockaddr *addr,
                          socklen_t *addrlen) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kAccept);
   int ret;
   struct bridge_sockaddr tmp;
   bridge_size_t tmp_len = static_cast<bridge_size_t>(sizeof(tmp));
@@ -427,6 +729,7 @@ int enc_untrusted_accept(int sockfd, struct sockaddr *addr,
 
 int enc_untrusted_bind(int sockfd, const struct sockaddr *addr,
                        socklen_t addrlen) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kBind);
   int ret;
   struct bridge_sockaddr tmp;
   sgx_status_t status =
@@ -441,6 +744,7 @@ int enc_untrusted_bind(int sockfd, const struct sockaddr *addr,
 
 int enc_untrusted_connect(int sockfd, const struct sockaddr *addr,
                           socklen_t addrlen) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kConnect);
   int ret;
   struct bridge_sockaddr tmp;
   sgx_status_t status =
@@ -460,6 +764,10 @@ ssize_t enc_untrusted_sendmsg(int sockfd, const struct msghdr *msg, int flags) {
     errno = EFAULT;
     return -1;
   }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSendmsg);
+  if (recorder.enabled()) {
+    recorder.set_bytes(asylo::MsghdrContentsSize(msg), 0);
+  }
 
   sgx_status_t status =
       ocall_enc_untrusted_sendmsg(&ret, sockfd, tmp_wrapper.get_msg(), flags);
@@ -478,6 +786,13 @@ ssize_t enc_untrusted_recvmsg(int sockfd, struct msghdr *msg, int flags) {
     errno = EFAULT;
     return -1;
   }
+  // The wrapper copies the caller's buffers out of the enclave as well.
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kRecvmsg);
+  uint64_t bytes_in = 0;
+  if (recorder.enabled()) {
+    bytes_in = asylo::MsghdrContentsSize(msg);
+    recorder.set_bytes(bytes_in, 0);
+  }
 
   sgx_status_t status =
       ocall_enc_untrusted_recvmsg(&ret, sockfd, tmp_wrapper.get_msg(), flags);
@@ -488,9 +803,104 @@ ssize_t enc_untrusted_recvmsg(int sockfd, struct msghdr *msg, int flags) {
   }
 
   FromBridgeIovecArray(tmp_wrapper.get_msg(), msg);
+
+  // The name and control data are copied from the buffers owned by
+  // |tmp_wrapper| rather than through the pointers in the bridge_msghdr, which
+  // the host could have redirected into enclave memory. The lengths reported by
+  // the host are clamped to the buffers provided by the caller.
+  const struct bridge_msghdr *bridge_msg = tmp_wrapper.get_msg();
+  uint64_t namelen =
+      std::min<uint64_t>(bridge_msg->msg_namelen, msg->msg_namelen);
+  uint64_t controllen = bridge_msg->msg_controllen;
+  int msg_flags = bridge_msg->msg_flags;
+  if (controllen > msg->msg_controllen) {
+    controllen = msg->msg_controllen;
+    msg_flags |= MSG_CTRUNC;
+  }
+  if (msg->msg_name && tmp_wrapper.get_msg_name()) {
+    memcpy(msg->msg_name, tmp_wrapper.get_msg_name(), namelen);
+  }
+  msg->msg_namelen = namelen;
+  if (msg->msg_control && tmp_wrapper.get_msg_control()) {
+    memcpy(msg->msg_control, tmp_wrapper.get_msg_control(), controllen);
+  }
+  msg->msg_controllen = controllen;
+  msg->msg_flags = msg_flags;
+  recorder.set_bytes(bytes_in, (ret > 0 ? ret : 0) + namelen + controllen);
   return static_cast<ssize_t>(ret);
 }
 
+int enc_untrusted_sendmmsg(int sockfd, struct mmsghdr *msgvec,
+                           unsigned int vlen, int flags) {
+  vlen = std::min(vlen, asylo::kMaxMmsgVlen);
+  if (vlen == 0) {
+    return 0;
+  }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSendmmsg);
+  asylo::BridgeMmsghdrBuffer buffer(msgvec, vlen, /*copy_contents=*/true);
+  if (!buffer.get_msgvec()) {
+    errno = ENOMEM;
+    return -1;
+  }
+  recorder.set_bytes(buffer.contents_size(), 0);
+
+  int ret;
+  sgx_status_t status = ocall_enc_untrusted_sendmmsg(
+      &ret, sockfd, buffer.get_msgvec(), vlen, flags);
+  if (status != SGX_SUCCESS) {
+    errno = EINTR;
+    return -1;
+  }
+  if (ret > static_cast<int>(vlen)) {
+    errno = EFAULT;
+    return -1;
+  }
+  buffer.CopySentLengths(ret, msgvec);
+  return ret;
+}
+
+int enc_untrusted_recvmmsg(int sockfd, struct mmsghdr *msgvec,
+                           unsigned int vlen, int flags,
+                           struct timespec *timeout) {
+  vlen = std::min(vlen, asylo::kMaxMmsgVlen);
+  if (vlen == 0) {
+    return 0;
+  }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kRecvmmsg);
+  asylo::BridgeMmsghdrBuffer buffer(msgvec, vlen, /*copy_contents=*/false);
+  if (!buffer.get_msgvec()) {
+    errno = ENOMEM;
+    return -1;
+  }
+  struct bridge_timespec bridge_timeout;
+  if (timeout) {
+    ToBridgeTimespec(timeout, &bridge_timeout);
+  }
+
+  int ret;
+  sgx_status_t status = ocall_enc_untrusted_recvmmsg(
+      &ret, sockfd, buffer.get_msgvec(), vlen, flags,
+      timeout ? &bridge_timeout : nullptr);
+  if (status != SGX_SUCCESS) {
+    errno = EINTR;
+    return -1;
+  }
+  if (ret > static_cast<int>(vlen) ||
+      (ret > 0 && !buffer.CopyReceived(ret, msgvec))) {
+    errno = EFAULT;
+    return -1;
+  }
+  if (recorder.enabled()) {
+    uint64_t bytes_out = 0;
+    for (int i = 0; i < ret; ++i) {
+      const struct msghdr &msg = msgvec[i].msg_hdr;
+      bytes_out += msgvec[i].msg_len + msg.msg_namelen + msg.msg_controllen;
+    }
+    recorder.set_bytes(0, bytes_out);
+  }
+  return ret;
+}
+
 const char *enc_untrusted_inet_ntop(int af, const void *src, char *dst,
                                     socklen_t size) {
   char *ret;
@@ -503,6 +913,7 @@ const char *enc_untrusted_inet_ntop(int af, const void *src, char *dst,
     errno = EAFNOSUPPORT;
     return nullptr;
   }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kInetNtop);
   sgx_status_t status = ocall_enc_untrusted_inet_ntop(
       &ret, af, src, src_size, dst, static_cast<bridge_size_t>(size));
   if (status != SGX_SUCCESS) {
@@ -527,6 +938,13 @@ int enc_untrusted_getaddrinfo(const char *node, const char *service,
     return -1;
   }
 
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kGetaddrinfo);
+  uint64_t bytes_in = 0;
+  if (recorder.enabled()) {
+    bytes_in = (node ? strlen(node) + 1 : 0) +
+               (service ? strlen(service) + 1 : 0) + serialized_hints.length();
+    recorder.set_bytes(bytes_in, 0);
+  }
   int ret;
   char *tmp_serialized_res_start;
   bridge_size_t tmp_serialized_res_len;
@@ -545,6 +963,8 @@ int enc_untrusted_getaddrinfo(const char *node, const char *service,
     return -1;
   }
 
+  recorder.set_bytes(bytes_in, tmp_serialized_res_len);
+
   // Copy then free serialized res from untrusted memory
   char tmp_serialized_res[tmp_serialized_res_len];
   memcpy(tmp_serialized_res, tmp_serialized_res_start,
@@ -563,6 +983,7 @@ void enc_untrusted_freeaddrinfo(struct addrinfo *res) {
 
 int enc_untrusted_getsockopt(int sockfd, int level, int optname, void *optval,
                              socklen_t *optlen) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kGetsockopt);
   int ret;
   unsigned int host_optlen = *optlen;
   sgx_status_t status = ocall_enc_untrusted_getsockopt(
@@ -578,6 +999,7 @@ int enc_untrusted_getsockopt(int sockfd, int level, int optname, void *optval,
 
 int enc_untrusted_setsockopt(int sockfd, int level, int optname,
                              const void *optval, socklen_t optlen) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSetsockopt);
   int ret;
   sgx_status_t status = ocall_enc_untrusted_setsockopt(
       &ret, sockfd, level, FromBridgeOptionName(level, optname), optval,
@@ -591,6 +1013,7 @@ int enc_untrusted_setsockopt(int sockfd, int level, int optname,
 
 int enc_untrusted_getsockname(int sockfd, struct sockaddr *addr,
                               socklen_t *addrlen) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kGetsockname);
   int ret;
   bridge_size_t tmp_addrlen = static_cast<bridge_size_t>(*addrlen);
   struct bridge_sockaddr tmp;
@@ -607,6 +1030,7 @@ int enc_untrusted_getsockname(int sockfd, struct sockaddr *addr,
 
 int enc_untrusted_getpeername(int sockfd, struct sockaddr *addr,
                               socklen_t *addrlen) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kGetpeername);
   int ret;
   bridge_size_t tmp_addrlen = static_cast<bridge_size_t>(*addrlen);
   struct bridge_sockaddr tmp;
@@ -626,6 +1050,7 @@ int enc_untrusted_getpeername(int sockfd, struct sockaddr *addr,
 //////////////////////////////////////
 
 int enc_untrusted_create_thread(const char *name) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kThreadCreate);
   int ret;
   sgx_status_t status = ocall_enc_untrusted_thread_create(&ret, name);
   if (status != SGX_SUCCESS) {
@@ -648,6 +1073,11 @@ int enc_untrusted_poll(struct pollfd *fds, nfds_t nfds, int timeout) {
       return -1;
     }
   }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kPoll);
+  if (recorder.enabled()) {
+    size_t bytes = nfds * sizeof(struct bridge_pollfd);
+    recorder.set_bytes(bytes, bytes);
+  }
   sgx_status_t status =
       ocall_enc_untrusted_poll(&ret, tmp.get(), nfds, timeout);
   if (status != SGX_SUCCESS) {
@@ -668,6 +1098,7 @@ int enc_untrusted_poll(struct pollfd *fds, nfds_t nfds, int timeout) {
 //////////////////////////////////////
 
 int enc_untrusted_getifaddrs(struct ifaddrs **ifap) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kGetifaddrs);
   char *serialized_ifaddrs = nullptr;
   bridge_ssize_t serialized_ifaddrs_len = 0;
   int ret = 0;
@@ -704,6 +1135,8 @@ int enc_untrusted_sched_getaffinity(pid_t pid, size_t cpusetsize,
     errno = EINVAL;
     return -1;
   }
+  asylo::HostCallRecorder recorder(
+      asylo::HandWrittenHostCall::kSchedGetaffinity);
 
   int ret;
   BridgeCpuSet bridge_mask;
@@ -737,6 +1170,8 @@ int enc_untrusted_register_signal_handler(
     errno = EINVAL;
     return -1;
   }
+  asylo::HostCallRecorder recorder(
+      asylo::HandWrittenHostCall::kRegisterSignalHandler);
   BridgeSignalHandler handler;
   handler.sigaction = bridge_sigaction;
   ToBridgeSigSet(&mask, &handler.mask);
@@ -751,6 +1186,7 @@ int enc_untrusted_register_signal_handler(
 }
 
 int enc_untrusted_sigprocmask(int how, const sigset_t *set, sigset_t *oldset) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSigprocmask);
   bridge_sigset_t bridge_set;
   ToBridgeSigSet(set, &bridge_set);
   bridge_sigset_t bridge_old_set;
@@ -770,11 +1206,13 @@ int enc_untrusted_sigprocmask(int how, const sigset_t *set, sigset_t *oldset) {
 //////////////////////////////////////
 
 void enc_untrusted_openlog(const char *ident, int option, int facility) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kOpenlog);
   ocall_enc_untrusted_openlog(ident, ToBridgeSysLogOption(option),
                               ToBridgeSysLogFacility(facility));
 }
 
 void enc_untrusted_syslog(int priority, const char *message) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSyslog);
   ocall_enc_untrusted_syslog(ToBridgeSysLogPriority(priority), message);
 }
 
@@ -783,6 +1221,7 @@ void enc_untrusted_syslog(int priority, const char *message) {
 //////////////////////////////////////
 
 int enc_untrusted_nanosleep(const struct timespec *req, struct timespec *rem) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kNanosleep);
   int ret;
   sgx_status_t status = ocall_enc_untrusted_nanosleep(
       &ret, reinterpret_cast<const bridge_timespec *>(req),
@@ -795,6 +1234,7 @@ int enc_untrusted_nanosleep(const struct timespec *req, struct timespec *rem) {
 }
 
 int enc_untrusted_clock_gettime(clockid_t clk_id, struct timespec *tp) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kClockGettime);
   int ret;
   sgx_status_t status = ocall_enc_untrusted_clock_gettime(
       &ret, static_cast<bridge_clockid_t>(clk_id),
@@ -811,6 +1251,7 @@ int enc_untrusted_clock_gettime(clockid_t clk_id, struct timespec *tp) {
 //////////////////////////////////////
 
 int enc_untrusted_gettimeofday(struct timeval *tv, void *tz) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kGettimeofday);
   int ret;
   sgx_status_t status = ocall_enc_untrusted_gettimeofday(
       &ret, reinterpret_cast<bridge_timeval *>(tv), nullptr);
@@ -825,6 +1266,7 @@ int enc_untrusted_gettimeofday(struct timeval *tv, void *tz) {
 //////////////////////////////////////
 
 int enc_untrusted_pipe(int pipefd[2]) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kPipe);
   int ret;
   sgx_status_t status = ocall_enc_untrusted_pipe(&ret, pipefd);
   if (status != SGX_SUCCESS) {
@@ -841,6 +1283,7 @@ int64_t enc_untrusted_sysconf(int name) {
     errno = EINVAL;
     return -1;
   }
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSysconf);
   sgx_status_t status = ocall_enc_untrusted_sysconf(&ret, bridge_name);
   if (status != SGX_SUCCESS) {
     errno = EINTR;
@@ -850,6 +1293,7 @@ int64_t enc_untrusted_sysconf(int name) {
 }
 
 uint32_t enc_untrusted_sleep(uint32_t seconds) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kSleep);
   uint32_t ret;
   ocall_enc_untrusted_sleep(&ret, seconds);
   return ret;
@@ -860,6 +1304,7 @@ uint32_t enc_untrusted_sleep(uint32_t seconds) {
 //////////////////////////////////////
 
 pid_t enc_untrusted_wait3(int *wstatus, int options, struct rusage *rusage) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kWait3);
   pid_t ret;
   struct BridgeWStatus bridge_wstatus;
   BridgeRUsage bridge_rusage;
@@ -907,6 +1352,7 @@ int enc_untrusted_release_shared_resource(enum SharedNameKind kind,
 //////////////////////////////////////
 
 void enc_untrusted_hex_dump(const void *buf, int nbytes) {
+  asylo::HostCallRecorder recorder(asylo::HandWrittenHostCall::kHexDump);
   ocall_enc_untrusted_hex_dump(buf, nbytes);
 }
 
@@ -20,6 +20,7 @@
 
 #include <errno.h>
 #include <stdlib.h>
+#include <sys/reent.h>
 
 #include "common/inc/internal/global_data.h"
 
@@ -38,6 +39,11 @@ size_t heap_size = 0;
 
 extern "C" {
 
+// Serialize access to the allocator. Defined in
+// asylo/platform/posix/pthread.cc.
+void __malloc_lock(struct _reent *);
+void __malloc_unlock(struct _reent *);
+
 size_t g_peak_heap_used __attribute__((visibility("default"))) = 0;
 
 int heap_init(void *_heap_base, size_t _heap_max_size, size_t _heap_min_size,
@@ -71,4 +77,17 @@ void *enclave_sbrk(int n) {
   return reinterpret_cast<void *>(prev_heap_end);
 }
 
+// Reports the size of the memory reserved for the heap and the number of bytes
+// currently claimed with enclave_sbrk(). The allocator calls enclave_sbrk()
+// with its lock held, so the same lock is held while the bounds are read.
+void enclave_heap_bounds(size_t *max_size, size_t *size) {
+  __malloc_lock(_REENT);
+  if (!heap_base) {
+    enclave_sbrk(0);
+  }
+  *max_size = heap_max_size;
+  *size = heap_size;
+  __malloc_unlock(_REENT);
+}
+
 }  //  extern "C"
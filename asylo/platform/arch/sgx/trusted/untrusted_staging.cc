@@ -0,0 +1,154 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/arch/include/trusted/untrusted_staging.h"
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+#include "asylo/platform/arch/include/trusted/host_call_stats.h"
+#include "asylo/platform/arch/include/trusted/host_calls.h"
+#include "asylo/platform/arch/sgx/trusted/generated_bridge_t.h"
+#include "asylo/platform/common/bridge_types.h"
+#include "asylo/platform/common/staging_buffer_pool.h"
+
+namespace asylo {
+namespace {
+
+// The total size of the released staging buffers kept for reuse.
+constexpr size_t kMaxCachedStagingBytes = 4 * 1024 * 1024;
+
+std::atomic<size_t> staging_threshold(kDefaultUntrustedStagingThreshold);
+
+StagingBufferPool *GetStagingBufferPool() {
+  static StagingBufferPool *pool = new StagingBufferPool(
+      enc_untrusted_malloc, enc_untrusted_free, kMaxCachedStagingBytes);
+  return pool;
+}
+
+// Returns true if a transfer of |count| bytes should be staged.
+bool ShouldStage(size_t count) {
+  size_t threshold = staging_threshold.load(std::memory_order_relaxed);
+  return threshold > 0 && count >= threshold;
+}
+
+// The signature shared by the ocalls that write a buffer in untrusted memory.
+using WriteOcall = std::function<sgx_status_t(bridge_ssize_t *ret,
+                                              const void *buf, int size)>;
+
+// Writes |count| bytes from |buf| through staging buffers with |ocall|,
+// splitting the transfer into pieces of at most kMaxUntrustedStagingSize
+// bytes. Stops at the first short or failed write.
+ssize_t StagedWriteWith(const void *buf, size_t count,
+                        const WriteOcall &ocall) {
+  StagingBufferPool::Buffer staging = GetStagingBufferPool()->Acquire(
+      std::min(count, kMaxUntrustedStagingSize));
+  if (!staging.data()) {
+    errno = ENOMEM;
+    return -1;
+  }
+  size_t total = 0;
+  while (total < count) {
+    size_t size = std::min(count - total, staging.size());
+    memcpy(staging.data(), static_cast<const char *>(buf) + total, size);
+    bridge_ssize_t ret;
+    if (ocall(&ret, staging.data(), static_cast<int>(size)) != SGX_SUCCESS) {
+      errno = EINTR;
+      ret = -1;
+    }
+    if (ret < 0) {
+      return total > 0 ? total : -1;
+    }
+    total += std::min(static_cast<size_t>(ret), size);
+    if (static_cast<size_t>(ret) < size) {
+      break;
+    }
+  }
+  return total;
+}
+
+}  // namespace
+
+void SetUntrustedStagingThreshold(size_t threshold) {
+  staging_threshold.store(threshold, std::memory_order_relaxed);
+}
+
+size_t GetUntrustedStagingThreshold() {
+  return staging_threshold.load(std::memory_order_relaxed);
+}
+
+ssize_t StagedRead(int fd, void *buf, size_t count) {
+  if (!ShouldStage(count)) {
+    return enc_untrusted_read(fd, buf, count);
+  }
+  // A single read is made so that a read from a pipe or socket does not block
+  // once some data has been returned.
+  StagingBufferPool::Buffer staging = GetStagingBufferPool()->Acquire(
+      std::min(count, kMaxUntrustedStagingSize));
+  if (!staging.data()) {
+    errno = ENOMEM;
+    return -1;
+  }
+  size_t size = std::min(count, staging.size());
+  bridge_ssize_t ret;
+  HostCallRecorder recorder(HandWrittenHostCall::kReadWithUntrustedPtr);
+  if (ocall_enc_untrusted_read_with_untrusted_ptr(
+          &ret, fd, staging.data(), static_cast<int>(size)) != SGX_SUCCESS) {
+    errno = EINTR;
+    return -1;
+  }
+  if (ret > 0) {
+    if (static_cast<size_t>(ret) > size) {
+      errno = EFAULT;
+      return -1;
+    }
+    memcpy(buf, staging.data(), ret);
+    recorder.set_bytes(0, ret);
+  }
+  return static_cast<ssize_t>(ret);
+}
+
+ssize_t StagedWrite(int fd, const void *buf, size_t count) {
+  if (!ShouldStage(count)) {
+    return enc_untrusted_write(fd, buf, count);
+  }
+  return StagedWriteWith(
+      buf, count, [fd](bridge_ssize_t *ret, const void *buf, int size) {
+        HostCallRecorder recorder(HandWrittenHostCall::kWriteWithUntrustedPtr);
+        recorder.set_bytes(size, 0);
+        return ocall_enc_untrusted_write_with_untrusted_ptr(ret, fd, buf, size);
+      });
+}
+
+ssize_t StagedSend(int sockfd, const void *buf, size_t len, int flags) {
+  if (!ShouldStage(len)) {
+    return enc_untrusted_send(sockfd, buf, len, flags);
+  }
+  return StagedWriteWith(buf, len, [sockfd, flags](bridge_ssize_t *ret,
+                                                   const void *buf, int size) {
+    HostCallRecorder recorder(HandWrittenHostCall::kSendWithUntrustedPtr);
+    recorder.set_bytes(size, 0);
+    return ocall_enc_untrusted_send_with_untrusted_ptr(ret, sockfd, buf, size,
+                                                       flags);
+  });
+}
+
+}  // namespace asylo
@@ -19,6 +19,7 @@
 // Stubs invoked by edger8r generated bridge code for ocalls.
 
 #include <arpa/inet.h>
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <ifaddrs.h>
@@ -28,6 +29,8 @@
 #include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/time.h>
@@ -36,6 +39,7 @@
 #include <time.h>
 #include <unistd.h>
 #include <algorithm>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "asylo/platform/arch/sgx/untrusted/generated_bridge_u.h"
@@ -50,6 +54,40 @@
 
 namespace {
 
+// Converts the |vlen| messages of |bridge_msgvec| to host messages stored in
+// |msgvec|. The iovec arrays of the host messages are stored in |iovs|. Only
+// the message headers are converted; the converted messages refer to the same
+// buffers as |bridge_msgvec|.
+bool FromBridgeMmsghdrArray(const struct bridge_mmsghdr *bridge_msgvec,
+                            unsigned int vlen,
+                            std::vector<struct mmsghdr> *msgvec,
+                            std::vector<struct iovec> *iovs) {
+  size_t num_iovs = 0;
+  for (unsigned int i = 0; i < vlen; ++i) {
+    num_iovs += bridge_msgvec[i].msg_hdr.msg_iovlen;
+  }
+  msgvec->resize(vlen);
+  iovs->resize(num_iovs);
+
+  struct iovec *next_iov = iovs->data();
+  for (unsigned int i = 0; i < vlen; ++i) {
+    const struct bridge_msghdr *bridge_msg = &bridge_msgvec[i].msg_hdr;
+    struct msghdr *msg = &(*msgvec)[i].msg_hdr;
+    if (!FromBridgeMsgHdr(bridge_msg, msg)) {
+      return false;
+    }
+    for (uint64_t j = 0; j < bridge_msg->msg_iovlen; ++j) {
+      if (!FromBridgeIovec(&bridge_msg->msg_iov[j], &next_iov[j])) {
+        return false;
+      }
+    }
+    msg->msg_iov = next_iov;
+    next_iov += bridge_msg->msg_iovlen;
+    (*msgvec)[i].msg_len = 0;
+  }
+  return true;
+}
+
 // Stores a pointer to a function inside the enclave that translates
 // |bridge_signum| to a value inside the enclave and calls the registered signal
 // handler for that signal.
@@ -181,6 +219,41 @@ int ocall_enc_untrusted_lstat(const char *pathname,
   return ret;
 }
 
+int ocall_enc_untrusted_stat_directory(const char *path,
+                                       struct bridge_stat *stat_buffers,
+                                       char *names, bridge_size_t names_size,
+                                       int max_entries) {
+  DIR *dir = opendir(path);
+  if (!dir) {
+    return -1;
+  }
+  int count = 0;
+  bridge_size_t names_used = 0;
+  struct dirent *entry;
+  while (count < max_entries && (entry = readdir(dir))) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+    size_t name_size = strlen(entry->d_name) + 1;
+    if (names_used + name_size > names_size) {
+      break;
+    }
+
+    // Entries which cannot be stat'ed, such as dangling symlinks, are left
+    // out.
+    struct stat host_stat_buffer;
+    if (fstatat(dirfd(dir), entry->d_name, &host_stat_buffer, 0) != 0) {
+      continue;
+    }
+    ToBridgeStat(&host_stat_buffer, &stat_buffers[count]);
+    memcpy(names + names_used, entry->d_name, name_size);
+    names_used += name_size;
+    ++count;
+  }
+  closedir(dir);
+  return count;
+}
+
 bridge_ssize_t ocall_enc_untrusted_write_with_untrusted_ptr(int fd,
                                                             const void *buf,
                                                             int size) {
@@ -192,6 +265,32 @@ bridge_ssize_t ocall_enc_untrusted_read_with_untrusted_ptr(int fd, void *buf,
   return static_cast<bridge_ssize_t>(read(fd, buf, size));
 }
 
+bridge_ssize_t ocall_enc_untrusted_pwrite_with_untrusted_ptr(int fd,
+                                                             const void *buf,
+                                                             int size,
+                                                             int64_t offset) {
+  return static_cast<bridge_ssize_t>(pwrite(fd, buf, size, offset));
+}
+
+bridge_ssize_t ocall_enc_untrusted_pread_with_untrusted_ptr(int fd, void *buf,
+                                                            int size,
+                                                            int64_t offset) {
+  return static_cast<bridge_ssize_t>(pread(fd, buf, size, offset));
+}
+
+bridge_ssize_t ocall_enc_untrusted_sendfile(int out_fd, int in_fd,
+                                            int64_t *offset, uint64_t count) {
+  if (!offset) {
+    return static_cast<bridge_ssize_t>(
+        sendfile(out_fd, in_fd, nullptr, static_cast<size_t>(count)));
+  }
+  off_t host_offset = static_cast<off_t>(*offset);
+  ssize_t ret =
+      sendfile(out_fd, in_fd, &host_offset, static_cast<size_t>(count));
+  *offset = static_cast<int64_t>(host_offset);
+  return static_cast<bridge_ssize_t>(ret);
+}
+
 //////////////////////////////////////
 //             Sockets              //
 //////////////////////////////////////
@@ -229,6 +328,13 @@ int ocall_enc_untrusted_accept(int sockfd, struct bridge_sockaddr *addr,
   return ret;
 }
 
+bridge_ssize_t ocall_enc_untrusted_send_with_untrusted_ptr(int sockfd,
+                                                           const void *buf,
+                                                           int size,
+                                                           int flags) {
+  return static_cast<bridge_ssize_t>(send(sockfd, buf, size, flags));
+}
+
 bridge_ssize_t ocall_enc_untrusted_sendmsg(int sockfd,
                                            const struct bridge_msghdr *msg,
                                            int flags) {
@@ -272,6 +378,50 @@ bridge_ssize_t ocall_enc_untrusted_recvmsg(int sockfd,
     errno = EFAULT;
     return -1;
   }
+  msg->msg_namelen = tmp.msg_namelen;
+  msg->msg_controllen = tmp.msg_controllen;
+  msg->msg_flags = tmp.msg_flags;
+  return ret;
+}
+
+int ocall_enc_untrusted_sendmmsg(int sockfd, struct bridge_mmsghdr *msgvec,
+                                 unsigned int vlen, int flags) {
+  std::vector<struct mmsghdr> host_msgvec;
+  std::vector<struct iovec> host_iovs;
+  if (!FromBridgeMmsghdrArray(msgvec, vlen, &host_msgvec, &host_iovs)) {
+    errno = EFAULT;
+    return -1;
+  }
+  int ret = sendmmsg(sockfd, host_msgvec.data(), vlen, flags);
+  for (int i = 0; i < ret; ++i) {
+    msgvec[i].msg_len = host_msgvec[i].msg_len;
+  }
+  return ret;
+}
+
+int ocall_enc_untrusted_recvmmsg(int sockfd, struct bridge_mmsghdr *msgvec,
+                                 unsigned int vlen, int flags,
+                                 const struct bridge_timespec *timeout) {
+  std::vector<struct mmsghdr> host_msgvec;
+  std::vector<struct iovec> host_iovs;
+  if (!FromBridgeMmsghdrArray(msgvec, vlen, &host_msgvec, &host_iovs)) {
+    errno = EFAULT;
+    return -1;
+  }
+  struct timespec host_timeout;
+  if (timeout && !FromBridgeTimespec(timeout, &host_timeout)) {
+    errno = EINVAL;
+    return -1;
+  }
+  int ret = recvmmsg(sockfd, host_msgvec.data(), vlen, flags,
+                     timeout ? &host_timeout : nullptr);
+  for (int i = 0; i < ret; ++i) {
+    struct bridge_msghdr *msg = &msgvec[i].msg_hdr;
+    msgvec[i].msg_len = host_msgvec[i].msg_len;
+    msg->msg_namelen = host_msgvec[i].msg_hdr.msg_namelen;
+    msg->msg_controllen = host_msgvec[i].msg_hdr.msg_controllen;
+    msg->msg_flags = host_msgvec[i].msg_hdr.msg_flags;
+  }
   return ret;
 }
 
@@ -19,6 +19,7 @@
 #include "asylo/platform/arch/sgx/untrusted/sgx_client.h"
 
 #include <string>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "asylo/enclave.pb.h"
@@ -26,10 +27,13 @@
 #include "asylo/platform/arch/sgx/untrusted/generated_bridge_u.h"
 #include "asylo/platform/arch/sgx/untrusted/sgx_error_space.h"
 #include "asylo/platform/common/bridge_types.h"
+#include "asylo/platform/common/thread_arena.h"
 #include "asylo/util/posix_error_space.h"
 
 namespace asylo {
 
+using google::protobuf::Arena;
+
 constexpr int kMaxEnclaveCreateAttempts = 5;
 
 
@@ -81,6 +85,121 @@ static Status run(sgx_enclave_id_t eid, const char *input, size_t input_len,
   return Status::OkStatus();
 }
 
+// Enters the enclave and invokes the execution entry-point, offering
+// |output_buffer| as the destination for the enclave's output. Behaves like
+// run(), except that on success *|output| may equal |output_buffer|, in which
+// case it must not be freed.
+static Status run_with_buffer(sgx_enclave_id_t eid, const char *input,
+                              size_t input_len, char *output_buffer,
+                              size_t output_buffer_size, char **output,
+                              size_t *output_len) {
+  int result;
+  sgx_status_t sgx_status = ecall_run_with_buffer(
+      eid, &result, input, static_cast<bridge_size_t>(input_len),
+      output_buffer, static_cast<bridge_size_t>(output_buffer_size), output,
+      static_cast<bridge_size_t *>(output_len));
+  if (sgx_status != SGX_SUCCESS) {
+    // Return a Status object in the SGX error space.
+    return Status(sgx_status, "Call to ecall_run_with_buffer failed");
+  } else if (result || *output_len == 0) {
+    // Ecall succeeded but did not return a value. This indicates that the
+    // trusted code failed to propagate error information over the enclave
+    // boundary (e.g. serialization failure).
+    return Status(error::GoogleError::INTERNAL, "No output from enclave");
+  }
+
+  return Status::OkStatus();
+}
+
+// Enters the enclave and fetches its serialized host call statistics. If the
+// ecall fails, or the enclave does not return any output, returns a non-OK
+// status. Otherwise, |output| points to a buffer of length *|output_len| that
+// contains output from the enclave.
+static Status get_host_call_stats(sgx_enclave_id_t eid, char **output,
+                                  size_t *output_len) {
+  int result;
+  sgx_status_t sgx_status = ecall_get_host_call_stats(
+      eid, &result, output, static_cast<bridge_size_t *>(output_len));
+  if (sgx_status != SGX_SUCCESS) {
+    // Return a Status object in the SGX error space.
+    return Status(sgx_status, "Call to ecall_get_host_call_stats failed");
+  } else if (result || *output_len == 0) {
+    return Status(error::GoogleError::INTERNAL, "No output from enclave");
+  }
+
+  return Status::OkStatus();
+}
+
+// Enters the enclave and fetches its serialized heap statistics. If the ecall
+// fails, or the enclave does not return any output, returns a non-OK status.
+// Otherwise, |output| points to a buffer of length *|output_len| that contains
+// output from the enclave.
+static Status get_heap_stats(sgx_enclave_id_t eid, char **output,
+                             size_t *output_len) {
+  int result;
+  sgx_status_t sgx_status = ecall_get_heap_stats(
+      eid, &result, output, static_cast<bridge_size_t *>(output_len));
+  if (sgx_status != SGX_SUCCESS) {
+    // Return a Status object in the SGX error space.
+    return Status(sgx_status, "Call to ecall_get_heap_stats failed");
+  } else if (result || *output_len == 0) {
+    return Status(error::GoogleError::INTERNAL, "No output from enclave");
+  }
+
+  return Status::OkStatus();
+}
+
+// Enters the enclave and invokes the batch execution entry-point. If the ecall
+// fails, or the enclave does not return any output, returns a non-OK status. In
+// this case, the caller cannot make any assumptions about the contents of
+// |output|. Otherwise, |output| points to a buffer of length *|output_len| that
+// contains output from the enclave.
+static Status run_batch(sgx_enclave_id_t eid, const char *input,
+                        size_t input_len, char **output, size_t *output_len) {
+  int result;
+  sgx_status_t sgx_status = ecall_run_batch(
+      eid, &result, input, static_cast<bridge_size_t>(input_len), output,
+      static_cast<bridge_size_t *>(output_len));
+  if (sgx_status != SGX_SUCCESS) {
+    // Return a Status object in the SGX error space.
+    return Status(sgx_status, "Call to ecall_run_batch failed");
+  } else if (result || *output_len == 0) {
+    // Ecall succeeded but did not return a value. This indicates that the
+    // trusted code failed to propagate error information over the enclave
+    // boundary (e.g. serialization failure).
+    return Status(error::GoogleError::INTERNAL, "No output from enclave");
+  }
+
+  return Status::OkStatus();
+}
+
+namespace {
+
+// Buffers owned by a thread for use with the run channel. They are reused
+// across calls to SGXClient::EnterAndRunWithChannel() and grow as needed.
+struct RunChannelBuffers {
+  // Serialized EnclaveInput.
+  std::string input;
+
+  // Untrusted buffer the enclave serializes its EnclaveOutput into.
+  std::vector<char> output;
+
+  // Destination for parsing the output when the caller does not request it.
+  EnclaveOutput scratch_output;
+
+  // Set while the thread is inside EnterAndRunWithChannel(). An ocall made
+  // during the call may re-enter an enclave on the same thread; such nested
+  // calls must not touch the buffers of the outer call.
+  bool in_use = false;
+};
+
+RunChannelBuffers *GetRunChannelBuffers() {
+  static thread_local RunChannelBuffers buffers;
+  return &buffers;
+}
+
+}  // namespace
+
 // Enters the enclave and invokes the finalization entry-point. If the ecall
 // fails, or the enclave does not return any output, returns a non-OK status. In
 // this case, the caller cannot make any assumptions about the contents of
@@ -182,12 +301,13 @@ Status SGXClient::EnterAndInitialize(const EnclaveConfig &config) {
 
   // Enclave entry-point was successfully invoked. |output| is guaranteed to
   // have a value.
-  StatusProto status_proto;
-  if (!status_proto.ParseFromArray(output, output_len)) {
+  ScopedThreadArena arena;
+  StatusProto *status_proto = Arena::CreateMessage<StatusProto>(arena.get());
+  if (!status_proto->ParseFromArray(output, output_len)) {
     return Status(error::GoogleError::INTERNAL,
                   "Failed to deserialize StatusProto");
   }
-  status.RestoreFrom(status_proto);
+  status.RestoreFrom(*status_proto);
 
   // |output| points to an untrusted memory buffer allocated by the enclave. It
   // is the untrusted caller's responsibility to free this buffer.
@@ -198,6 +318,10 @@ Status SGXClient::EnterAndInitialize(const EnclaveConfig &config) {
 
 Status SGXClient::EnterAndRun(const EnclaveInput &input,
                               EnclaveOutput *output) {
+  if (run_channel_buffer_size_ > 0 && !GetRunChannelBuffers()->in_use) {
+    return EnterAndRunWithChannel(input, output);
+  }
+
   std::string buf;
   if (!input.SerializeToString(&buf)) {
     return Status(error::GoogleError::INVALID_ARGUMENT,
@@ -212,22 +336,168 @@ Status SGXClient::EnterAndRun(const EnclaveInput &input,
   }
 
   // Enclave entry-point was successfully invoked. |output_buf| is guaranteed to
-  // have a value.
-  EnclaveOutput local_output;
-  local_output.ParseFromArray(output_buf, output_len);
-  status.RestoreFrom(local_output.status());
+  // have a value. Parse directly into the caller's output, or into a temporary
+  // on the thread's arena if the caller does not want the output.
+  ScopedThreadArena arena;
+  EnclaveOutput *parsed_output =
+      output ? output : Arena::CreateMessage<EnclaveOutput>(arena.get());
+  parsed_output->ParseFromArray(output_buf, output_len);
+  status.RestoreFrom(parsed_output->status());
 
   // If |output| is not null, then |output_buf| points to a memory buffer
   // allocated inside the enclave using enc_untrusted_malloc(). It is the
   // caller's responsibility to free this buffer.
   free(output_buf);
 
-  // Set the output parameter if necessary.
-  if (output) {
-    *output = local_output;
+  return status;
+}
+
+Status SGXClient::EnterAndRunWithChannel(const EnclaveInput &input,
+                                         EnclaveOutput *output) {
+  RunChannelBuffers *buffers = GetRunChannelBuffers();
+  buffers->in_use = true;
+  auto release = [buffers](const Status &status) {
+    buffers->in_use = false;
+    return status;
+  };
+
+  // SerializeToString() reuses the existing capacity of |buffers->input|.
+  if (!input.SerializeToString(&buffers->input)) {
+    return release(Status(error::GoogleError::INVALID_ARGUMENT,
+                          "Failed to serialize EnclaveInput"));
+  }
+  if (buffers->output.size() < run_channel_buffer_size_) {
+    buffers->output.resize(run_channel_buffer_size_);
   }
 
-  return status;
+  char *output_buf = nullptr;
+  size_t output_len = 0;
+  Status status = run_with_buffer(
+      id_, buffers->input.data(), buffers->input.size(),
+      buffers->output.data(), buffers->output.size(), &output_buf, &output_len);
+  if (!status.ok()) {
+    return release(status);
+  }
+
+  // Parse directly into the caller's output, avoiding an intermediate copy.
+  EnclaveOutput *parsed_output = output ? output : &buffers->scratch_output;
+  parsed_output->ParseFromArray(output_buf, output_len);
+  status.RestoreFrom(parsed_output->status());
+
+  // The output only needs to be freed if it did not fit in the channel buffer,
+  // in which case it was allocated inside the enclave using
+  // enc_untrusted_malloc().
+  if (output_buf != buffers->output.data()) {
+    free(output_buf);
+  }
+
+  return release(status);
+}
+
+Status SGXClient::EnterAndRunBatch(const std::vector<EnclaveInput> &inputs,
+                                   std::vector<EnclaveOutput> *outputs,
+                                   std::vector<Status> *statuses) {
+  // The copy of the inputs is only needed until they are serialized, so it is
+  // built on the thread's arena. The output batch stays on the heap so that its
+  // outputs can be swapped into |outputs| without copying.
+  std::string buf;
+  {
+    ScopedThreadArena arena;
+    EnclaveInputBatch *input_batch =
+        Arena::CreateMessage<EnclaveInputBatch>(arena.get());
+    input_batch->mutable_inputs()->Reserve(inputs.size());
+    for (const EnclaveInput &input : inputs) {
+      *input_batch->add_inputs() = input;
+    }
+    if (!input_batch->SerializeToString(&buf)) {
+      return Status(error::GoogleError::INVALID_ARGUMENT,
+                    "Failed to serialize EnclaveInputBatch");
+    }
+  }
+
+  char *output_buf = nullptr;
+  size_t output_len = 0;
+  Status status =
+      run_batch(id_, buf.data(), buf.size(), &output_buf, &output_len);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // Enclave entry-point was successfully invoked. |output_buf| is guaranteed to
+  // have a value, which was allocated inside the enclave using
+  // enc_untrusted_malloc().
+  EnclaveOutputBatch output_batch;
+  bool parsed = output_batch.ParseFromArray(output_buf, output_len);
+  free(output_buf);
+  if (!parsed) {
+    return Status(error::GoogleError::INTERNAL,
+                  "Failed to parse EnclaveOutputBatch");
+  }
+  status.RestoreFrom(output_batch.status());
+  if (!status.ok()) {
+    return status;
+  }
+  if (static_cast<size_t>(output_batch.outputs_size()) != inputs.size()) {
+    return Status(error::GoogleError::INTERNAL,
+                  absl::StrCat("Expected ", inputs.size(),
+                               " outputs from enclave, got ",
+                               output_batch.outputs_size()));
+  }
+
+  if (outputs) {
+    outputs->resize(inputs.size());
+  }
+  if (statuses) {
+    statuses->resize(inputs.size());
+  }
+  for (int i = 0; i < output_batch.outputs_size(); ++i) {
+    EnclaveOutput *output = output_batch.mutable_outputs(i);
+    if (statuses) {
+      (*statuses)[i].RestoreFrom(output->status());
+    }
+    if (outputs) {
+      (*outputs)[i].Swap(output);
+    }
+  }
+
+  return Status::OkStatus();
+}
+
+Status SGXClient::GetHostCallStats(HostCallStats *stats) {
+  char *output = nullptr;
+  size_t output_len = 0;
+  Status status = get_host_call_stats(id_, &output, &output_len);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // |output| points to an untrusted memory buffer allocated by the enclave. It
+  // is the untrusted caller's responsibility to free this buffer.
+  bool parsed = stats->ParseFromArray(output, output_len);
+  free(output);
+  if (!parsed) {
+    return Status(error::GoogleError::INTERNAL,
+                  "Failed to parse HostCallStats");
+  }
+  return Status::OkStatus();
+}
+
+Status SGXClient::GetHeapStats(HeapStats *stats) {
+  char *output = nullptr;
+  size_t output_len = 0;
+  Status status = get_heap_stats(id_, &output, &output_len);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // |output| points to an untrusted memory buffer allocated by the enclave. It
+  // is the untrusted caller's responsibility to free this buffer.
+  bool parsed = stats->ParseFromArray(output, output_len);
+  free(output);
+  if (!parsed) {
+    return Status(error::GoogleError::INTERNAL, "Failed to parse HeapStats");
+  }
+  return Status::OkStatus();
 }
 
 Status SGXClient::EnterAndFinalize(const EnclaveFinal &final_input) {
@@ -247,9 +517,10 @@ Status SGXClient::EnterAndFinalize(const EnclaveFinal &final_input) {
 
   // Enclave entry-point was successfully invoked. |output| is guaranteed to
   // have a value.
-  StatusProto status_proto;
-  status_proto.ParseFromArray(output, output_len);
-  status.RestoreFrom(status_proto);
+  ScopedThreadArena arena;
+  StatusProto *status_proto = Arena::CreateMessage<StatusProto>(arena.get());
+  status_proto->ParseFromArray(output, output_len);
+  status.RestoreFrom(*status_proto);
 
   // |output| points to an untrusted memory buffer allocated by the enclave. It
   // is the untrusted caller's responsibility to free this buffer.
@@ -19,6 +19,9 @@
 #ifndef ASYLO_PLATFORM_ARCH_SGX_UNTRUSTED_SGX_CLIENT_H_
 #define ASYLO_PLATFORM_ARCH_SGX_UNTRUSTED_SGX_CLIENT_H_
 
+#include <string>
+#include <vector>
+
 #include "asylo/platform/core/enclave_client.h"
 #include "asylo/platform/core/enclave_manager.h"
 #include "asylo/util/status.h"
@@ -32,6 +35,28 @@ class SGXClient : public EnclaveClient {
  public:
   explicit SGXClient(const std::string &name) : EnclaveClient(name) {}
   Status EnterAndRun(const EnclaveInput &input, EnclaveOutput *output) override;
+  Status EnterAndRunBatch(const std::vector<EnclaveInput> &inputs,
+                          std::vector<EnclaveOutput> *outputs,
+                          std::vector<Status> *statuses) override;
+  Status GetHostCallStats(HostCallStats *stats) override;
+  Status GetHeapStats(HeapStats *stats) override;
+
+  /// Enables the persistent run channel for subsequent calls to EnterAndRun().
+  ///
+  /// In this mode, each calling thread reuses an input serialization buffer and
+  /// an untrusted output buffer of at least \p output_buffer_size bytes across
+  /// calls. The enclave serializes its output directly into that buffer and the
+  /// output is parsed from it in place, which avoids allocating and freeing an
+  /// untrusted buffer for every call. Outputs larger than the buffer fall back
+  /// to the default path. Passing zero disables the run channel.
+  ///
+  /// This method is not thread-safe and should be called before the client is
+  /// shared between threads.
+  ///
+  /// \param output_buffer_size The size of the per-thread output buffer.
+  void EnableRunChannel(size_t output_buffer_size) {
+    run_channel_buffer_size_ = output_buffer_size;
+  }
 
   // Returns true when a TCS is active in simulation mode. Always returns false
   // in hardware mode, since TCS active/inactive state is only set and used in
@@ -46,9 +71,12 @@ class SGXClient : public EnclaveClient {
   Status EnterAndDonateThread() override;
   Status EnterAndHandleSignal(const EnclaveSignal &signal) override;
   Status DestroyEnclave() override;
+  Status EnterAndRunWithChannel(const EnclaveInput &input,
+                                EnclaveOutput *output);
   std::string path_;               // Path to enclave object file.
   sgx_launch_token_t token_;  // SGX SDK launch token.
   sgx_enclave_id_t id_;       // SGX SDK enclave identifier.
+  size_t run_channel_buffer_size_ = 0;  // Size of the run channel buffer.
 };
 
 /// Enclave loader for Intel Software Guard Extension (SGX) based enclaves.
@@ -298,6 +298,11 @@ struct bridge_iovec {
   uint64_t iov_len;
 };
 
+struct bridge_mmsghdr {
+  struct bridge_msghdr msg_hdr;
+  uint32_t msg_len;
+};
+
 struct bridge_siginfo_t {
   int32_t si_signo;
   int32_t si_code;
@@ -0,0 +1,69 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/host_call_stats.h"
+
+namespace asylo {
+
+int HostCallLatencyBucket(int64_t latency_ns) {
+  if (latency_ns <= 1) {
+    return 0;
+  }
+  int bucket = 63 - __builtin_clzll(static_cast<uint64_t>(latency_ns));
+  return bucket < kHostCallLatencyBuckets ? bucket
+                                          : kHostCallLatencyBuckets - 1;
+}
+
+void RecordHostCall(uint64_t bytes_in, uint64_t bytes_out, int64_t latency_ns,
+                    HostCallCounters *counters) {
+  if (latency_ns < 0) {
+    latency_ns = 0;
+  }
+  counters->count.fetch_add(1, std::memory_order_relaxed);
+  counters->bytes_in.fetch_add(bytes_in, std::memory_order_relaxed);
+  counters->bytes_out.fetch_add(bytes_out, std::memory_order_relaxed);
+  counters->total_latency_ns.fetch_add(latency_ns, std::memory_order_relaxed);
+  counters->latency_histogram[HostCallLatencyBucket(latency_ns)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+void ResetHostCallCounters(HostCallCounters *counters) {
+  counters->count.store(0, std::memory_order_relaxed);
+  counters->bytes_in.store(0, std::memory_order_relaxed);
+  counters->bytes_out.store(0, std::memory_order_relaxed);
+  counters->total_latency_ns.store(0, std::memory_order_relaxed);
+  for (std::atomic<uint64_t> &bucket : counters->latency_histogram) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void CopyHostCallCounters(const char *name, const HostCallCounters &counters,
+                          HostCallStatsEntry *entry) {
+  entry->set_name(name);
+  entry->set_count(counters.count.load(std::memory_order_relaxed));
+  entry->set_bytes_in(counters.bytes_in.load(std::memory_order_relaxed));
+  entry->set_bytes_out(counters.bytes_out.load(std::memory_order_relaxed));
+  entry->set_total_latency_ns(
+      counters.total_latency_ns.load(std::memory_order_relaxed));
+  entry->clear_latency_histogram();
+  for (const std::atomic<uint64_t> &bucket : counters.latency_histogram) {
+    entry->add_latency_histogram(bucket.load(std::memory_order_relaxed));
+  }
+}
+
+}  // namespace asylo
@@ -0,0 +1,64 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_COMMON_HOST_CALL_STATS_H_
+#define ASYLO_PLATFORM_COMMON_HOST_CALL_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "asylo/enclave.pb.h"
+
+namespace asylo {
+
+// The number of buckets in the latency histogram of a host call. See
+// HostCallStatsEntry in asylo/enclave.proto for the bucket boundaries.
+constexpr int kHostCallLatencyBuckets = 32;
+
+// Counters for one type of host call. The counters are updated with relaxed
+// atomic operations, so a snapshot taken while calls are in progress may be
+// slightly inconsistent across fields, but each field is accurate on its own.
+// An object with static storage duration starts out with all counters zero.
+struct HostCallCounters {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> bytes_in;
+  std::atomic<uint64_t> bytes_out;
+  std::atomic<uint64_t> total_latency_ns;
+  std::atomic<uint64_t> latency_histogram[kHostCallLatencyBuckets];
+};
+
+// Returns the index of the latency histogram bucket for a call that took
+// |latency_ns| nanoseconds.
+int HostCallLatencyBucket(int64_t latency_ns);
+
+// Records a call that copied |bytes_in| bytes for its [in] parameters and
+// |bytes_out| bytes for its [out] parameters and took |latency_ns|
+// nanoseconds. Negative latencies are recorded as zero.
+void RecordHostCall(uint64_t bytes_in, uint64_t bytes_out, int64_t latency_ns,
+                    HostCallCounters *counters);
+
+// Sets all of the counters in |counters| to zero.
+void ResetHostCallCounters(HostCallCounters *counters);
+
+// Copies a snapshot of |counters| to |entry|, which is labeled with |name|.
+void CopyHostCallCounters(const char *name, const HostCallCounters &counters,
+                          HostCallStatsEntry *entry);
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_COMMON_HOST_CALL_STATS_H_
@@ -0,0 +1,106 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/host_call_stats.h"
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace asylo {
+namespace {
+
+// Tests that latencies are bucketed by their most significant bit.
+TEST(HostCallStatsTest, LatencyBuckets) {
+  EXPECT_EQ(HostCallLatencyBucket(-5), 0);
+  EXPECT_EQ(HostCallLatencyBucket(0), 0);
+  EXPECT_EQ(HostCallLatencyBucket(1), 0);
+  EXPECT_EQ(HostCallLatencyBucket(2), 1);
+  EXPECT_EQ(HostCallLatencyBucket(3), 1);
+  EXPECT_EQ(HostCallLatencyBucket(4), 2);
+  EXPECT_EQ(HostCallLatencyBucket(1023), 9);
+  EXPECT_EQ(HostCallLatencyBucket(1024), 10);
+
+  // Latencies beyond the last bucket are counted in the last bucket.
+  EXPECT_EQ(HostCallLatencyBucket(INT64_C(1) << 40),
+            kHostCallLatencyBuckets - 1);
+  EXPECT_EQ(HostCallLatencyBucket(INT64_MAX), kHostCallLatencyBuckets - 1);
+}
+
+// Tests that recorded calls are reflected in a snapshot of the counters.
+TEST(HostCallStatsTest, RecordAndCopy) {
+  static HostCallCounters counters;
+  RecordHostCall(/*bytes_in=*/10, /*bytes_out=*/0, /*latency_ns=*/1000,
+                 &counters);
+  RecordHostCall(/*bytes_in=*/5, /*bytes_out=*/7, /*latency_ns=*/1500,
+                 &counters);
+  RecordHostCall(/*bytes_in=*/0, /*bytes_out=*/0, /*latency_ns=*/-1,
+                 &counters);
+
+  HostCallStatsEntry entry;
+  CopyHostCallCounters("read", counters, &entry);
+  EXPECT_EQ(entry.name(), "read");
+  EXPECT_EQ(entry.count(), 3);
+  EXPECT_EQ(entry.bytes_in(), 15);
+  EXPECT_EQ(entry.bytes_out(), 7);
+  EXPECT_EQ(entry.total_latency_ns(), 2500);
+  ASSERT_EQ(entry.latency_histogram_size(), kHostCallLatencyBuckets);
+  EXPECT_EQ(entry.latency_histogram(0), 1);
+  EXPECT_EQ(entry.latency_histogram(9), 1);
+  EXPECT_EQ(entry.latency_histogram(10), 1);
+
+  // Copying again replaces the previous snapshot.
+  ResetHostCallCounters(&counters);
+  CopyHostCallCounters("read", counters, &entry);
+  EXPECT_EQ(entry.count(), 0);
+  EXPECT_EQ(entry.total_latency_ns(), 0);
+  ASSERT_EQ(entry.latency_histogram_size(), kHostCallLatencyBuckets);
+  for (uint64_t bucket : entry.latency_histogram()) {
+    EXPECT_EQ(bucket, 0);
+  }
+}
+
+// Tests that no calls are lost when recorded from several threads.
+TEST(HostCallStatsTest, ConcurrentRecording) {
+  constexpr int kNumThreads = 8;
+  constexpr int kCallsPerThread = 10000;
+  static HostCallCounters counters;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([] {
+      for (int j = 0; j < kCallsPerThread; ++j) {
+        RecordHostCall(1, 2, 100, &counters);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  HostCallStatsEntry entry;
+  CopyHostCallCounters("write", counters, &entry);
+  EXPECT_EQ(entry.count(), kNumThreads * kCallsPerThread);
+  EXPECT_EQ(entry.bytes_in(), kNumThreads * kCallsPerThread);
+  EXPECT_EQ(entry.bytes_out(), 2 * kNumThreads * kCallsPerThread);
+  EXPECT_EQ(entry.latency_histogram(6), kNumThreads * kCallsPerThread);
+}
+
+}  // namespace
+}  // namespace asylo
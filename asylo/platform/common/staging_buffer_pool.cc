@@ -0,0 +1,100 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/staging_buffer_pool.h"
+
+namespace asylo {
+namespace {
+
+// Returns the index of the smallest size class that holds |size| bytes. Size
+// class i holds buffers of kMinBufferSize << i bytes.
+int SizeClass(size_t size) {
+  int size_class = 0;
+  while ((StagingBufferPool::kMinBufferSize << size_class) < size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+}  // namespace
+
+constexpr size_t StagingBufferPool::kMinBufferSize;
+constexpr int StagingBufferPool::kNumSizeClasses;
+
+StagingBufferPool::Buffer::Buffer(Buffer &&other)
+    : pool_(other.pool_), data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+}
+
+StagingBufferPool::Buffer::~Buffer() {
+  if (data_) {
+    pool_->Release(data_, size_);
+  }
+}
+
+StagingBufferPool::StagingBufferPool(AllocateFunction allocate,
+                                     FreeFunction free,
+                                     size_t max_cached_bytes)
+    : allocate_(allocate),
+      free_(free),
+      max_cached_bytes_(max_cached_bytes),
+      cached_bytes_(0) {}
+
+StagingBufferPool::~StagingBufferPool() {
+  for (std::vector<char *> &free_list : free_lists_) {
+    for (char *data : free_list) {
+      free_(data);
+    }
+  }
+}
+
+StagingBufferPool::Buffer StagingBufferPool::Acquire(size_t size) {
+  int size_class = SizeClass(size);
+  size_t class_size = kMinBufferSize << size_class;
+  {
+    absl::MutexLock lock(&mu_);
+    std::vector<char *> &free_list = free_lists_[size_class];
+    if (!free_list.empty()) {
+      char *data = free_list.back();
+      free_list.pop_back();
+      cached_bytes_ -= class_size;
+      return Buffer(this, data, class_size);
+    }
+  }
+  char *data = static_cast<char *>(allocate_(class_size));
+  return Buffer(this, data, data ? class_size : 0);
+}
+
+size_t StagingBufferPool::cached_bytes() const {
+  absl::MutexLock lock(&mu_);
+  return cached_bytes_;
+}
+
+void StagingBufferPool::Release(char *data, size_t size) {
+  {
+    absl::MutexLock lock(&mu_);
+    if (cached_bytes_ + size <= max_cached_bytes_) {
+      free_lists_[SizeClass(size)].push_back(data);
+      cached_bytes_ += size;
+      return;
+    }
+  }
+  free_(data);
+}
+
+}  // namespace asylo
@@ -0,0 +1,106 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_COMMON_STAGING_BUFFER_POOL_H_
+#define ASYLO_PLATFORM_COMMON_STAGING_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+
+namespace asylo {
+
+// A pool of reusable buffers obtained from a caller-provided allocator. It is
+// used to stage data in untrusted memory for host calls that transfer large
+// buffers, so that each transfer does not have to allocate and free untrusted
+// memory with two additional host calls.
+//
+// Buffers are handed out in power-of-two size classes. A released buffer is
+// kept for reuse as long as the total size of the cached buffers does not
+// exceed the limit the pool was created with, and is freed otherwise.
+class StagingBufferPool {
+ public:
+  using AllocateFunction = void *(*)(size_t size);
+  using FreeFunction = void (*)(void *ptr);
+
+  // The size of the smallest size class.
+  static constexpr size_t kMinBufferSize = 4096;
+
+  // A buffer borrowed from a pool. The buffer is returned to the pool when the
+  // object is destroyed.
+  class Buffer {
+   public:
+    Buffer(Buffer &&other);
+    ~Buffer();
+
+    Buffer(const Buffer &) = delete;
+    Buffer &operator=(const Buffer &) = delete;
+    Buffer &operator=(Buffer &&) = delete;
+
+    // Returns the buffer, or nullptr if it could not be allocated.
+    char *data() const { return data_; }
+
+    // Returns the size of the buffer, which may be larger than requested.
+    size_t size() const { return size_; }
+
+   private:
+    friend class StagingBufferPool;
+
+    Buffer(StagingBufferPool *pool, char *data, size_t size)
+        : pool_(pool), data_(data), size_(size) {}
+
+    StagingBufferPool *pool_;
+    char *data_;
+    size_t size_;
+  };
+
+  // Creates a pool that allocates buffers with |allocate| and frees them with
+  // |free|, and caches up to |max_cached_bytes| bytes of released buffers.
+  StagingBufferPool(AllocateFunction allocate, FreeFunction free,
+                    size_t max_cached_bytes);
+  ~StagingBufferPool();
+
+  StagingBufferPool(const StagingBufferPool &) = delete;
+  StagingBufferPool &operator=(const StagingBufferPool &) = delete;
+
+  // Returns a buffer of at least |size| bytes, reusing a cached buffer of the
+  // same size class if there is one.
+  Buffer Acquire(size_t size) LOCKS_EXCLUDED(mu_);
+
+  // Returns the total size of the buffers currently cached by the pool.
+  size_t cached_bytes() const LOCKS_EXCLUDED(mu_);
+
+ private:
+  // The number of size classes, which covers every size_t value.
+  static constexpr int kNumSizeClasses = 64;
+
+  void Release(char *data, size_t size) LOCKS_EXCLUDED(mu_);
+
+  const AllocateFunction allocate_;
+  const FreeFunction free_;
+  const size_t max_cached_bytes_;
+
+  mutable absl::Mutex mu_;
+  std::vector<char *> free_lists_[kNumSizeClasses] GUARDED_BY(mu_);
+  size_t cached_bytes_ GUARDED_BY(mu_);
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_COMMON_STAGING_BUFFER_POOL_H_
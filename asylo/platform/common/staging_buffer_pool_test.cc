@@ -0,0 +1,121 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/staging_buffer_pool.h"
+
+#include <cstdlib>
+#include <utility>
+
+#include <gtest/gtest.h>
+
+namespace asylo {
+namespace {
+
+// The number of live allocations made through CountingAllocate.
+int live_allocations = 0;
+
+// The number of calls to CountingAllocate.
+int total_allocations = 0;
+
+void *CountingAllocate(size_t size) {
+  ++live_allocations;
+  ++total_allocations;
+  return malloc(size);
+}
+
+void CountingFree(void *ptr) {
+  --live_allocations;
+  free(ptr);
+}
+
+class StagingBufferPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    live_allocations = 0;
+    total_allocations = 0;
+  }
+};
+
+// Tests that buffers are rounded up to a power-of-two size class.
+TEST_F(StagingBufferPoolTest, BuffersAreRoundedUpToSizeClass) {
+  StagingBufferPool pool(CountingAllocate, CountingFree, 1 << 20);
+  EXPECT_EQ(pool.Acquire(1).size(), StagingBufferPool::kMinBufferSize);
+  EXPECT_EQ(pool.Acquire(StagingBufferPool::kMinBufferSize).size(),
+            StagingBufferPool::kMinBufferSize);
+  EXPECT_EQ(pool.Acquire(StagingBufferPool::kMinBufferSize + 1).size(),
+            2 * StagingBufferPool::kMinBufferSize);
+  EXPECT_EQ(pool.Acquire(100000).size(), 131072);
+}
+
+// Tests that a released buffer is reused for a request of the same size class.
+TEST_F(StagingBufferPoolTest, ReleasedBuffersAreReused) {
+  StagingBufferPool pool(CountingAllocate, CountingFree, 1 << 20);
+  char *data;
+  {
+    StagingBufferPool::Buffer buffer = pool.Acquire(10000);
+    ASSERT_NE(buffer.data(), nullptr);
+    data = buffer.data();
+  }
+  EXPECT_EQ(pool.cached_bytes(), 16384);
+  {
+    StagingBufferPool::Buffer buffer = pool.Acquire(16000);
+    EXPECT_EQ(buffer.data(), data);
+    EXPECT_EQ(pool.cached_bytes(), 0);
+  }
+  EXPECT_EQ(total_allocations, 1);
+}
+
+// Tests that buffers that do not fit in the cache are freed on release, and
+// that cached buffers are freed with the pool.
+TEST_F(StagingBufferPoolTest, CacheIsBounded) {
+  {
+    StagingBufferPool pool(CountingAllocate, CountingFree, 8192);
+    {
+      StagingBufferPool::Buffer small = pool.Acquire(8192);
+      StagingBufferPool::Buffer large = pool.Acquire(65536);
+      EXPECT_EQ(live_allocations, 2);
+    }
+    EXPECT_EQ(live_allocations, 1);
+    EXPECT_EQ(pool.cached_bytes(), 8192);
+  }
+  EXPECT_EQ(live_allocations, 0);
+}
+
+// Tests that a moved buffer is released exactly once.
+TEST_F(StagingBufferPoolTest, MovedBufferIsReleasedOnce) {
+  StagingBufferPool pool(CountingAllocate, CountingFree, 0);
+  {
+    StagingBufferPool::Buffer buffer = pool.Acquire(100);
+    StagingBufferPool::Buffer moved(std::move(buffer));
+    EXPECT_EQ(buffer.data(), nullptr);
+    EXPECT_NE(moved.data(), nullptr);
+  }
+  EXPECT_EQ(live_allocations, 0);
+}
+
+// Tests that allocation failures are reported with a null buffer.
+TEST_F(StagingBufferPoolTest, AllocationFailureYieldsNullBuffer) {
+  StagingBufferPool pool([](size_t size) -> void * { return nullptr; },
+                         CountingFree, 1 << 20);
+  StagingBufferPool::Buffer buffer = pool.Acquire(100);
+  EXPECT_EQ(buffer.data(), nullptr);
+  EXPECT_EQ(buffer.size(), 0);
+}
+
+}  // namespace
+}  // namespace asylo
@@ -0,0 +1,74 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/thread_arena.h"
+
+namespace asylo {
+namespace {
+
+// The reusable arena of a thread, along with its initial block.
+struct ThreadArena {
+  ThreadArena() {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = initial_block;
+    options.initial_block_size = sizeof(initial_block);
+    arena.reset(new google::protobuf::Arena(options));
+  }
+
+  alignas(8) char initial_block[kThreadArenaInitialBlockSize];
+  std::unique_ptr<google::protobuf::Arena> arena;
+
+  // Set while a ScopedThreadArena on the thread is using |arena|.
+  bool in_use = false;
+};
+
+// The arena of the calling thread. Created on first use and never destroyed,
+// since thread-local objects with non-trivial destructors are not supported in
+// all enclave runtimes.
+thread_local ThreadArena *thread_arena = nullptr;
+
+// The arena returned by ScopedThreadArena::Current().
+thread_local google::protobuf::Arena *current_arena = nullptr;
+
+}  // namespace
+
+ScopedThreadArena::ScopedThreadArena() : previous_(current_arena) {
+  if (!thread_arena) {
+    thread_arena = new ThreadArena();
+  }
+  if (thread_arena->in_use) {
+    nested_arena_.reset(new google::protobuf::Arena());
+    arena_ = nested_arena_.get();
+  } else {
+    thread_arena->in_use = true;
+    arena_ = thread_arena->arena.get();
+  }
+  current_arena = arena_;
+}
+
+ScopedThreadArena::~ScopedThreadArena() {
+  current_arena = previous_;
+  if (!nested_arena_) {
+    arena_->Reset();
+    thread_arena->in_use = false;
+  }
+}
+
+google::protobuf::Arena *ScopedThreadArena::Current() { return current_arena; }
+
+}  // namespace asylo
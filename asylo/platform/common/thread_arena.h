@@ -0,0 +1,75 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_COMMON_THREAD_ARENA_H_
+#define ASYLO_PLATFORM_COMMON_THREAD_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+
+#include <google/protobuf/arena.h>
+
+namespace asylo {
+
+// The size of the initial block of the arena of each thread. Messages that fit
+// in the initial block are parsed and built without any heap allocations once
+// the thread's arena has been created.
+constexpr size_t kThreadArenaInitialBlockSize = 8192;
+
+// Provides a protobuf arena for the messages that only live for the duration of
+// a single call across the enclave boundary.
+//
+// Each thread keeps a single arena that is reused by every ScopedThreadArena on
+// that thread and reset when the ScopedThreadArena is destroyed. Resetting the
+// arena keeps its initial block, so steady-state calls whose messages fit in
+// the initial block do not allocate from the heap. A ScopedThreadArena created
+// while another one is alive on the same thread, such as by a call into an
+// enclave made while handling a host call, uses a fresh arena of its own so
+// that it does not free the messages of the outer call.
+//
+// ScopedThreadArena is not copyable and must be destroyed on the thread that
+// created it.
+class ScopedThreadArena {
+ public:
+  ScopedThreadArena();
+  ~ScopedThreadArena();
+
+  ScopedThreadArena(const ScopedThreadArena &other) = delete;
+  ScopedThreadArena &operator=(const ScopedThreadArena &other) = delete;
+
+  // Returns the arena provided by this object.
+  google::protobuf::Arena *get() const { return arena_; }
+
+  // Returns the arena of the innermost ScopedThreadArena alive on the calling
+  // thread, or nullptr if there is none.
+  static google::protobuf::Arena *Current();
+
+ private:
+  // The arena provided by this object.
+  google::protobuf::Arena *arena_;
+
+  // Owns |arena_| if it is not the arena of the thread.
+  std::unique_ptr<google::protobuf::Arena> nested_arena_;
+
+  // The value of Current() before this object was created.
+  google::protobuf::Arena *previous_;
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_COMMON_THREAD_ARENA_H_
@@ -0,0 +1,120 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/thread_arena.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <gtest/gtest.h>
+#include "asylo/enclave.pb.h"
+
+// Counts the heap allocations made by the test.
+static std::atomic<int> num_allocations(0);
+
+void *operator new(size_t size) {
+  ++num_allocations;
+  void *ptr = malloc(size);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t size) noexcept { free(ptr); }
+
+namespace asylo {
+namespace {
+
+// Tests that Current() returns the arena of the innermost scope.
+TEST(ThreadArenaTest, CurrentTracksInnermostScope) {
+  EXPECT_EQ(ScopedThreadArena::Current(), nullptr);
+  {
+    ScopedThreadArena outer;
+    EXPECT_EQ(ScopedThreadArena::Current(), outer.get());
+    {
+      ScopedThreadArena inner;
+      EXPECT_NE(inner.get(), outer.get());
+      EXPECT_EQ(ScopedThreadArena::Current(), inner.get());
+    }
+    EXPECT_EQ(ScopedThreadArena::Current(), outer.get());
+  }
+  EXPECT_EQ(ScopedThreadArena::Current(), nullptr);
+}
+
+// Tests that a thread reuses its arena, and that a nested scope does not free
+// the messages of the outer scope.
+TEST(ThreadArenaTest, ArenaIsReusedAndReset) {
+  google::protobuf::Arena *first_arena;
+  {
+    ScopedThreadArena arena;
+    first_arena = arena.get();
+    EnclaveOutput *output =
+        google::protobuf::Arena::CreateMessage<EnclaveOutput>(arena.get());
+    output->mutable_status()->set_code(1);
+    {
+      ScopedThreadArena nested;
+      google::protobuf::Arena::CreateMessage<EnclaveOutput>(nested.get());
+    }
+    EXPECT_EQ(output->status().code(), 1);
+  }
+
+  ScopedThreadArena arena;
+  EXPECT_EQ(arena.get(), first_arena);
+  EXPECT_EQ(arena.get()->SpaceUsed(), 0);
+}
+
+// Tests that, after the first use on a thread, parsing a small message into
+// the arena does not allocate from the heap.
+TEST(ThreadArenaTest, ParsingAvoidsHeapAllocations) {
+  EnclaveOutput message;
+  message.mutable_status()->set_code(3);
+  message.mutable_status()->set_error_message("error");
+  std::string serialized = message.SerializeAsString();
+
+  int heap_allocations;
+  {
+    int start = num_allocations;
+    EnclaveOutput parsed;
+    ASSERT_TRUE(parsed.ParseFromString(serialized));
+    heap_allocations = num_allocations - start;
+  }
+
+  // Create the thread's arena.
+  { ScopedThreadArena warm_up; }
+
+  int arena_allocations;
+  {
+    int start = num_allocations;
+    ScopedThreadArena arena;
+    EnclaveOutput *parsed =
+        google::protobuf::Arena::CreateMessage<EnclaveOutput>(arena.get());
+    ASSERT_TRUE(parsed->ParseFromString(serialized));
+    arena_allocations = num_allocations - start;
+  }
+
+  EXPECT_GT(heap_allocations, 0);
+  EXPECT_EQ(arena_allocations, 0);
+}
+
+}  // namespace
+}  // namespace asylo
@@ -0,0 +1,65 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/tsc_clock.h"
+
+#include <cpuid.h>
+
+namespace asylo {
+namespace {
+
+// CPUID.80000007H:EDX[8] indicates an invariant TSC.
+constexpr unsigned int kInvariantTscBit = 1u << 8;
+
+// CPUID.(EAX=07H, ECX=0H):EBX[2] indicates support for SGX.
+constexpr unsigned int kSgxBit = 1u << 2;
+
+// CPUID.(EAX=12H, ECX=0H):EAX[1] indicates support for SGX2, which permits
+// RDTSC inside an enclave.
+constexpr unsigned int kSgx2Bit = 1u << 1;
+
+}  // namespace
+
+bool IsTscClockSupported() {
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) ||
+      !(edx & kInvariantTscBit)) {
+    return false;
+  }
+
+  // RDTSC raises #UD inside an SGX1 enclave. A CPU without SGX can only run
+  // enclaves in simulation mode, where RDTSC is always permitted.
+  if (!__get_cpuid_count(0x07, 0, &eax, &ebx, &ecx, &edx) ||
+      !(ebx & kSgxBit)) {
+    return true;
+  }
+  return __get_cpuid_count(0x12, 0, &eax, &ebx, &ecx, &edx) &&
+         (eax & kSgx2Bit);
+}
+
+uint64_t ComputeTscClockMultiplier(uint64_t tsc_start, int64_t monotonic_start,
+                                   uint64_t tsc_end, int64_t monotonic_end) {
+  if (tsc_end <= tsc_start || monotonic_end <= monotonic_start) {
+    return 0;
+  }
+  unsigned __int128 elapsed_ns = monotonic_end - monotonic_start;
+  return static_cast<uint64_t>((elapsed_ns << kTscClockShift) /
+                               (tsc_end - tsc_start));
+}
+
+}  // namespace asylo
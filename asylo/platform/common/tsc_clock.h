@@ -0,0 +1,165 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_COMMON_TSC_CLOCK_H_
+#define ASYLO_PLATFORM_COMMON_TSC_CLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+namespace asylo {
+
+// A clock derived from the CPU's time-stamp counter (TSC).
+//
+// The host periodically publishes the value of the TSC together with the
+// values of CLOCK_MONOTONIC and CLOCK_REALTIME sampled at the same instant, and
+// the rate at which the TSC advances. A reader computes the current time by
+// reading the TSC and extrapolating from the published sample. The parameters
+// only need to be republished occasionally to follow adjustments to the host
+// clocks, so no host thread has to wake up at the clock's resolution.
+//
+// The parameters are published with a sequence lock: the writer makes
+// |sequence| odd while it updates the other fields and even once it is done,
+// and a reader retries if it observes an odd or changed sequence number.
+struct TscClockParameters {
+  std::atomic<uint64_t> sequence;
+
+  // The value of the TSC at which the clocks were sampled.
+  std::atomic<uint64_t> tsc_base;
+
+  // The values of CLOCK_MONOTONIC and CLOCK_REALTIME, in nanoseconds, at
+  // |tsc_base|.
+  std::atomic<int64_t> monotonic_base;
+  std::atomic<int64_t> realtime_base;
+
+  // The number of nanoseconds per TSC tick as a fixed-point value with
+  // kTscClockShift fractional bits. Zero if the parameters are unusable.
+  std::atomic<uint64_t> multiplier;
+};
+
+// The number of fractional bits in TscClockParameters::multiplier.
+constexpr int kTscClockShift = 32;
+
+// Returns the current value of the time-stamp counter.
+inline uint64_t ReadTsc() { return __builtin_ia32_rdtsc(); }
+
+// Returns true if the TSC of the host CPU runs at a constant rate in all power
+// states and can be read from inside an enclave. May only be called outside an
+// enclave.
+bool IsTscClockSupported();
+
+// Computes the multiplier for TscClockParameters from two samples of the TSC
+// and CLOCK_MONOTONIC. Returns zero if the samples do not describe a TSC
+// advancing at a positive rate.
+uint64_t ComputeTscClockMultiplier(uint64_t tsc_start, int64_t monotonic_start,
+                                   uint64_t tsc_end, int64_t monotonic_end);
+
+// Publishes a new set of parameters to |params|. Concurrent calls for the same
+// |params| are not supported.
+inline void PublishTscClockParameters(uint64_t tsc_base, int64_t monotonic_base,
+                                      int64_t realtime_base,
+                                      uint64_t multiplier,
+                                      TscClockParameters *params) {
+  uint64_t sequence = params->sequence.load(std::memory_order_relaxed);
+  params->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  params->tsc_base.store(tsc_base, std::memory_order_relaxed);
+  params->monotonic_base.store(monotonic_base, std::memory_order_relaxed);
+  params->realtime_base.store(realtime_base, std::memory_order_relaxed);
+  params->multiplier.store(multiplier, std::memory_order_relaxed);
+  params->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Computes the current values of CLOCK_MONOTONIC and CLOCK_REALTIME in
+// nanoseconds from |params| and |tsc|. Returns false if a consistent and usable
+// set of parameters could not be read, in which case the caller should use
+// another clock source.
+inline bool ReadTscClock(const TscClockParameters &params, uint64_t tsc,
+                         int64_t *monotonic, int64_t *realtime) {
+  constexpr int kMaxAttempts = 16;
+  for (int i = 0; i < kMaxAttempts; ++i) {
+    uint64_t sequence = params.sequence.load(std::memory_order_acquire);
+    uint64_t tsc_base = params.tsc_base.load(std::memory_order_relaxed);
+    int64_t monotonic_base =
+        params.monotonic_base.load(std::memory_order_relaxed);
+    int64_t realtime_base = params.realtime_base.load(std::memory_order_relaxed);
+    uint64_t multiplier = params.multiplier.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((sequence & 1) ||
+        params.sequence.load(std::memory_order_relaxed) != sequence) {
+      continue;
+    }
+
+    // A TSC value before the base sample means the TSC is not synchronized
+    // across CPUs, or the parameters are not trustworthy.
+    if (multiplier == 0 || tsc < tsc_base) {
+      return false;
+    }
+    int64_t elapsed = static_cast<int64_t>(
+        (static_cast<unsigned __int128>(tsc - tsc_base) * multiplier) >>
+        kTscClockShift);
+    *monotonic = monotonic_base + elapsed;
+    *realtime = realtime_base + elapsed;
+    return true;
+  }
+  return false;
+}
+
+// The sources the trusted monotonic clock may be read from.
+enum class MonotonicClockSource { kNone, kTsc, kHostCall, kTicker };
+
+// Keeps the trusted monotonic clock from going backwards as observed by one
+// thread while it switches between unsynchronized sources.
+//
+// A sample that is behind the previous sample from the same host-provided
+// source (a host call or the ticker) means the host rewound its clock, which
+// is fatal. Samples extrapolated from the TSC may legitimately step back
+// slightly when the parameters are republished, and samples from different
+// sources are not comparable, so in those cases the sample is clamped to the
+// largest value returned so far.
+class MonotonicClockGuard {
+ public:
+  // Returns |sample|, read from |source|, clamped to never decrease. Aborts if
+  // the host rewound |source| since it was last read.
+  int64_t Advance(MonotonicClockSource source, int64_t sample) {
+    if (source == last_source_ && source != MonotonicClockSource::kTsc &&
+        sample < last_sample_) {
+      abort();
+    }
+    last_source_ = source;
+    last_sample_ = sample;
+    if (sample < last_value_) {
+      return last_value_;
+    }
+    last_value_ = sample;
+    return sample;
+  }
+
+ private:
+  // The source and raw value of the previous sample.
+  MonotonicClockSource last_source_ = MonotonicClockSource::kNone;
+  int64_t last_sample_ = 0;
+
+  // The largest value returned so far.
+  int64_t last_value_ = 0;
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_COMMON_TSC_CLOCK_H_
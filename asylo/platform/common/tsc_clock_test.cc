@@ -0,0 +1,171 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/common/tsc_clock.h"
+
+#include <time.h>
+#include <atomic>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+namespace asylo {
+namespace {
+
+constexpr uint64_t kOne = UINT64_C(1) << kTscClockShift;
+
+// Returns the value of |clock_id| as a number of nanoseconds.
+int64_t Now(clockid_t clock_id) {
+  struct timespec ts;
+  clock_gettime(clock_id, &ts);
+  return ts.tv_sec * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+// Tests that the multiplier is the number of nanoseconds per tick.
+TEST(TscClockTest, ComputeMultiplier) {
+  EXPECT_EQ(ComputeTscClockMultiplier(100, 1000, 200, 1100), kOne);
+  EXPECT_EQ(ComputeTscClockMultiplier(0, 0, 4, 1), kOne / 4);
+  EXPECT_EQ(ComputeTscClockMultiplier(0, 0, 1, 3), 3 * kOne);
+
+  // Samples that do not move forward yield an unusable multiplier.
+  EXPECT_EQ(ComputeTscClockMultiplier(200, 1000, 100, 1100), 0);
+  EXPECT_EQ(ComputeTscClockMultiplier(100, 1000, 200, 1000), 0);
+}
+
+// Tests that time is extrapolated from the published sample.
+TEST(TscClockTest, ReadExtrapolatesFromBase) {
+  TscClockParameters params = {};
+  PublishTscClockParameters(/*tsc_base=*/1000, /*monotonic_base=*/50,
+                            /*realtime_base=*/5000, /*multiplier=*/2 * kOne,
+                            &params);
+  EXPECT_EQ(params.sequence, 2);
+
+  int64_t monotonic;
+  int64_t realtime;
+  ASSERT_TRUE(ReadTscClock(params, 1000, &monotonic, &realtime));
+  EXPECT_EQ(monotonic, 50);
+  EXPECT_EQ(realtime, 5000);
+
+  ASSERT_TRUE(ReadTscClock(params, 1010, &monotonic, &realtime));
+  EXPECT_EQ(monotonic, 70);
+  EXPECT_EQ(realtime, 5020);
+
+  // Large intervals do not overflow the intermediate product.
+  uint64_t ticks = UINT64_C(1) << 40;
+  ASSERT_TRUE(ReadTscClock(params, 1000 + ticks, &monotonic, &realtime));
+  EXPECT_EQ(monotonic, 50 + 2 * static_cast<int64_t>(ticks));
+}
+
+// Tests that unusable parameters are reported to the caller.
+TEST(TscClockTest, ReadFailsWithUnusableParameters) {
+  TscClockParameters params = {};
+  int64_t monotonic;
+  int64_t realtime;
+
+  // Never published.
+  EXPECT_FALSE(ReadTscClock(params, 1000, &monotonic, &realtime));
+
+  // TSC value before the base sample.
+  PublishTscClockParameters(1000, 0, 0, kOne, &params);
+  EXPECT_FALSE(ReadTscClock(params, 999, &monotonic, &realtime));
+
+  // Update in progress.
+  params.sequence = 3;
+  EXPECT_FALSE(ReadTscClock(params, 1000, &monotonic, &realtime));
+}
+
+// Tests that readers never observe a mix of two sets of parameters.
+TEST(TscClockTest, ReadersSeeConsistentParameters) {
+  TscClockParameters params = {};
+  PublishTscClockParameters(0, 0, 0, kOne, &params);
+
+  // Each set of parameters satisfies realtime == 2 * monotonic at tsc == 0.
+  std::atomic<bool> done(false);
+  std::thread writer([&params, &done] {
+    for (int64_t i = 1; !done; ++i) {
+      PublishTscClockParameters(0, i, 2 * i, kOne, &params);
+    }
+  });
+
+  for (int i = 0; i < 100000; ++i) {
+    int64_t monotonic;
+    int64_t realtime;
+    if (ReadTscClock(params, 0, &monotonic, &realtime)) {
+      ASSERT_EQ(realtime, 2 * monotonic);
+    }
+  }
+  done = true;
+  writer.join();
+}
+
+// Tests that the TSC clock tracks CLOCK_MONOTONIC on the host.
+TEST(TscClockTest, TracksHostClock) {
+  if (!IsTscClockSupported()) {
+    return;
+  }
+
+  uint64_t tsc_start = ReadTsc();
+  int64_t monotonic_start = Now(CLOCK_MONOTONIC);
+  struct timespec delay = {0, 20000000};
+  nanosleep(&delay, nullptr);
+  uint64_t multiplier = ComputeTscClockMultiplier(
+      tsc_start, monotonic_start, ReadTsc(), Now(CLOCK_MONOTONIC));
+  ASSERT_NE(multiplier, 0);
+
+  TscClockParameters params = {};
+  PublishTscClockParameters(ReadTsc(), Now(CLOCK_MONOTONIC),
+                            Now(CLOCK_REALTIME), multiplier, &params);
+  nanosleep(&delay, nullptr);
+
+  int64_t monotonic;
+  int64_t realtime;
+  ASSERT_TRUE(ReadTscClock(params, ReadTsc(), &monotonic, &realtime));
+  EXPECT_NEAR(monotonic, Now(CLOCK_MONOTONIC), 2000000);
+  EXPECT_NEAR(realtime, Now(CLOCK_REALTIME), 2000000);
+}
+
+// Tests that the guard clamps when switching between sources and when the TSC
+// clock steps back.
+TEST(TscClockTest, GuardClampsAcrossSources) {
+  MonotonicClockGuard guard;
+  EXPECT_EQ(guard.Advance(MonotonicClockSource::kTicker, 100), 100);
+  EXPECT_EQ(guard.Advance(MonotonicClockSource::kTsc, 300), 300);
+  EXPECT_EQ(guard.Advance(MonotonicClockSource::kTsc, 250), 300);
+  EXPECT_EQ(guard.Advance(MonotonicClockSource::kTicker, 150), 300);
+  EXPECT_EQ(guard.Advance(MonotonicClockSource::kTicker, 160), 300);
+  EXPECT_EQ(guard.Advance(MonotonicClockSource::kHostCall, 200), 300);
+  EXPECT_EQ(guard.Advance(MonotonicClockSource::kHostCall, 400), 400);
+}
+
+// Tests that a ticker going backwards is still detected.
+TEST(TscClockTest, GuardAbortsWhenTickerGoesBackwards) {
+  MonotonicClockGuard guard;
+  guard.Advance(MonotonicClockSource::kTicker, 100);
+  EXPECT_DEATH(guard.Advance(MonotonicClockSource::kTicker, 99), "");
+}
+
+// Tests that a host clock going backwards is still detected.
+TEST(TscClockTest, GuardAbortsWhenHostClockGoesBackwards) {
+  MonotonicClockGuard guard;
+  guard.Advance(MonotonicClockSource::kHostCall, 100);
+  guard.Advance(MonotonicClockSource::kHostCall, 100);
+  EXPECT_DEATH(guard.Advance(MonotonicClockSource::kHostCall, 50), "");
+}
+
+}  // namespace
+}  // namespace asylo
@@ -20,6 +20,7 @@
 #define ASYLO_PLATFORM_CORE_ENCLAVE_CLIENT_H_
 
 #include <unordered_map>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "asylo/enclave.pb.h"  // IWYU pragma: export
@@ -50,6 +51,64 @@ class EnclaveClient {
   virtual Status EnterAndRun(const EnclaveInput &input,
                              EnclaveOutput *output) = 0;
 
+  /// Enters the enclave and invokes its execution entry point once for each
+  /// element of \p inputs.
+  ///
+  /// Implementations may dispatch the whole batch within a single enclave
+  /// entry. The default implementation calls EnterAndRun() for each input.
+  ///
+  /// \param inputs The inputs to pass to the execution entry point, in order.
+  /// \param[out] outputs A nullable pointer to a vector that is resized to the
+  ///                     number of inputs and receives the output for each
+  ///                     input.
+  /// \param[out] statuses A nullable pointer to a vector that is resized to
+  ///                      the number of inputs and receives the status of the
+  ///                      execution entry point for each input.
+  /// \return A non-OK status if the batch could not be dispatched, in which
+  ///         case the contents of \p outputs and \p statuses are unspecified.
+  virtual Status EnterAndRunBatch(const std::vector<EnclaveInput> &inputs,
+                                  std::vector<EnclaveOutput> *outputs,
+                                  std::vector<Status> *statuses) {
+    if (outputs) {
+      outputs->resize(inputs.size());
+    }
+    if (statuses) {
+      statuses->resize(inputs.size());
+    }
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      Status status =
+          EnterAndRun(inputs[i], outputs ? &(*outputs)[i] : nullptr);
+      if (statuses) {
+        (*statuses)[i] = status;
+      }
+    }
+    return Status::OkStatus();
+  }
+
+  /// Fetches the statistics of the host calls made by the enclave.
+  ///
+  /// Statistics are only collected by enclaves initialized with
+  /// `EnclaveConfig.enable_host_call_stats` set. Otherwise, all counters are
+  /// zero.
+  ///
+  /// \param[out] stats The statistics of each type of host call.
+  /// \return An UNIMPLEMENTED error if the enclave backend does not collect
+  ///         host call statistics.
+  virtual Status GetHostCallStats(HostCallStats *stats) {
+    return Status(error::GoogleError::UNIMPLEMENTED,
+                  "Host call statistics are not supported by this client");
+  }
+
+  /// Fetches the usage statistics of the enclave heap.
+  ///
+  /// \param[out] stats The current usage of the enclave heap.
+  /// \return An UNIMPLEMENTED error if the enclave backend does not report
+  ///         heap statistics.
+  virtual Status GetHeapStats(HeapStats *stats) {
+    return Status(error::GoogleError::UNIMPLEMENTED,
+                  "Heap statistics are not supported by this client");
+  }
+
  protected:
   /// Returns the name of the enclave.
   ///
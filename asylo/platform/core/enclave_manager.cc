@@ -22,10 +22,15 @@
 #include <stdint.h>
 #include <sys/ucontext.h>
 #include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <thread>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 
 #include "asylo/util/logging.h"
 #include "asylo/platform/common/time_util.h"
@@ -63,7 +68,139 @@ void WaitUntil(int64_t deadline) {
   }
 }
 
+// The interval over which the TSC rate is first estimated.
+constexpr int64_t kTscClockCalibrationPeriod = INT64_C(10000000);
+
+// The interval at which the TSC clock parameters are republished.
+constexpr int64_t kTscClockRefreshPeriod = INT64_C(1000000000);
+
+// The time a pool waits before retrying after failing to load an enclave.
+constexpr absl::Duration kPoolRefillRetryDelay = absl::Seconds(1);
+
 }  // namespace
+
+// A set of enclaves loaded and initialized ahead of time by a background
+// thread, which keeps the pool filled to its target size.
+class EnclaveManager::EnclavePool {
+ public:
+  EnclavePool(EnclaveManager *manager, std::string name,
+              std::unique_ptr<EnclaveLoader> loader, EnclaveConfig config,
+              size_t size)
+      : manager_(manager),
+        name_(std::move(name)),
+        loader_(std::move(loader)),
+        config_(std::move(config)),
+        size_(size) {
+    refill_thread_ = std::thread([this] { RefillLoop(); });
+  }
+
+  ~EnclavePool() { Shutdown(); }
+
+  const EnclaveLoader &loader() const { return *loader_; }
+
+  const EnclaveConfig &config() const { return config_; }
+
+  // Takes an enclave from the pool and returns it, or returns nullptr if the
+  // pool is empty. Either way the background thread is woken to refill the
+  // pool.
+  std::unique_ptr<EnclaveClient> Take() LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock lock(&mu_);
+    if (idle_.empty()) {
+      ++stats_.misses;
+      return nullptr;
+    }
+    std::unique_ptr<EnclaveClient> client = std::move(idle_.front());
+    idle_.pop_front();
+    ++stats_.hits;
+    return client;
+  }
+
+  EnclavePoolStats GetStats() const LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock lock(&mu_);
+    EnclavePoolStats stats = stats_;
+    stats.available = idle_.size();
+    return stats;
+  }
+
+  // Stops the background thread and returns the enclaves remaining in the
+  // pool. Subsequent calls return an empty vector.
+  std::vector<std::unique_ptr<EnclaveClient>> Shutdown() LOCKS_EXCLUDED(mu_) {
+    {
+      absl::MutexLock lock(&mu_);
+      shutting_down_ = true;
+    }
+    if (refill_thread_.joinable()) {
+      refill_thread_.join();
+    }
+
+    absl::MutexLock lock(&mu_);
+    std::vector<std::unique_ptr<EnclaveClient>> clients;
+    for (auto &client : idle_) {
+      clients.push_back(std::move(client));
+    }
+    idle_.clear();
+    return clients;
+  }
+
+ private:
+  bool RefillNeededOrShuttingDown() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return shutting_down_ || idle_.size() < size_;
+  }
+
+  bool ShuttingDown() const EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return shutting_down_;
+  }
+
+  // Loads enclaves until the pool is full, then waits for enclaves to be taken.
+  void RefillLoop() LOCKS_EXCLUDED(mu_) {
+    while (true) {
+      std::string name;
+      {
+        absl::MutexLock lock(&mu_);
+        mu_.Await(
+            absl::Condition(this, &EnclavePool::RefillNeededOrShuttingDown));
+        if (shutting_down_) {
+          return;
+        }
+        name = absl::StrCat(name_, "#", next_id_++);
+      }
+
+      absl::Time start = absl::Now();
+      StatusOr<std::unique_ptr<EnclaveClient>> result =
+          manager_->LoadPooledEnclave(*this, name);
+      absl::Duration latency = absl::Now() - start;
+
+      absl::MutexLock lock(&mu_);
+      if (!result.ok()) {
+        LOG(ERROR) << "Failed to load enclave into pool " << name_ << ": "
+                   << result.status();
+        ++stats_.refill_failures;
+        mu_.AwaitWithTimeout(absl::Condition(this, &EnclavePool::ShuttingDown),
+                             kPoolRefillRetryDelay);
+        continue;
+      }
+      idle_.push_back(std::move(result).ValueOrDie());
+      ++stats_.refills;
+      stats_.total_refill_latency += latency;
+      stats_.max_refill_latency = std::max(stats_.max_refill_latency, latency);
+    }
+  }
+
+  EnclaveManager *const manager_;
+  const std::string name_;
+  const std::unique_ptr<EnclaveLoader> loader_;
+  const EnclaveConfig config_;
+  const size_t size_;
+
+  mutable absl::Mutex mu_;
+  std::deque<std::unique_ptr<EnclaveClient>> idle_ GUARDED_BY(mu_);
+  EnclavePoolStats stats_ GUARDED_BY(mu_);
+  uint64_t next_id_ GUARDED_BY(mu_) = 0;
+  bool shutting_down_ GUARDED_BY(mu_) = false;
+
+  std::thread refill_thread_;
+};
+
 absl::Mutex EnclaveManager::mu_;
 bool EnclaveManager::configured_ = false;
 EnclaveManagerOptions *EnclaveManager::options_ = nullptr;
@@ -128,6 +265,14 @@ bool EnclaveManagerOptions::holds_host_config() const {
   return absl::holds_alternative<HostConfig>(host_config_info_);
 }
 
+EnclaveManagerOptions &EnclaveManagerOptions::set_use_tsc_clock(
+    bool use_tsc_clock) {
+  use_tsc_clock_ = use_tsc_clock;
+  return *this;
+}
+
+bool EnclaveManagerOptions::use_tsc_clock() const { return use_tsc_clock_; }
+
 HostConfig EnclaveManager::GetHostConfig() {
   if (options_->holds_host_config()) {
     StatusOr<HostConfig> config_result = options_->get_host_config();
@@ -143,7 +288,12 @@ HostConfig EnclaveManager::GetHostConfig() {
   return config;
 }
 
-EnclaveManager::EnclaveManager() : host_config_(GetHostConfig()) {
+EnclaveManager::EnclaveManager()
+    : use_tsc_clock_(false),
+      tsc_clock_parameters_(),
+      last_tsc_sample_(0),
+      last_monotonic_sample_(0),
+      host_config_(GetHostConfig()) {
   Status rc = shared_resource_manager_.RegisterUnmanagedResource(
       SharedName::Address("clock_monotonic"), &clock_monotonic_);
   if (!rc.ok()) {
@@ -156,6 +306,26 @@ EnclaveManager::EnclaveManager() : host_config_(GetHostConfig()) {
     LOG(FATAL) << "Could not register realtime clock resource.";
   }
 
+  use_tsc_clock_ = options_->use_tsc_clock();
+  if (use_tsc_clock_ && !IsTscClockSupported()) {
+    LOG(WARNING) << "TSC clock is not supported on this CPU, falling back to "
+                    "the default clock";
+    use_tsc_clock_ = false;
+  }
+  if (use_tsc_clock_) {
+    // Take an initial sample over a short interval to estimate the TSC rate.
+    // The estimate is refined each time the parameters are republished.
+    PublishTscClock();
+    Sleep(kTscClockCalibrationPeriod);
+    PublishTscClock();
+
+    rc = shared_resource_manager_.RegisterUnmanagedResource(
+        SharedName::Address("clock_tsc_parameters"), &tsc_clock_parameters_);
+    if (!rc.ok()) {
+      LOG(FATAL) << "Could not register TSC clock resource.";
+    }
+  }
+
   SpawnWorkerThread();
 }
 
@@ -166,6 +336,8 @@ Status EnclaveManager::DestroyEnclave(EnclaveClient *client,
     return Status::OkStatus();
   }
 
+  // The enclave is finalized and destroyed without holding clients_mu_, so that
+  // several enclaves can be torn down concurrently.
   Status status;
   if (!skip_finalize) {
     status = client->EnterAndFinalize(final_input);
@@ -179,24 +351,32 @@ Status EnclaveManager::DestroyEnclave(EnclaveClient *client,
     status =
         EnclaveSignalDispatcher::GetInstance()->DeregisterAllSignalsForClient(
             client);
-    const auto &name = name_by_client_[client];
-    client_by_name_.erase(name);
-    name_by_client_.erase(client);
+    UnregisterPooledClient(client);
+    ReleaseName(GetName(client));
   }
 
   return status;
 }
 
 EnclaveClient *EnclaveManager::GetClient(const std::string &name) const {
-  auto it = client_by_name_.find(name);
-  if (it == client_by_name_.end()) {
+  {
+    absl::MutexLock lock(&clients_mu_);
+    auto it = client_by_name_.find(name);
+    if (it != client_by_name_.end()) {
+      return it->second.get();
+    }
+  }
+
+  absl::MutexLock lock(&pooled_clients_mu_);
+  auto pooled_it = pooled_client_by_name_.find(name);
+  if (pooled_it == pooled_client_by_name_.end()) {
     return nullptr;
-  } else {
-    return it->second.get();
   }
+  return pooled_it->second;
 }
 
 const std::string EnclaveManager::GetName(const EnclaveClient *client) const {
+  absl::MutexLock lock(&clients_mu_);
   auto it = name_by_client_.find(client);
   if (it == name_by_client_.end()) {
     return "";
@@ -205,6 +385,34 @@ const std::string EnclaveManager::GetName(const EnclaveClient *client) const {
   }
 }
 
+StatusOr<HostCallStats> EnclaveManager::GetHostCallStats(
+    const std::string &name) const {
+  EnclaveClient *client = GetClient(name);
+  if (!client) {
+    return Status(error::GoogleError::NOT_FOUND, "No such enclave: " + name);
+  }
+  HostCallStats stats;
+  Status status = client->GetHostCallStats(&stats);
+  if (!status.ok()) {
+    return status;
+  }
+  return stats;
+}
+
+StatusOr<HeapStats> EnclaveManager::GetHeapStats(
+    const std::string &name) const {
+  EnclaveClient *client = GetClient(name);
+  if (!client) {
+    return Status(error::GoogleError::NOT_FOUND, "No such enclave: " + name);
+  }
+  HeapStats stats;
+  Status status = client->GetHeapStats(&stats);
+  if (!status.ok()) {
+    return status;
+  }
+  return stats;
+}
+
 Status EnclaveManager::Configure(const EnclaveManagerOptions &options) {
   absl::MutexLock lock(&mu_);
 
@@ -256,28 +464,98 @@ Status EnclaveManager::LoadEnclave(const std::string &name,
   return LoadEnclaveInternal(name, loader, sanitized_config);
 }
 
-Status EnclaveManager::LoadEnclaveInternal(const std::string &name,
-                                           const EnclaveLoader &loader,
-                                           const EnclaveConfig &config) {
-  // Check whether a client with this name already exists.
-  if (client_by_name_.find(name) != client_by_name_.end()) {
+std::vector<Status> EnclaveManager::LoadEnclaves(
+    const std::vector<EnclaveLoadSpec> &specs) {
+  std::vector<Status> statuses(specs.size());
+  size_t num_threads = std::min<size_t>(
+      specs.size(), std::max(1u, std::thread::hardware_concurrency()));
+
+  // Each thread repeatedly claims the next spec that has not been loaded yet.
+  std::atomic<size_t> next_spec(0);
+  auto load_specs = [this, &specs, &statuses, &next_spec] {
+    size_t i;
+    while ((i = next_spec++) < specs.size()) {
+      const EnclaveLoadSpec &spec = specs[i];
+      if (!spec.loader) {
+        statuses[i] = Status(error::GoogleError::INVALID_ARGUMENT,
+                             "No loader for enclave: " + spec.name);
+        continue;
+      }
+      statuses[i] = LoadEnclave(spec.name, *spec.loader, spec.config);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back(load_specs);
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  return statuses;
+}
+
+Status EnclaveManager::ReserveName(const std::string &name) {
+  absl::MutexLock lock(&clients_mu_);
+  if (!client_by_name_.emplace(name, nullptr).second) {
     Status status(error::GoogleError::ALREADY_EXISTS,
                   "Name already exists: " + name);
     LOG(ERROR) << "LoadEnclave failed: " << status;
     return status;
   }
+  return Status::OkStatus();
+}
+
+void EnclaveManager::BindReservedName(const std::string &name,
+                                      std::unique_ptr<EnclaveClient> client) {
+  absl::MutexLock lock(&clients_mu_);
+  name_by_client_.emplace(client.get(), name);
+  client_by_name_[name] = std::move(client);
+}
 
+void EnclaveManager::ReleaseName(const std::string &name) {
+  // The client, if any, is destroyed after clients_mu_ is released.
+  std::unique_ptr<EnclaveClient> client;
+  absl::MutexLock lock(&clients_mu_);
+  auto it = client_by_name_.find(name);
+  if (it == client_by_name_.end()) {
+    return;
+  }
+  client = std::move(it->second);
+  client_by_name_.erase(it);
+  if (client) {
+    name_by_client_.erase(client.get());
+  }
+}
+
+Status EnclaveManager::LoadEnclaveInternal(const std::string &name,
+                                           const EnclaveLoader &loader,
+                                           const EnclaveConfig &config) {
+  // Reserve the name, so that concurrent attempts to load an enclave with the
+  // same name fail while this one is in progress.
+  Status status = ReserveName(name);
+  if (!status.ok()) {
+    return status;
+  }
+  return LoadReservedEnclave(name, loader, config);
+}
+
+Status EnclaveManager::LoadReservedEnclave(const std::string &name,
+                                           const EnclaveLoader &loader,
+                                           const EnclaveConfig &config) {
   // Attempt to load the enclave.
   StatusOr<std::unique_ptr<EnclaveClient>> result = loader.LoadEnclave(name);
   if (!result.ok()) {
     LOG(ERROR) << "LoadEnclave failed: " << result.status();
+    ReleaseName(name);
     return result.status();
   }
 
-  // Add the client to the lookup tables.
+  // Add the client to the lookup tables before initializing it, since the
+  // enclave may look itself up by name during initialization.
   EnclaveClient *client = result.ValueOrDie().get();
-  client_by_name_.emplace(name, std::move(result).ValueOrDie());
-  name_by_client_.emplace(client, name);
+  BindReservedName(name, std::move(result).ValueOrDie());
 
   Status status = client->EnterAndInitialize(config);
   // If initialization fails, don't keep the enclave registered. GetClient will
@@ -288,12 +566,160 @@ Status EnclaveManager::LoadEnclaveInternal(const std::string &name,
       LOG(ERROR) << "DestroyEnclave failed after EnterAndInitialize failure: "
                  << destroy_status;
     }
-    client_by_name_.erase(name);
-    name_by_client_.erase(client);
+    ReleaseName(name);
   }
   return status;
 }
 
+Status EnclaveManager::CreateEnclavePool(const std::string &pool_name,
+                                         std::unique_ptr<EnclaveLoader> loader,
+                                         EnclaveConfig config,
+                                         size_t pool_size) {
+  if (!loader) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "Enclave pool requires a loader");
+  }
+  SetEnclaveConfigDefaults(host_config_, &config);
+
+  absl::MutexLock lock(&pools_mu_);
+  if (pools_.find(pool_name) != pools_.end()) {
+    return Status(error::GoogleError::ALREADY_EXISTS,
+                  "Pool name already exists: " + pool_name);
+  }
+  pools_.emplace(pool_name, std::make_shared<EnclavePool>(
+                                this, pool_name, std::move(loader),
+                                std::move(config), pool_size));
+  return Status::OkStatus();
+}
+
+Status EnclaveManager::LoadEnclaveFromPool(const std::string &pool_name,
+                                           const std::string &name) {
+  std::shared_ptr<EnclavePool> pool = GetPool(pool_name);
+  if (!pool) {
+    return Status(error::GoogleError::NOT_FOUND,
+                  "No such enclave pool: " + pool_name);
+  }
+
+  // Reserve the name before taking an enclave from the pool, so that a failed
+  // request does not drain it.
+  Status status = ReserveName(name);
+  if (!status.ok()) {
+    return status;
+  }
+
+  std::unique_ptr<EnclaveClient> client = pool->Take();
+  if (!client) {
+    return LoadReservedEnclave(name, pool->loader(), pool->config());
+  }
+  BindReservedName(name, std::move(client));
+  return Status::OkStatus();
+}
+
+StatusOr<EnclavePoolStats> EnclaveManager::GetEnclavePoolStats(
+    const std::string &pool_name) const {
+  std::shared_ptr<EnclavePool> pool = GetPool(pool_name);
+  if (!pool) {
+    return Status(error::GoogleError::NOT_FOUND,
+                  "No such enclave pool: " + pool_name);
+  }
+  return pool->GetStats();
+}
+
+Status EnclaveManager::DestroyEnclavePool(const std::string &pool_name,
+                                          const EnclaveFinal &final_input) {
+  std::shared_ptr<EnclavePool> pool;
+  {
+    absl::MutexLock lock(&pools_mu_);
+    auto it = pools_.find(pool_name);
+    if (it == pools_.end()) {
+      return Status(error::GoogleError::NOT_FOUND,
+                    "No such enclave pool: " + pool_name);
+    }
+    pool = std::move(it->second);
+    pools_.erase(it);
+  }
+
+  Status status = Status::OkStatus();
+  for (auto &client : pool->Shutdown()) {
+    Status destroy_status =
+        DestroyPooledEnclave(std::move(client), final_input);
+    if (!destroy_status.ok()) {
+      LOG(ERROR) << "Failed to destroy pooled enclave: " << destroy_status;
+      status = destroy_status;
+    }
+  }
+  return status;
+}
+
+StatusOr<std::unique_ptr<EnclaveClient>> EnclaveManager::LoadPooledEnclave(
+    const EnclavePool &pool, const std::string &name) {
+  StatusOr<std::unique_ptr<EnclaveClient>> result =
+      pool.loader().LoadEnclave(name);
+  if (!result.ok()) {
+    return result.status();
+  }
+  std::unique_ptr<EnclaveClient> client = std::move(result).ValueOrDie();
+
+  // Register the client before it is initialized, since the enclave may look
+  // itself up by name during initialization.
+  {
+    absl::MutexLock lock(&pooled_clients_mu_);
+    pooled_client_by_name_.emplace(name, client.get());
+  }
+
+  Status status = client->EnterAndInitialize(pool.config());
+  if (!status.ok()) {
+    Status destroy_status = client->DestroyEnclave();
+    if (!destroy_status.ok()) {
+      LOG(ERROR) << "DestroyEnclave failed after EnterAndInitialize failure: "
+                 << destroy_status;
+    }
+    absl::MutexLock lock(&pooled_clients_mu_);
+    pooled_client_by_name_.erase(name);
+    return status;
+  }
+  return std::move(client);
+}
+
+Status EnclaveManager::DestroyPooledEnclave(
+    std::unique_ptr<EnclaveClient> client, const EnclaveFinal &final_input) {
+  // The pool owns the enclave, so it is destroyed even if finalization fails.
+  Status status = client->EnterAndFinalize(final_input);
+  Status destroy_status = client->DestroyEnclave();
+  if (status.ok()) {
+    status = destroy_status;
+  }
+  Status deregister_status =
+      EnclaveSignalDispatcher::GetInstance()->DeregisterAllSignalsForClient(
+          client.get());
+  if (status.ok()) {
+    status = deregister_status;
+  }
+  UnregisterPooledClient(client.get());
+  return status;
+}
+
+void EnclaveManager::UnregisterPooledClient(const EnclaveClient *client) {
+  absl::MutexLock lock(&pooled_clients_mu_);
+  for (auto it = pooled_client_by_name_.begin();
+       it != pooled_client_by_name_.end(); ++it) {
+    if (it->second == client) {
+      pooled_client_by_name_.erase(it);
+      return;
+    }
+  }
+}
+
+std::shared_ptr<EnclaveManager::EnclavePool> EnclaveManager::GetPool(
+    const std::string &pool_name) const {
+  absl::MutexLock lock(&pools_mu_);
+  auto it = pools_.find(pool_name);
+  if (it == pools_.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
 void EnclaveManager::SpawnWorkerThread() {
   std::mutex worker_init_lock;
   worker_init_lock.lock();
@@ -310,9 +736,32 @@ void EnclaveManager::Tick() {
   clock_realtime_ = RealTimeClock();
 }
 
+void EnclaveManager::PublishTscClock() {
+  // Sample the TSC on both sides of the host clocks and use the midpoint.
+  uint64_t tsc_before = ReadTsc();
+  int64_t monotonic = MonotonicClock();
+  int64_t realtime = RealTimeClock();
+  uint64_t tsc = tsc_before + (ReadTsc() - tsc_before) / 2;
+
+  uint64_t multiplier = tsc_clock_parameters_.multiplier.load();
+  if (last_tsc_sample_ != 0) {
+    uint64_t measured_multiplier = ComputeTscClockMultiplier(
+        last_tsc_sample_, last_monotonic_sample_, tsc, monotonic);
+    if (measured_multiplier != 0) {
+      multiplier = measured_multiplier;
+    }
+  }
+  last_tsc_sample_ = tsc;
+  last_monotonic_sample_ = monotonic;
+  PublishTscClockParameters(tsc, monotonic, realtime, multiplier,
+                            &tsc_clock_parameters_);
+}
+
 void EnclaveManager::WorkerLoop(std::mutex *unlock_when_ready) {
-  // Tick each 70us ~ 14.29kHz
-  const int64_t kClockPeriod = INT64_C(70000);
+  // Tick each 70us ~ 14.29kHz, or only republish the TSC clock parameters
+  // about once a second if enclaves read time from the TSC.
+  const int64_t kClockPeriod =
+      use_tsc_clock_ ? kTscClockRefreshPeriod : INT64_C(70000);
   Tick();
   unlock_when_ready->unlock();
   unlock_when_ready = nullptr;
@@ -320,6 +769,9 @@ void EnclaveManager::WorkerLoop(std::mutex *unlock_when_ready) {
   while (true) {
     WaitUntil(next_tick);
     Tick();
+    if (use_tsc_clock_) {
+      PublishTscClock();
+    }
     next_tick += kClockPeriod;
   }
 }
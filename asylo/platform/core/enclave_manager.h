@@ -22,11 +22,14 @@
 // Declares the enclave client API, providing types and methods for loading,
 // accessing, and finalizing enclaves.
 
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
@@ -34,6 +37,7 @@
 #include "absl/time/time.h"
 #include "absl/types/variant.h"
 #include "asylo/enclave.pb.h"  // IWYU pragma: export
+#include "asylo/platform/common/tsc_clock.h"
 #include "asylo/platform/core/enclave_client.h"
 #include "asylo/platform/core/enclave_config_util.h"
 #include "asylo/platform/core/shared_resource_manager.h"
@@ -111,10 +115,68 @@ class EnclaveManagerOptions {
   /// Returns true if a HostConfig instance is embedded in this object.
   bool holds_host_config() const;
 
+  /// Selects whether enclaves read time from the time-stamp counter.
+  ///
+  /// By default, a host thread publishes the current time to enclaves every
+  /// 70 microseconds. If the TSC clock is enabled and the CPU has an invariant
+  /// TSC that enclaves are permitted to read, the host instead publishes a
+  /// sample of the TSC and the host clocks about once a second, and enclaves
+  /// extrapolate the current time from the TSC. Otherwise the default clock is
+  /// used.
+  ///
+  /// \return A reference to this EnclaveManagerOptions object.
+  EnclaveManagerOptions &set_use_tsc_clock(bool use_tsc_clock);
+
+  /// Returns true if enclaves should read time from the time-stamp counter.
+  bool use_tsc_clock() const;
+
  private:
   // A variant that either holds information necessary for connecting to the
   // config server or a HostConfig proto.
   absl::variant<ConfigServerConnectionAttributes, HostConfig> host_config_info_;
+
+  // Whether enclaves should read time from the time-stamp counter.
+  bool use_tsc_clock_ = false;
+};
+
+/// Describes an enclave to load with EnclaveManager::LoadEnclaves().
+struct EnclaveLoadSpec {
+  /// Name to bind the loaded enclave under.
+  std::string name;
+
+  /// Configured enclave loader to load from. Not owned, and must remain valid
+  /// until LoadEnclaves() returns.
+  const EnclaveLoader *loader = nullptr;
+
+  /// Enclave configuration to launch the enclave with.
+  EnclaveConfig config;
+};
+
+/// Statistics describing an enclave pool created by
+/// EnclaveManager::CreateEnclavePool().
+struct EnclavePoolStats {
+  /// The number of loaded and initialized enclaves waiting in the pool.
+  size_t available = 0;
+
+  /// The number of requests served with an enclave from the pool.
+  uint64_t hits = 0;
+
+  /// The number of requests that found the pool empty and loaded an enclave
+  /// synchronously.
+  uint64_t misses = 0;
+
+  /// The number of enclaves loaded into the pool in the background.
+  uint64_t refills = 0;
+
+  /// The number of background loads that failed.
+  uint64_t refill_failures = 0;
+
+  /// The total time spent loading and initializing enclaves in the background.
+  absl::Duration total_refill_latency = absl::ZeroDuration();
+
+  /// The longest time spent loading and initializing a single enclave in the
+  /// background.
+  absl::Duration max_refill_latency = absl::ZeroDuration();
 };
 
 /// A manager object responsible for creating and managing enclave instances.
@@ -203,6 +265,72 @@ class EnclaveManager {
   Status LoadEnclave(const std::string &name, const EnclaveLoader &loader,
                      EnclaveConfig config);
 
+  /// Loads a set of enclaves concurrently.
+  ///
+  /// Loads each enclave described by \p specs as if by
+  /// LoadEnclave(spec.name, *spec.loader, spec.config), loading several
+  /// enclaves at a time. A failure to load one enclave does not affect the
+  /// others.
+  ///
+  /// \param specs The enclaves to load.
+  /// \return The status of loading each enclave, in the same order as
+  ///         \p specs.
+  std::vector<Status> LoadEnclaves(const std::vector<EnclaveLoadSpec> &specs);
+
+  /// Creates a pool of enclaves that are loaded and initialized ahead of time.
+  ///
+  /// The pool loads \p pool_size enclaves from \p loader in the background,
+  /// each initialized with \p config, and loads a replacement in the
+  /// background whenever an enclave is taken from the pool by
+  /// LoadEnclaveFromPool(). This moves the cost of creating and initializing
+  /// an enclave off the path of the caller acquiring it.
+  ///
+  /// Since pooled enclaves are initialized before they are bound to a name,
+  /// every enclave in the pool is initialized with the same configuration and
+  /// is known inside the enclave by a name generated by the pool.
+  ///
+  /// It is an error to specify a pool name which is already in use.
+  ///
+  /// \param pool_name Name to bind the pool under.
+  /// \param loader Configured enclave loader to load enclaves from.
+  /// \param config Enclave configuration to launch the enclaves with.
+  /// \param pool_size Number of initialized enclaves to keep in the pool.
+  Status CreateEnclavePool(const std::string &pool_name,
+                           std::unique_ptr<EnclaveLoader> loader,
+                           EnclaveConfig config, size_t pool_size);
+
+  /// Binds an enclave from a pool to a name.
+  ///
+  /// Takes an initialized enclave from the pool named \p pool_name and binds
+  /// it to \p name, after which it is managed like any enclave loaded with
+  /// LoadEnclave(). If the pool is empty, an enclave is loaded and initialized
+  /// synchronously from the pool's loader and configuration instead.
+  ///
+  /// It is an error to specify a name which is already bound to an enclave.
+  ///
+  /// \param pool_name The name of a pool created by CreateEnclavePool().
+  /// \param name Name to bind the enclave under.
+  Status LoadEnclaveFromPool(const std::string &pool_name,
+                             const std::string &name);
+
+  /// Returns statistics for an enclave pool.
+  ///
+  /// \param pool_name The name of a pool created by CreateEnclavePool().
+  /// \return The pool's statistics, or an error if there is no such pool.
+  StatusOr<EnclavePoolStats> GetEnclavePoolStats(
+      const std::string &pool_name) const;
+
+  /// Destroys an enclave pool.
+  ///
+  /// Stops loading enclaves into the pool, then finalizes with \p final_input
+  /// and destroys every enclave remaining in it. Enclaves already taken from
+  /// the pool are not affected.
+  ///
+  /// \param pool_name The name of a pool created by CreateEnclavePool().
+  /// \param final_input Input to pass the finalizer of each pooled enclave.
+  Status DestroyEnclavePool(const std::string &pool_name,
+                            const EnclaveFinal &final_input);
+
   /// Fetches a client to a loaded enclave.
   ///
   /// \param name The name of an EnclaveClient that may be registered in the
@@ -219,6 +347,28 @@ class EnclaveManager {
   ///         empty string will be returned.
   const std::string GetName(const EnclaveClient *client) const;
 
+  /// Fetches the statistics of the host calls made by an enclave.
+  ///
+  /// Statistics are only collected by enclaves loaded with
+  /// `EnclaveConfig.enable_host_call_stats` set.
+  ///
+  /// \param name The name of a loaded enclave.
+  /// \return The statistics of each type of host call made by the enclave, or
+  ///         an error if there is no such enclave or its client does not
+  ///         support host call statistics.
+  StatusOr<HostCallStats> GetHostCallStats(const std::string &name) const;
+
+  /// Fetches the usage statistics of the heap of an enclave.
+  ///
+  /// Enclave heaps have a fixed size chosen when the enclave is built. The
+  /// peak heap size and the fragmentation reported here can be used to choose
+  /// that size.
+  ///
+  /// \param name The name of a loaded enclave.
+  /// \return The current usage of the enclave's heap, or an error if there is
+  ///         no such enclave or its client does not support heap statistics.
+  StatusOr<HeapStats> GetHeapStats(const std::string &name) const;
+
   /// Destroys an enclave.
   ///
   /// Destroys an enclave. This method calls `client's` EnterAndFinalize entry
@@ -264,6 +414,49 @@ class EnclaveManager {
   Status LoadEnclaveInternal(const std::string &name, const EnclaveLoader &loader,
                              const EnclaveConfig &config);
 
+  // Reserves |name| for an enclave that is being loaded. Only the name is
+  // reserved under clients_mu_; the enclave itself is loaded and initialized
+  // without holding it, so enclaves can be loaded concurrently. Returns an
+  // error if |name| is already reserved or bound.
+  Status ReserveName(const std::string &name) LOCKS_EXCLUDED(clients_mu_);
+
+  // Binds a name reserved with ReserveName() to |client|.
+  void BindReservedName(const std::string &name,
+                        std::unique_ptr<EnclaveClient> client)
+      LOCKS_EXCLUDED(clients_mu_);
+
+  // Removes |name| and the client bound to it, if any, from the lookup tables.
+  void ReleaseName(const std::string &name) LOCKS_EXCLUDED(clients_mu_);
+
+  // Loads an enclave under a name reserved with ReserveName(). The name is
+  // released if loading fails.
+  Status LoadReservedEnclave(const std::string &name,
+                             const EnclaveLoader &loader,
+                             const EnclaveConfig &config);
+
+  class EnclavePool;
+
+  // Loads an enclave for |pool| and initializes it under |name|. The enclave is
+  // registered as a pooled enclave so that it can be found by GetClient() while
+  // it is owned by the pool.
+  StatusOr<std::unique_ptr<EnclaveClient>> LoadPooledEnclave(
+      const EnclavePool &pool, const std::string &name)
+      LOCKS_EXCLUDED(pooled_clients_mu_);
+
+  // Finalizes and destroys an enclave owned by a pool.
+  Status DestroyPooledEnclave(std::unique_ptr<EnclaveClient> client,
+                              const EnclaveFinal &final_input)
+      LOCKS_EXCLUDED(pooled_clients_mu_);
+
+  // Removes |client| from the registry of enclaves created by a pool, if it is
+  // present.
+  void UnregisterPooledClient(const EnclaveClient *client)
+      LOCKS_EXCLUDED(pooled_clients_mu_);
+
+  // Returns the pool named |pool_name|, or nullptr if there is no such pool.
+  std::shared_ptr<EnclavePool> GetPool(const std::string &pool_name) const
+      LOCKS_EXCLUDED(pools_mu_);
+
   // Create a thread to periodically update logic.
   void SpawnWorkerThread();
 
@@ -273,6 +466,10 @@ class EnclaveManager {
   // Execute a single iteration of the work loop.
   void Tick();
 
+  // Samples the TSC and the host clocks and publishes them to
+  // tsc_clock_parameters_, using the previous sample to measure the TSC rate.
+  void PublishTscClock();
+
   // Manager object for untrusted resources shared with enclaves.
   SharedResourceManager shared_resource_manager_;
 
@@ -282,8 +479,36 @@ class EnclaveManager {
   // Value synchronized to CLOCK_REALTIME by the worker loop.
   std::atomic<int64_t> clock_realtime_;
 
-  std::unordered_map<std::string, std::unique_ptr<EnclaveClient>> client_by_name_;
-  std::unordered_map<const EnclaveClient *, std::string> name_by_client_;
+  // True if enclaves read time from the TSC, in which case the worker loop
+  // publishes tsc_clock_parameters_ and updates the other clocks only when it
+  // does so.
+  bool use_tsc_clock_;
+
+  // Parameters of the TSC clock, and the sample they were last computed from.
+  TscClockParameters tsc_clock_parameters_;
+  uint64_t last_tsc_sample_;
+  int64_t last_monotonic_sample_;
+
+  // Lookup tables for loaded enclaves. A name that is reserved by an enclave
+  // that is still being loaded is mapped to nullptr.
+  mutable absl::Mutex clients_mu_;
+  std::unordered_map<std::string, std::unique_ptr<EnclaveClient>>
+      client_by_name_ GUARDED_BY(clients_mu_);
+  std::unordered_map<const EnclaveClient *, std::string> name_by_client_
+      GUARDED_BY(clients_mu_);
+
+  // Enclave pools, indexed by name.
+  mutable absl::Mutex pools_mu_;
+  std::unordered_map<std::string, std::shared_ptr<EnclavePool>> pools_
+      GUARDED_BY(pools_mu_);
+
+  // Enclaves created by a pool, indexed by the name they were initialized
+  // with. An enclave refers to itself by that name when calling back into the
+  // manager, so it is kept here for as long as the enclave exists, including
+  // after it has been bound to another name by LoadEnclaveFromPool().
+  mutable absl::Mutex pooled_clients_mu_;
+  std::unordered_map<std::string, EnclaveClient *> pooled_client_by_name_
+      GUARDED_BY(pooled_clients_mu_);
 
   // A part of the configuration for enclaves launched by the enclave manager
   // comes from the Asylo daemon. This member caches such configuration.
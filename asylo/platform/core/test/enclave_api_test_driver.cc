@@ -17,9 +17,11 @@
  */
 
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include "asylo/platform/arch/sgx/untrusted/sgx_client.h"
 #include "asylo/platform/core/test/proto_test.pb.h"
 #include "asylo/test/util/enclave_test.h"
 #include "asylo/test/util/status_matchers.h"
@@ -32,30 +34,83 @@ namespace {
 // compares the transferred fields to the expected example values. Finally, the
 // |output| protobuf is populated with example data inside the enclave, and then
 // validated outside the enclave in the test driver.
-class ClientApiTest : public EnclaveTest {};
-
-TEST_F(ClientApiTest, InputOutputTest) {
-  EnclaveInput enclave_input;
-  EnclaveApiTest *input_test =
-      enclave_input.MutableExtension(enclave_api_test_input);
-  input_test->set_test_string("test string");
-  input_test->set_test_int(1);
-  input_test->add_test_repeated("test repeated 1");
-  input_test->add_test_repeated("test repeated 2");
-  EnclaveOutput enclave_output;
-  Status status = client_->EnterAndRun(enclave_input, &enclave_output);
-  EXPECT_THAT(status, IsOk());
-
-  ASSERT_TRUE(enclave_output.HasExtension(enclave_api_test_output));
-  EnclaveApiTest output_test =
-      enclave_output.GetExtension(enclave_api_test_output);
-  ASSERT_TRUE(output_test.has_test_string());
-  ASSERT_TRUE(output_test.has_test_int());
-  ASSERT_EQ(output_test.test_repeated_size(), 2);
-  EXPECT_EQ(output_test.test_string(), "output string");
-  EXPECT_EQ(output_test.test_int(), 1);
-  EXPECT_EQ(output_test.test_repeated(0), "output repeated 1");
-  EXPECT_EQ(output_test.test_repeated(1), "output repeated 2");
+class ClientApiTest : public EnclaveTest {
+ protected:
+  // Returns the example input expected by the test enclave.
+  EnclaveInput ExampleInput() {
+    EnclaveInput enclave_input;
+    EnclaveApiTest *input_test =
+        enclave_input.MutableExtension(enclave_api_test_input);
+    input_test->set_test_string("test string");
+    input_test->set_test_int(1);
+    input_test->add_test_repeated("test repeated 1");
+    input_test->add_test_repeated("test repeated 2");
+    return enclave_input;
+  }
+
+  // Runs the enclave with the example input and validates its output.
+  void CheckInputOutput() {
+    EnclaveOutput enclave_output;
+    Status status = client_->EnterAndRun(ExampleInput(), &enclave_output);
+    EXPECT_THAT(status, IsOk());
+
+    ASSERT_TRUE(enclave_output.HasExtension(enclave_api_test_output));
+    EnclaveApiTest output_test =
+        enclave_output.GetExtension(enclave_api_test_output);
+    ASSERT_TRUE(output_test.has_test_string());
+    ASSERT_TRUE(output_test.has_test_int());
+    ASSERT_EQ(output_test.test_repeated_size(), 2);
+    EXPECT_EQ(output_test.test_string(), "output string");
+    EXPECT_EQ(output_test.test_int(), 1);
+    EXPECT_EQ(output_test.test_repeated(0), "output repeated 1");
+    EXPECT_EQ(output_test.test_repeated(1), "output repeated 2");
+  }
+};
+
+TEST_F(ClientApiTest, InputOutputTest) { CheckInputOutput(); }
+
+// Tests that outputs are returned correctly through the run channel, both when
+// they fit in the channel buffer and when they do not.
+TEST_F(ClientApiTest, RunChannelInputOutputTest) {
+  SGXClient *sgx_client = dynamic_cast<SGXClient *>(client_);
+  ASSERT_NE(sgx_client, nullptr);
+
+  // Too small for the output, which exercises the fallback path.
+  sgx_client->EnableRunChannel(8);
+  CheckInputOutput();
+  CheckInputOutput();
+
+  sgx_client->EnableRunChannel(4096);
+  for (int i = 0; i < 3; ++i) {
+    CheckInputOutput();
+  }
+
+  // The status is still propagated if the output is not requested.
+  EXPECT_THAT(client_->EnterAndRun(ExampleInput(), nullptr), IsOk());
+
+  sgx_client->EnableRunChannel(0);
+  CheckInputOutput();
+}
+
+// Tests that a batch of inputs is dispatched in one call and that each input
+// gets its own output and status.
+TEST_F(ClientApiTest, RunBatchTest) {
+  std::vector<EnclaveInput> inputs = {ExampleInput(), EnclaveInput(),
+                                      ExampleInput()};
+  std::vector<EnclaveOutput> outputs;
+  std::vector<Status> statuses;
+  ASSERT_THAT(client_->EnterAndRunBatch(inputs, &outputs, &statuses), IsOk());
+  ASSERT_EQ(outputs.size(), inputs.size());
+  ASSERT_EQ(statuses.size(), inputs.size());
+
+  // The enclave rejects inputs without the test extension.
+  EXPECT_THAT(statuses[1], StatusIs(error::GoogleError::INVALID_ARGUMENT));
+  for (int i : {0, 2}) {
+    EXPECT_THAT(statuses[i], IsOk());
+    ASSERT_TRUE(outputs[i].HasExtension(enclave_api_test_output));
+    EXPECT_EQ(outputs[i].GetExtension(enclave_api_test_output).test_string(),
+              "output string");
+  }
 }
 
 }  // namespace
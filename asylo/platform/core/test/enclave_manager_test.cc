@@ -0,0 +1,320 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/core/enclave_manager.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "asylo/test/util/fake_local_enclave_client.h"
+#include "asylo/test/util/status_matchers.h"
+
+namespace asylo {
+namespace {
+
+using ::testing::Not;
+
+// Counts the calls made to the enclaves created by a FakeEnclaveLoader.
+struct EnclaveCounters {
+  std::atomic<int> loaded{0};
+  std::atomic<int> initialized{0};
+  std::atomic<int> finalized{0};
+};
+
+// An enclave that records calls to its entry points in an EnclaveCounters.
+class CountingEnclave {
+ public:
+  explicit CountingEnclave(EnclaveCounters *counters) : counters_(counters) {}
+
+  Status Run(const EnclaveInput &input, EnclaveOutput *output) {
+    return Status::OkStatus();
+  }
+
+  Status Initialize(const EnclaveConfig &config) {
+    ++counters_->initialized;
+    return Status::OkStatus();
+  }
+
+  Status Finalize(const EnclaveFinal &final_input) {
+    ++counters_->finalized;
+    return Status::OkStatus();
+  }
+
+ private:
+  EnclaveCounters *counters_;
+};
+
+// A loader that creates FakeLocalEnclaveClients wrapping CountingEnclaves, or
+// fails if it is configured to.
+class FakeEnclaveLoader : public EnclaveLoader {
+ public:
+  FakeEnclaveLoader(EnclaveCounters *counters, bool fail)
+      : counters_(counters), fail_(fail) {}
+
+ protected:
+  StatusOr<std::unique_ptr<EnclaveClient>> LoadEnclave(
+      const std::string &name) const override {
+    if (fail_) {
+      return Status(error::GoogleError::INTERNAL, "Load failed");
+    }
+    ++counters_->loaded;
+    return std::unique_ptr<EnclaveClient>(
+        new FakeLocalEnclaveClient<CountingEnclave>(
+            absl::make_unique<CountingEnclave>(counters_)));
+  }
+
+ private:
+  EnclaveCounters *counters_;
+  bool fail_;
+};
+
+class EnclaveManagerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    EnclaveManager::Configure(EnclaveManagerOptions());
+    manager_ = EnclaveManager::Instance().ValueOrDie();
+  }
+
+  // Creates a pool of |size| enclaves named |pool_name|.
+  Status CreatePool(const std::string &pool_name, size_t size,
+                    bool fail = false) {
+    return manager_->CreateEnclavePool(
+        pool_name, absl::make_unique<FakeEnclaveLoader>(&counters_, fail),
+        EnclaveConfig(), size);
+  }
+
+  // Waits until |predicate| holds for the statistics of |pool_name|. Returns
+  // false if it does not hold within a generous timeout.
+  bool WaitForStats(const std::string &pool_name,
+                    const std::function<bool(const EnclavePoolStats &)>
+                        &predicate) {
+    absl::Time deadline = absl::Now() + absl::Seconds(10);
+    while (absl::Now() < deadline) {
+      StatusOr<EnclavePoolStats> stats =
+          manager_->GetEnclavePoolStats(pool_name);
+      if (stats.ok() && predicate(stats.ValueOrDie())) {
+        return true;
+      }
+      absl::SleepFor(absl::Milliseconds(1));
+    }
+    return false;
+  }
+
+  EnclaveManager *manager_;
+  EnclaveCounters counters_;
+};
+
+// Tests that a pool fills up in the background, hands out its enclaves, and
+// refills itself.
+TEST_F(EnclaveManagerTest, PoolHitsAndRefills) {
+  constexpr size_t kPoolSize = 4;
+  ASSERT_THAT(CreatePool("hits", kPoolSize), IsOk());
+  ASSERT_TRUE(WaitForStats("hits", [](const EnclavePoolStats &stats) {
+    return stats.available == kPoolSize;
+  }));
+  EXPECT_EQ(counters_.initialized, kPoolSize);
+
+  ASSERT_THAT(manager_->LoadEnclaveFromPool("hits", "/hits/0"), IsOk());
+  EnclaveClient *client = manager_->GetClient("/hits/0");
+  ASSERT_NE(client, nullptr);
+  EXPECT_EQ(manager_->GetName(client), "/hits/0");
+  EXPECT_THAT(client->EnterAndRun(EnclaveInput(), nullptr), IsOk());
+
+  ASSERT_TRUE(WaitForStats("hits", [](const EnclavePoolStats &stats) {
+    return stats.available == kPoolSize && stats.refills == kPoolSize + 1;
+  }));
+  EnclavePoolStats stats =
+      manager_->GetEnclavePoolStats("hits").ValueOrDie();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 0);
+  EXPECT_EQ(stats.refill_failures, 0);
+  EXPECT_GE(stats.total_refill_latency, stats.max_refill_latency);
+
+  EXPECT_THAT(manager_->DestroyEnclave(client, EnclaveFinal()), IsOk());
+  EXPECT_EQ(manager_->GetClient("/hits/0"), nullptr);
+  EXPECT_THAT(manager_->DestroyEnclavePool("hits", EnclaveFinal()), IsOk());
+}
+
+// Tests that an empty pool loads an enclave synchronously.
+TEST_F(EnclaveManagerTest, EmptyPoolMisses) {
+  ASSERT_THAT(CreatePool("misses", 0), IsOk());
+  ASSERT_THAT(manager_->LoadEnclaveFromPool("misses", "/misses/0"), IsOk());
+  EnclaveClient *client = manager_->GetClient("/misses/0");
+  ASSERT_NE(client, nullptr);
+
+  EnclavePoolStats stats =
+      manager_->GetEnclavePoolStats("misses").ValueOrDie();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 1);
+  EXPECT_EQ(stats.available, 0);
+
+  EXPECT_THAT(manager_->DestroyEnclave(client, EnclaveFinal()), IsOk());
+  EXPECT_THAT(manager_->DestroyEnclavePool("misses", EnclaveFinal()), IsOk());
+}
+
+// Tests that requesting a name that is already bound fails without taking an
+// enclave from the pool.
+TEST_F(EnclaveManagerTest, DuplicateNameDoesNotDrainPool) {
+  ASSERT_THAT(CreatePool("duplicate", 2), IsOk());
+  ASSERT_TRUE(WaitForStats("duplicate", [](const EnclavePoolStats &stats) {
+    return stats.available == 2;
+  }));
+
+  ASSERT_THAT(manager_->LoadEnclaveFromPool("duplicate", "/duplicate/0"),
+              IsOk());
+  EXPECT_THAT(manager_->LoadEnclaveFromPool("duplicate", "/duplicate/0"),
+              StatusIs(error::GoogleError::ALREADY_EXISTS));
+  EXPECT_EQ(manager_->GetEnclavePoolStats("duplicate").ValueOrDie().hits, 1);
+
+  EXPECT_THAT(manager_->DestroyEnclave(manager_->GetClient("/duplicate/0"),
+                                       EnclaveFinal()),
+              IsOk());
+  EXPECT_THAT(manager_->DestroyEnclavePool("duplicate", EnclaveFinal()),
+              IsOk());
+}
+
+// Tests that destroying a pool finalizes the enclaves remaining in it.
+TEST_F(EnclaveManagerTest, DestroyPoolFinalizesIdleEnclaves) {
+  ASSERT_THAT(CreatePool("destroy", 3), IsOk());
+  ASSERT_TRUE(WaitForStats("destroy", [](const EnclavePoolStats &stats) {
+    return stats.available == 3;
+  }));
+
+  EXPECT_THAT(manager_->DestroyEnclavePool("destroy", EnclaveFinal()), IsOk());
+  EXPECT_EQ(counters_.finalized, 3);
+  EXPECT_THAT(manager_->GetEnclavePoolStats("destroy"), Not(IsOk()));
+  EXPECT_THAT(manager_->LoadEnclaveFromPool("destroy", "/destroy/0"),
+              StatusIs(error::GoogleError::NOT_FOUND));
+}
+
+// Tests that failures to load enclaves in the background are counted and that
+// a miss reports the loader's error.
+TEST_F(EnclaveManagerTest, RefillFailuresAreReported) {
+  ASSERT_THAT(CreatePool("failures", 1, /*fail=*/true), IsOk());
+  ASSERT_TRUE(WaitForStats("failures", [](const EnclavePoolStats &stats) {
+    return stats.refill_failures > 0;
+  }));
+  EXPECT_THAT(manager_->LoadEnclaveFromPool("failures", "/failures/0"),
+              StatusIs(error::GoogleError::INTERNAL));
+  EXPECT_EQ(manager_->GetClient("/failures/0"), nullptr);
+  EXPECT_THAT(manager_->DestroyEnclavePool("failures", EnclaveFinal()),
+              IsOk());
+}
+
+// Tests that pool names must be unique.
+TEST_F(EnclaveManagerTest, CreatePoolFailsWithDuplicateName) {
+  ASSERT_THAT(CreatePool("unique", 0), IsOk());
+  EXPECT_THAT(CreatePool("unique", 0),
+              StatusIs(error::GoogleError::ALREADY_EXISTS));
+  EXPECT_THAT(manager_->DestroyEnclavePool("unique", EnclaveFinal()), IsOk());
+}
+
+// Tests that LoadEnclaves loads every enclave and reports a status for each.
+TEST_F(EnclaveManagerTest, LoadEnclavesReportsStatusPerEnclave) {
+  constexpr int kNumEnclaves = 16;
+  FakeEnclaveLoader loader(&counters_, /*fail=*/false);
+  FakeEnclaveLoader failing_loader(&counters_, /*fail=*/true);
+
+  std::vector<EnclaveLoadSpec> specs(kNumEnclaves + 3);
+  for (int i = 0; i < kNumEnclaves; ++i) {
+    specs[i].name = absl::StrCat("/bulk/", i);
+    specs[i].loader = &loader;
+  }
+  specs[kNumEnclaves].name = "/bulk/0";
+  specs[kNumEnclaves].loader = &loader;
+  specs[kNumEnclaves + 1].name = "/bulk/failing";
+  specs[kNumEnclaves + 1].loader = &failing_loader;
+  specs[kNumEnclaves + 2].name = "/bulk/no_loader";
+
+  std::vector<Status> statuses = manager_->LoadEnclaves(specs);
+  ASSERT_EQ(statuses.size(), specs.size());
+
+  // Exactly one of the two enclaves named "/bulk/0" is loaded.
+  EXPECT_NE(statuses[0].ok(), statuses[kNumEnclaves].ok());
+  for (int i = 1; i < kNumEnclaves; ++i) {
+    EXPECT_THAT(statuses[i], IsOk());
+  }
+  EXPECT_THAT(statuses[kNumEnclaves + 1],
+              StatusIs(error::GoogleError::INTERNAL));
+  EXPECT_THAT(statuses[kNumEnclaves + 2],
+              StatusIs(error::GoogleError::INVALID_ARGUMENT));
+  EXPECT_EQ(manager_->GetClient("/bulk/failing"), nullptr);
+  EXPECT_EQ(counters_.initialized, kNumEnclaves);
+
+  // Destroy the enclaves concurrently.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumEnclaves; ++i) {
+    threads.emplace_back([this, i] {
+      std::string name = absl::StrCat("/bulk/", i);
+      EnclaveClient *client = manager_->GetClient(name);
+      ASSERT_NE(client, nullptr);
+      EXPECT_EQ(manager_->GetName(client), name);
+      EXPECT_THAT(manager_->DestroyEnclave(client, EnclaveFinal()), IsOk());
+      EXPECT_EQ(manager_->GetClient(name), nullptr);
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counters_.finalized, kNumEnclaves);
+}
+
+// Tests that host call statistics are only fetched for loaded enclaves whose
+// clients support them.
+TEST_F(EnclaveManagerTest, GetHostCallStats) {
+  EXPECT_THAT(manager_->GetHostCallStats("/stats/missing").status(),
+              StatusIs(error::GoogleError::NOT_FOUND));
+
+  FakeEnclaveLoader loader(&counters_, /*fail=*/false);
+  ASSERT_THAT(manager_->LoadEnclave("/stats/fake", loader), IsOk());
+  EXPECT_THAT(manager_->GetHostCallStats("/stats/fake").status(),
+              StatusIs(error::GoogleError::UNIMPLEMENTED));
+
+  EnclaveClient *client = manager_->GetClient("/stats/fake");
+  ASSERT_NE(client, nullptr);
+  EXPECT_THAT(manager_->DestroyEnclave(client, EnclaveFinal()), IsOk());
+}
+
+// Tests that heap statistics are only fetched for loaded enclaves whose clients
+// support them.
+TEST_F(EnclaveManagerTest, GetHeapStats) {
+  EXPECT_THAT(manager_->GetHeapStats("/heap/missing").status(),
+              StatusIs(error::GoogleError::NOT_FOUND));
+
+  FakeEnclaveLoader loader(&counters_, /*fail=*/false);
+  ASSERT_THAT(manager_->LoadEnclave("/heap/fake", loader), IsOk());
+  EXPECT_THAT(manager_->GetHeapStats("/heap/fake").status(),
+              StatusIs(error::GoogleError::UNIMPLEMENTED));
+
+  EnclaveClient *client = manager_->GetClient("/heap/fake");
+  ASSERT_NE(client, nullptr);
+  EXPECT_THAT(manager_->DestroyEnclave(client, EnclaveFinal()), IsOk());
+}
+
+}  // namespace
+}  // namespace asylo
@@ -28,22 +28,29 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "asylo/util/logging.h"
 #include "asylo/identity/init.h"
+#include "asylo/platform/arch/include/trusted/enclave_interface.h"
+#include "asylo/platform/arch/include/trusted/host_call_stats.h"
 #include "asylo/platform/arch/include/trusted/host_calls.h"
 #include "asylo/platform/arch/include/trusted/time.h"
+#include "asylo/platform/arch/include/trusted/untrusted_staging.h"
 #include "asylo/platform/common/bridge_types.h"
+#include "asylo/platform/common/thread_arena.h"
 #include "asylo/platform/core/shared_name_kind.h"
 #include "asylo/platform/core/trusted_global_state.h"
 #include "asylo/platform/posix/io/io_manager.h"
 #include "asylo/platform/posix/io/native_paths.h"
 #include "asylo/platform/posix/io/random_devices.h"
+#include "asylo/platform/posix/io/stat_cache.h"
 #include "asylo/platform/posix/signal/signal_manager.h"
 #include "asylo/platform/posix/threading/thread_manager.h"
 #include "asylo/util/posix_error_space.h"
 #include "asylo/util/status.h"
 
 using EnclaveState = ::asylo::TrustedApplication::State;
+using google::protobuf::Arena;
 using google::protobuf::RepeatedPtrField;
 
 namespace asylo {
@@ -61,7 +68,8 @@ void LogError(const Status &status) {
 }
 
 // StatusSerializer can be used to serialize a given proto2 message to an
-// untrusted buffer.
+// untrusted buffer. The trusted staging buffer used during serialization is
+// allocated on |arena|.
 //
 // OutputProto must be a proto2 message type.
 template <class OutputProto>
@@ -71,22 +79,35 @@ class StatusSerializer {
   // which is a nested message within |output_proto|. StatusSerializer does not
   // take ownership of any of the input pointers. Input pointers must remain
   // valid for the lifetime of the StatusSerializer.
-  StatusSerializer(const OutputProto *output_proto, StatusProto *status_proto,
-                   char **output, size_t *output_len)
-      : output_proto_{output_proto},
+  StatusSerializer(Arena *arena, const OutputProto *output_proto,
+                   StatusProto *status_proto, char **output,
+                   size_t *output_len)
+      : arena_{arena},
+        output_proto_{output_proto},
         status_proto_{status_proto},
         output_{output},
         output_len_{output_len} {}
 
-  // Creates a new StatusSerializer that saves Status objects to |status_proto|.
-  // StatusSerializer does not take ownership of any of the input pointers.
-  // Input pointers must remain valid for the lifetime of the StatusSerializer.
-  StatusSerializer(char **output, size_t *output_len)
-      : output_proto_{&proto},
-        status_proto_{&proto},
+  // Creates a new StatusSerializer that saves Status objects to a StatusProto
+  // allocated on |arena|. StatusSerializer does not take ownership of any of
+  // the input pointers. Input pointers must remain valid for the lifetime of
+  // the StatusSerializer.
+  StatusSerializer(Arena *arena, char **output, size_t *output_len)
+      : arena_{arena},
+        proto_{Arena::CreateMessage<OutputProto>(arena)},
+        output_proto_{proto_},
+        status_proto_{proto_},
         output_{output},
         output_len_{output_len} {}
 
+  // Sets an untrusted buffer of |size| bytes to serialize into. If the
+  // serialized output fits in |buffer|, it is written there instead of into a
+  // newly allocated untrusted buffer and *output is set to |buffer|.
+  void set_output_buffer(char *buffer, size_t size) {
+    output_buffer_ = buffer;
+    output_buffer_size_ = size;
+  }
+
   // Saves the given |status| into the StatusSerializer's status_proto_. Then
   // serializes its output_proto_ into a buffer. On success 0 is returned, else
   // 1 is returned and the StatusSerializer logs the error.
@@ -96,24 +117,31 @@ class StatusSerializer {
     // Serialize to a trusted buffer instead of an untrusted buffer because the
     // serialization routine may rely on read backs for correctness.
     *output_len_ = output_proto_->ByteSize();
-    std::unique_ptr<char[]> trusted_output(new char[*output_len_]);
-    if (!output_proto_->SerializeToArray(trusted_output.get(), *output_len_)) {
+    char *trusted_output = Arena::CreateArray<char>(arena_, *output_len_);
+    if (!output_proto_->SerializeToArray(trusted_output, *output_len_)) {
       *output_ = nullptr;
       *output_len_ = 0;
       LogError(status);
       return 1;
     }
-    *output_ = reinterpret_cast<char *>(enc_untrusted_malloc(*output_len_));
-    memcpy(*output_, trusted_output.get(), *output_len_);
+    if (output_buffer_ && *output_len_ <= output_buffer_size_) {
+      *output_ = output_buffer_;
+    } else {
+      *output_ = reinterpret_cast<char *>(enc_untrusted_malloc(*output_len_));
+    }
+    memcpy(*output_, trusted_output, *output_len_);
     return 0;
   }
 
  private:
-  OutputProto proto;
+  Arena *arena_;
+  OutputProto *proto_ = nullptr;
   const OutputProto *output_proto_;
   StatusProto *status_proto_;
   char **output_;
   size_t *output_len_;
+  char *output_buffer_ = nullptr;
+  size_t output_buffer_size_ = 0;
 };
 
 }  // namespace
@@ -135,6 +163,10 @@ EnclaveState TrustedApplication::GetState() {
   return enclave_state_;
 }
 
+google::protobuf::Arena *TrustedApplication::GetArena() const {
+  return ScopedThreadArena::Current();
+}
+
 void TrustedApplication::SetState(const EnclaveState &state) {
   absl::MutexLock lock(&mutex_);
   enclave_state_ = state;
@@ -182,6 +214,8 @@ Status InitializeEnvironmentVariables(
 }
 
 Status TrustedApplication::InitializeInternal(const EnclaveConfig &config) {
+  EnableHostCallStats(config.enable_host_call_stats());
+  SetUntrustedStagingThreshold(config.untrusted_staging_threshold_bytes());
   InitializeIO(config);
   Status status =
       InitializeEnvironmentVariables(config.environment_variables());
@@ -190,6 +224,12 @@ Status TrustedApplication::InitializeInternal(const EnclaveConfig &config) {
   if(!InitLogging(log_directory, GetEnclaveName().c_str(), vlog_level)) {
     fprintf(stderr, "Initialization of enclave logging failed\n");
   }
+  const LoggingConfig &logging_config = config.logging_config();
+  if (logging_config.buffered_log_flush_threshold_bytes() > 0 &&
+      !EnableBufferedLogging(logging_config.buffered_log_flush_threshold_bytes(),
+                             logging_config.buffered_log_flush_interval_ms())) {
+    fprintf(stderr, "Enabling buffered enclave logging failed\n");
+  }
   if (!status.ok()) {
     LOG(WARNING) << "Initialization of enclave environment variables failed: "
                  << status;
@@ -234,6 +274,8 @@ void InitializeIO(const EnclaveConfig &config) {
   // empty string is used.
   io_manager.RegisterVirtualPathHandler(
       "", ::absl::make_unique<io::NativePathHandler>());
+  io::GetNativeStatCache()->set_ttl(
+      absl::Milliseconds(config.native_stat_cache_ttl_ms()));
 
   // Register handlers for /dev/random and /dev/urandom so they can be opened
   // and read like regular files without exiting the enclave.
@@ -260,10 +302,13 @@ int __asylo_user_init(const char *name, const char *config, size_t config_len,
     return 1;
   }
 
-  StatusSerializer<StatusProto> status_serializer(output, output_len);
+  ScopedThreadArena arena;
+  StatusSerializer<StatusProto> status_serializer(arena.get(), output,
+                                                  output_len);
 
-  EnclaveConfig enclave_config;
-  if (!enclave_config.ParseFromArray(config, config_len)) {
+  EnclaveConfig *enclave_config =
+      Arena::CreateMessage<EnclaveConfig>(arena.get());
+  if (!enclave_config->ParseFromArray(config, config_len)) {
     status = Status(error::GoogleError::INVALID_ARGUMENT,
                     "Failed to parse EnclaveConfig");
     return status_serializer.Serialize(status);
@@ -278,7 +323,7 @@ int __asylo_user_init(const char *name, const char *config, size_t config_len,
 
   SetEnclaveName(name);
   // Invoke the enclave entry-point.
-  status = trusted_application->InitializeInternal(enclave_config);
+  status = trusted_application->InitializeInternal(*enclave_config);
   if (!status.ok()) {
     trusted_application->SetState(EnclaveState::kUninitialized);
     return status_serializer.Serialize(status);
@@ -290,17 +335,41 @@ int __asylo_user_init(const char *name, const char *config, size_t config_len,
 
 int __asylo_user_run(const char *input, size_t input_len, char **output,
                      size_t *output_len) {
+  return __asylo_user_run_with_buffer(input, input_len,
+                                      /*output_buffer=*/nullptr,
+                                      /*output_buffer_size=*/0, output,
+                                      output_len);
+}
+
+int __asylo_user_run_with_buffer(const char *input, size_t input_len,
+                                 char *output_buffer, size_t output_buffer_size,
+                                 char **output, size_t *output_len) {
   Status status = VerifyOutputArguments(output, output_len);
   if (!status.ok()) {
     return 1;
   }
 
-  EnclaveOutput enclave_output;
+  ScopedThreadArena arena;
+  EnclaveOutput *enclave_output =
+      Arena::CreateMessage<EnclaveOutput>(arena.get());
   StatusSerializer<EnclaveOutput> status_serializer(
-      &enclave_output, enclave_output.mutable_status(), output, output_len);
+      arena.get(), enclave_output, enclave_output->mutable_status(), output,
+      output_len);
+
+  // The output buffer is supplied by the untrusted caller, so it must be
+  // checked to lie entirely outside the enclave before anything is written to
+  // it.
+  if (output_buffer) {
+    if (!enc_is_outside_enclave(output_buffer, output_buffer_size)) {
+      status = Status(error::GoogleError::INVALID_ARGUMENT,
+                      "Output buffer is not in untrusted memory");
+      return status_serializer.Serialize(status);
+    }
+    status_serializer.set_output_buffer(output_buffer, output_buffer_size);
+  }
 
-  EnclaveInput enclave_input;
-  if (!enclave_input.ParseFromArray(input, input_len)) {
+  EnclaveInput *enclave_input = Arena::CreateMessage<EnclaveInput>(arena.get());
+  if (!enclave_input->ParseFromArray(input, input_len)) {
     status = Status(error::GoogleError::INVALID_ARGUMENT,
                     "Failed to parse EnclaveInput");
     return status_serializer.Serialize(status);
@@ -314,10 +383,51 @@ int __asylo_user_run(const char *input, size_t input_len, char **output,
   }
 
   // Invoke the enclave entry-point.
-  status = trusted_application->Run(enclave_input, &enclave_output);
+  status = trusted_application->Run(*enclave_input, enclave_output);
   return status_serializer.Serialize(status);
 }
 
+int __asylo_user_run_batch(const char *input, size_t input_len, char **output,
+                           size_t *output_len) {
+  Status status = VerifyOutputArguments(output, output_len);
+  if (!status.ok()) {
+    return 1;
+  }
+
+  ScopedThreadArena arena;
+  EnclaveOutputBatch *output_batch =
+      Arena::CreateMessage<EnclaveOutputBatch>(arena.get());
+  StatusSerializer<EnclaveOutputBatch> status_serializer(
+      arena.get(), output_batch, output_batch->mutable_status(), output,
+      output_len);
+
+  EnclaveInputBatch *input_batch =
+      Arena::CreateMessage<EnclaveInputBatch>(arena.get());
+  if (!input_batch->ParseFromArray(input, input_len)) {
+    status = Status(error::GoogleError::INVALID_ARGUMENT,
+                    "Failed to parse EnclaveInputBatch");
+    return status_serializer.Serialize(status);
+  }
+
+  // The state is checked once for the whole batch.
+  TrustedApplication *trusted_application = GetApplicationInstance();
+  if (trusted_application->GetState() != EnclaveState::kRunning) {
+    status = Status(error::GoogleError::FAILED_PRECONDITION,
+                    "Enclave not in state RUNNING");
+    return status_serializer.Serialize(status);
+  }
+
+  // Invoke the enclave entry-point for each input, recording the status of each
+  // invocation in its own output.
+  output_batch->mutable_outputs()->Reserve(input_batch->inputs_size());
+  for (const EnclaveInput &enclave_input : input_batch->inputs()) {
+    EnclaveOutput *enclave_output = output_batch->add_outputs();
+    trusted_application->Run(enclave_input, enclave_output)
+        .SaveTo(enclave_output->mutable_status());
+  }
+  return status_serializer.Serialize(Status::OkStatus());
+}
+
 int __asylo_user_fini(const char *input, size_t input_len, char **output,
                       size_t *output_len) {
   Status status = VerifyOutputArguments(output, output_len);
@@ -325,10 +435,12 @@ int __asylo_user_fini(const char *input, size_t input_len, char **output,
     return 1;
   }
 
-  StatusSerializer<StatusProto> status_serializer(output, output_len);
+  ScopedThreadArena arena;
+  StatusSerializer<StatusProto> status_serializer(arena.get(), output,
+                                                  output_len);
 
-  asylo::EnclaveFinal enclave_final;
-  if (!enclave_final.ParseFromArray(input, input_len)) {
+  EnclaveFinal *enclave_final = Arena::CreateMessage<EnclaveFinal>(arena.get());
+  if (!enclave_final->ParseFromArray(input, input_len)) {
     status = Status(error::GoogleError::INVALID_ARGUMENT,
                     "Failed to parse EnclaveFinal");
     return status_serializer.Serialize(status);
@@ -342,13 +454,14 @@ int __asylo_user_fini(const char *input, size_t input_len, char **output,
   }
 
   // Invoke the enclave entry-point.
-  status = trusted_application->Finalize(enclave_final);
+  status = trusted_application->Finalize(*enclave_final);
   if (!status.ok()) {
     trusted_application->SetState(EnclaveState::kRunning);
     return status_serializer.Serialize(status);
   }
 
   trusted_application->SetState(EnclaveState::kFinalized);
+  FlushLogs();
   return status_serializer.Serialize(status);
 }
 
@@ -23,6 +23,7 @@
 
 #include <string>
 
+#include <google/protobuf/arena.h>
 #include "asylo/enclave.pb.h"
 #include "asylo/platform/arch/include/trusted/entry_points.h"
 #include "asylo/platform/core/trusted_global_state.h"
@@ -128,6 +129,14 @@ class TrustedApplication {
   /// Returns the enclave state in a thread-safe manner.
   State GetState() LOCKS_EXCLUDED(mutex_);
 
+  /// Returns the protobuf arena holding the input and output of the entry
+  /// point running on the calling thread.
+  ///
+  /// The arena is reset when the entry point returns, so it may be used to
+  /// allocate parts of an output message, or temporary objects, that are not
+  /// needed after the call. Returns nullptr outside an entry point.
+  google::protobuf::Arena *GetArena() const;
+
  private:
   // Tracks the current enclave state.
   State enclave_state_ GUARDED_BY(mutex_) = State::kUninitialized;
@@ -147,6 +156,12 @@ class TrustedApplication {
                                size_t *output_len);
   friend int __asylo_user_run(const char *input, size_t input_len,
                               char **output, size_t *output_len);
+  friend int __asylo_user_run_with_buffer(const char *input, size_t input_len,
+                                          char *output_buffer,
+                                          size_t output_buffer_size,
+                                          char **output, size_t *output_len);
+  friend int __asylo_user_run_batch(const char *input, size_t input_len,
+                                    char **output, size_t *output_len);
   friend int __asylo_user_fini(const char *input, size_t input_len,
                                char **output, size_t *output_len);
   friend int __asylo_threading_donate();
@@ -0,0 +1,43 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "asylo/platform/posix/io/io_manager.h"
+
+using asylo::io::IOManager;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int eventfd(unsigned int initval, int flags) {
+  return IOManager::GetInstance().EventFd(initval, flags);
+}
+
+int eventfd_read(int fd, eventfd_t *value) {
+  return read(fd, value, sizeof(*value)) == sizeof(*value) ? 0 : -1;
+}
+
+int eventfd_write(int fd, eventfd_t value) {
+  return write(fd, &value, sizeof(value)) == sizeof(value) ? 0 : -1;
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
@@ -0,0 +1,47 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_POSIX_INCLUDE_SYS_EVENTFD_H_
+#define ASYLO_PLATFORM_POSIX_INCLUDE_SYS_EVENTFD_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t eventfd_t;
+
+// Provide semaphore-like semantics for reads from the new descriptor.
+#define EFD_SEMAPHORE 00000001
+// Atomically set close-on-exec flag for the new descriptor.
+#define EFD_CLOEXEC 02000000
+// Atomically mark the descriptor as non-blocking.
+#define EFD_NONBLOCK 00004000
+
+int eventfd(unsigned int initval, int flags);
+
+int eventfd_read(int fd, eventfd_t *value);
+
+int eventfd_write(int fd, eventfd_t value);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // ASYLO_PLATFORM_POSIX_INCLUDE_SYS_EVENTFD_H_
@@ -63,6 +63,13 @@ struct msghdr {
   int msg_flags;
 };
 
+struct mmsghdr {
+  struct msghdr msg_hdr;
+  unsigned int msg_len;
+};
+
+struct timespec;
+
 int accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
 int bind(int sockfd, const struct sockaddr *addr, socklen_t addrlen);
 int connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen);
@@ -83,18 +90,18 @@ int getpeername(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
 
 int listen(int sockfd, int backlog);
 
-// No implemention provided.
 ssize_t recv(int sockfd, void *buf, size_t len, int flags);
-
-// No implementation provided.
 ssize_t recvfrom(int sockfd, void *buf, size_t len, int flags,
                  struct sockaddr *src_addr, socklen_t *addrlen);
-
-// No implemention provided.
 ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags);
+int recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+             struct timespec *timeout);
 
 ssize_t send(int sockfd, const void *buf, size_t len, int flags);
+ssize_t sendto(int sockfd, const void *buf, size_t len, int flags,
+               const struct sockaddr *dest_addr, socklen_t addrlen);
 ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags);
+int sendmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags);
 
 int setsockopt(int socket, int level, int option_name, const void *option_value,
                socklen_t option_len);
@@ -0,0 +1,47 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_POSIX_INCLUDE_SYS_TIMERFD_H_
+#define ASYLO_PLATFORM_POSIX_INCLUDE_SYS_TIMERFD_H_
+
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Interpret the expiration time passed to timerfd_settime as an absolute value
+// of the timer's clock.
+#define TFD_TIMER_ABSTIME 00000001
+// Atomically set close-on-exec flag for the new descriptor.
+#define TFD_CLOEXEC 02000000
+// Atomically mark the descriptor as non-blocking.
+#define TFD_NONBLOCK 00004000
+
+int timerfd_create(int clockid, int flags);
+
+int timerfd_settime(int fd, int flags, const struct itimerspec *new_value,
+                    struct itimerspec *old_value);
+
+int timerfd_gettime(int fd, struct itimerspec *curr_value);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // ASYLO_PLATFORM_POSIX_INCLUDE_SYS_TIMERFD_H_
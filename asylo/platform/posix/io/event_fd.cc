@@ -0,0 +1,140 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "asylo/platform/posix/io/event_fd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+
+namespace asylo {
+namespace {
+
+// The largest value the counter of an eventfd descriptor can hold.
+constexpr uint64_t kMaxCounter = UINT64_C(0xfffffffffffffffe);
+
+}  // namespace
+
+EventFdIOContext::EventFdIOContext(unsigned int initval, int flags)
+    : semaphore_(flags & EFD_SEMAPHORE),
+      flags_(flags & O_NONBLOCK),
+      counter_(initval) {}
+
+ssize_t EventFdIOContext::Read(void *buf, size_t count) {
+  if (count < sizeof(uint64_t)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  uint64_t value;
+  {
+    absl::MutexLock lock(&mu_);
+    while (counter_ == 0) {
+      if (flags_ & O_NONBLOCK) {
+        errno = EAGAIN;
+        return -1;
+      }
+      changed_.Wait(&mu_);
+    }
+    value = semaphore_ ? 1 : counter_;
+    counter_ -= value;
+    changed_.SignalAll();
+  }
+  memcpy(buf, &value, sizeof(value));
+  io::IOManager::GetInstance().NotifyReadinessChanged();
+  return sizeof(value);
+}
+
+ssize_t EventFdIOContext::Write(const void *buf, size_t count) {
+  if (count < sizeof(uint64_t)) {
+    errno = EINVAL;
+    return -1;
+  }
+  uint64_t value;
+  memcpy(&value, buf, sizeof(value));
+  if (value > kMaxCounter) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  {
+    absl::MutexLock lock(&mu_);
+    while (counter_ > kMaxCounter - value) {
+      if (flags_ & O_NONBLOCK) {
+        errno = EAGAIN;
+        return -1;
+      }
+      changed_.Wait(&mu_);
+    }
+    counter_ += value;
+    changed_.SignalAll();
+  }
+  io::IOManager::GetInstance().NotifyReadinessChanged();
+  return sizeof(value);
+}
+
+int EventFdIOContext::Close() { return 0; }
+
+int EventFdIOContext::LSeek(off_t offset, int whence) {
+  errno = ESPIPE;
+  return -1;
+}
+
+int EventFdIOContext::FCntl(int cmd, int64_t arg) {
+  switch (cmd) {
+    case F_GETFL:
+      return O_RDWR | flags_;
+    case F_SETFL:
+      flags_ = arg & O_NONBLOCK;
+      return 0;
+    case F_GETFD:
+    case F_SETFD:
+      // Close-on-exec has no meaning inside the enclave.
+      return 0;
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+}
+
+int EventFdIOContext::FStat(struct stat *stat_buffer) {
+  memset(stat_buffer, 0, sizeof(*stat_buffer));
+  stat_buffer->st_mode = S_IRUSR | S_IWUSR;
+  stat_buffer->st_nlink = 1;
+  return 0;
+}
+
+int EventFdIOContext::Isatty() { return 0; }
+
+bool EventFdIOContext::PollReadiness(short events, short *revents) {
+  short ready = 0;
+  {
+    absl::MutexLock lock(&mu_);
+    if (counter_ > 0) {
+      ready |= POLLIN | POLLRDNORM;
+    }
+    if (counter_ < kMaxCounter) {
+      ready |= POLLOUT | POLLWRNORM;
+    }
+  }
+  *revents = ready & events;
+  return true;
+}
+
+}  // namespace asylo
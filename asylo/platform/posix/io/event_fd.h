@@ -0,0 +1,65 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef ASYLO_PLATFORM_POSIX_IO_EVENT_FD_H_
+#define ASYLO_PLATFORM_POSIX_IO_EVENT_FD_H_
+
+#include <sys/stat.h>
+#include <atomic>
+#include <cstdint>
+
+#include "absl/synchronization/mutex.h"
+#include "asylo/platform/posix/io/io_manager.h"
+
+namespace asylo {
+
+// IOContext implementation for a descriptor created by eventfd(2). The counter
+// of the descriptor is kept in trusted memory, so threads of the enclave can
+// wake each other up through it without a host call.
+class EventFdIOContext : public io::IOManager::IOContext {
+ public:
+  // Creates a descriptor with a counter of |initval|. |flags| may contain
+  // EFD_SEMAPHORE and EFD_NONBLOCK.
+  EventFdIOContext(unsigned int initval, int flags);
+
+ protected:
+  ssize_t Read(void *buf, size_t count) override;
+  ssize_t Write(const void *buf, size_t count) override;
+  int Close() override;
+  int LSeek(off_t offset, int whence) override;
+  int FCntl(int cmd, int64_t arg) override;
+  int FStat(struct stat *stat_buffer) override;
+  int Isatty() override;
+  bool PollReadiness(short events, short *revents) override;
+
+ private:
+  const bool semaphore_;
+
+  // O_NONBLOCK if reads and writes should not block.
+  std::atomic<int> flags_;
+
+  absl::Mutex mu_;
+
+  // Signaled whenever |counter_| changes.
+  absl::CondVar changed_;
+
+  uint64_t counter_ GUARDED_BY(mu_);
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_POSIX_IO_EVENT_FD_H_
@@ -0,0 +1,110 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include "asylo/platform/posix/io/io_manager.h"
+
+namespace asylo {
+namespace {
+
+// Tests that writes add to the counter and a read returns and resets it.
+TEST(EventFdTest, ReadWrite) {
+  int fd = eventfd(3, 0);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(eventfd_write(fd, 4), 0);
+
+  eventfd_t value;
+  ASSERT_EQ(eventfd_read(fd, &value), 0);
+  EXPECT_EQ(value, 7);
+
+  // Buffers smaller than the counter are rejected.
+  char small[4];
+  EXPECT_EQ(read(fd, small, sizeof(small)), -1);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(write(fd, small, sizeof(small)), -1);
+  EXPECT_EQ(errno, EINVAL);
+  close(fd);
+}
+
+// Tests that reads decrement the counter by one in semaphore mode.
+TEST(EventFdTest, Semaphore) {
+  int fd = eventfd(2, EFD_SEMAPHORE | EFD_NONBLOCK);
+  ASSERT_GE(fd, 0);
+  eventfd_t value;
+  ASSERT_EQ(eventfd_read(fd, &value), 0);
+  EXPECT_EQ(value, 1);
+  ASSERT_EQ(eventfd_read(fd, &value), 0);
+  EXPECT_EQ(value, 1);
+  EXPECT_EQ(eventfd_read(fd, &value), -1);
+  EXPECT_EQ(errno, EAGAIN);
+  close(fd);
+}
+
+// Tests that a write which would overflow the counter does not block in
+// non-blocking mode.
+TEST(EventFdTest, Overflow) {
+  int fd = eventfd(0, EFD_NONBLOCK);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(eventfd_write(fd, UINT64_C(0xfffffffffffffffe)), 0);
+  EXPECT_EQ(eventfd_write(fd, 1), -1);
+  EXPECT_EQ(errno, EAGAIN);
+
+  struct pollfd pfd = {fd, POLLIN | POLLOUT, 0};
+  ASSERT_EQ(poll(&pfd, 1, 0), 1);
+  EXPECT_EQ(pfd.revents, POLLIN);
+
+  // The largest value is reserved.
+  EXPECT_EQ(eventfd_write(fd, UINT64_C(0xffffffffffffffff)), -1);
+  EXPECT_EQ(errno, EINVAL);
+  close(fd);
+}
+
+// Tests that a thread waiting in poll() is woken up by a write from another
+// thread.
+TEST(EventFdTest, PollWakeup) {
+  int fd = eventfd(0, 0);
+  ASSERT_GE(fd, 0);
+  struct pollfd pfd = {fd, POLLIN, 0};
+  ASSERT_EQ(poll(&pfd, 1, 0), 0);
+
+  std::thread writer([fd] { eventfd_write(fd, 1); });
+  ASSERT_EQ(poll(&pfd, 1, -1), 1);
+  EXPECT_EQ(pfd.revents, POLLIN);
+  writer.join();
+
+  eventfd_t value;
+  ASSERT_EQ(eventfd_read(fd, &value), 0);
+  EXPECT_EQ(value, 1);
+  close(fd);
+}
+
+// Tests that unsupported flags are rejected.
+TEST(EventFdTest, InvalidFlags) {
+  EXPECT_EQ(eventfd(0, O_APPEND), -1);
+  EXPECT_EQ(errno, EINVAL);
+}
+
+}  // namespace
+}  // namespace asylo
@@ -22,12 +22,22 @@
 #include <fcntl.h>
 #include <poll.h>
 #include <stdint.h>
-
-#include "absl/algorithm/container.h"
-#include "absl/strings/str_cat.h"
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "asylo/platform/arch/include/trusted/host_calls.h"
+#include "asylo/platform/posix/io/event_fd.h"
 #include "asylo/platform/posix/io/native_paths.h"
+#include "asylo/platform/posix/io/timer_fd.h"
+#include "asylo/platform/posix/io/trusted_pipe.h"
 #include "asylo/platform/posix/io/util.h"
 #include "asylo/util/posix_error_space.h"
 #include "asylo/util/statusor.h"
@@ -35,6 +45,46 @@
 namespace asylo {
 namespace io {
 
+ssize_t IOManager::IOContext::Preadv(const struct iovec *iov, int iovcnt,
+                                     off_t offset) {
+  if (iovcnt <= 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  ssize_t total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    ssize_t result = Pread(iov[i].iov_base, iov[i].iov_len, offset + total);
+    if (result < 0) {
+      return total > 0 ? total : result;
+    }
+    total += result;
+    if (static_cast<size_t>(result) < iov[i].iov_len) {
+      break;
+    }
+  }
+  return total;
+}
+
+ssize_t IOManager::IOContext::Pwritev(const struct iovec *iov, int iovcnt,
+                                      off_t offset) {
+  if (iovcnt <= 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  ssize_t total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    ssize_t result = Pwrite(iov[i].iov_base, iov[i].iov_len, offset + total);
+    if (result < 0) {
+      return total > 0 ? total : result;
+    }
+    total += result;
+    if (static_cast<size_t>(result) < iov[i].iov_len) {
+      break;
+    }
+  }
+  return total;
+}
+
 IOManager::FileDescriptorTable::FileDescriptorTable()
     : maximum_fd_soft_limit(kMaxOpenFiles),
       maximum_fd_hard_limit(kMaxOpenFiles) {}
@@ -46,13 +96,15 @@ std::shared_ptr<IOManager::IOContext> IOManager::FileDescriptorTable::Get(
 }
 
 bool IOManager::FileDescriptorTable::HasSharedIOContext(int fd) {
-  if (!IsFileDescriptorValid(fd)) return false;
-  return !fd_table_[fd].unique();
+  if (!IsFileDescriptorValid(fd) || !fd_table_[fd]) return false;
+  // The reference count of the context also includes references held by
+  // callers, so the entries of the table are counted separately.
+  return entry_counts_[fd_table_[fd].get()] > 1;
 }
 
 void IOManager::FileDescriptorTable::Delete(int fd) {
   if (!IsFileDescriptorValid(fd)) return;
-  fd_table_[fd] = nullptr;
+  SetEntry(fd, nullptr);
 }
 
 bool IOManager::FileDescriptorTable::IsFileDescriptorUnused(int fd) {
@@ -65,7 +117,7 @@ int IOManager::FileDescriptorTable::Insert(IOContext *context) {
   if (fd < 0) {
     return -1;
   }
-  fd_table_[fd] = std::shared_ptr<IOContext>(context);
+  SetEntry(fd, std::shared_ptr<IOContext>(context));
   return fd;
 }
 
@@ -74,7 +126,7 @@ int IOManager::FileDescriptorTable::CopyFileDescriptor(int oldfd, int startfd) {
   if (!IsFileDescriptorValid(oldfd) || newfd == -1) {
     return -1;
   }
-  fd_table_[newfd] = fd_table_[oldfd];
+  SetEntry(newfd, fd_table_[oldfd]);
   return newfd;
 }
 
@@ -84,7 +136,7 @@ int IOManager::FileDescriptorTable::CopyFileDescriptorToSpecifiedTarget(
       fd_table_[newfd]) {
     return -1;
   }
-  fd_table_[newfd] = fd_table_[oldfd];
+  SetEntry(newfd, fd_table_[oldfd]);
   return newfd;
 }
 
@@ -123,6 +175,20 @@ int IOManager::FileDescriptorTable::GetHighestFileDescriptorUsed() {
   return -1;
 }
 
+void IOManager::FileDescriptorTable::SetEntry(
+    int fd, std::shared_ptr<IOContext> context) {
+  if (fd_table_[fd]) {
+    auto it = entry_counts_.find(fd_table_[fd].get());
+    if (--it->second == 0) {
+      entry_counts_.erase(it);
+    }
+  }
+  if (context) {
+    ++entry_counts_[context.get()];
+  }
+  fd_table_[fd] = std::move(context);
+}
+
 int IOManager::FileDescriptorTable::GetNextFreeFileDescriptor(int startfd) {
   if (startfd < 0) {
     return -1;
@@ -167,48 +233,14 @@ int IOManager::Close(int fd) {
 
 IOManager::VirtualPathHandler *IOManager::HandlerForPath(
     absl::string_view path) const {
-  // Start by looking for a full match.
-  std::string current_prefix(path);
-
-  // Keep looking until we find a match or run out of handlers to check.
-  while (true) {
-    // Find the first handler with a prefix greater or equal to this path.
-    // If there is an exact match, this will be it.  Otherwise, any match must
-    // be before this.
-    auto iter = prefix_to_handler_.lower_bound(current_prefix);
-
-    // iter->first is the registered prefix.
-    // iter->second.get() is a pointer to the registered handler.
-
-    // lower_bound can land directory on a match.
-    if (iter != prefix_to_handler_.end() && current_prefix == iter->first) {
-      return iter->second.get();
+  // A prefix matches if it is the whole path, or is followed by a "/" in the
+  // path.
+  for (const PathHandlerEntry &entry : path_handlers_) {
+    if (absl::StartsWith(path, entry.prefix) &&
+        (path.size() == entry.prefix.size() ||
+         path[entry.prefix.size()] == '/')) {
+      return entry.handler.get();
     }
-
-    // Since we started with the lower_bound, any prefixes will be found
-    // before that iterator.  If there are none, we're done.
-    if (iter == prefix_to_handler_.begin()) break;
-    --iter;
-
-    // Determine how much this handler's prefix and the current prefix have in
-    // common.
-    std::string::const_iterator end_prefix, end_path;
-    std::tie(end_prefix, end_path) =
-        absl::c_mismatch(iter->first, current_prefix);
-
-    // If the entire prefix is in the current prefix up to a /, it's a match.
-    if (end_prefix == iter->first.end() && *end_path == '/') {
-      return iter->second.get();
-    }
-
-    // Back up the prefix to nearest directory.  We know there can't be a
-    // matching handler with a longer prefix match or we would have found it by
-    // now.
-    while (*end_prefix != '/') --end_prefix;
-
-    // The next iteration of the loop will look for a matching handler using
-    // that directory prefix.
-    current_prefix = std::string(iter->first.begin(), end_prefix);
   }
 
   // Didn't find a handler.
@@ -268,6 +300,30 @@ int IOManager::Dup2(int oldfd, int newfd) {
 }
 
 int IOManager::Pipe(int pipefd[2]) {
+  std::unique_ptr<TrustedPipeIOContext> read_end;
+  std::unique_ptr<TrustedPipeIOContext> write_end;
+  TrustedPipeIOContext::CreatePipe(/*flags=*/0, &read_end, &write_end);
+
+  absl::WriterMutexLock lock(&fd_table_lock_);
+  int read_fd = fd_table_.Insert(read_end.get());
+  if (read_fd < 0) {
+    errno = EMFILE;
+    return -1;
+  }
+  read_end.release();
+  int write_fd = fd_table_.Insert(write_end.get());
+  if (write_fd < 0) {
+    fd_table_.Delete(read_fd);
+    errno = EMFILE;
+    return -1;
+  }
+  write_end.release();
+  pipefd[0] = read_fd;
+  pipefd[1] = write_fd;
+  return 0;
+}
+
+int IOManager::HostPipe(int pipefd[2]) {
   int res = enc_untrusted_pipe(pipefd);
   if (res != -1) {
     pipefd[0] = RegisterHostFileDescriptor(pipefd[0]);
@@ -280,25 +336,221 @@ int IOManager::Pipe(int pipefd[2]) {
   return res;
 }
 
+int IOManager::EventFd(unsigned int initval, int flags) {
+  if (flags & ~(EFD_SEMAPHORE | EFD_CLOEXEC | EFD_NONBLOCK)) {
+    errno = EINVAL;
+    return -1;
+  }
+  auto context = absl::make_unique<EventFdIOContext>(initval, flags);
+
+  absl::WriterMutexLock lock(&fd_table_lock_);
+  int fd = fd_table_.Insert(context.get());
+  if (fd < 0) {
+    errno = EMFILE;
+    return -1;
+  }
+  context.release();
+  return fd;
+}
+
+int IOManager::TimerFdCreate(int clockid, int flags) {
+  if ((clockid != CLOCK_REALTIME && clockid != CLOCK_MONOTONIC) ||
+      (flags & ~(TFD_CLOEXEC | TFD_NONBLOCK))) {
+    errno = EINVAL;
+    return -1;
+  }
+  auto context = absl::make_unique<TimerFdIOContext>(clockid, flags);
+
+  absl::WriterMutexLock lock(&fd_table_lock_);
+  int fd = fd_table_.Insert(context.get());
+  if (fd < 0) {
+    errno = EMFILE;
+    return -1;
+  }
+  context.release();
+  return fd;
+}
+
 int IOManager::Poll(struct pollfd *fds, nfds_t nfds, int timeout) {
-  std::vector<int> enclave_fd(nfds);
+  // The longest the host is asked to wait when streams implemented inside the
+  // enclave are polled together with host file descriptors and no doorbell is
+  // available. A stream inside the enclave that becomes ready in the meantime
+  // is only noticed once the host call returns.
+  constexpr int kMaxHostPollMilliseconds = 10;
+
+  std::vector<std::shared_ptr<IOContext>> contexts(nfds);
+  std::vector<bool> is_host_fd(nfds);
+  std::vector<struct pollfd> host_fds;
+  std::vector<nfds_t> host_fd_index;
   {
     absl::ReaderMutexLock lock(&fd_table_lock_);
-    for (int i = 0; i < nfds; ++i) {
-      enclave_fd[i] = fds[i].fd;
-      std::shared_ptr<IOContext> context = fd_table_.Get(enclave_fd[i]);
-      if (context) {
-        fds[i].fd = context->GetHostFileDescriptor();
-      } else {
-        fds[i].fd = -1;
+    for (nfds_t i = 0; i < nfds; ++i) {
+      contexts[i] = fd_table_.Get(fds[i].fd);
+      int host_fd = contexts[i] ? contexts[i]->GetHostFileDescriptor() : -1;
+      if (host_fd >= 0) {
+        host_fds.push_back({host_fd, fds[i].events, 0});
+        host_fd_index.push_back(i);
+        contexts[i] = nullptr;
+        is_host_fd[i] = true;
       }
     }
   }
-  int ret = enc_untrusted_poll(fds, nfds, timeout);
-  for (int i = 0; i < nfds; ++i) {
-    fds[i].fd = enclave_fd[i];
+
+  absl::Time deadline = timeout < 0
+                            ? absl::InfiniteFuture()
+                            : absl::Now() + absl::Milliseconds(timeout);
+  while (true) {
+    uint64_t generation;
+    {
+      absl::MutexLock lock(&readiness_mutex_);
+      generation = readiness_generation_;
+    }
+
+    int ready = 0;
+    bool has_trusted_fds = false;
+    for (nfds_t i = 0; i < nfds; ++i) {
+      fds[i].revents = 0;
+      if (contexts[i] &&
+          contexts[i]->PollReadiness(fds[i].events, &fds[i].revents)) {
+        has_trusted_fds = true;
+      } else if (!contexts[i] && fds[i].fd >= 0 && !is_host_fd[i]) {
+        fds[i].revents = POLLNVAL;
+      }
+      if (fds[i].revents != 0) {
+        ++ready;
+      }
+    }
+
+    // Streams that are already ready are reported without waiting. Host file
+    // descriptors are still polled once without a timeout so that a stream
+    // that is always ready does not starve them.
+    if (ready > 0) {
+      if (!host_fds.empty() &&
+          enc_untrusted_poll(host_fds.data(), host_fds.size(), 0) > 0) {
+        for (size_t j = 0; j < host_fds.size(); ++j) {
+          fds[host_fd_index[j]].revents = host_fds[j].revents;
+          if (host_fds[j].revents != 0) {
+            ++ready;
+          }
+        }
+      }
+      return ready;
+    }
+
+    // Streams such as timers become ready without being notified, so the wait
+    // ends when the first of them may change.
+    absl::Time wakeup = deadline;
+    for (nfds_t i = 0; i < nfds; ++i) {
+      if (contexts[i]) {
+        wakeup = std::min(wakeup, contexts[i]->NextReadinessChange());
+      }
+    }
+
+    // Without streams implemented inside the enclave, the host waits for the
+    // whole timeout. Otherwise it waits until the next change of a stream
+    // inside the enclave, which rings the doorbell to end the host call.
+    int host_timeout = timeout;
+    if (has_trusted_fds && wakeup != absl::InfiniteFuture()) {
+      absl::Duration remaining = wakeup - absl::Now();
+      host_timeout = remaining <= absl::ZeroDuration()
+                         ? 0
+                         : absl::ToInt64Milliseconds(
+                               absl::Ceil(remaining, absl::Milliseconds(1)));
+    }
+    if (!host_fds.empty() || !has_trusted_fds) {
+      int doorbell = -1;
+      if (has_trusted_fds) {
+        if (!BeginHostPoll(generation, &doorbell)) {
+          continue;
+        }
+        if (doorbell >= 0) {
+          host_fds.push_back({doorbell, POLLIN, 0});
+        } else if (host_timeout < 0 ||
+                   host_timeout > kMaxHostPollMilliseconds) {
+          host_timeout = kMaxHostPollMilliseconds;
+        }
+      }
+      int ret = enc_untrusted_poll(host_fds.data(), host_fds.size(),
+                                   host_timeout);
+      if (has_trusted_fds) {
+        int saved_errno = errno;
+        EndHostPoll();
+        errno = saved_errno;
+        if (doorbell >= 0) {
+          if (ret > 0 && host_fds.back().revents != 0) {
+            --ret;
+          }
+          host_fds.pop_back();
+        }
+      }
+      if (ret != 0 || !has_trusted_fds) {
+        for (size_t j = 0; j < host_fds.size(); ++j) {
+          fds[host_fd_index[j]].revents = host_fds[j].revents;
+        }
+        return ret;
+      }
+    }
+
+    if (deadline - absl::Now() <= absl::ZeroDuration()) {
+      return 0;
+    }
+    if (host_fds.empty()) {
+      WaitForReadinessChange(generation, wakeup);
+    }
+  }
+}
+
+void IOManager::NotifyReadinessChanged() {
+  absl::MutexLock lock(&readiness_mutex_);
+  ++readiness_generation_;
+  readiness_changed_.SignalAll();
+  if (host_polls_in_flight_ > 0 && !doorbell_rung_) {
+    char byte = 0;
+    doorbell_rung_ = enc_untrusted_write(doorbell_fds_[1], &byte, 1) == 1;
+  }
+}
+
+bool IOManager::BeginHostPoll(uint64_t generation, int *doorbell) {
+  absl::MutexLock lock(&readiness_mutex_);
+  if (readiness_generation_ != generation) {
+    return false;
+  }
+  if (!doorbell_created_) {
+    doorbell_created_ = true;
+    if (enc_untrusted_pipe(doorbell_fds_) != 0) {
+      doorbell_fds_[0] = -1;
+      doorbell_fds_[1] = -1;
+    }
+  }
+  *doorbell = doorbell_fds_[0];
+  if (*doorbell >= 0) {
+    ++host_polls_in_flight_;
+  }
+  return true;
+}
+
+void IOManager::EndHostPoll() {
+  absl::MutexLock lock(&readiness_mutex_);
+  if (doorbell_fds_[0] < 0) {
+    return;
+  }
+  // The doorbell stays readable until the last host poll returns, so that no
+  // host poll in flight misses it.
+  if (--host_polls_in_flight_ == 0 && doorbell_rung_) {
+    char byte;
+    enc_untrusted_read(doorbell_fds_[0], &byte, 1);
+    doorbell_rung_ = false;
+  }
+}
+
+void IOManager::WaitForReadinessChange(uint64_t generation,
+                                       absl::Time deadline) {
+  absl::MutexLock lock(&readiness_mutex_);
+  while (readiness_generation_ == generation) {
+    if (readiness_changed_.WaitWithDeadline(&readiness_mutex_, deadline)) {
+      return;
+    }
   }
-  return ret;
 }
 
 template <typename IOAction>
@@ -320,17 +572,17 @@ template <typename IOAction>
 typename std::result_of<IOAction(IOManager::VirtualPathHandler *,
                                  const char *)>::type
 IOManager::CallWithHandler(const char *path, IOAction action) {
-  StatusOr<std::string> status = CanonicalizePath(path);
+  char canonical_path[kPathBufferSize];
+  VirtualPathHandler *handler;
+  Status status = CanonicalizePath(path, canonical_path, &handler);
   if (!status.ok()) {
-    errno = status.status().error_code();
+    errno = status.error_code();
     return -1;
   }
 
-  absl::string_view canonical_path = status.ValueOrDie();
-  VirtualPathHandler *handler = HandlerForPath(canonical_path);
   if (handler) {
     // Invoke the path handler if one is installed.
-    return action(handler, canonical_path.data());
+    return action(handler, canonical_path);
   }
 
   errno = ENOENT;
@@ -342,21 +594,21 @@ typename std::result_of<IOAction(IOManager::VirtualPathHandler *, const char *,
                                  const char *)>::type
 IOManager::CallWithHandler(const char *path1, const char *path2,
                            IOAction action) {
-  StatusOr<std::string> status1 = CanonicalizePath(path1);
-  StatusOr<std::string> status2 = CanonicalizePath(path2);
+  char canonical_path1[kPathBufferSize];
+  char canonical_path2[kPathBufferSize];
+  VirtualPathHandler *handler1;
+  VirtualPathHandler *handler2;
+  Status status1 = CanonicalizePath(path1, canonical_path1, &handler1);
+  Status status2 = CanonicalizePath(path2, canonical_path2, &handler2);
   if (!status1.ok()) {
-    errno = status1.status().error_code();
+    errno = status1.error_code();
     return -1;
   }
   if (!status2.ok()) {
-    errno = status2.status().error_code();
+    errno = status2.error_code();
     return -1;
   }
 
-  absl::string_view canonical_path1 = status1.ValueOrDie();
-  absl::string_view canonical_path2 = status2.ValueOrDie();
-  VirtualPathHandler *handler1 = HandlerForPath(canonical_path1);
-  VirtualPathHandler *handler2 = HandlerForPath(canonical_path2);
   if (handler1 != handler2) {
     errno = EXDEV;
     return -1;
@@ -364,7 +616,7 @@ IOManager::CallWithHandler(const char *path1, const char *path2,
 
   if (handler1) {
     // Invoke the path handler if one is installed.
-    return action(handler1, canonical_path1.data(), canonical_path2.data());
+    return action(handler1, canonical_path1, canonical_path2);
   }
 
   errno = ENOENT;
@@ -384,12 +636,31 @@ bool IOManager::RegisterVirtualPathHandler(
     return false;
   }
 
-  prefix_to_handler_.emplace(path_prefix, std::move(handler));
+  auto has_prefix = [&path_prefix](const PathHandlerEntry &entry) {
+    return entry.prefix == path_prefix;
+  };
+  // A handler already registered for the prefix is kept.
+  if (std::any_of(path_handlers_.begin(), path_handlers_.end(), has_prefix)) {
+    return true;
+  }
+
+  // Keep the entries ordered by decreasing prefix length.
+  auto iter = std::find_if(path_handlers_.begin(), path_handlers_.end(),
+                           [&path_prefix](const PathHandlerEntry &entry) {
+                             return entry.prefix.size() < path_prefix.size();
+                           });
+  path_handlers_.insert(iter, PathHandlerEntry{path_prefix, std::move(handler)});
   return true;
 }
 
 void IOManager::DeregisterVirtualPathHandler(const std::string &path_prefix) {
-  prefix_to_handler_.erase(path_prefix);
+  auto iter = std::find_if(path_handlers_.begin(), path_handlers_.end(),
+                           [&path_prefix](const PathHandlerEntry &entry) {
+                             return entry.prefix == path_prefix;
+                           });
+  if (iter != path_handlers_.end()) {
+    path_handlers_.erase(iter);
+  }
 }
 
 Status IOManager::SetCurrentWorkingDirectory(absl::string_view path) {
@@ -407,6 +678,17 @@ std::string IOManager::GetCurrentWorkingDirectory() const {
 }
 
 StatusOr<std::string> IOManager::CanonicalizePath(absl::string_view path) const {
+  char buffer[kPathBufferSize];
+  VirtualPathHandler *handler;
+  Status status = CanonicalizePath(path, buffer, &handler);
+  if (!status.ok()) {
+    return status;
+  }
+  return std::string(buffer);
+}
+
+Status IOManager::CanonicalizePath(absl::string_view path, char *buffer,
+                                   VirtualPathHandler **handler) const {
   // Cannot resolve an empty path.
   if (path.empty()) {
     return Status(error::PosixError::P_ENOENT,
@@ -417,10 +699,10 @@ StatusOr<std::string> IOManager::CanonicalizePath(absl::string_view path) const
   // By default, though, any handler is fine.
   VirtualPathHandler *required_handler = nullptr;
 
-  // Handle relative paths.
-  std::string relative_path;
+  // Handle relative paths by resolving them relative to the working directory.
+  absl::string_view working_directory;
   if (path.front() != '/') {
-    std::string working_directory = GetCurrentWorkingDirectory();
+    working_directory = current_working_directory_;
 
     // If the current working directory has not yet been set, cannot
     // canonicalize relative paths.
@@ -429,27 +711,26 @@ StatusOr<std::string> IOManager::CanonicalizePath(absl::string_view path) const
                     "Canonicalization of relative path before initialization");
     }
 
-    // Prepend the working directory to the given path. Don't worry about
-    // possible duplicate '/' characters, as NormalizePath will strip them out.
-    relative_path = absl::StrCat(working_directory, "/", path);
-    path = relative_path;
-
     // Relative paths are only allowed to resolve to the same handler as the
     // working directory.
     required_handler = HandlerForPath(working_directory);
   }
 
   // Normalize the path to remove any directory traversals.
-  std::string ret = util::NormalizePath(path);
+  if (util::NormalizePath(working_directory, path, buffer, kPathBufferSize) ==
+      0) {
+    return Status(error::PosixError::P_ENAMETOOLONG, "Path too long");
+  }
 
   // If the allowed handler for this path is restricted, check that it matches
   // the requirement.
-  if (required_handler && HandlerForPath(ret) != required_handler) {
+  *handler = HandlerForPath(buffer);
+  if (required_handler && *handler != required_handler) {
     return Status(error::PosixError::P_EACCES,
                   "Relative path resolution across access domains");
   }
 
-  return ret;
+  return Status::OkStatus();
 }
 
 int IOManager::Write(int fd, const char *buf, size_t count) {
@@ -511,6 +792,13 @@ int IOManager::LStat(const char *pathname, struct stat *stat_buffer) {
   });
 }
 
+int IOManager::PrefetchStats(const char *directory) {
+  return CallWithHandler(
+      directory, [](VirtualPathHandler *handler, const char *canonical_path) {
+        return handler->PrefetchStats(canonical_path);
+      });
+}
+
 int IOManager::LSeek(int fd, off_t offset, int whence) {
   return CallWithContext(fd,
                          [offset, whence](std::shared_ptr<IOContext> context) {
@@ -552,6 +840,21 @@ int IOManager::Isatty(int fd) {
       fd, [](std::shared_ptr<IOContext> context) { return context->Isatty(); });
 }
 
+int IOManager::TimerFdSetTime(int fd, int flags,
+                              const struct itimerspec *new_value,
+                              struct itimerspec *old_value) {
+  return CallWithContext(fd, [flags, new_value,
+                              old_value](std::shared_ptr<IOContext> context) {
+    return context->TimerSetTime(flags, new_value, old_value);
+  });
+}
+
+int IOManager::TimerFdGetTime(int fd, struct itimerspec *curr_value) {
+  return CallWithContext(fd, [curr_value](std::shared_ptr<IOContext> context) {
+    return context->TimerGetTime(curr_value);
+  });
+}
+
 int IOManager::Ioctl(int fd, int request, void *argp) {
   return CallWithContext(fd,
                          [request, argp](std::shared_ptr<IOContext> context) {
@@ -578,6 +881,120 @@ ssize_t IOManager::Readv(int fd, const struct iovec *iov, int iovcnt) {
   });
 }
 
+ssize_t IOManager::Pread(int fd, void *buf, size_t count, off_t offset) {
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  return CallWithContext(
+      fd, [buf, count, offset](std::shared_ptr<IOContext> context) {
+        return context->Pread(buf, count, offset);
+      });
+}
+
+ssize_t IOManager::Pwrite(int fd, const void *buf, size_t count,
+                          off_t offset) {
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  return CallWithContext(
+      fd, [buf, count, offset](std::shared_ptr<IOContext> context) {
+        return context->Pwrite(buf, count, offset);
+      });
+}
+
+ssize_t IOManager::Preadv(int fd, const struct iovec *iov, int iovcnt,
+                          off_t offset) {
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  return CallWithContext(
+      fd, [iov, iovcnt, offset](std::shared_ptr<IOContext> context) {
+        return context->Preadv(iov, iovcnt, offset);
+      });
+}
+
+ssize_t IOManager::Pwritev(int fd, const struct iovec *iov, int iovcnt,
+                           off_t offset) {
+  if (offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  return CallWithContext(
+      fd, [iov, iovcnt, offset](std::shared_ptr<IOContext> context) {
+        return context->Pwritev(iov, iovcnt, offset);
+      });
+}
+
+ssize_t IOManager::SendFile(int out_fd, int in_fd, off_t *offset,
+                            size_t count) {
+  if (offset && *offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  std::shared_ptr<IOContext> out_context;
+  std::shared_ptr<IOContext> in_context;
+  {
+    absl::ReaderMutexLock lock(&fd_table_lock_);
+    out_context = fd_table_.Get(out_fd);
+    in_context = fd_table_.Get(in_fd);
+  }
+  if (!out_context || !in_context) {
+    errno = EBADF;
+    return -1;
+  }
+
+  int host_out_fd = out_context->GetHostFileDescriptor();
+  int host_in_fd = in_context->GetHostFileDescriptor();
+  if (host_out_fd >= 0 && host_in_fd >= 0) {
+    ssize_t ret =
+        enc_untrusted_sendfile(host_out_fd, host_in_fd, offset, count);
+    out_context->InvalidateStat();
+    return ret;
+  }
+
+  // At least one of the streams is implemented inside the enclave, so the data
+  // has to be copied through trusted memory.
+  constexpr size_t kMaxChunkSize = 64 * 1024;
+  std::unique_ptr<char[]> buf(new char[std::min(count, kMaxChunkSize)]);
+  size_t total = 0;
+  bool failed = false;
+  while (total < count) {
+    size_t chunk_size = std::min(count - total, kMaxChunkSize);
+    ssize_t bytes_read = offset ? in_context->Pread(buf.get(), chunk_size,
+                                                    *offset + total)
+                                : in_context->Read(buf.get(), chunk_size);
+    if (bytes_read <= 0) {
+      failed = bytes_read < 0;
+      break;
+    }
+    ssize_t written = 0;
+    while (written < bytes_read) {
+      ssize_t ret =
+          out_context->Write(buf.get() + written, bytes_read - written);
+      if (ret <= 0) {
+        failed = ret < 0;
+        break;
+      }
+      written += ret;
+      total += ret;
+    }
+    // A write that makes no progress ends the transfer like a short write.
+    if (written < bytes_read) {
+      break;
+    }
+  }
+  if (offset) {
+    *offset += total;
+  }
+  if (failed && total == 0) {
+    return -1;
+  }
+  return total;
+}
+
 mode_t IOManager::Umask(mode_t mask) { return enc_untrusted_umask(mask); }
 
 int IOManager::GetRLimit(int resource, struct rlimit *rlim) {
@@ -717,6 +1134,22 @@ ssize_t IOManager::RecvMsg(int sockfd, struct msghdr *msg, int flags) {
                          });
 }
 
+int IOManager::SendMMsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+                        int flags) {
+  return CallWithContext(
+      sockfd, [msgvec, vlen, flags](std::shared_ptr<IOContext> context) {
+        return context->SendMMsg(msgvec, vlen, flags);
+      });
+}
+
+int IOManager::RecvMMsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+                        int flags, struct timespec *timeout) {
+  return CallWithContext(sockfd, [msgvec, vlen, flags, timeout](
+                                     std::shared_ptr<IOContext> context) {
+    return context->RecvMMsg(msgvec, vlen, flags, timeout);
+  });
+}
+
 int IOManager::GetSockName(int sockfd, struct sockaddr *addr,
                            socklen_t *addrlen) {
   return CallWithContext(sockfd,
@@ -27,6 +27,7 @@
 
 #include <poll.h>
 #include <stdint.h>
+#include <time.h>
 #include <cstdlib>
 #include <functional>
 #include <map>
@@ -34,10 +35,12 @@
 #include <queue>
 #include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "asylo/platform/storage/secure/enclave_storage_secure.h"
 #include "asylo/util/statusor.h"
 
@@ -117,6 +120,26 @@ class IOManager {
       return -1;
     }
 
+    // Implements IOManager::Pread. Must not change the stream's offset.
+    virtual ssize_t Pread(void *buf, size_t count, off_t offset) {
+      errno = ENOSYS;
+      return -1;
+    }
+
+    // Implements IOManager::Pwrite. Must not change the stream's offset.
+    virtual ssize_t Pwrite(const void *buf, size_t count, off_t offset) {
+      errno = ENOSYS;
+      return -1;
+    }
+
+    // Implements IOManager::Preadv. The default implementation calls Pread()
+    // once per buffer.
+    virtual ssize_t Preadv(const struct iovec *iov, int iovcnt, off_t offset);
+
+    // Implements IOManager::Pwritev. The default implementation calls Pwrite()
+    // once per buffer.
+    virtual ssize_t Pwritev(const struct iovec *iov, int iovcnt, off_t offset);
+
     // Implements setsockopt.
     virtual int SetSockOpt(int level, int option_name, const void *option_value,
                            socklen_t option_len) {
@@ -179,6 +202,20 @@ class IOManager {
       return -1;
     }
 
+    // Implements sendmmsg.
+    virtual int SendMMsg(struct mmsghdr *msgvec, unsigned int vlen,
+                         int flags) {
+      errno = ENOSYS;
+      return -1;
+    }
+
+    // Implements recvmmsg.
+    virtual int RecvMMsg(struct mmsghdr *msgvec, unsigned int vlen, int flags,
+                         struct timespec *timeout) {
+      errno = ENOSYS;
+      return -1;
+    }
+
     // Implements getsockname.
     virtual int GetSockName(struct sockaddr *addr, socklen_t *addrlen) {
       errno = ENOSYS;
@@ -191,8 +228,39 @@ class IOManager {
       return -1;
     }
 
+    // Implements timerfd_settime.
+    virtual int TimerSetTime(int flags, const struct itimerspec *new_value,
+                             struct itimerspec *old_value) {
+      errno = EINVAL;
+      return -1;
+    }
+
+    // Implements timerfd_gettime.
+    virtual int TimerGetTime(struct itimerspec *curr_value) {
+      errno = EINVAL;
+      return -1;
+    }
+
+    // Reports the readiness of a stream implemented inside the enclave for
+    // poll(2). Stores the events from |events| the stream is ready for, along
+    // with POLLERR and POLLHUP if applicable, in |revents| and returns true.
+    // Returns false if the readiness of the stream cannot be determined inside
+    // the enclave. Implementations must call
+    // IOManager::NotifyReadinessChanged() whenever the readiness of the stream
+    // may have changed.
+    virtual bool PollReadiness(short events, short *revents) { return false; }
+
+    // Returns the time at which the readiness reported by PollReadiness() may
+    // next change without a call to IOManager::NotifyReadinessChanged(), such
+    // as the expiration of a timer.
+    virtual absl::Time NextReadinessChange() { return absl::InfiniteFuture(); }
+
     virtual int GetHostFileDescriptor() { return -1; }
 
+    // Invalidates any cached metadata of the file backing the stream, after
+    // the host has written to the file through GetHostFileDescriptor().
+    virtual void InvalidateStat() {}
+
    private:
     friend class IOManager;
   };
@@ -252,6 +320,13 @@ class IOManager {
       return -1;
     }
 
+    // Fetches the metadata of the entries of |directory| ahead of calls to
+    // Stat() and LStat(). Returns the number of entries fetched.
+    virtual int PrefetchStats(const char *directory) {
+      errno = ENOSYS;
+      return -1;
+    }
+
    private:
     friend class IOManager;
   };
@@ -318,8 +393,15 @@ class IOManager {
     // |startfd|. Returns -1 if there is no file descriptor available.
     int GetNextFreeFileDescriptor(int startfd);
 
+    // Replaces the entry for |fd| with |context|, keeping |entry_counts_| up
+    // to date.
+    void SetEntry(int fd, std::shared_ptr<IOContext> context);
+
     std::array<std::shared_ptr<IOContext>, kMaxOpenFiles> fd_table_;
 
+    // The number of entries of |fd_table_| that refer to each IOContext.
+    std::unordered_map<const IOContext *, int> entry_counts_;
+
     // The maximum file descriptor number allowed.
     int maximum_fd_soft_limit;
 
@@ -363,6 +445,12 @@ class IOManager {
   // it points to.
   int LStat(const char *pathname, struct stat *stat_buffer);
 
+  // Fetches the metadata of the entries of |directory| in a single operation,
+  // so that subsequent calls to Stat() and LStat() for them do not each have
+  // to leave the enclave. Returns the number of entries fetched, which may be
+  // fewer than the directory contains, or -1 on failure.
+  int PrefetchStats(const char *directory);
+
   // Opens |path|, returning an enclave file descriptor or -1 on failure.
   int Open(const char *path, int flags, mode_t mode);
 
@@ -377,8 +465,28 @@ class IOManager {
 
   // Creates a pipe. The array |pipefd| is used to return two file descriptors
   // referring to the ends of the pipe. |pipefd[0]| refers to the read end while
-  // |pipefd[1]| refers to the write end.
-  int Pipe(int pipefd[2]);
+  // |pipefd[1]| refers to the write end. The pipe is implemented inside the
+  // enclave and its data never leaves trusted memory.
+  int Pipe(int pipefd[2]) LOCKS_EXCLUDED(fd_table_lock_);
+
+  // Creates a pipe on the host, as Pipe() does inside the enclave. Host pipes
+  // are required for file descriptors that must be shared with the host.
+  int HostPipe(int pipefd[2]);
+
+  // Implements eventfd(2). The counter of the descriptor is kept inside the
+  // enclave.
+  int EventFd(unsigned int initval, int flags) LOCKS_EXCLUDED(fd_table_lock_);
+
+  // Implements timerfd_create(2). The timer is driven by the clocks of the
+  // enclave and is polled without a host call.
+  int TimerFdCreate(int clockid, int flags) LOCKS_EXCLUDED(fd_table_lock_);
+
+  // Implements timerfd_settime(2).
+  int TimerFdSetTime(int fd, int flags, const struct itimerspec *new_value,
+                     struct itimerspec *old_value);
+
+  // Implements timerfd_gettime(2).
+  int TimerFdGetTime(int fd, struct itimerspec *curr_value);
 
   // Reads up to |count| bytes from the stream into |buf|, returning the number
   // of bytes read on success or -1 on error.
@@ -412,9 +520,19 @@ class IOManager {
   // Implements unlink(2).
   int Unlink(const char *pathname);
 
-  // Implements poll(2).
+  // Implements poll(2). The readiness of streams implemented inside the
+  // enclave is evaluated without a host call, and only the streams backed by
+  // host file descriptors are polled on the host. If a stream inside the
+  // enclave is already ready, the host file descriptors are polled once
+  // without a timeout and reported alongside it. Descriptors that are not open
+  // are reported with POLLNVAL.
   int Poll(struct pollfd *fds, nfds_t nfds, int timeout)
-      LOCKS_EXCLUDED(fd_table_lock_);
+      LOCKS_EXCLUDED(fd_table_lock_, readiness_mutex_);
+
+  // Wakes up the callers of Poll() waiting for streams implemented inside the
+  // enclave, which re-evaluate the readiness of their streams. Callers waiting
+  // on the host are woken up through a host pipe.
+  void NotifyReadinessChanged() LOCKS_EXCLUDED(readiness_mutex_);
 
   // Implements mkdir(2).
   int Mkdir(const char *pathname, mode_t mode);
@@ -425,6 +543,24 @@ class IOManager {
   // Implements readv(2).
   ssize_t Readv(int fd, const struct iovec *iov, int iovcnt);
 
+  // Implements pread(2).
+  ssize_t Pread(int fd, void *buf, size_t count, off_t offset);
+
+  // Implements pwrite(2).
+  ssize_t Pwrite(int fd, const void *buf, size_t count, off_t offset);
+
+  // Implements preadv(2).
+  ssize_t Preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
+  // Implements pwritev(2).
+  ssize_t Pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset);
+
+  // Implements sendfile(2). If both file descriptors are backed by host file
+  // descriptors, the data is transferred by the host without being copied into
+  // the enclave. Otherwise, it is copied through an enclave buffer.
+  ssize_t SendFile(int out_fd, int in_fd, off_t *offset, size_t count)
+      LOCKS_EXCLUDED(fd_table_lock_);
+
   // Implements umask(2).
   mode_t Umask(mode_t mask);
 
@@ -468,6 +604,14 @@ class IOManager {
   // Implements recvmsg(2).
   ssize_t RecvMsg(int sockfd, struct msghdr *msg, int flags);
 
+  // Implements sendmmsg(2).
+  int SendMMsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+               int flags);
+
+  // Implements recvmmsg(2).
+  int RecvMMsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+               int flags, struct timespec *timeout);
+
   // Implements getsockname(2).
   int GetSockName(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
 
@@ -508,12 +652,38 @@ class IOManager {
   // relative paths and path normalization.
   StatusOr<std::string> CanonicalizePath(absl::string_view path) const;
 
+  // The size of the buffers paths are canonicalized into, which matches
+  // PATH_MAX on Linux. Longer paths are rejected with ENAMETOOLONG.
+  static constexpr size_t kPathBufferSize = 4096;
+
+  // Canonicalizes |path| as above into |buffer|, which holds kPathBufferSize
+  // bytes, without allocating memory. On success, stores the handler for the
+  // canonical path in |handler|, or nullptr if no handler matches it.
+  Status CanonicalizePath(absl::string_view path, char *buffer,
+                          VirtualPathHandler **handler) const;
+
   // Closes a file descriptor by removing it from |fd_table_|, and closing the
   // corresponding host file descriptor if this is the last reference to it.
   // This method does not obtain a locker. Caller of this method is responsible
   // for obtaining |fd_table_lock_|.
   int CloseFileDescriptor(int fd) EXCLUSIVE_LOCKS_REQUIRED(fd_table_lock_);
 
+  // Waits until NotifyReadinessChanged() has been called since
+  // |readiness_generation_| had the value |generation|, or until |deadline|.
+  void WaitForReadinessChange(uint64_t generation, absl::Time deadline)
+      LOCKS_EXCLUDED(readiness_mutex_);
+
+  // Registers a host poll that waits together with streams implemented inside
+  // the enclave. Returns false if NotifyReadinessChanged() has been called
+  // since |readiness_generation_| had the value |generation|. Otherwise stores
+  // in |doorbell| a host file descriptor that becomes readable on the next
+  // call to NotifyReadinessChanged(), or -1 if no doorbell is available.
+  bool BeginHostPoll(uint64_t generation, int *doorbell)
+      LOCKS_EXCLUDED(readiness_mutex_);
+
+  // Unregisters a host poll registered by BeginHostPoll().
+  void EndHostPoll() LOCKS_EXCLUDED(readiness_mutex_);
+
   // Fetches the VirtualFileHandler associated with a given path, or
   // nullptr if no entry is found.
   VirtualPathHandler *HandlerForPath(absl::string_view path) const;
@@ -539,14 +709,35 @@ class IOManager {
                                    const char *)>::type
   CallWithHandler(const char *path1, const char *path2, IOAction action);
 
-  // A map from path prefix to VirtualPathHandler.
-  std::map<std::string, std::unique_ptr<VirtualPathHandler>> prefix_to_handler_;
+  // A VirtualPathHandler and the path prefix it is registered for.
+  struct PathHandlerEntry {
+    std::string prefix;
+    std::unique_ptr<VirtualPathHandler> handler;
+  };
+
+  // The registered handlers, ordered by decreasing length of their prefixes so
+  // that the first entry matching a path has the longest matching prefix.
+  std::vector<PathHandlerEntry> path_handlers_;
 
   FileDescriptorTable fd_table_;
 
   // A mutex that locks the fd_table_.
   absl::Mutex fd_table_lock_;
 
+  // Incremented by NotifyReadinessChanged(), and signaled through
+  // |readiness_changed_|.
+  absl::Mutex readiness_mutex_;
+  absl::CondVar readiness_changed_;
+  uint64_t readiness_generation_ GUARDED_BY(readiness_mutex_) = 0;
+
+  // A host pipe that NotifyReadinessChanged() writes to while host polls are
+  // in flight, so that they return without waiting for their timeout. It is
+  // created by the first host poll that needs it.
+  bool doorbell_created_ GUARDED_BY(readiness_mutex_) = false;
+  int doorbell_fds_[2] GUARDED_BY(readiness_mutex_) = {-1, -1};
+  bool doorbell_rung_ GUARDED_BY(readiness_mutex_) = false;
+  int host_polls_in_flight_ GUARDED_BY(readiness_mutex_) = 0;
+
   std::string current_working_directory_;
 };
 
@@ -18,22 +18,80 @@
 
 #include "asylo/platform/posix/io/native_paths.h"
 
+#include <errno.h>
 #include <fcntl.h>
+#include <string.h>
+#include <vector>
 
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
 #include "asylo/platform/arch/include/trusted/host_calls.h"
+#include "asylo/platform/arch/include/trusted/untrusted_staging.h"
 #include "asylo/platform/posix/io/secure_paths.h"
+#include "asylo/platform/posix/io/stat_cache.h"
 
 namespace asylo {
 namespace io {
+namespace {
+
+// The maximum number of directory entries fetched by a single prefetch.
+constexpr int kMaxPrefetchedEntries = 128;
+
+// The size of the buffer receiving the names of prefetched directory entries.
+constexpr size_t kPrefetchedNamesSize = 8192;
+
+// Implements stat(), if |follow_links| is true, or lstat() of |path| on the
+// host, consulting the native stat cache first.
+int CachedStat(const char *path, bool follow_links, struct stat *stat_buffer) {
+  StatCache *cache = GetNativeStatCache();
+  if (!cache->enabled()) {
+    return follow_links ? enc_untrusted_stat(path, stat_buffer)
+                        : enc_untrusted_lstat(path, stat_buffer);
+  }
+
+  absl::Time now = absl::Now();
+  uint64_t generation = cache->generation();
+  int error;
+  if (cache->Lookup(path, follow_links, now, stat_buffer, &error)) {
+    if (error != 0) {
+      errno = error;
+      return -1;
+    }
+    return 0;
+  }
+
+  int result = follow_links ? enc_untrusted_stat(path, stat_buffer)
+                            : enc_untrusted_lstat(path, stat_buffer);
+  error = result == 0 ? 0 : errno;
+  cache->Insert(path, follow_links, result == 0 ? stat_buffer : nullptr, error,
+                now, generation);
+  errno = error;
+  return result;
+}
+
+// Invalidates the cached metadata of |path| and of its parent directory.
+void InvalidateCachedStat(const char *path) {
+  GetNativeStatCache()->Invalidate(path);
+}
+
+}  // namespace
+
+void IOContextNative::InvalidateStat() {
+  if (!path_.empty()) {
+    GetNativeStatCache()->Invalidate(path_);
+  }
+}
 
 int IOContextNative::Close() { return enc_untrusted_close(host_fd_); }
 
 ssize_t IOContextNative::Read(void *buf, size_t count) {
-  return enc_untrusted_read(host_fd_, buf, count);
+  return StagedRead(host_fd_, buf, count);
 }
 
 ssize_t IOContextNative::Write(const void *buf, size_t count) {
-  return enc_untrusted_write(host_fd_, buf, count);
+  ssize_t result = StagedWrite(host_fd_, buf, count);
+  InvalidateStat();
+  return result;
 }
 
 int IOContextNative::LSeek(off_t offset, int whence) {
@@ -53,13 +111,37 @@ int IOContextNative::FStat(struct stat *stat_buffer) {
 int IOContextNative::Isatty() { return enc_untrusted_isatty(host_fd_); }
 
 ssize_t IOContextNative::Writev(const struct iovec *iov, int iovcnt) {
-  return enc_untrusted_writev(host_fd_, iov, iovcnt);
+  ssize_t result = enc_untrusted_writev(host_fd_, iov, iovcnt);
+  InvalidateStat();
+  return result;
 }
 
 ssize_t IOContextNative::Readv(const struct iovec *iov, int iovcnt) {
   return enc_untrusted_readv(host_fd_, iov, iovcnt);
 }
 
+ssize_t IOContextNative::Pread(void *buf, size_t count, off_t offset) {
+  return enc_untrusted_pread(host_fd_, buf, count, offset);
+}
+
+ssize_t IOContextNative::Pwrite(const void *buf, size_t count, off_t offset) {
+  ssize_t result = enc_untrusted_pwrite(host_fd_, buf, count, offset);
+  InvalidateStat();
+  return result;
+}
+
+ssize_t IOContextNative::Preadv(const struct iovec *iov, int iovcnt,
+                                off_t offset) {
+  return enc_untrusted_preadv(host_fd_, iov, iovcnt, offset);
+}
+
+ssize_t IOContextNative::Pwritev(const struct iovec *iov, int iovcnt,
+                                 off_t offset) {
+  ssize_t result = enc_untrusted_pwritev(host_fd_, iov, iovcnt, offset);
+  InvalidateStat();
+  return result;
+}
+
 int IOContextNative::SetSockOpt(int level, int option_name,
                                 const void *option_value,
                                 socklen_t option_len) {
@@ -76,7 +158,7 @@ int IOContextNative::Shutdown(int how) {
 }
 
 ssize_t IOContextNative::Send(const void *buf, size_t len, int flags) {
-  return enc_untrusted_send(host_fd_, buf, len, flags);
+  return StagedSend(host_fd_, buf, len, flags);
 }
 
 int IOContextNative::GetSockOpt(int level, int optname, void *optval,
@@ -104,6 +186,16 @@ ssize_t IOContextNative::RecvMsg(struct msghdr *msg, int flags) {
   return enc_untrusted_recvmsg(host_fd_, msg, flags);
 }
 
+int IOContextNative::SendMMsg(struct mmsghdr *msgvec, unsigned int vlen,
+                              int flags) {
+  return enc_untrusted_sendmmsg(host_fd_, msgvec, vlen, flags);
+}
+
+int IOContextNative::RecvMMsg(struct mmsghdr *msgvec, unsigned int vlen,
+                              int flags, struct timespec *timeout) {
+  return enc_untrusted_recvmmsg(host_fd_, msgvec, vlen, flags, timeout);
+}
+
 int IOContextNative::GetSockName(struct sockaddr *addr, socklen_t *addrlen) {
   return enc_untrusted_getsockname(host_fd_, addr, addrlen);
 }
@@ -117,28 +209,50 @@ int IOContextNative::GetHostFileDescriptor() { return host_fd_; }
 std::unique_ptr<IOManager::IOContext> NativePathHandler::Open(const char *path,
                                                               int flags,
                                                               mode_t mode) {
+  // Opening a file may create or truncate it, and a file opened for writing
+  // keeps changing until it is closed.
+  bool writable = (flags & O_ACCMODE) != O_RDONLY || (flags & O_TRUNC);
+  bool modifies = writable || (flags & O_CREAT);
+
   if (flags & O_SECURE) {
-    return IOContextSecure::Create(path, flags, mode);
+    auto context = IOContextSecure::Create(path, flags, mode);
+    if (modifies) {
+      InvalidateCachedStat(path);
+    }
+    return context;
   }
 
   int host_fd = enc_untrusted_open(path, flags, mode);
+  if (modifies) {
+    InvalidateCachedStat(path);
+  }
   if (host_fd < 0) {
     return nullptr;
   }
 
+  if (writable && GetNativeStatCache()->enabled()) {
+    return ::absl::make_unique<IOContextNative>(host_fd, path);
+  }
   return ::absl::make_unique<IOContextNative>(host_fd);
 }
 
 int NativePathHandler::Chown(const char *path, uid_t owner, gid_t group) {
-  return enc_untrusted_chown(path, owner, group);
+  int result = enc_untrusted_chown(path, owner, group);
+  InvalidateCachedStat(path);
+  return result;
 }
 
 int NativePathHandler::Link(const char *existing, const char *new_link) {
-  return enc_untrusted_link(existing, new_link);
+  int result = enc_untrusted_link(existing, new_link);
+  InvalidateCachedStat(existing);
+  InvalidateCachedStat(new_link);
+  return result;
 }
 
 int NativePathHandler::Unlink(const char *pathname) {
-  return enc_untrusted_unlink(pathname);
+  int result = enc_untrusted_unlink(pathname);
+  InvalidateCachedStat(pathname);
+  return result;
 }
 
 ssize_t NativePathHandler::ReadLink(const char *path_name, char *buf,
@@ -147,24 +261,76 @@ ssize_t NativePathHandler::ReadLink(const char *path_name, char *buf,
 }
 
 int NativePathHandler::SymLink(const char *path1, const char *path2) {
-  return enc_untrusted_symlink(path1, path2);
+  int result = enc_untrusted_symlink(path1, path2);
+  InvalidateCachedStat(path2);
+  return result;
 }
 
 int NativePathHandler::Stat(const char *pathname, struct stat *stat_buffer) {
-  return enc_untrusted_stat(pathname, stat_buffer);
+  return CachedStat(pathname, /*follow_links=*/true, stat_buffer);
 }
 
 int NativePathHandler::LStat(const char *pathname, struct stat *stat_buffer) {
-  return enc_untrusted_lstat(pathname, stat_buffer);
+  return CachedStat(pathname, /*follow_links=*/false, stat_buffer);
 }
 
 int NativePathHandler::Mkdir(const char *path, mode_t mode) {
-  return enc_untrusted_mkdir(path, mode);
+  int result = enc_untrusted_mkdir(path, mode);
+  InvalidateCachedStat(path);
+  return result;
 }
 
 int NativePathHandler::Access(const char *path, int mode) {
   return enc_untrusted_access(path, mode);
 }
 
+int NativePathHandler::PrefetchStats(const char *directory) {
+  StatCache *cache = GetNativeStatCache();
+  if (!cache->enabled()) {
+    return 0;
+  }
+
+  absl::Time now = absl::Now();
+  uint64_t generation = cache->generation();
+  std::vector<struct stat> stat_buffers(kMaxPrefetchedEntries);
+  std::vector<char> names(kPrefetchedNamesSize);
+  int count =
+      enc_untrusted_stat_directory(directory, stat_buffers.data(), names.data(),
+                                   names.size(), kMaxPrefetchedEntries);
+  if (count < 0) {
+    return -1;
+  }
+  cache->RecordPrefetch();
+
+  std::string path = directory;
+  if (path.empty() || path.back() != '/') {
+    path.push_back('/');
+  }
+  size_t prefix_size = path.size();
+
+  // The names are provided by the host, so each one is checked to be
+  // terminated within the buffer and to name an entry of |directory|.
+  const char *name = names.data();
+  const char *names_end = names.data() + names.size();
+  for (int i = 0; i < count; ++i) {
+    const char *terminator = static_cast<const char *>(
+        memchr(name, '\0', names_end - name));
+    if (!terminator) {
+      break;
+    }
+    absl::string_view entry(name, terminator - name);
+    name = terminator + 1;
+    if (entry.empty() || entry == "." || entry == ".." ||
+        entry.find('/') != absl::string_view::npos) {
+      continue;
+    }
+    path.resize(prefix_size);
+    path.append(entry.data(), entry.size());
+    cache->Insert(path, /*follow_links=*/true, &stat_buffers[i], /*error=*/0,
+                  now, generation);
+  }
+  return count;
+}
+
 }  // namespace io
 }  // namespace asylo
@@ -19,6 +19,9 @@
 #ifndef ASYLO_PLATFORM_POSIX_IO_NATIVE_PATHS_H_
 #define ASYLO_PLATFORM_POSIX_IO_NATIVE_PATHS_H_
 
+#include <string>
+#include <utility>
+
 #include "asylo/platform/posix/io/io_manager.h"
 
 namespace asylo {
@@ -29,6 +32,12 @@ namespace io {
 class IOContextNative : public IOManager::IOContext {
  public:
   explicit IOContextNative(int host_fd) : host_fd_(host_fd) {}
+
+  // Creates a context for a file opened for writing at |path|, whose cached
+  // metadata is invalidated whenever the file is written.
+  IOContextNative(int host_fd, std::string path)
+      : host_fd_(host_fd), path_(std::move(path)) {}
+
   ssize_t Read(void *buf, size_t count) override;
   ssize_t Write(const void *buf, size_t count) override;
   int LSeek(off_t offset, int whence) override;
@@ -39,6 +48,10 @@ class IOContextNative : public IOManager::IOContext {
   int Close() override;
   ssize_t Writev(const struct iovec *iov, int iovcnt) override;
   ssize_t Readv(const struct iovec *iov, int iovcnt) override;
+  ssize_t Pread(void *buf, size_t count, off_t offset) override;
+  ssize_t Pwrite(const void *buf, size_t count, off_t offset) override;
+  ssize_t Preadv(const struct iovec *iov, int iovcnt, off_t offset) override;
+  ssize_t Pwritev(const struct iovec *iov, int iovcnt, off_t offset) override;
   int SetSockOpt(int level, int option_name, const void *option_value,
                  socklen_t option_len) override;
   int Connect(const struct sockaddr *addr, socklen_t addrlen) override;
@@ -51,13 +64,23 @@ class IOContextNative : public IOManager::IOContext {
   int Listen(int backlog) override;
   ssize_t SendMsg(const struct msghdr *msg, int flags) override;
   ssize_t RecvMsg(struct msghdr *msg, int flags) override;
+  int SendMMsg(struct mmsghdr *msgvec, unsigned int vlen, int flags) override;
+  int RecvMMsg(struct mmsghdr *msgvec, unsigned int vlen, int flags,
+               struct timespec *timeout) override;
   int GetSockName(struct sockaddr *addr, socklen_t *addrlen) override;
   int GetPeerName(struct sockaddr *addr, socklen_t *addrlen) override;
   int GetHostFileDescriptor() override;
 
+  // Invalidates the cached metadata of the file, if it was opened by path for
+  // writing.
+  void InvalidateStat() override;
+
  private:
   // Host file descriptor implementing this stream.
   int host_fd_;
+
+  // Path at which the file was opened for writing, or empty.
+  std::string path_;
 };
 
 // VirtualPathHandler implementation handling paths to be forwarded to the host.
@@ -75,6 +98,7 @@ class NativePathHandler : public io::IOManager::VirtualPathHandler {
   int LStat(const char *pathname, struct stat *stat_buffer) override;
   int Mkdir(const char *path, mode_t mode) override;
   int Access(const char *path, int mode) override;
+  int PrefetchStats(const char *directory) override;
 };
 
 }  // namespace io
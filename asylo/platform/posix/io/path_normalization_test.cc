@@ -59,6 +59,16 @@ TEST_P(PathNormalizationTest, HasExpectedResult) {
   EXPECT_EQ(NormalizePath(params.first), params.second);
 }
 
+// Verifies that normalizing into a buffer yields the same result.
+TEST_P(PathNormalizationTest, BufferHasExpectedResult) {
+  PathParams::value_type params = GetParam();
+  char buffer[64];
+  size_t length = NormalizePath(/*base=*/"", params.first, buffer,
+                                sizeof(buffer));
+  EXPECT_EQ(absl::string_view(buffer, length), params.second);
+  EXPECT_EQ(buffer[length], '\0');
+}
+
 // Returns a mapping of inputs to outputs to be verified.
 PathParams GetTestPathParams() {
   return {
@@ -104,6 +114,27 @@ INSTANTIATE_TEST_CASE_P(PathList, PathNormalizationTest,
                         ::testing::ValuesIn(GetTestPathParams()),
                         PathParamsValueToTestName);
 
+// Tests that a path is resolved relative to the base directory, and that ".."
+// in the path may back up through the base directory.
+TEST(NormalizePathTest, ResolvesRelativeToBase) {
+  char buffer[64];
+  size_t length = NormalizePath("/foo/bar", "baz", buffer, sizeof(buffer));
+  EXPECT_EQ(absl::string_view(buffer, length), "/foo/bar/baz");
+  length = NormalizePath("/foo/bar", "../../baz/.", buffer, sizeof(buffer));
+  EXPECT_EQ(absl::string_view(buffer, length), "/baz");
+  length = NormalizePath("/foo/", "../..", buffer, sizeof(buffer));
+  EXPECT_EQ(absl::string_view(buffer, length), "/");
+}
+
+// Tests that a path which does not fit in the buffer with its terminating NUL
+// is rejected.
+TEST(NormalizePathTest, RejectsSmallBuffer) {
+  char buffer[8];
+  EXPECT_EQ(NormalizePath("", "/foo/bar", buffer, sizeof(buffer)), 0);
+  EXPECT_EQ(NormalizePath("", "/foo/ba", buffer, sizeof(buffer)), 7);
+  EXPECT_EQ(NormalizePath("", "/", buffer, 1), 0);
+}
+
 }  // namespace
 }  // namespace util
 }  // namespace io
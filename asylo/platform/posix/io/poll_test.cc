@@ -0,0 +1,144 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <thread>
+
+#include <gtest/gtest.h>
+#include "asylo/platform/posix/io/io_manager.h"
+
+namespace asylo {
+namespace {
+
+// Tests that descriptors that are not open are reported as invalid, and that
+// negative descriptors are ignored.
+TEST(PollTest, InvalidFileDescriptors) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  int closed_fd = dup(fds[0]);
+  ASSERT_GE(closed_fd, 0);
+  ASSERT_EQ(close(closed_fd), 0);
+
+  struct pollfd pfds[3] = {
+      {closed_fd, POLLIN, 0}, {-1, POLLIN, 0}, {fds[0], POLLIN, 0}};
+  ASSERT_EQ(poll(pfds, 3, -1), 1);
+  EXPECT_EQ(pfds[0].revents, POLLNVAL);
+  EXPECT_EQ(pfds[1].revents, 0);
+  EXPECT_EQ(pfds[2].revents, 0);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+// Tests that the random devices, which are implemented inside the enclave, are
+// always readable.
+TEST(PollTest, RandomDeviceIsReadable) {
+  int fd = open("/dev/urandom", O_RDONLY);
+  ASSERT_GE(fd, 0);
+  struct pollfd pfd = {fd, POLLIN | POLLOUT, 0};
+  ASSERT_EQ(poll(&pfd, 1, -1), 1);
+  EXPECT_EQ(pfd.revents, POLLIN);
+  close(fd);
+}
+
+// Tests that host file descriptors are reported together with streams inside
+// the enclave that are ready, rather than only once no such stream is ready.
+TEST(PollTest, TrustedReadinessDoesNotStarveHostFileDescriptors) {
+  int trusted_fds[2];
+  int host_fds[2];
+  ASSERT_EQ(pipe(trusted_fds), 0);
+  ASSERT_EQ(io::IOManager::GetInstance().HostPipe(host_fds), 0);
+
+  char c = 'a';
+  ASSERT_EQ(write(host_fds[1], &c, 1), 1);
+  struct pollfd pfds[2] = {{trusted_fds[0], POLLIN, 0},
+                           {host_fds[0], POLLIN, 0}};
+  ASSERT_EQ(poll(pfds, 2, 0), 1);
+  EXPECT_EQ(pfds[0].revents, 0);
+  EXPECT_EQ(pfds[1].revents, POLLIN);
+
+  // Once the pipe inside the enclave is ready, both are reported.
+  ASSERT_EQ(write(trusted_fds[1], &c, 1), 1);
+  ASSERT_EQ(poll(pfds, 2, 0), 2);
+  EXPECT_EQ(pfds[0].revents, POLLIN);
+  EXPECT_EQ(pfds[1].revents, POLLIN);
+
+  // A ready stream inside the enclave is reported alone once the host file
+  // descriptor is drained.
+  ASSERT_EQ(read(host_fds[0], &c, 1), 1);
+  ASSERT_EQ(poll(pfds, 2, 0), 1);
+  EXPECT_EQ(pfds[0].revents, POLLIN);
+  EXPECT_EQ(pfds[1].revents, 0);
+
+  for (int fd : {trusted_fds[0], trusted_fds[1], host_fds[0], host_fds[1]}) {
+    close(fd);
+  }
+}
+
+// Tests that a poll waiting on the host together with a stream inside the
+// enclave is woken up when the stream becomes ready, and that a dup'ed host
+// file descriptor stays open until its last copy is closed.
+TEST(PollTest, TrustedReadinessWakesHostPoll) {
+  int trusted_fds[2];
+  int host_fds[2];
+  ASSERT_EQ(pipe(trusted_fds), 0);
+  ASSERT_EQ(io::IOManager::GetInstance().HostPipe(host_fds), 0);
+
+  struct pollfd pfds[2] = {{trusted_fds[0], POLLIN, 0},
+                           {host_fds[0], POLLIN, 0}};
+  std::thread writer([&trusted_fds] {
+    char c = 'a';
+    write(trusted_fds[1], &c, 1);
+  });
+  ASSERT_EQ(poll(pfds, 2, -1), 1);
+  EXPECT_EQ(pfds[0].revents, POLLIN);
+  EXPECT_EQ(pfds[1].revents, 0);
+  writer.join();
+
+  // Once the stream is drained, the doorbell no longer wakes the host poll.
+  char c;
+  ASSERT_EQ(read(trusted_fds[0], &c, 1), 1);
+  EXPECT_EQ(poll(pfds, 2, 10), 0);
+
+  int write_fd = dup(host_fds[1]);
+  ASSERT_GE(write_fd, 0);
+  ASSERT_EQ(close(host_fds[1]), 0);
+  ASSERT_EQ(write(write_fd, &c, 1), 1);
+  ASSERT_EQ(poll(pfds, 2, -1), 1);
+  EXPECT_EQ(pfds[1].revents, POLLIN);
+
+  for (int fd : {trusted_fds[0], trusted_fds[1], host_fds[0], write_fd}) {
+    close(fd);
+  }
+}
+
+// Tests that a poll of host file descriptors alone still times out on the host.
+TEST(PollTest, HostTimeout) {
+  int host_fds[2];
+  ASSERT_EQ(io::IOManager::GetInstance().HostPipe(host_fds), 0);
+  struct pollfd pfd = {host_fds[0], POLLIN, 0};
+  EXPECT_EQ(poll(&pfd, 1, 10), 0);
+  EXPECT_EQ(pfd.revents, 0);
+  close(host_fds[0]);
+  close(host_fds[1]);
+}
+
+}  // namespace
+}  // namespace asylo
@@ -20,6 +20,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <string.h>
 #include <sys/sysmacros.h>
 
@@ -92,6 +93,12 @@ int RandomIOContext::Isatty() {
   return 0;
 }
 
+bool RandomIOContext::PollReadiness(short events, short *revents) {
+  // Random data can always be read without blocking.
+  *revents = events & (POLLIN | POLLRDNORM);
+  return true;
+}
+
 std::unique_ptr<io::IOManager::IOContext> RandomPathHandler::Open(
     const char *path, int flags, mode_t mode) {
   bool is_random = strcmp(path, kRandomPath) == 0;
@@ -19,12 +19,14 @@
 #include "asylo/platform/posix/io/secure_paths.h"
 
 #include <errno.h>
+#include <poll.h>
 #include <stdint.h>
 #include <sys/ioctl.h>
 
 #include "asylo/platform/arch/include/trusted/host_calls.h"
 #include "asylo/platform/crypto/gcmlib/gcm_cryptor.h"
 #include "asylo/platform/posix/io/io_manager.h"
+#include "asylo/platform/posix/io/stat_cache.h"
 #include "asylo/platform/storage/secure/aead_handler.h"
 #include "asylo/platform/storage/secure/enclave_storage_secure.h"
 
@@ -43,13 +45,26 @@ ssize_t IOContextSecure::Read(void *buf, size_t count) {
 }
 
 ssize_t IOContextSecure::Write(const void *buf, size_t count) {
-  return platform::storage::secure_write(host_fd_, buf, count);
+  ssize_t result = platform::storage::secure_write(host_fd_, buf, count);
+  InvalidateStat();
+  return result;
 }
 
 int IOContextSecure::LSeek(off_t offset, int whence) {
   return platform::storage::secure_lseek(host_fd_, offset, whence);
 }
 
+ssize_t IOContextSecure::Pread(void *buf, size_t count, off_t offset) {
+  return platform::storage::secure_pread(host_fd_, buf, count, offset);
+}
+
+ssize_t IOContextSecure::Pwrite(const void *buf, size_t count, off_t offset) {
+  ssize_t result =
+      platform::storage::secure_pwrite(host_fd_, buf, count, offset);
+  InvalidateStat();
+  return result;
+}
+
 int IOContextSecure::FSync() { return enc_untrusted_fsync(host_fd_); }
 
 int IOContextSecure::FStat(struct stat *st) {
@@ -58,6 +73,16 @@ int IOContextSecure::FStat(struct stat *st) {
 
 int IOContextSecure::Isatty() { return enc_untrusted_isatty(host_fd_); }
 
+bool IOContextSecure::PollReadiness(short events, short *revents) {
+  // As for regular files on the host, reads and writes never block.
+  *revents = events & (POLLIN | POLLRDNORM | POLLOUT | POLLWRNORM);
+  return true;
+}
+
+void IOContextSecure::InvalidateStat() {
+  GetNativeStatCache()->Invalidate(path_);
+}
+
 int IOContextSecure::Ioctl(int request, void *argp) {
   switch (request) {
     case ENCLAVE_STORAGE_SET_KEY: {
@@ -19,6 +19,9 @@
 #ifndef ASYLO_PLATFORM_POSIX_IO_SECURE_PATHS_H_
 #define ASYLO_PLATFORM_POSIX_IO_SECURE_PATHS_H_
 
+#include <string>
+#include <utility>
+
 #include "asylo/platform/posix/io/io_manager.h"
 
 namespace asylo {
@@ -27,11 +30,13 @@ namespace io {
 // IOContext implementation wrapping a stream managed by the secure I/O layer.
 class IOContextSecure : public IOManager::IOContext {
  public:
-  // Factory method to create an instance of the class.
+  // Factory method to create an instance of the class. The cached metadata of
+  // the backing store at |path| is invalidated whenever it is written.
   static std::unique_ptr<IOManager::IOContext> Create(const char *path,
                                                       int flags, mode_t mode) {
     int host_fd = platform::storage::secure_open(path, flags, mode);
-    return std::unique_ptr<IOManager::IOContext>(new IOContextSecure(host_fd));
+    return std::unique_ptr<IOManager::IOContext>(
+        new IOContextSecure(host_fd, path));
   }
 
  protected:
@@ -39,16 +44,26 @@ class IOContextSecure : public IOManager::IOContext {
   ssize_t Write(const void *buf, size_t count) override;
   int Close() override;
   int LSeek(off_t offset, int whence) override;
+  ssize_t Pread(void *buf, size_t count, off_t offset) override;
+  ssize_t Pwrite(const void *buf, size_t count, off_t offset) override;
   int FSync() override;
   int FStat(struct stat *st) override;
   int Isatty() override;
   int Ioctl(int request, void *argp) override;
+  bool PollReadiness(short events, short *revents) override;
 
  private:
-  explicit IOContextSecure(int host_fd) : host_fd_(host_fd) {}
+  IOContextSecure(int host_fd, std::string path)
+      : host_fd_(host_fd), path_(std::move(path)) {}
+
+  // Invalidates the cached metadata of the backing store.
+  void InvalidateStat();
 
   // Host-provided file descriptor of the backing store.
   int host_fd_;
+
+  // Path of the backing store.
+  std::string path_;
 };
 
 }  // namespace io
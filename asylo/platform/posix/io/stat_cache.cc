@@ -0,0 +1,171 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/posix/io/stat_cache.h"
+
+#include <errno.h>
+#include <iterator>
+#include <utility>
+
+namespace asylo {
+namespace io {
+namespace {
+
+// The number of results cached for paths handled by NativePathHandler.
+constexpr size_t kNativeStatCacheSize = 4096;
+
+// Returns the cache key of stat() or lstat() of |path|.
+std::string MakeKey(absl::string_view path, bool follow_links) {
+  std::string key(1, follow_links ? 'S' : 'L');
+  key.append(path.data(), path.size());
+  return key;
+}
+
+// Returns the parent directory of the absolute path |path|, or an empty string
+// if |path| has no parent.
+absl::string_view ParentDirectory(absl::string_view path) {
+  size_t slash = path.rfind('/');
+  if (slash == absl::string_view::npos || path.size() <= 1) {
+    return absl::string_view();
+  }
+  return slash == 0 ? path.substr(0, 1) : path.substr(0, slash);
+}
+
+}  // namespace
+
+StatCache::StatCache(size_t max_entries)
+    : max_entries_(max_entries),
+      ttl_nanoseconds_(0),
+      generation_(0),
+      hits_(0),
+      misses_(0),
+      prefetches_(0) {}
+
+void StatCache::set_ttl(absl::Duration ttl) {
+  int64_t nanoseconds =
+      ttl > absl::ZeroDuration() ? absl::ToInt64Nanoseconds(ttl) : 0;
+  ttl_nanoseconds_.store(nanoseconds, std::memory_order_relaxed);
+  if (nanoseconds == 0) {
+    Clear();
+  }
+}
+
+bool StatCache::Lookup(absl::string_view path, bool follow_links,
+                       absl::Time now, struct stat *stat_buffer, int *error) {
+  if (!enabled()) {
+    return false;
+  }
+  std::string key = MakeKey(path, follow_links);
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (now >= it->second->expiration) {
+    Erase(key);
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  *error = it->second->error;
+  if (*error == 0) {
+    *stat_buffer = it->second->stat_buffer;
+  }
+  return true;
+}
+
+void StatCache::Insert(absl::string_view path, bool follow_links,
+                       const struct stat *stat_buffer, int error,
+                       absl::Time now, uint64_t generation) {
+  int64_t ttl_nanoseconds = ttl_nanoseconds_.load(std::memory_order_relaxed);
+  if (ttl_nanoseconds == 0 || max_entries_ == 0) {
+    return;
+  }
+  // Only a missing file is worth remembering as a failure; other errors such
+  // as EACCES or EIO are rare and may be transient.
+  if ((error == 0 && !stat_buffer) || (error != 0 && error != ENOENT)) {
+    return;
+  }
+  Entry entry;
+  entry.key = MakeKey(path, follow_links);
+  if (error == 0) {
+    entry.stat_buffer = *stat_buffer;
+  }
+  entry.error = error;
+  entry.expiration = now + absl::Nanoseconds(ttl_nanoseconds);
+
+  absl::MutexLock lock(&mu_);
+  if (generation_.load(std::memory_order_relaxed) != generation) {
+    return;
+  }
+  Erase(entry.key);
+  while (entries_.size() >= max_entries_) {
+    Erase(entries_.back().key);
+  }
+  entries_.push_front(std::move(entry));
+  index_.emplace(entries_.front().key, entries_.begin());
+}
+
+void StatCache::Invalidate(absl::string_view path) {
+  if (!enabled()) {
+    return;
+  }
+  absl::string_view parent = ParentDirectory(path);
+  absl::MutexLock lock(&mu_);
+  generation_.fetch_add(1, std::memory_order_release);
+  if (entries_.empty()) {
+    return;
+  }
+  Erase(MakeKey(path, /*follow_links=*/true));
+  Erase(MakeKey(path, /*follow_links=*/false));
+  if (!parent.empty()) {
+    Erase(MakeKey(parent, /*follow_links=*/true));
+    Erase(MakeKey(parent, /*follow_links=*/false));
+  }
+}
+
+void StatCache::Clear() {
+  absl::MutexLock lock(&mu_);
+  generation_.fetch_add(1, std::memory_order_release);
+  index_.clear();
+  entries_.clear();
+}
+
+size_t StatCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+void StatCache::Erase(const std::string &key) {
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return;
+  }
+  entries_.erase(it->second);
+  index_.erase(it);
+}
+
+StatCache *GetNativeStatCache() {
+  static StatCache *cache = new StatCache(kNativeStatCacheSize);
+  return cache;
+}
+
+}  // namespace io
+}  // namespace asylo
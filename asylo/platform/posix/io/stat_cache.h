@@ -0,0 +1,162 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_POSIX_IO_STAT_CACHE_H_
+#define ASYLO_PLATFORM_POSIX_IO_STAT_CACHE_H_
+
+#include <sys/stat.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace asylo {
+namespace io {
+
+// A cache of the results of stat() and lstat() on paths forwarded to the host.
+// Each of these calls requires a host call, and programs such as build tools
+// stat the same files many times.
+//
+// The host may change a file at any time without the enclave noticing, so the
+// cache is disabled until a time-to-live is set, and entries expire once it has
+// passed. Changes made from inside the enclave invalidate the affected entries
+// immediately. Failures with ENOENT are cached as well, since probing for files
+// which do not exist is common. When the cache is full, the least recently used
+// entry is evicted.
+//
+// A result fetched from the host may be stale by the time it is inserted, if
+// an invalidation ran while the host call was in flight. Callers therefore
+// sample generation() before the host call, and Insert() drops the result if
+// any invalidation happened since.
+class StatCache {
+ public:
+  // Creates a disabled cache holding at most |max_entries| results.
+  explicit StatCache(size_t max_entries);
+
+  StatCache(const StatCache &) = delete;
+  StatCache &operator=(const StatCache &) = delete;
+
+  // Sets the time for which results are cached. A zero |ttl| disables the
+  // cache and removes all entries.
+  void set_ttl(absl::Duration ttl);
+
+  // Returns true if results are cached.
+  bool enabled() const {
+    return ttl_nanoseconds_.load(std::memory_order_relaxed) > 0;
+  }
+
+  // Looks up the result of stat(), if |follow_links| is true, or lstat() of
+  // |path| at time |now|. On a hit, stores the cached errno in |error|, or zero
+  // and the cached metadata in |stat_buffer| if the call succeeded, and returns
+  // true.
+  bool Lookup(absl::string_view path, bool follow_links, absl::Time now,
+              struct stat *stat_buffer, int *error);
+
+  // Returns the current invalidation generation, which changes whenever
+  // entries are invalidated or cleared.
+  uint64_t generation() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  // Caches the result of stat() or lstat() of |path| at time |now|. |error| is
+  // the errno of a failed call, or zero if the call succeeded and returned
+  // |stat_buffer|. |generation| is the value of generation() sampled before the
+  // result was fetched; the result is dropped if it has changed since.
+  void Insert(absl::string_view path, bool follow_links,
+              const struct stat *stat_buffer, int error, absl::Time now,
+              uint64_t generation);
+
+  // Removes the entries for |path| and for its parent directory, whose
+  // metadata changes when an entry is added or removed.
+  void Invalidate(absl::string_view path);
+
+  // Removes all entries. The counters are not reset.
+  void Clear();
+
+  // Records that the entries of a directory were fetched in a single host call
+  // in order to be inserted into the cache.
+  void RecordPrefetch() {
+    prefetches_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Returns the number of entries in the cache, including expired entries that
+  // have not been evicted yet.
+  size_t size() const;
+
+  // Returns the number of lookups that were satisfied from the cache.
+  uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+
+  // Returns the number of lookups that were not satisfied from the cache.
+  uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+  // Returns the number of directories that were prefetched.
+  uint64_t prefetches() const {
+    return prefetches_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the number of host calls the cache saved. Each hit saves a host
+  // call, and each prefetch costs one.
+  int64_t saved_host_calls() const {
+    return static_cast<int64_t>(hits()) - static_cast<int64_t>(prefetches());
+  }
+
+ private:
+  struct Entry {
+    std::string key;
+    struct stat stat_buffer;
+    int error;
+    absl::Time expiration;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  // Removes the entry with |key|, if any.
+  void Erase(const std::string &key) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const size_t max_entries_;
+
+  std::atomic<int64_t> ttl_nanoseconds_;
+
+  mutable absl::Mutex mu_;
+
+  // Entries ordered from most to least recently used.
+  EntryList entries_ GUARDED_BY(mu_);
+  std::unordered_map<std::string, EntryList::iterator> index_ GUARDED_BY(mu_);
+
+  // Incremented under |mu_| by every invalidation, so that Insert() can detect
+  // one that raced with the host call producing its result.
+  std::atomic<uint64_t> generation_;
+
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+  std::atomic<uint64_t> prefetches_;
+};
+
+// Returns the cache used for paths handled by NativePathHandler.
+StatCache *GetNativeStatCache();
+
+}  // namespace io
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_POSIX_IO_STAT_CACHE_H_
@@ -0,0 +1,114 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "asylo/platform/posix/io/stat_cache.h"
+#include "asylo/test/util/test_flags.h"
+
+namespace asylo {
+namespace io {
+namespace {
+
+constexpr char kMessage[] = "stat cache invalidation";
+constexpr ssize_t kMessageSize = sizeof(kMessage) - 1;
+
+// Enables the cache of host file metadata for the duration of each test, and
+// provides a fresh path in the test directory.
+class StatCacheInvalidationTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    GetNativeStatCache()->set_ttl(absl::Minutes(1));
+  }
+
+  void TearDown() override {
+    GetNativeStatCache()->set_ttl(absl::ZeroDuration());
+  }
+
+  std::string MakePath(const char *name) {
+    std::string path = absl::StrCat(FLAGS_test_tmpdir, "/", name);
+    remove(path.c_str());
+    return path;
+  }
+
+  // Returns the size of |path| as reported by stat().
+  off_t Size(const std::string &path) {
+    struct stat stat_buffer;
+    EXPECT_EQ(stat(path.c_str(), &stat_buffer), 0);
+    return stat_buffer.st_size;
+  }
+};
+
+// Tests that a sendfile() performed on the host invalidates the cached
+// metadata of the output file.
+TEST_F(StatCacheInvalidationTest, HostSendFile) {
+  std::string in_path = MakePath("stat_cache_sendfile_in");
+  std::string out_path = MakePath("stat_cache_sendfile_out");
+  int in_fd = open(in_path.c_str(), O_CREAT | O_RDWR, 0644);
+  ASSERT_GE(in_fd, 0);
+  ASSERT_EQ(write(in_fd, kMessage, kMessageSize), kMessageSize);
+  int out_fd = open(out_path.c_str(), O_CREAT | O_WRONLY, 0644);
+  ASSERT_GE(out_fd, 0);
+
+  EXPECT_EQ(Size(out_path), 0);
+  off_t offset = 0;
+  ASSERT_EQ(sendfile(out_fd, in_fd, &offset, kMessageSize),
+            kMessageSize);
+  EXPECT_EQ(Size(out_path), kMessageSize);
+
+  close(in_fd);
+  close(out_fd);
+}
+
+// Tests that writes to a secure file invalidate the cached metadata of its
+// backing store.
+TEST_F(StatCacheInvalidationTest, SecureWrite) {
+  std::string path = MakePath("stat_cache_secure");
+  int fd = open(path.c_str(), O_CREAT | O_RDWR | O_SECURE, 0644);
+  ASSERT_GE(fd, 0);
+  std::vector<uint8_t> key(32, 0x5a);
+  struct key_info ioctl_param;
+  ioctl_param.length = key.size();
+  ioctl_param.data = key.data();
+  ASSERT_EQ(ioctl(fd, ENCLAVE_STORAGE_SET_KEY, &ioctl_param), 0);
+
+  off_t size = Size(path);
+  ASSERT_EQ(write(fd, kMessage, kMessageSize), kMessageSize);
+  off_t written_size = Size(path);
+  EXPECT_GT(written_size, size);
+
+  // Writing past the end of the file grows the backing store further.
+  ASSERT_EQ(pwrite(fd, kMessage, kMessageSize, 4096), kMessageSize);
+  EXPECT_GT(Size(path), written_size);
+
+  close(fd);
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace asylo
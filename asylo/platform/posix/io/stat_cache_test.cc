@@ -0,0 +1,204 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/posix/io/stat_cache.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+namespace asylo {
+namespace io {
+namespace {
+
+constexpr absl::Duration kTtl = absl::Seconds(10);
+
+// Returns a stat buffer identified by |inode|.
+struct stat MakeStat(ino_t inode) {
+  struct stat stat_buffer;
+  memset(&stat_buffer, 0, sizeof(stat_buffer));
+  stat_buffer.st_ino = inode;
+  stat_buffer.st_size = 100 * inode;
+  return stat_buffer;
+}
+
+// Tests that the cache stores nothing until a time-to-live is set.
+TEST(StatCacheTest, DisabledByDefault) {
+  StatCache cache(8);
+  EXPECT_FALSE(cache.enabled());
+  absl::Time now = absl::Now();
+  struct stat stat_buffer = MakeStat(1);
+  cache.Insert("/a", true, &stat_buffer, 0, now, cache.generation());
+  EXPECT_EQ(cache.size(), 0);
+  int error;
+  EXPECT_FALSE(cache.Lookup("/a", true, now, &stat_buffer, &error));
+  EXPECT_EQ(cache.misses(), 0);
+}
+
+// Tests that successful results are returned until they expire.
+TEST(StatCacheTest, HitUntilExpired) {
+  StatCache cache(8);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  struct stat expected = MakeStat(7);
+  cache.Insert("/a", true, &expected, 0, now, cache.generation());
+
+  struct stat actual;
+  int error = -1;
+  ASSERT_TRUE(cache.Lookup("/a", true, now + kTtl / 2, &actual, &error));
+  EXPECT_EQ(error, 0);
+  EXPECT_EQ(actual.st_ino, expected.st_ino);
+  EXPECT_EQ(actual.st_size, expected.st_size);
+  EXPECT_EQ(cache.hits(), 1);
+
+  EXPECT_FALSE(cache.Lookup("/a", true, now + kTtl, &actual, &error));
+  EXPECT_EQ(cache.misses(), 1);
+  EXPECT_EQ(cache.size(), 0);
+}
+
+// Tests that stat() and lstat() results are cached separately.
+TEST(StatCacheTest, SeparatesStatAndLstat) {
+  StatCache cache(8);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  struct stat target = MakeStat(1);
+  struct stat link = MakeStat(2);
+  cache.Insert("/link", true, &target, 0, now, cache.generation());
+  cache.Insert("/link", false, &link, 0, now, cache.generation());
+
+  struct stat actual;
+  int error;
+  ASSERT_TRUE(cache.Lookup("/link", true, now, &actual, &error));
+  EXPECT_EQ(actual.st_ino, 1);
+  ASSERT_TRUE(cache.Lookup("/link", false, now, &actual, &error));
+  EXPECT_EQ(actual.st_ino, 2);
+}
+
+// Tests that missing files are cached and other errors are not.
+TEST(StatCacheTest, CachesOnlyMissingFiles) {
+  StatCache cache(8);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  cache.Insert("/missing", true, nullptr, ENOENT, now, cache.generation());
+  cache.Insert("/forbidden", true, nullptr, EACCES, now, cache.generation());
+
+  struct stat actual;
+  int error = 0;
+  ASSERT_TRUE(cache.Lookup("/missing", true, now, &actual, &error));
+  EXPECT_EQ(error, ENOENT);
+  EXPECT_FALSE(cache.Lookup("/forbidden", true, now, &actual, &error));
+}
+
+// Tests that invalidating a path removes its entries and those of its parent
+// directory.
+TEST(StatCacheTest, InvalidateRemovesPathAndParent) {
+  StatCache cache(16);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  struct stat stat_buffer = MakeStat(1);
+  for (const char *path : {"/", "/dir", "/dir/a", "/dir/b", "/file"}) {
+    cache.Insert(path, true, &stat_buffer, 0, now, cache.generation());
+    cache.Insert(path, false, &stat_buffer, 0, now, cache.generation());
+  }
+
+  cache.Invalidate("/dir/a");
+  int error;
+  EXPECT_FALSE(cache.Lookup("/dir/a", true, now, &stat_buffer, &error));
+  EXPECT_FALSE(cache.Lookup("/dir/a", false, now, &stat_buffer, &error));
+  EXPECT_FALSE(cache.Lookup("/dir", true, now, &stat_buffer, &error));
+  EXPECT_FALSE(cache.Lookup("/dir", false, now, &stat_buffer, &error));
+  EXPECT_TRUE(cache.Lookup("/dir/b", true, now, &stat_buffer, &error));
+  EXPECT_TRUE(cache.Lookup("/", true, now, &stat_buffer, &error));
+
+  cache.Invalidate("/file");
+  EXPECT_FALSE(cache.Lookup("/file", true, now, &stat_buffer, &error));
+  EXPECT_FALSE(cache.Lookup("/", true, now, &stat_buffer, &error));
+  EXPECT_TRUE(cache.Lookup("/dir/b", false, now, &stat_buffer, &error));
+}
+
+// Tests that the least recently used entry is evicted when the cache is full.
+TEST(StatCacheTest, EvictsLeastRecentlyUsed) {
+  StatCache cache(2);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  struct stat stat_buffer = MakeStat(1);
+  cache.Insert("/a", true, &stat_buffer, 0, now, cache.generation());
+  cache.Insert("/b", true, &stat_buffer, 0, now, cache.generation());
+  int error;
+  ASSERT_TRUE(cache.Lookup("/a", true, now, &stat_buffer, &error));
+  cache.Insert("/c", true, &stat_buffer, 0, now, cache.generation());
+
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_TRUE(cache.Lookup("/a", true, now, &stat_buffer, &error));
+  EXPECT_FALSE(cache.Lookup("/b", true, now, &stat_buffer, &error));
+  EXPECT_TRUE(cache.Lookup("/c", true, now, &stat_buffer, &error));
+}
+
+// Tests that disabling the cache removes all entries.
+TEST(StatCacheTest, DisablingClears) {
+  StatCache cache(8);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  struct stat stat_buffer = MakeStat(1);
+  cache.Insert("/a", true, &stat_buffer, 0, now, cache.generation());
+  cache.set_ttl(absl::ZeroDuration());
+  EXPECT_FALSE(cache.enabled());
+  EXPECT_EQ(cache.size(), 0);
+}
+
+// Tests that a result fetched before an invalidation is not inserted after it,
+// since it may predate the change that caused the invalidation.
+TEST(StatCacheTest, DropsInsertStampedBeforeInvalidate) {
+  StatCache cache(8);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  struct stat stat_buffer = MakeStat(1);
+
+  uint64_t generation = cache.generation();
+  cache.Invalidate("/dir/a");
+  cache.Insert("/dir/a", true, &stat_buffer, 0, now, generation);
+  EXPECT_EQ(cache.size(), 0);
+  int error;
+  EXPECT_FALSE(cache.Lookup("/dir/a", true, now, &stat_buffer, &error));
+
+  // A result fetched after the invalidation is cached.
+  cache.Insert("/dir/a", true, &stat_buffer, 0, now, cache.generation());
+  EXPECT_TRUE(cache.Lookup("/dir/a", true, now, &stat_buffer, &error));
+}
+
+// Tests that prefetches are charged against the host calls saved by hits.
+TEST(StatCacheTest, SavedHostCalls) {
+  StatCache cache(8);
+  cache.set_ttl(kTtl);
+  absl::Time now = absl::Now();
+  struct stat stat_buffer = MakeStat(1);
+  cache.RecordPrefetch();
+  cache.Insert("/dir/a", false, &stat_buffer, 0, now, cache.generation());
+  cache.Insert("/dir/b", false, &stat_buffer, 0, now, cache.generation());
+  int error;
+  EXPECT_TRUE(cache.Lookup("/dir/a", false, now, &stat_buffer, &error));
+  EXPECT_TRUE(cache.Lookup("/dir/b", false, now, &stat_buffer, &error));
+  EXPECT_TRUE(cache.Lookup("/dir/a", false, now, &stat_buffer, &error));
+  EXPECT_EQ(cache.prefetches(), 1);
+  EXPECT_EQ(cache.saved_host_calls(), 2);
+}
+
+}  // namespace
+}  // namespace io
+}  // namespace asylo
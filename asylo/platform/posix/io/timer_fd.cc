@@ -0,0 +1,222 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "asylo/platform/posix/io/timer_fd.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <limits>
+
+#include "absl/time/clock.h"
+#include "asylo/platform/common/time_util.h"
+
+namespace asylo {
+namespace {
+
+constexpr int64_t kNanosecondsPerSecond = INT64_C(1000000000);
+
+// Returns true if |ts| is a non-negative time which can be used to set a timer.
+bool IsValidTimerValue(const struct timespec &ts) {
+  return ts.tv_sec >= 0 && ts.tv_nsec >= 0 &&
+         ts.tv_nsec < kNanosecondsPerSecond &&
+         IsRepresentableAsNanoseconds(&ts);
+}
+
+}  // namespace
+
+TimerFdIOContext::TimerFdIOContext(clockid_t clock_id, int flags)
+    : clock_id_(clock_id),
+      flags_(flags & O_NONBLOCK),
+      next_expiration_(0),
+      interval_(0),
+      expirations_(0) {}
+
+int64_t TimerFdIOContext::Now() const {
+  struct timespec ts;
+  clock_gettime(clock_id_, &ts);
+  return TimeSpecToNanoseconds(&ts);
+}
+
+void TimerFdIOContext::UpdateExpirations(int64_t now) {
+  if (next_expiration_ == 0 || now < next_expiration_) {
+    return;
+  }
+  if (interval_ == 0) {
+    ++expirations_;
+    next_expiration_ = 0;
+    return;
+  }
+  int64_t periods = (now - next_expiration_) / interval_ + 1;
+  expirations_ += periods;
+  next_expiration_ += periods * interval_;
+}
+
+void TimerFdIOContext::GetTime(int64_t now, struct itimerspec *value) {
+  int64_t remaining = next_expiration_ == 0 ? 0 : next_expiration_ - now;
+  NanosecondsToTimeSpec(&value->it_value, remaining);
+  NanosecondsToTimeSpec(&value->it_interval, interval_);
+}
+
+ssize_t TimerFdIOContext::Read(void *buf, size_t count) {
+  if (count < sizeof(uint64_t)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  uint64_t value;
+  {
+    absl::MutexLock lock(&mu_);
+    while (true) {
+      int64_t now = Now();
+      UpdateExpirations(now);
+      if (expirations_ > 0) {
+        break;
+      }
+      if (flags_ & O_NONBLOCK) {
+        errno = EAGAIN;
+        return -1;
+      }
+      if (next_expiration_ == 0) {
+        changed_.Wait(&mu_);
+      } else {
+        changed_.WaitWithTimeout(&mu_,
+                                 absl::Nanoseconds(next_expiration_ - now));
+      }
+    }
+    value = expirations_;
+    expirations_ = 0;
+  }
+  memcpy(buf, &value, sizeof(value));
+  io::IOManager::GetInstance().NotifyReadinessChanged();
+  return sizeof(value);
+}
+
+ssize_t TimerFdIOContext::Write(const void *buf, size_t count) {
+  errno = EINVAL;
+  return -1;
+}
+
+int TimerFdIOContext::Close() { return 0; }
+
+int TimerFdIOContext::LSeek(off_t offset, int whence) {
+  errno = ESPIPE;
+  return -1;
+}
+
+int TimerFdIOContext::FCntl(int cmd, int64_t arg) {
+  switch (cmd) {
+    case F_GETFL:
+      return O_RDWR | flags_;
+    case F_SETFL:
+      flags_ = arg & O_NONBLOCK;
+      return 0;
+    case F_GETFD:
+    case F_SETFD:
+      // Close-on-exec has no meaning inside the enclave.
+      return 0;
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+}
+
+int TimerFdIOContext::FStat(struct stat *stat_buffer) {
+  memset(stat_buffer, 0, sizeof(*stat_buffer));
+  stat_buffer->st_mode = S_IRUSR | S_IWUSR;
+  stat_buffer->st_nlink = 1;
+  return 0;
+}
+
+int TimerFdIOContext::Isatty() { return 0; }
+
+int TimerFdIOContext::TimerSetTime(int flags,
+                                   const struct itimerspec *new_value,
+                                   struct itimerspec *old_value) {
+  if (!new_value) {
+    errno = EFAULT;
+    return -1;
+  }
+  if ((flags & ~TFD_TIMER_ABSTIME) || !IsValidTimerValue(new_value->it_value) ||
+      !IsValidTimerValue(new_value->it_interval)) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  {
+    absl::MutexLock lock(&mu_);
+    int64_t now = Now();
+    if (old_value) {
+      UpdateExpirations(now);
+      GetTime(now, old_value);
+    }
+
+    int64_t value = TimeSpecToNanoseconds(&new_value->it_value);
+    if (value == 0) {
+      next_expiration_ = 0;
+    } else if (flags & TFD_TIMER_ABSTIME) {
+      // An expiration time in the past expires the timer immediately, but zero
+      // is reserved for a disarmed timer.
+      next_expiration_ = value > 0 ? value : 1;
+    } else if (value > std::numeric_limits<int64_t>::max() - now) {
+      next_expiration_ = std::numeric_limits<int64_t>::max();
+    } else {
+      next_expiration_ = now + value;
+    }
+    interval_ = TimeSpecToNanoseconds(&new_value->it_interval);
+    expirations_ = 0;
+    changed_.SignalAll();
+  }
+  io::IOManager::GetInstance().NotifyReadinessChanged();
+  return 0;
+}
+
+int TimerFdIOContext::TimerGetTime(struct itimerspec *curr_value) {
+  if (!curr_value) {
+    errno = EFAULT;
+    return -1;
+  }
+  absl::MutexLock lock(&mu_);
+  int64_t now = Now();
+  UpdateExpirations(now);
+  GetTime(now, curr_value);
+  return 0;
+}
+
+bool TimerFdIOContext::PollReadiness(short events, short *revents) {
+  absl::MutexLock lock(&mu_);
+  UpdateExpirations(Now());
+  *revents = expirations_ > 0 ? events & (POLLIN | POLLRDNORM) : 0;
+  return true;
+}
+
+absl::Time TimerFdIOContext::NextReadinessChange() {
+  absl::MutexLock lock(&mu_);
+  int64_t now = Now();
+  UpdateExpirations(now);
+  if (expirations_ > 0 || next_expiration_ == 0) {
+    return absl::InfiniteFuture();
+  }
+
+  // The clock of the timer may differ from the clock used by absl::Now(), so
+  // the expiration is converted through the remaining time.
+  return absl::Now() + absl::Nanoseconds(next_expiration_ - now);
+}
+
+}  // namespace asylo
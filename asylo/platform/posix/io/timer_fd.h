@@ -0,0 +1,91 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#ifndef ASYLO_PLATFORM_POSIX_IO_TIMER_FD_H_
+#define ASYLO_PLATFORM_POSIX_IO_TIMER_FD_H_
+
+#include <sys/stat.h>
+#include <time.h>
+#include <atomic>
+#include <cstdint>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "asylo/platform/posix/io/io_manager.h"
+
+namespace asylo {
+
+// IOContext implementation for a descriptor created by timerfd_create(2). The
+// timer is driven by the clocks of the enclave, which are read without a host
+// call, and expirations are counted when the timer is next inspected rather
+// than by a thread waking up at the expiration time.
+class TimerFdIOContext : public io::IOManager::IOContext {
+ public:
+  // Creates a disarmed timer measured against |clock_id|, which must be
+  // CLOCK_REALTIME or CLOCK_MONOTONIC. |flags| may contain TFD_NONBLOCK.
+  TimerFdIOContext(clockid_t clock_id, int flags);
+
+ protected:
+  ssize_t Read(void *buf, size_t count) override;
+  ssize_t Write(const void *buf, size_t count) override;
+  int Close() override;
+  int LSeek(off_t offset, int whence) override;
+  int FCntl(int cmd, int64_t arg) override;
+  int FStat(struct stat *stat_buffer) override;
+  int Isatty() override;
+  int TimerSetTime(int flags, const struct itimerspec *new_value,
+                   struct itimerspec *old_value) override;
+  int TimerGetTime(struct itimerspec *curr_value) override;
+  bool PollReadiness(short events, short *revents) override;
+  absl::Time NextReadinessChange() override;
+
+ private:
+  // Returns the current value of |clock_id_| in nanoseconds.
+  int64_t Now() const;
+
+  // Adds the expirations which occurred up to |now| to |expirations_| and
+  // advances or disarms the timer accordingly.
+  void UpdateExpirations(int64_t now) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Stores the current setting of the timer, relative to |now|, in |value|.
+  void GetTime(int64_t now, struct itimerspec *value)
+      SHARED_LOCKS_REQUIRED(mu_);
+
+  const clockid_t clock_id_;
+
+  // O_NONBLOCK if reads should not block.
+  std::atomic<int> flags_;
+
+  absl::Mutex mu_;
+
+  // Signaled whenever the timer is set.
+  absl::CondVar changed_;
+
+  // The next expiration of the timer as a value of |clock_id_| in nanoseconds,
+  // or zero if the timer is disarmed.
+  int64_t next_expiration_ GUARDED_BY(mu_);
+
+  // The period of the timer in nanoseconds, or zero for a one-shot timer.
+  int64_t interval_ GUARDED_BY(mu_);
+
+  // The number of expirations since the timer was last read or set.
+  uint64_t expirations_ GUARDED_BY(mu_);
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_POSIX_IO_TIMER_FD_H_
@@ -0,0 +1,138 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+#include "asylo/platform/posix/io/io_manager.h"
+
+namespace asylo {
+namespace {
+
+// Returns an itimerspec expiring after |value_ns| and then every |interval_ns|
+// nanoseconds.
+struct itimerspec TimerValue(int64_t value_ns, int64_t interval_ns) {
+  struct itimerspec value;
+  value.it_value.tv_sec = value_ns / 1000000000;
+  value.it_value.tv_nsec = value_ns % 1000000000;
+  value.it_interval.tv_sec = interval_ns / 1000000000;
+  value.it_interval.tv_nsec = interval_ns % 1000000000;
+  return value;
+}
+
+// Tests that a one-shot timer expires once and a blocking read waits for it.
+TEST(TimerFdTest, OneShot) {
+  int fd = timerfd_create(CLOCK_MONOTONIC, 0);
+  ASSERT_GE(fd, 0);
+  struct itimerspec value = TimerValue(20000000, 0);
+  ASSERT_EQ(timerfd_settime(fd, 0, &value, nullptr), 0);
+
+  uint64_t expirations;
+  ASSERT_EQ(read(fd, &expirations, sizeof(expirations)), sizeof(expirations));
+  EXPECT_EQ(expirations, 1);
+
+  struct itimerspec current;
+  ASSERT_EQ(timerfd_gettime(fd, &current), 0);
+  EXPECT_EQ(current.it_value.tv_sec, 0);
+  EXPECT_EQ(current.it_value.tv_nsec, 0);
+  close(fd);
+}
+
+// Tests that the expirations of a periodic timer accumulate until it is read.
+TEST(TimerFdTest, Periodic) {
+  int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+  ASSERT_GE(fd, 0);
+  uint64_t expirations;
+  EXPECT_EQ(read(fd, &expirations, sizeof(expirations)), -1);
+  EXPECT_EQ(errno, EAGAIN);
+
+  struct itimerspec value = TimerValue(1000000, 1000000);
+  ASSERT_EQ(timerfd_settime(fd, 0, &value, nullptr), 0);
+  struct timespec delay = {0, 10000000};
+  nanosleep(&delay, nullptr);
+  ASSERT_EQ(read(fd, &expirations, sizeof(expirations)), sizeof(expirations));
+  EXPECT_GE(expirations, 5);
+
+  struct itimerspec current;
+  ASSERT_EQ(timerfd_gettime(fd, &current), 0);
+  EXPECT_EQ(current.it_interval.tv_nsec, 1000000);
+  EXPECT_LE(current.it_value.tv_nsec, 1000000);
+  close(fd);
+}
+
+// Tests that poll() returns when a timer expires, and that a disarmed timer
+// never becomes ready.
+TEST(TimerFdTest, Poll) {
+  int fd = timerfd_create(CLOCK_MONOTONIC, 0);
+  ASSERT_GE(fd, 0);
+  struct pollfd pfd = {fd, POLLIN, 0};
+  ASSERT_EQ(poll(&pfd, 1, 10), 0);
+
+  struct itimerspec value = TimerValue(10000000, 0);
+  ASSERT_EQ(timerfd_settime(fd, 0, &value, nullptr), 0);
+  ASSERT_EQ(poll(&pfd, 1, -1), 1);
+  EXPECT_EQ(pfd.revents, POLLIN);
+
+  // Disarming the timer discards the pending expiration.
+  value = TimerValue(0, 0);
+  ASSERT_EQ(timerfd_settime(fd, 0, &value, nullptr), 0);
+  ASSERT_EQ(poll(&pfd, 1, 0), 0);
+  close(fd);
+}
+
+// Tests that an absolute expiration time in the past expires immediately.
+TEST(TimerFdTest, AbsoluteTime) {
+  int fd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK);
+  ASSERT_GE(fd, 0);
+  struct itimerspec value = TimerValue(1, 0);
+  ASSERT_EQ(timerfd_settime(fd, TFD_TIMER_ABSTIME, &value, nullptr), 0);
+  uint64_t expirations;
+  ASSERT_EQ(read(fd, &expirations, sizeof(expirations)), sizeof(expirations));
+  EXPECT_EQ(expirations, 1);
+  close(fd);
+}
+
+// Tests that invalid arguments are rejected.
+TEST(TimerFdTest, InvalidArguments) {
+  EXPECT_EQ(timerfd_create(CLOCK_PROCESS_CPUTIME_ID, 0), -1);
+  EXPECT_EQ(errno, EINVAL);
+
+  int fd = timerfd_create(CLOCK_MONOTONIC, 0);
+  ASSERT_GE(fd, 0);
+  struct itimerspec value = TimerValue(0, 0);
+  value.it_value.tv_nsec = 1000000000;
+  EXPECT_EQ(timerfd_settime(fd, 0, &value, nullptr), -1);
+  EXPECT_EQ(errno, EINVAL);
+  close(fd);
+
+  // Descriptors which are not timers cannot be set.
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  value = TimerValue(1000000, 0);
+  EXPECT_EQ(timerfd_settime(fds[0], 0, &value, nullptr), -1);
+  EXPECT_EQ(errno, EINVAL);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+}  // namespace
+}  // namespace asylo
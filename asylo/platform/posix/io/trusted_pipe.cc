@@ -0,0 +1,268 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/posix/io/trusted_pipe.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "asylo/platform/common/ring_buffer.h"
+
+namespace asylo {
+namespace {
+
+// Writes of at most this many bytes are not interleaved with data from other
+// writes, as for PIPE_BUF on Linux.
+constexpr size_t kAtomicWriteSize = 4096;
+
+// Returns the total length of the buffers in |iov|, or -1 if |iovcnt| is not
+// valid.
+ssize_t IovecLength(const struct iovec *iov, int iovcnt) {
+  if (iovcnt <= 0) {
+    return -1;
+  }
+  size_t total = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    total += iov[i].iov_len;
+  }
+  return total;
+}
+
+}  // namespace
+
+// The state shared by both ends of a pipe. Readers and writers serialize on a
+// single mutex, so the single-reader, single-writer RingBuffer may be shared by
+// any number of threads.
+class TrustedPipeIOContext::PipeBuffer {
+ public:
+  absl::Mutex mu;
+
+  // Signaled whenever data is read or written, or an end is closed.
+  absl::CondVar changed;
+
+  RingBuffer<kTrustedPipeCapacity> ring GUARDED_BY(mu);
+};
+
+void TrustedPipeIOContext::CreatePipe(
+    int flags, std::unique_ptr<TrustedPipeIOContext> *read_end,
+    std::unique_ptr<TrustedPipeIOContext> *write_end) {
+  auto buffer = std::make_shared<PipeBuffer>();
+  read_end->reset(new TrustedPipeIOContext(buffer, /*is_read_end=*/true,
+                                           flags & O_NONBLOCK));
+  write_end->reset(new TrustedPipeIOContext(buffer, /*is_read_end=*/false,
+                                            flags & O_NONBLOCK));
+}
+
+TrustedPipeIOContext::TrustedPipeIOContext(std::shared_ptr<PipeBuffer> buffer,
+                                           bool is_read_end, int flags)
+    : buffer_(std::move(buffer)), is_read_end_(is_read_end), flags_(flags) {}
+
+ssize_t TrustedPipeIOContext::Read(void *buf, size_t count) {
+  if (!is_read_end_) {
+    errno = EBADF;
+    return -1;
+  }
+  if (count == 0) {
+    return 0;
+  }
+
+  size_t bytes_read;
+  {
+    absl::MutexLock lock(&buffer_->mu);
+    RingBuffer<kTrustedPipeCapacity> &ring = buffer_->ring;
+    while (ring.empty()) {
+      if (ring.is_closed_for_write()) {
+        return 0;
+      }
+      if (flags_ & O_NONBLOCK) {
+        errno = EAGAIN;
+        return -1;
+      }
+      buffer_->changed.Wait(&buffer_->mu);
+    }
+    bytes_read = ring.NonBlockingRead(static_cast<uint8_t *>(buf), count);
+    buffer_->changed.SignalAll();
+  }
+  io::IOManager::GetInstance().NotifyReadinessChanged();
+  return bytes_read;
+}
+
+ssize_t TrustedPipeIOContext::Write(const void *buf, size_t count) {
+  if (is_read_end_) {
+    errno = EBADF;
+    return -1;
+  }
+
+  // Small writes are only performed once there is room for all of their data.
+  const size_t needed = count <= kAtomicWriteSize ? count : 1;
+  const uint8_t *data = static_cast<const uint8_t *>(buf);
+  size_t written = 0;
+  absl::MutexLock lock(&buffer_->mu);
+  RingBuffer<kTrustedPipeCapacity> &ring = buffer_->ring;
+  while (written < count) {
+    if (ring.is_closed_for_read()) {
+      if (written == 0) {
+        errno = EPIPE;
+        return -1;
+      }
+      break;
+    }
+    if (ring.available() < needed) {
+      if (flags_ & O_NONBLOCK) {
+        if (written == 0) {
+          errno = EAGAIN;
+          return -1;
+        }
+        break;
+      }
+      buffer_->changed.Wait(&buffer_->mu);
+      continue;
+    }
+    written += ring.NonBlockingWrite(data + written, count - written);
+    buffer_->changed.SignalAll();
+
+    // Readers waiting in poll() are not blocked on the mutex of the pipe, so
+    // they can be woken up while it is held.
+    io::IOManager::GetInstance().NotifyReadinessChanged();
+  }
+  return written;
+}
+
+int TrustedPipeIOContext::Close() {
+  {
+    absl::MutexLock lock(&buffer_->mu);
+    if (is_read_end_) {
+      buffer_->ring.close_for_read();
+    } else {
+      buffer_->ring.close_for_write();
+    }
+    buffer_->changed.SignalAll();
+  }
+  io::IOManager::GetInstance().NotifyReadinessChanged();
+  return 0;
+}
+
+int TrustedPipeIOContext::LSeek(off_t offset, int whence) {
+  errno = ESPIPE;
+  return -1;
+}
+
+int TrustedPipeIOContext::FCntl(int cmd, int64_t arg) {
+  switch (cmd) {
+    case F_GETFL:
+      return (is_read_end_ ? O_RDONLY : O_WRONLY) | flags_;
+    case F_SETFL:
+      flags_ = arg & O_NONBLOCK;
+      return 0;
+    case F_GETFD:
+    case F_SETFD:
+      // Close-on-exec has no meaning inside the enclave.
+      return 0;
+    default:
+      errno = EINVAL;
+      return -1;
+  }
+}
+
+int TrustedPipeIOContext::FStat(struct stat *stat_buffer) {
+  memset(stat_buffer, 0, sizeof(*stat_buffer));
+  stat_buffer->st_mode = S_IFIFO | S_IRUSR | S_IWUSR;
+  stat_buffer->st_nlink = 1;
+  stat_buffer->st_blksize = kAtomicWriteSize;
+  return 0;
+}
+
+int TrustedPipeIOContext::Isatty() {
+  // Pipes are not terminals.
+  return 0;
+}
+
+ssize_t TrustedPipeIOContext::Writev(const struct iovec *iov, int iovcnt) {
+  ssize_t total = IovecLength(iov, iovcnt);
+  if (total < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // Gather the buffers so that the data is written by a single call to Write()
+  // and is not interleaved with concurrent writes.
+  std::vector<uint8_t> data(total);
+  size_t offset = 0;
+  for (int i = 0; i < iovcnt; ++i) {
+    memcpy(data.data() + offset, iov[i].iov_base, iov[i].iov_len);
+    offset += iov[i].iov_len;
+  }
+  return Write(data.data(), data.size());
+}
+
+ssize_t TrustedPipeIOContext::Readv(const struct iovec *iov, int iovcnt) {
+  ssize_t total = IovecLength(iov, iovcnt);
+  if (total < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  // A single read never returns more than the capacity of the pipe.
+  std::vector<uint8_t> data(
+      std::min(static_cast<size_t>(total), kTrustedPipeCapacity));
+  ssize_t bytes_read = Read(data.data(), data.size());
+  if (bytes_read <= 0) {
+    return bytes_read;
+  }
+  size_t offset = 0;
+  for (int i = 0; i < iovcnt && offset < bytes_read; ++i) {
+    size_t size = std::min(iov[i].iov_len, bytes_read - offset);
+    memcpy(iov[i].iov_base, data.data() + offset, size);
+    offset += size;
+  }
+  return bytes_read;
+}
+
+bool TrustedPipeIOContext::PollReadiness(short events, short *revents) {
+  short ready = 0;
+  {
+    absl::MutexLock lock(&buffer_->mu);
+    const RingBuffer<kTrustedPipeCapacity> &ring = buffer_->ring;
+    if (is_read_end_) {
+      if (!ring.empty()) {
+        ready |= POLLIN | POLLRDNORM;
+      }
+      if (ring.is_closed_for_write()) {
+        ready |= POLLHUP;
+      }
+    } else {
+      if (ring.is_closed_for_read()) {
+        ready |= POLLERR;
+      } else if (!ring.full()) {
+        ready |= POLLOUT | POLLWRNORM;
+      }
+    }
+  }
+  *revents = ready & (events | POLLERR | POLLHUP);
+  return true;
+}
+
+}  // namespace asylo
@@ -0,0 +1,74 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_POSIX_IO_TRUSTED_PIPE_H_
+#define ASYLO_PLATFORM_POSIX_IO_TRUSTED_PIPE_H_
+
+#include <sys/stat.h>
+#include <atomic>
+#include <memory>
+
+#include "asylo/platform/posix/io/io_manager.h"
+
+namespace asylo {
+
+// The number of bytes a pipe created inside the enclave can hold, which matches
+// the default capacity of a pipe on Linux.
+constexpr size_t kTrustedPipeCapacity = 65536;
+
+// IOContext implementation for one end of a pipe between threads of the
+// enclave. Data written to the pipe is held in a RingBuffer in trusted memory,
+// so reading, writing and polling the pipe do not require a host call.
+class TrustedPipeIOContext : public io::IOManager::IOContext {
+ public:
+  // Creates the read end and the write end of a new pipe. |flags| may contain
+  // O_NONBLOCK.
+  static void CreatePipe(int flags,
+                         std::unique_ptr<TrustedPipeIOContext> *read_end,
+                         std::unique_ptr<TrustedPipeIOContext> *write_end);
+
+ protected:
+  ssize_t Read(void *buf, size_t count) override;
+  ssize_t Write(const void *buf, size_t count) override;
+  int Close() override;
+  int LSeek(off_t offset, int whence) override;
+  int FCntl(int cmd, int64_t arg) override;
+  int FStat(struct stat *stat_buffer) override;
+  int Isatty() override;
+  ssize_t Writev(const struct iovec *iov, int iovcnt) override;
+  ssize_t Readv(const struct iovec *iov, int iovcnt) override;
+  bool PollReadiness(short events, short *revents) override;
+
+ private:
+  class PipeBuffer;
+
+  TrustedPipeIOContext(std::shared_ptr<PipeBuffer> buffer, bool is_read_end,
+                       int flags);
+
+  // The state shared by both ends of the pipe.
+  const std::shared_ptr<PipeBuffer> buffer_;
+
+  const bool is_read_end_;
+
+  // The file status flags of this end of the pipe.
+  std::atomic<int> flags_;
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_POSIX_IO_TRUSTED_PIPE_H_
@@ -0,0 +1,235 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "asylo/platform/posix/io/io_manager.h"
+#include "asylo/platform/posix/io/trusted_pipe.h"
+
+namespace asylo {
+namespace {
+
+class TrustedPipeTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_EQ(pipe(fds_), 0); }
+
+  void TearDown() override {
+    CloseReadEnd();
+    CloseWriteEnd();
+  }
+
+  void CloseReadEnd() {
+    if (fds_[0] >= 0) {
+      close(fds_[0]);
+      fds_[0] = -1;
+    }
+  }
+
+  void CloseWriteEnd() {
+    if (fds_[1] >= 0) {
+      close(fds_[1]);
+      fds_[1] = -1;
+    }
+  }
+
+  int fds_[2];
+};
+
+// Tests that data written to the pipe is read back in order.
+TEST_F(TrustedPipeTest, ReadWrite) {
+  const std::string message = "Hello from the write end!";
+  ASSERT_EQ(write(fds_[1], message.data(), message.size()), message.size());
+
+  std::vector<char> buf(message.size() + 16);
+  ASSERT_EQ(read(fds_[0], buf.data(), 5), 5);
+  EXPECT_EQ(std::string(buf.data(), 5), message.substr(0, 5));
+
+  // A read returns the available data rather than waiting for more.
+  ASSERT_EQ(read(fds_[0], buf.data(), buf.size()), message.size() - 5);
+  EXPECT_EQ(std::string(buf.data(), message.size() - 5), message.substr(5));
+}
+
+// Tests that the pipe is not backed by a host file descriptor and reports
+// itself as a FIFO.
+TEST_F(TrustedPipeTest, FStat) {
+  struct stat st;
+  ASSERT_EQ(fstat(fds_[0], &st), 0);
+  EXPECT_TRUE(S_ISFIFO(st.st_mode));
+  EXPECT_EQ(lseek(fds_[0], 0, SEEK_SET), -1);
+  EXPECT_EQ(errno, ESPIPE);
+}
+
+// Tests that the ends of the pipe may only be used in their direction.
+TEST_F(TrustedPipeTest, WrongDirection) {
+  char c = 'a';
+  EXPECT_EQ(write(fds_[0], &c, 1), -1);
+  EXPECT_EQ(errno, EBADF);
+  EXPECT_EQ(read(fds_[1], &c, 1), -1);
+  EXPECT_EQ(errno, EBADF);
+}
+
+// Tests end-of-file and broken pipe conditions.
+TEST_F(TrustedPipeTest, ClosedEnds) {
+  char c = 'a';
+  ASSERT_EQ(write(fds_[1], &c, 1), 1);
+  CloseWriteEnd();
+
+  // Buffered data is still delivered before end-of-file.
+  EXPECT_EQ(read(fds_[0], &c, 1), 1);
+  EXPECT_EQ(read(fds_[0], &c, 1), 0);
+
+  ASSERT_EQ(pipe(fds_), 0);
+  CloseReadEnd();
+  EXPECT_EQ(write(fds_[1], &c, 1), -1);
+  EXPECT_EQ(errno, EPIPE);
+}
+
+// Tests that a duplicated end keeps the pipe open.
+TEST_F(TrustedPipeTest, DupKeepsEndOpen) {
+  int dup_fd = dup(fds_[1]);
+  ASSERT_GE(dup_fd, 0);
+  CloseWriteEnd();
+
+  char c = 'a';
+  ASSERT_EQ(write(dup_fd, &c, 1), 1);
+  EXPECT_EQ(read(fds_[0], &c, 1), 1);
+  close(dup_fd);
+  EXPECT_EQ(read(fds_[0], &c, 1), 0);
+}
+
+// Tests non-blocking reads and writes.
+TEST_F(TrustedPipeTest, NonBlocking) {
+  ASSERT_EQ(fcntl(fds_[0], F_SETFL, O_NONBLOCK), 0);
+  ASSERT_EQ(fcntl(fds_[1], F_SETFL, O_NONBLOCK), 0);
+  EXPECT_EQ(fcntl(fds_[0], F_GETFL) & O_ACCMODE, O_RDONLY);
+  EXPECT_EQ(fcntl(fds_[1], F_GETFL) & O_ACCMODE, O_WRONLY);
+  EXPECT_NE(fcntl(fds_[1], F_GETFL) & O_NONBLOCK, 0);
+
+  char c = 'a';
+  EXPECT_EQ(read(fds_[0], &c, 1), -1);
+  EXPECT_EQ(errno, EAGAIN);
+
+  // Fill the pipe.
+  std::vector<char> buf(kTrustedPipeCapacity + 1, 'b');
+  EXPECT_EQ(write(fds_[1], buf.data(), buf.size()), kTrustedPipeCapacity);
+  EXPECT_EQ(write(fds_[1], &c, 1), -1);
+  EXPECT_EQ(errno, EAGAIN);
+
+  EXPECT_EQ(read(fds_[0], buf.data(), buf.size()), kTrustedPipeCapacity);
+}
+
+// Tests that a blocking write larger than the pipe completes as the reader
+// drains it.
+TEST_F(TrustedPipeTest, LargeBlockingWrite) {
+  constexpr size_t kSize = 4 * kTrustedPipeCapacity + 17;
+  std::vector<char> data(kSize);
+  for (size_t i = 0; i < kSize; ++i) {
+    data[i] = static_cast<char>(i * 7);
+  }
+
+  std::thread writer([this, &data] {
+    EXPECT_EQ(write(fds_[1], data.data(), data.size()), data.size());
+    CloseWriteEnd();
+  });
+
+  std::vector<char> received;
+  char buf[1000];
+  ssize_t ret;
+  while ((ret = read(fds_[0], buf, sizeof(buf))) > 0) {
+    received.insert(received.end(), buf, buf + ret);
+  }
+  writer.join();
+  EXPECT_EQ(ret, 0);
+  EXPECT_EQ(received, data);
+}
+
+// Tests the readiness reported by poll.
+TEST_F(TrustedPipeTest, PollReadiness) {
+  struct pollfd pfds[2] = {{fds_[0], POLLIN, 0}, {fds_[1], POLLOUT, 0}};
+  ASSERT_EQ(poll(pfds, 2, 0), 1);
+  EXPECT_EQ(pfds[0].revents, 0);
+  EXPECT_EQ(pfds[1].revents, POLLOUT);
+
+  char c = 'a';
+  ASSERT_EQ(write(fds_[1], &c, 1), 1);
+  ASSERT_EQ(poll(pfds, 1, 0), 1);
+  EXPECT_EQ(pfds[0].revents, POLLIN);
+
+  CloseWriteEnd();
+  ASSERT_EQ(poll(pfds, 1, 0), 1);
+  EXPECT_EQ(pfds[0].revents, POLLIN | POLLHUP);
+}
+
+// Tests that poll times out if the pipe does not become ready.
+TEST_F(TrustedPipeTest, PollTimeout) {
+  struct pollfd pfd = {fds_[0], POLLIN, 0};
+  EXPECT_EQ(poll(&pfd, 1, 10), 0);
+  EXPECT_EQ(pfd.revents, 0);
+}
+
+// Tests that a thread waiting in poll is woken up by a write from another
+// thread.
+TEST_F(TrustedPipeTest, PollWakeup) {
+  std::thread writer([this] {
+    char c = 'a';
+    EXPECT_EQ(write(fds_[1], &c, 1), 1);
+  });
+  struct pollfd pfd = {fds_[0], POLLIN, 0};
+  EXPECT_EQ(poll(&pfd, 1, -1), 1);
+  EXPECT_EQ(pfd.revents, POLLIN);
+  writer.join();
+}
+
+// Tests that host pipes are still available and can be polled together with
+// pipes inside the enclave.
+TEST_F(TrustedPipeTest, PollWithHostPipe) {
+  int host_fds[2];
+  ASSERT_EQ(io::IOManager::GetInstance().HostPipe(host_fds), 0);
+
+  char c = 'a';
+  ASSERT_EQ(write(host_fds[1], &c, 1), 1);
+  struct pollfd pfds[2] = {{fds_[0], POLLIN, 0}, {host_fds[0], POLLIN, 0}};
+  ASSERT_EQ(poll(pfds, 2, -1), 1);
+  EXPECT_EQ(pfds[0].revents, 0);
+  EXPECT_EQ(pfds[1].revents, POLLIN);
+  ASSERT_EQ(read(host_fds[0], &c, 1), 1);
+
+  std::thread writer([this] {
+    char c = 'b';
+    EXPECT_EQ(write(fds_[1], &c, 1), 1);
+  });
+  ASSERT_EQ(poll(pfds, 2, -1), 1);
+  EXPECT_EQ(pfds[0].revents, POLLIN);
+  EXPECT_EQ(pfds[1].revents, 0);
+  writer.join();
+
+  close(host_fds[0]);
+  close(host_fds[1]);
+}
+
+}  // namespace
+}  // namespace asylo
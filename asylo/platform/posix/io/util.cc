@@ -15,29 +15,30 @@
  * limitations under the License.
  *
  */
-
 #include "asylo/platform/posix/io/util.h"
 
-#include <vector>
+#include <string.h>
 
-#include "absl/strings/str_cat.h"
-#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
 
 namespace asylo {
 namespace io {
 namespace util {
+namespace {
 
-std::string NormalizePath(absl::string_view path) {
-  // Collects the current view of the directories in the path.
-  std::vector<absl::string_view> directories;
-
+// Appends the directories in |path| to the normalized path of |*length| bytes
+// in |buffer|, which holds |size| bytes, and updates |*length|. Returns false
+// if the result does not fit in |buffer| with a terminating NUL.
+bool AppendNormalizedPath(absl::string_view path, char *buffer, size_t size,
+                          size_t *length) {
   // Scan through the path, finding the directories.
   size_t current_directory = 0;
   while (current_directory < path.size()) {
     // Extract the next directory name.
     size_t next_directory = path.find_first_of('/', current_directory);
-    if (next_directory == std::string::npos) next_directory = path.size();
+    if (next_directory == absl::string_view::npos) {
+      next_directory = path.size();
+    }
     absl::string_view name =
         path.substr(current_directory, next_directory - current_directory);
 
@@ -47,18 +48,47 @@ std::string NormalizePath(absl::string_view path) {
     // If the directory name is empty or ".", leave it out entirely.
     if (name.empty() || name == ".") continue;
 
-    // If the directory name is "..", back up by one.
+    // If the directory name is "..", back up to the previous "/". If already
+    // at the root, stay at the root.
     if (name == "..") {
-      // If already at the root, stay at the root.
-      if (!directories.empty()) directories.pop_back();
+      while (*length > 0 && buffer[--*length] != '/') {
+      }
       continue;
     }
 
-    // Otherwise, keep track of this directory.
-    directories.push_back(name);
+    // Otherwise, append "/" and the directory name.
+    if (*length + name.size() + 2 > size) {
+      return false;
+    }
+    buffer[(*length)++] = '/';
+    memcpy(buffer + *length, name.data(), name.size());
+    *length += name.size();
   }
+  return true;
+}
 
-  return absl::StrCat("/", absl::StrJoin(directories, "/"));
+}  // namespace
+
+std::string NormalizePath(absl::string_view path) {
+  // The normalized path is at most one character longer than |path|.
+  std::string normalized(path.size() + 2, '\0');
+  normalized.resize(NormalizePath(/*base=*/"", path, &normalized[0],
+                                  normalized.size()));
+  return normalized;
+}
+
+size_t NormalizePath(absl::string_view base, absl::string_view path,
+                     char *buffer, size_t size) {
+  size_t length = 0;
+  if (size < 2 || !AppendNormalizedPath(base, buffer, size, &length) ||
+      !AppendNormalizedPath(path, buffer, size, &length)) {
+    return 0;
+  }
+  if (length == 0) {
+    buffer[length++] = '/';
+  }
+  buffer[length] = '\0';
+  return length;
 }
 
 }  // namespace util
@@ -19,6 +19,9 @@
 #ifndef ASYLO_PLATFORM_POSIX_IO_UTIL_H_
 #define ASYLO_PLATFORM_POSIX_IO_UTIL_H_
 
+#include <cstddef>
+#include <string>
+
 #include "absl/strings/string_view.h"
 
 namespace asylo {
@@ -27,6 +30,13 @@ namespace util {
 
 std::string NormalizePath(absl::string_view path);
 
+// Normalizes |path| as NormalizePath() does, resolving it relative to the
+// directory |base| if |base| is not empty, and stores the NUL-terminated result
+// in |buffer|, which holds |size| bytes. Does not allocate memory. Returns the
+// length of the normalized path, or 0 if it does not fit in |buffer|.
+size_t NormalizePath(absl::string_view base, absl::string_view path,
+                     char *buffer, size_t size);
+
 }  // namespace util
 }  // namespace io
 }  // namespace asylo
@@ -16,6 +16,7 @@
  *
  */
 
+#include <errno.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -248,5 +249,45 @@ TEST_F(VirtualHandlerTest, SiblingMatch) {
   DeregisterVirtualPathHandler(path2);
 }
 
+TEST_F(VirtualHandlerTest, NormalizedPathMatch) {
+  const std::string path1 = "/test/dummy";
+  const std::string path2 = "/test/dummy/nested";
+  const std::string label1 = "NormalizedPathMatch1";
+  const std::string label2 = "NormalizedPathMatch2";
+
+  // Register handlers in increasing order of prefix length.
+  RegisterVirtualPathHandler(path1, label1);
+  RegisterVirtualPathHandler(path2, label2);
+
+  // Verify the handler is chosen for the normalized path.
+  StatusOr<std::string> result_or_error =
+      Read("//test/./dummy/../dummy/nested/file");
+  ASSERT_TRUE(result_or_error.ok());
+  EXPECT_EQ(result_or_error.ValueOrDie(), label2);
+  result_or_error = Read("/test/dummy/nested/../file");
+  ASSERT_TRUE(result_or_error.ok());
+  EXPECT_EQ(result_or_error.ValueOrDie(), label1);
+
+  // Cleanup registered handlers.
+  DeregisterVirtualPathHandler(path1);
+  DeregisterVirtualPathHandler(path2);
+}
+
+TEST_F(VirtualHandlerTest, PathTooLong) {
+  const std::string path = "/test/dummy";
+  const std::string label = "PathTooLong";
+
+  // Register a handler.
+  RegisterVirtualPathHandler(path, label);
+
+  // Verify that paths longer than PATH_MAX on Linux are rejected.
+  std::string long_path = absl::StrCat(path, "/", std::string(4096, 'a'));
+  EXPECT_EQ(open(long_path.c_str(), O_RDONLY), -1);
+  EXPECT_EQ(errno, ENAMETOOLONG);
+
+  // Cleanup registered handler.
+  DeregisterVirtualPathHandler(path);
+}
+
 }  // namespace
 }  // namespace asylo
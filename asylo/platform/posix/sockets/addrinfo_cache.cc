@@ -0,0 +1,192 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/posix/sockets/addrinfo_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <iterator>
+#include <utility>
+
+#include "asylo/platform/common/bridge_proto_serializer.h"
+
+namespace asylo {
+namespace {
+
+// The number of results cached by getaddrinfo() inside the enclave.
+constexpr size_t kAddrinfoCacheSize = 64;
+
+// The time for which getaddrinfo() results are cached inside the enclave.
+constexpr absl::Duration kAddrinfoCacheTtl = absl::Seconds(30);
+
+// Appends |str| to |key| so that a null string, an empty string and adjacent
+// strings are all distinguishable.
+void AppendString(const char *str, std::string *key) {
+  if (!str) {
+    key->push_back('\0');
+    return;
+  }
+  key->push_back('\1');
+  key->append(str);
+  key->push_back('\0');
+}
+
+// Appends the raw bytes of |value| to |key|.
+void AppendInt(int value, std::string *key) {
+  key->append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// Returns the cache key of a getaddrinfo() query. Only the hint fields that
+// getaddrinfo() reads are part of the key.
+std::string MakeKey(const char *node, const char *service,
+                    const struct addrinfo *hints) {
+  std::string key;
+  AppendString(node, &key);
+  AppendString(service, &key);
+  if (hints) {
+    key.push_back('\1');
+    AppendInt(hints->ai_flags, &key);
+    AppendInt(hints->ai_family, &key);
+    AppendInt(hints->ai_socktype, &key);
+    AppendInt(hints->ai_protocol, &key);
+  } else {
+    key.push_back('\0');
+  }
+  return key;
+}
+
+}  // namespace
+
+struct addrinfo *CopyAddrinfo(const struct addrinfo *in) {
+  struct addrinfo *head = nullptr;
+  struct addrinfo **tail = &head;
+  for (const struct addrinfo *info = in; info != nullptr;
+       info = info->ai_next) {
+    auto *copy =
+        static_cast<struct addrinfo *>(malloc(sizeof(struct addrinfo)));
+    if (!copy) {
+      FreeDeserializedAddrinfo(head);
+      return nullptr;
+    }
+    *copy = *info;
+    copy->ai_addr = nullptr;
+    copy->ai_canonname = nullptr;
+    copy->ai_next = nullptr;
+    *tail = copy;
+    tail = &copy->ai_next;
+
+    if (info->ai_addr) {
+      copy->ai_addr = static_cast<struct sockaddr *>(malloc(info->ai_addrlen));
+      if (!copy->ai_addr) {
+        FreeDeserializedAddrinfo(head);
+        return nullptr;
+      }
+      memcpy(copy->ai_addr, info->ai_addr, info->ai_addrlen);
+    }
+    if (info->ai_canonname) {
+      copy->ai_canonname = strdup(info->ai_canonname);
+      if (!copy->ai_canonname) {
+        FreeDeserializedAddrinfo(head);
+        return nullptr;
+      }
+    }
+  }
+  return head;
+}
+
+AddrinfoCache::AddrinfoCache(size_t max_entries, absl::Duration ttl)
+    : max_entries_(max_entries), ttl_(ttl), hits_(0), misses_(0) {}
+
+AddrinfoCache::~AddrinfoCache() { Clear(); }
+
+bool AddrinfoCache::Lookup(const char *node, const char *service,
+                           const struct addrinfo *hints, absl::Time now,
+                           struct addrinfo **res) {
+  std::string key = MakeKey(node, service, hints);
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (now >= it->second->expiration) {
+    Erase(it->second);
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  struct addrinfo *copy = CopyAddrinfo(it->second->result);
+  if (!copy) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  entries_.splice(entries_.begin(), entries_, it->second);
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  *res = copy;
+  return true;
+}
+
+void AddrinfoCache::Insert(const char *node, const char *service,
+                           const struct addrinfo *hints,
+                           const struct addrinfo *res, absl::Time now) {
+  if (max_entries_ == 0 || !res) {
+    return;
+  }
+  struct addrinfo *copy = CopyAddrinfo(res);
+  if (!copy) {
+    return;
+  }
+
+  std::string key = MakeKey(node, service, hints);
+  absl::MutexLock lock(&mu_);
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    Erase(it->second);
+  }
+  while (entries_.size() >= max_entries_) {
+    Erase(std::prev(entries_.end()));
+  }
+  entries_.push_front(Entry{key, copy, now + ttl_});
+  index_.emplace(std::move(key), entries_.begin());
+}
+
+void AddrinfoCache::Clear() {
+  absl::MutexLock lock(&mu_);
+  while (!entries_.empty()) {
+    Erase(entries_.begin());
+  }
+}
+
+size_t AddrinfoCache::size() const {
+  absl::MutexLock lock(&mu_);
+  return entries_.size();
+}
+
+void AddrinfoCache::Erase(EntryList::iterator it) {
+  FreeDeserializedAddrinfo(it->result);
+  index_.erase(it->key);
+  entries_.erase(it);
+}
+
+AddrinfoCache *GetAddrinfoCache() {
+  static AddrinfoCache *cache =
+      new AddrinfoCache(kAddrinfoCacheSize, kAddrinfoCacheTtl);
+  return cache;
+}
+
+}  // namespace asylo
@@ -0,0 +1,118 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_PLATFORM_POSIX_SOCKETS_ADDRINFO_CACHE_H_
+#define ASYLO_PLATFORM_POSIX_SOCKETS_ADDRINFO_CACHE_H_
+
+#include <netdb.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace asylo {
+
+// A cache of successful getaddrinfo() results, keyed by the node, service and
+// hints of the query. Resolving a name requires a host call and the
+// deserialization of the result into a freshly allocated list, and clients
+// such as gRPC resolve the same few names repeatedly.
+//
+// Entries expire a fixed amount of time after they are inserted, since the
+// host resolver does not report the TTL of the records it returns. When the
+// cache is full, the least recently used entry is evicted.
+//
+// The cache owns its own copy of each list and hands out a new deep copy on
+// every hit, so callers release results with freeaddrinfo() exactly as they
+// would release a list returned by the host call.
+class AddrinfoCache {
+ public:
+  // Creates a cache holding at most |max_entries| results, each for at most
+  // |ttl|. A cache with |max_entries| equal to zero caches nothing.
+  AddrinfoCache(size_t max_entries, absl::Duration ttl);
+  ~AddrinfoCache();
+
+  AddrinfoCache(const AddrinfoCache &) = delete;
+  AddrinfoCache &operator=(const AddrinfoCache &) = delete;
+
+  // Looks up the result of a query at time |now|. On a hit, stores a copy of
+  // the cached list in |res| and returns true. Returns false on a miss, or if
+  // the copy could not be allocated.
+  bool Lookup(const char *node, const char *service,
+              const struct addrinfo *hints, absl::Time now,
+              struct addrinfo **res);
+
+  // Caches a copy of |res| as the result of a query at time |now|, replacing
+  // any existing entry for the same query. |res| remains owned by the caller.
+  void Insert(const char *node, const char *service,
+              const struct addrinfo *hints, const struct addrinfo *res,
+              absl::Time now);
+
+  // Removes all entries. The hit and miss counters are not reset.
+  void Clear();
+
+  // Returns the number of entries in the cache, including expired entries that
+  // have not been evicted yet.
+  size_t size() const;
+
+  // Returns the number of lookups that were satisfied from the cache.
+  uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+
+  // Returns the number of lookups that were not satisfied from the cache.
+  uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+ private:
+  struct Entry {
+    std::string key;
+    struct addrinfo *result;
+    absl::Time expiration;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  // Removes |it| from the cache and frees its result.
+  void Erase(EntryList::iterator it) EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const size_t max_entries_;
+  const absl::Duration ttl_;
+
+  mutable absl::Mutex mu_;
+
+  // Entries ordered from most to least recently used.
+  EntryList entries_ GUARDED_BY(mu_);
+  std::unordered_map<std::string, EntryList::iterator> index_ GUARDED_BY(mu_);
+
+  std::atomic<uint64_t> hits_;
+  std::atomic<uint64_t> misses_;
+};
+
+// Returns a deep copy of the addrinfo list |in| allocated with malloc(), in the
+// layout released by FreeDeserializedAddrinfo(). Returns nullptr if |in| is
+// nullptr or if an allocation fails.
+struct addrinfo *CopyAddrinfo(const struct addrinfo *in);
+
+// Returns the cache used by getaddrinfo() inside the enclave.
+AddrinfoCache *GetAddrinfoCache();
+
+}  // namespace asylo
+
+#endif  // ASYLO_PLATFORM_POSIX_SOCKETS_ADDRINFO_CACHE_H_
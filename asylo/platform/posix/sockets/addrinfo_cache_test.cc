@@ -0,0 +1,206 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/platform/posix/sockets/addrinfo_cache.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "asylo/platform/common/bridge_proto_serializer.h"
+
+namespace asylo {
+namespace {
+
+constexpr absl::Duration kTtl = absl::Seconds(10);
+
+// Returns a list of one IPv4 result per address in |addresses|, with
+// |canonname| set on the first result, in the layout released by
+// FreeDeserializedAddrinfo().
+struct addrinfo *MakeResult(const std::vector<uint32_t> &addresses,
+                            const char *canonname) {
+  struct addrinfo *head = nullptr;
+  struct addrinfo **tail = &head;
+  for (uint32_t address : addresses) {
+    auto *info =
+        static_cast<struct addrinfo *>(calloc(1, sizeof(struct addrinfo)));
+    auto *addr =
+        static_cast<struct sockaddr_in *>(calloc(1, sizeof(sockaddr_in)));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(address);
+    info->ai_family = AF_INET;
+    info->ai_socktype = SOCK_STREAM;
+    info->ai_addrlen = sizeof(*addr);
+    info->ai_addr = reinterpret_cast<struct sockaddr *>(addr);
+    if (!head && canonname) {
+      info->ai_canonname = strdup(canonname);
+    }
+    *tail = info;
+    tail = &info->ai_next;
+  }
+  return head;
+}
+
+// Checks that |actual| is a copy of |expected| sharing no memory with it.
+void ExpectDeepCopy(const struct addrinfo *expected,
+                    const struct addrinfo *actual) {
+  for (; expected && actual;
+       expected = expected->ai_next, actual = actual->ai_next) {
+    EXPECT_NE(expected, actual);
+    EXPECT_EQ(actual->ai_flags, expected->ai_flags);
+    EXPECT_EQ(actual->ai_family, expected->ai_family);
+    EXPECT_EQ(actual->ai_socktype, expected->ai_socktype);
+    EXPECT_EQ(actual->ai_protocol, expected->ai_protocol);
+    ASSERT_EQ(actual->ai_addrlen, expected->ai_addrlen);
+    EXPECT_NE(actual->ai_addr, expected->ai_addr);
+    EXPECT_EQ(memcmp(actual->ai_addr, expected->ai_addr, actual->ai_addrlen),
+              0);
+    if (expected->ai_canonname) {
+      ASSERT_NE(actual->ai_canonname, nullptr);
+      EXPECT_NE(actual->ai_canonname, expected->ai_canonname);
+      EXPECT_STREQ(actual->ai_canonname, expected->ai_canonname);
+    } else {
+      EXPECT_EQ(actual->ai_canonname, nullptr);
+    }
+  }
+  EXPECT_EQ(expected, nullptr);
+  EXPECT_EQ(actual, nullptr);
+}
+
+// Tests that a copied list matches the original and can be freed
+// independently.
+TEST(AddrinfoCacheTest, CopyAddrinfo) {
+  struct addrinfo *original = MakeResult({0x7f000001, 0x0a000001}, "host");
+  struct addrinfo *copy = CopyAddrinfo(original);
+  ExpectDeepCopy(original, copy);
+  FreeDeserializedAddrinfo(original);
+  FreeDeserializedAddrinfo(copy);
+
+  EXPECT_EQ(CopyAddrinfo(nullptr), nullptr);
+}
+
+// Tests that a cached result is returned as a fresh copy on every hit.
+TEST(AddrinfoCacheTest, HitReturnsCopy) {
+  AddrinfoCache cache(4, kTtl);
+  absl::Time now = absl::UnixEpoch();
+  struct addrinfo *res = nullptr;
+  EXPECT_FALSE(cache.Lookup("host", "80", nullptr, now, &res));
+
+  struct addrinfo *original = MakeResult({0x7f000001}, "host");
+  cache.Insert("host", "80", nullptr, original, now);
+
+  struct addrinfo *first = nullptr;
+  struct addrinfo *second = nullptr;
+  ASSERT_TRUE(cache.Lookup("host", "80", nullptr, now, &first));
+  ASSERT_TRUE(cache.Lookup("host", "80", nullptr, now, &second));
+  ExpectDeepCopy(original, first);
+  ExpectDeepCopy(original, second);
+  EXPECT_NE(first, second);
+
+  // The cache does not retain the inserted list or the returned copies.
+  FreeDeserializedAddrinfo(original);
+  FreeDeserializedAddrinfo(first);
+  FreeDeserializedAddrinfo(second);
+  EXPECT_EQ(cache.hits(), 2);
+  EXPECT_EQ(cache.misses(), 1);
+}
+
+// Tests that queries differing in node, service or hints are cached
+// separately.
+TEST(AddrinfoCacheTest, KeyIncludesQuery) {
+  AddrinfoCache cache(8, kTtl);
+  absl::Time now = absl::UnixEpoch();
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+
+  struct addrinfo *result = MakeResult({1}, nullptr);
+  cache.Insert("host", "80", &hints, result, now);
+  FreeDeserializedAddrinfo(result);
+
+  struct addrinfo *res = nullptr;
+  EXPECT_FALSE(cache.Lookup("host", "443", &hints, now, &res));
+  EXPECT_FALSE(cache.Lookup("other", "80", &hints, now, &res));
+  EXPECT_FALSE(cache.Lookup("host", "80", nullptr, now, &res));
+  EXPECT_FALSE(cache.Lookup(nullptr, "80", &hints, now, &res));
+  EXPECT_FALSE(cache.Lookup("", "80", &hints, now, &res));
+  hints.ai_socktype = SOCK_DGRAM;
+  EXPECT_FALSE(cache.Lookup("host", "80", &hints, now, &res));
+  hints.ai_socktype = 0;
+
+  // Fields that getaddrinfo() ignores in the hints do not affect the key.
+  hints.ai_addrlen = 16;
+  ASSERT_TRUE(cache.Lookup("host", "80", &hints, now, &res));
+  FreeDeserializedAddrinfo(res);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 6);
+}
+
+// Tests that entries expire after the TTL.
+TEST(AddrinfoCacheTest, EntriesExpire) {
+  AddrinfoCache cache(4, kTtl);
+  absl::Time now = absl::UnixEpoch();
+  struct addrinfo *result = MakeResult({1}, nullptr);
+  cache.Insert("host", nullptr, nullptr, result, now);
+  FreeDeserializedAddrinfo(result);
+
+  struct addrinfo *res = nullptr;
+  ASSERT_TRUE(cache.Lookup("host", nullptr, nullptr,
+                           now + kTtl - absl::Nanoseconds(1), &res));
+  FreeDeserializedAddrinfo(res);
+  EXPECT_FALSE(cache.Lookup("host", nullptr, nullptr, now + kTtl, &res));
+  EXPECT_EQ(cache.size(), 0);
+}
+
+// Tests that the least recently used entry is evicted when the cache is full.
+TEST(AddrinfoCacheTest, EvictsLeastRecentlyUsed) {
+  AddrinfoCache cache(2, kTtl);
+  absl::Time now = absl::UnixEpoch();
+  struct addrinfo *result = MakeResult({1}, nullptr);
+  cache.Insert("a", nullptr, nullptr, result, now);
+  cache.Insert("b", nullptr, nullptr, result, now);
+
+  struct addrinfo *res = nullptr;
+  ASSERT_TRUE(cache.Lookup("a", nullptr, nullptr, now, &res));
+  FreeDeserializedAddrinfo(res);
+
+  cache.Insert("c", nullptr, nullptr, result, now);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_FALSE(cache.Lookup("b", nullptr, nullptr, now, &res));
+  ASSERT_TRUE(cache.Lookup("a", nullptr, nullptr, now, &res));
+  FreeDeserializedAddrinfo(res);
+  ASSERT_TRUE(cache.Lookup("c", nullptr, nullptr, now, &res));
+  FreeDeserializedAddrinfo(res);
+
+  // Reinserting a query replaces its entry.
+  cache.Insert("c", nullptr, nullptr, result, now);
+  EXPECT_EQ(cache.size(), 2);
+  FreeDeserializedAddrinfo(result);
+
+  // A cache without capacity caches nothing.
+  AddrinfoCache empty(0, kTtl);
+  result = MakeResult({1}, nullptr);
+  empty.Insert("a", nullptr, nullptr, result, now);
+  FreeDeserializedAddrinfo(result);
+  EXPECT_EQ(empty.size(), 0);
+}
+
+}  // namespace
+}  // namespace asylo
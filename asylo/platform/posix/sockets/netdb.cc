@@ -19,7 +19,9 @@
 #include <netdb.h>
 #include <stdlib.h>
 
+#include "absl/time/clock.h"
 #include "asylo/platform/arch/include/trusted/host_calls.h"
+#include "asylo/platform/posix/sockets/addrinfo_cache.h"
 
 extern "C" {
 
@@ -28,7 +30,16 @@ const char *gai_strerror(int ecode) { abort(); }
 
 int getaddrinfo(const char *node, const char *service,
                 const struct addrinfo *hints, struct addrinfo **res) {
-  return enc_untrusted_getaddrinfo(node, service, hints, res);
+  asylo::AddrinfoCache *cache = asylo::GetAddrinfoCache();
+  absl::Time now = absl::Now();
+  if (cache->Lookup(node, service, hints, now, res)) {
+    return 0;
+  }
+  int ret = enc_untrusted_getaddrinfo(node, service, hints, res);
+  if (ret == 0) {
+    cache->Insert(node, service, hints, *res, now);
+  }
+  return ret;
 }
 
 void freeaddrinfo(struct addrinfo *res) {
@@ -18,6 +18,7 @@
 
 #include <sys/socket.h>
 
+#include <errno.h>
 #include <stdlib.h>
 
 #include "asylo/platform/arch/include/trusted/host_calls.h"
@@ -49,7 +50,9 @@ int socket(int domain, int type, int protocol) {
   return IOManager::GetInstance().Socket(domain, type, protocol);
 }
 
-ssize_t recv(int sockfd, void *buf, size_t len, int flags) { abort(); }
+ssize_t recv(int sockfd, void *buf, size_t len, int flags) {
+  return recvfrom(sockfd, buf, len, flags, nullptr, nullptr);
+}
 
 int getsockopt(int sockfd, int level, int optname, void *optval,
                socklen_t *optlen) {
@@ -77,6 +80,30 @@ ssize_t recvmsg(int sockfd, struct msghdr *msg, int flags) {
   return IOManager::GetInstance().RecvMsg(sockfd, msg, flags);
 }
 
+int sendmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen,
+             int flags) {
+  return IOManager::GetInstance().SendMMsg(sockfd, msgvec, vlen, flags);
+}
+
+int recvmmsg(int sockfd, struct mmsghdr *msgvec, unsigned int vlen, int flags,
+             struct timespec *timeout) {
+  return IOManager::GetInstance().RecvMMsg(sockfd, msgvec, vlen, flags,
+                                           timeout);
+}
+
+ssize_t sendto(int sockfd, const void *buf, size_t len, int flags,
+               const struct sockaddr *dest_addr, socklen_t addrlen) {
+  struct iovec iov;
+  iov.iov_base = const_cast<void *>(buf);
+  iov.iov_len = len;
+  struct msghdr msg = {};
+  msg.msg_name = const_cast<struct sockaddr *>(dest_addr);
+  msg.msg_namelen = dest_addr ? addrlen : 0;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  return IOManager::GetInstance().SendMsg(sockfd, &msg, flags);
+}
+
 int getsockname(int sockfd, struct sockaddr *addr, socklen_t *addrlen) {
   return IOManager::GetInstance().GetSockName(sockfd, addr, addrlen);
 }
@@ -89,7 +116,23 @@ in_addr_t inet_addr(const char *cp) { abort(); }
 
 ssize_t recvfrom(int socket, void *buffer, size_t length, int flags,
                  struct sockaddr *address, socklen_t *address_len) {
-  abort();
+  if (address && !address_len) {
+    errno = EFAULT;
+    return -1;
+  }
+  struct iovec iov;
+  iov.iov_base = buffer;
+  iov.iov_len = length;
+  struct msghdr msg = {};
+  msg.msg_name = address;
+  msg.msg_namelen = address ? *address_len : 0;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  ssize_t ret = IOManager::GetInstance().RecvMsg(socket, &msg, flags);
+  if (ret >= 0 && address) {
+    *address_len = msg.msg_namelen;
+  }
+  return ret;
 }
 
 struct servent *getservbyport(int port, const char *proto) {
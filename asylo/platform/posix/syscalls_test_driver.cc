@@ -759,6 +759,58 @@ TEST_F(SyscallsTest, Readv) {
       RunSyscallInsideEnclave("readv", FLAGS_test_tmpdir + "/readv", nullptr));
 }
 
+// Tests pread() and pwrite() by overwriting and reading back part of a file at
+// explicit offsets, and checking that the file offset does not change.
+TEST_F(SyscallsTest, PreadPwrite) {
+  EXPECT_TRUE(RunSyscallInsideEnclave(
+      "pread pwrite", FLAGS_test_tmpdir + "/pread_pwrite", nullptr));
+}
+
+// Tests preadv() and pwritev() by writing a scattered array at an offset and
+// reading it back to a scattered array, and checking that the file offset does
+// not change.
+TEST_F(SyscallsTest, PreadvPwritev) {
+  EXPECT_TRUE(RunSyscallInsideEnclave(
+      "preadv pwritev", FLAGS_test_tmpdir + "/preadv_pwritev", nullptr));
+}
+
+// Tests pread() and pwrite() on a secure file, including an overwrite inside
+// the file, which must not change its size.
+TEST_F(SyscallsTest, SecurePreadPwrite) {
+  EXPECT_TRUE(RunSyscallInsideEnclave(
+      "pread pwrite secure", FLAGS_test_tmpdir + "/secure_pread_pwrite",
+      nullptr));
+}
+
+// Tests preadv() and pwritev() on a secure file, including an overwrite inside
+// the file, which must not change its size.
+TEST_F(SyscallsTest, SecurePreadvPwritev) {
+  EXPECT_TRUE(RunSyscallInsideEnclave(
+      "preadv pwritev secure", FLAGS_test_tmpdir + "/secure_preadv_pwritev",
+      nullptr));
+}
+
+// Tests sendfile() by transferring data between two files, both from an
+// explicit offset and from the file offset of the input file.
+TEST_F(SyscallsTest, SendFile) {
+  EXPECT_TRUE(RunSyscallInsideEnclave("sendfile",
+                                      FLAGS_test_tmpdir + "/sendfile", nullptr));
+}
+
+// Tests sendfile() between a file and a pipe implemented inside the enclave,
+// which copies the data through trusted memory.
+TEST_F(SyscallsTest, SendFilePipe) {
+  EXPECT_TRUE(RunSyscallInsideEnclave(
+      "sendfile pipe", FLAGS_test_tmpdir + "/sendfile_pipe", nullptr));
+}
+
+// Tests sendmmsg() and recvmmsg() by sending a batch of datagrams to a UDP
+// socket and receiving them, and sendto() and recvfrom() with a single
+// datagram.
+TEST_F(SyscallsTest, SendMMsgRecvMMsg) {
+  EXPECT_TRUE(RunSyscallInsideEnclave("sendmmsg recvmmsg", "", nullptr));
+}
+
 // Tests getrlimit() and setrlimit() with RLIMIT_NOFILE by setting the limit and
 // getting it to compare the result.
 TEST_F(SyscallsTest, RlimitNoFile) {
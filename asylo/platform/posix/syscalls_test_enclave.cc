@@ -16,17 +16,23 @@
  *
  */
 
+#include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <ifaddrs.h>
+#include <netinet/in.h>
 #include <regex.h>
 #include <sched.h>
 #include <stdio.h>
 #include <sys/resource.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
 #include <sys/uio.h>
 #include <unistd.h>
 #include <algorithm>
+#include <string>
 #include <unordered_set>
+#include <vector>
 
 #include "absl/strings/str_cat.h"
 #include "asylo/util/logging.h"
@@ -105,6 +111,20 @@ class SyscallsEnclave : public EnclaveTestCase {
       return RunWritevTest(test_input.path_name());
     } else if (test_input.test_target() == "readv") {
       return RunReadvTest(test_input.path_name());
+    } else if (test_input.test_target() == "pread pwrite") {
+      return RunPreadPwriteTest(test_input.path_name(), 0);
+    } else if (test_input.test_target() == "pread pwrite secure") {
+      return RunPreadPwriteTest(test_input.path_name(), O_SECURE);
+    } else if (test_input.test_target() == "preadv pwritev") {
+      return RunPreadvPwritevTest(test_input.path_name(), 0);
+    } else if (test_input.test_target() == "preadv pwritev secure") {
+      return RunPreadvPwritevTest(test_input.path_name(), O_SECURE);
+    } else if (test_input.test_target() == "sendfile") {
+      return RunSendFileTest(test_input.path_name());
+    } else if (test_input.test_target() == "sendfile pipe") {
+      return RunSendFilePipeTest(test_input.path_name());
+    } else if (test_input.test_target() == "sendmmsg recvmmsg") {
+      return RunSendMMsgRecvMMsgTest();
     } else if (test_input.test_target() == "rlimit nofile") {
       return RunRlimitNoFileTest(test_input.path_name());
     } else if (test_input.test_target() == "rlimit low nofile") {
@@ -915,6 +935,410 @@ class SyscallsEnclave : public EnclaveTestCase {
     return Status::OkStatus();
   }
 
+  // Returns an error if the file offset of |fd| is not |expected_offset|.
+  Status CheckFileOffset(int fd, off_t expected_offset) {
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset != expected_offset) {
+      return Status(error::GoogleError::INTERNAL,
+                    absl::StrCat("File offset of fd:", fd, " is ", offset,
+                                 ", expected ", expected_offset));
+    }
+    return Status::OkStatus();
+  }
+
+  // Overwrites |data| at |offset| inside the file |fd|, with pwritev() if
+  // |vectored| is true and pwrite() otherwise, and checks that the file keeps
+  // its size and reads back in full. |contents| holds the contents of the file
+  // and is updated to match.
+  Status CheckOverwrite(int fd, off_t offset, const std::string &data,
+                        bool vectored, std::string *contents) {
+    struct stat before;
+    if (fstat(fd, &before) != 0) {
+      return Status(static_cast<error::PosixError>(errno), "fstat failed");
+    }
+
+    ssize_t rc;
+    if (vectored) {
+      struct iovec iov[2];
+      iov[0].iov_base = const_cast<char *>(data.data());
+      iov[0].iov_len = data.size() / 2;
+      iov[1].iov_base = const_cast<char *>(data.data()) + iov[0].iov_len;
+      iov[1].iov_len = data.size() - iov[0].iov_len;
+      rc = pwritev(fd, iov, 2, offset);
+    } else {
+      rc = pwrite(fd, data.data(), data.size(), offset);
+    }
+    if (rc != data.size()) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("Overwrite returned:", rc, " instead of ",
+                                 data.size()));
+    }
+    contents->replace(offset, data.size(), data);
+
+    struct stat after;
+    if (fstat(fd, &after) != 0) {
+      return Status(static_cast<error::PosixError>(errno), "fstat failed");
+    }
+    if (after.st_size != before.st_size) {
+      return Status(error::GoogleError::INTERNAL,
+                    absl::StrCat("Overwrite changed the file size from ",
+                                 before.st_size, " to ", after.st_size));
+    }
+
+    // Ask for one byte more than the file holds to check where it ends.
+    std::string buf(contents->size() + 1, '\0');
+    rc = pread(fd, &buf[0], buf.size(), 0);
+    if (rc != contents->size()) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("pread of the whole file returned:", rc,
+                                 " instead of ", contents->size()));
+    }
+    buf.resize(rc);
+    if (buf != *contents) {
+      return Status(error::GoogleError::INTERNAL,
+                    "File contents after the overwrite do not match.");
+    }
+    return Status::OkStatus();
+  }
+
+  Status RunPreadPwriteTest(const std::string &path, int extra_flags) {
+    auto fd_or_error = OpenFile(path, O_CREAT | O_RDWR | extra_flags, 0644);
+    if (!fd_or_error.ok()) {
+      return fd_or_error.status();
+    }
+    int fd = fd_or_error.ValueOrDie();
+    platform::storage::FdCloser fd_closer(fd);
+    const std::string message = "0123456789";
+    ssize_t rc = write(fd, message.c_str(), message.size());
+    if (rc != message.size()) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Bytes written to file does not match message size");
+    }
+
+    rc = pwrite(fd, "abc", 3, 2);
+    if (rc != 3) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("pwrite return:", rc, " does not match 3"));
+    }
+    Status status = CheckFileOffset(fd, message.size());
+    if (!status.ok()) {
+      return status;
+    }
+
+    char buf[5];
+    rc = pread(fd, buf, sizeof(buf), 1);
+    if (rc != sizeof(buf)) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("pread return:", rc, " does not match ",
+                                 sizeof(buf)));
+    }
+    if (memcmp(buf, "1abc5", sizeof(buf)) != 0) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Data from pread does not match the expected data.");
+    }
+    status = CheckFileOffset(fd, message.size());
+    if (!status.ok()) {
+      return status;
+    }
+
+    if (pread(fd, buf, sizeof(buf), -1) != -1 || errno != EINVAL) {
+      return Status(error::GoogleError::INTERNAL,
+                    "pread with a negative offset did not fail with EINVAL");
+    }
+
+    // Grow the file over several blocks, then overwrite a range in the middle.
+    std::string contents = "01abc56789";
+    std::string tail(8192, 'x');
+    rc = pwrite(fd, tail.data(), tail.size(), contents.size());
+    if (rc != tail.size()) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("pwrite return:", rc, " does not match ",
+                                 tail.size()));
+    }
+    contents += tail;
+    status = CheckOverwrite(fd, 1000, "overwrite", /*vectored=*/false,
+                            &contents);
+    if (!status.ok()) {
+      return status;
+    }
+    return CheckFileOffset(fd, message.size());
+  }
+
+  Status RunPreadvPwritevTest(const std::string &path, int extra_flags) {
+    auto fd_or_error = OpenFile(path, O_CREAT | O_RDWR | extra_flags, 0644);
+    if (!fd_or_error.ok()) {
+      return fd_or_error.status();
+    }
+    int fd = fd_or_error.ValueOrDie();
+    platform::storage::FdCloser fd_closer(fd);
+    constexpr int num_messages = 2;
+    constexpr off_t offset = 4;
+    const std::string message1 = "First pwritev message";
+    const std::string message2 = "Second pwritev message";
+    const std::string message = message1 + message2;
+    struct iovec iov[num_messages];
+    memset(iov, 0, sizeof(iov));
+    iov[0].iov_base = const_cast<char *>(message1.c_str());
+    iov[1].iov_base = const_cast<char *>(message2.c_str());
+    iov[0].iov_len = message1.size();
+    iov[1].iov_len = message2.size();
+    ssize_t rc = pwritev(fd, iov, num_messages, offset);
+    if (rc != message.size()) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("pwritev return:", rc,
+                                 " does not match message size:",
+                                 message.size()));
+    }
+    Status status = CheckFileOffset(fd, 0);
+    if (!status.ok()) {
+      return status;
+    }
+
+    char buf1[message1.size()];
+    char buf2[message2.size()];
+    iov[0].iov_base = reinterpret_cast<void *>(buf1);
+    iov[1].iov_base = reinterpret_cast<void *>(buf2);
+    rc = preadv(fd, iov, num_messages, offset);
+    if (rc != message.size()) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("preadv return:", rc,
+                                 " does not match message size:",
+                                 message.size()));
+    }
+    if (memcmp(buf1, message1.c_str(), message1.size()) ||
+        memcmp(buf2, message2.c_str(), message2.size())) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Messages from preadv do not match the expected message.");
+    }
+
+    std::string contents = std::string(offset, '\0') + message;
+    status = CheckOverwrite(fd, offset + 6, "overwrite", /*vectored=*/true,
+                            &contents);
+    if (!status.ok()) {
+      return status;
+    }
+    return CheckFileOffset(fd, 0);
+  }
+
+  Status RunSendFileTest(const std::string &path) {
+    auto in_fd_or_error = OpenFile(path + "_in", O_CREAT | O_RDWR, 0644);
+    if (!in_fd_or_error.ok()) {
+      return in_fd_or_error.status();
+    }
+    int in_fd = in_fd_or_error.ValueOrDie();
+    platform::storage::FdCloser in_fd_closer(in_fd);
+    auto out_fd_or_error = OpenFile(path + "_out", O_CREAT | O_RDWR, 0644);
+    if (!out_fd_or_error.ok()) {
+      return out_fd_or_error.status();
+    }
+    int out_fd = out_fd_or_error.ValueOrDie();
+    platform::storage::FdCloser out_fd_closer(out_fd);
+
+    const std::string message = "sendfile message";
+    ssize_t rc = write(in_fd, message.c_str(), message.size());
+    if (rc != message.size()) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Bytes written to file does not match message size");
+    }
+
+    // Transfer from an explicit offset, which leaves the file offset of
+    // |in_fd| unchanged.
+    off_t offset = 2;
+    rc = sendfile(out_fd, in_fd, &offset, message.size());
+    if (rc != message.size() - 2 || offset != message.size()) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("sendfile with offset returned:", rc,
+                                 " and updated offset to:", offset));
+    }
+    Status status = CheckFileOffset(in_fd, message.size());
+    if (!status.ok()) {
+      return status;
+    }
+
+    // Transfer from the file offset of |in_fd|, which advances it.
+    if (lseek(in_fd, 0, SEEK_SET) != 0) {
+      return Status(static_cast<error::PosixError>(errno), "lseek failed");
+    }
+    rc = sendfile(out_fd, in_fd, nullptr, message.size());
+    if (rc != message.size()) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("sendfile returned:", rc));
+    }
+    status = CheckFileOffset(in_fd, message.size());
+    if (!status.ok()) {
+      return status;
+    }
+
+    const std::string expected = message.substr(2) + message;
+    std::string buf(expected.size(), '\0');
+    rc = pread(out_fd, &buf[0], buf.size(), 0);
+    if (rc != expected.size() || buf != expected) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Data transferred by sendfile does not match the expected "
+                    "data.");
+    }
+    return Status::OkStatus();
+  }
+
+  Status RunSendFilePipeTest(const std::string &path) {
+    auto fd_or_error = OpenFile(path, O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (!fd_or_error.ok()) {
+      return fd_or_error.status();
+    }
+    int fd = fd_or_error.ValueOrDie();
+    platform::storage::FdCloser fd_closer(fd);
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+      return Status(static_cast<error::PosixError>(errno), "pipe failed");
+    }
+    platform::storage::FdCloser read_fd_closer(pipe_fds[0]);
+    platform::storage::FdCloser write_fd_closer(pipe_fds[1]);
+
+    const std::string message = "sendfile pipe message";
+    ssize_t rc = write(fd, message.c_str(), message.size());
+    if (rc != static_cast<ssize_t>(message.size())) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Bytes written to file does not match message size");
+    }
+
+    // Transfer from the file to the pipe inside the enclave.
+    off_t offset = 0;
+    rc = sendfile(pipe_fds[1], fd, &offset, message.size());
+    if (rc != static_cast<ssize_t>(message.size()) ||
+        offset != static_cast<off_t>(message.size())) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("sendfile to pipe returned:", rc,
+                                 " and updated offset to:", offset));
+    }
+    std::string buf(message.size(), '\0');
+    rc = read(pipe_fds[0], &buf[0], buf.size());
+    if (rc != static_cast<ssize_t>(buf.size()) || buf != message) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Data read from the pipe does not match the message");
+    }
+
+    // Transfer from the pipe back to the file. The transfer stops at the end
+    // of the pipe, before |count| bytes.
+    rc = write(pipe_fds[1], message.c_str(), message.size());
+    if (rc != static_cast<ssize_t>(message.size())) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Bytes written to pipe does not match message size");
+    }
+    close(pipe_fds[1]);
+    write_fd_closer.release();
+    if (lseek(fd, 0, SEEK_SET) != 0) {
+      return Status(static_cast<error::PosixError>(errno), "lseek failed");
+    }
+    rc = sendfile(fd, pipe_fds[0], nullptr, 2 * message.size());
+    if (rc != static_cast<ssize_t>(message.size())) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("sendfile from pipe returned:", rc));
+    }
+    buf.assign(message.size(), '\0');
+    rc = pread(fd, &buf[0], buf.size(), 0);
+    if (rc != static_cast<ssize_t>(buf.size()) || buf != message) {
+      return Status(error::GoogleError::INTERNAL,
+                    "Data transferred from the pipe does not match the "
+                    "message");
+    }
+    return Status::OkStatus();
+  }
+
+  Status RunSendMMsgRecvMMsgTest() {
+    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sockfd < 0) {
+      return Status(static_cast<error::PosixError>(errno), "socket failed");
+    }
+    platform::storage::FdCloser fd_closer(sockfd);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(sockfd, reinterpret_cast<struct sockaddr *>(&addr), addr_len) !=
+            0 ||
+        getsockname(sockfd, reinterpret_cast<struct sockaddr *>(&addr),
+                    &addr_len) != 0) {
+      return Status(static_cast<error::PosixError>(errno), "bind failed");
+    }
+
+    // Send a batch of datagrams to the socket itself.
+    constexpr int kNumMessages = 4;
+    std::vector<std::string> messages;
+    std::vector<struct iovec> iovs(kNumMessages);
+    std::vector<struct mmsghdr> msgvec(kNumMessages);
+    for (int i = 0; i < kNumMessages; ++i) {
+      messages.push_back(absl::StrCat("datagram ", i));
+      iovs[i].iov_base = const_cast<char *>(messages[i].data());
+      iovs[i].iov_len = messages[i].size();
+      memset(&msgvec[i], 0, sizeof(msgvec[i]));
+      msgvec[i].msg_hdr.msg_name = &addr;
+      msgvec[i].msg_hdr.msg_namelen = addr_len;
+      msgvec[i].msg_hdr.msg_iov = &iovs[i];
+      msgvec[i].msg_hdr.msg_iovlen = 1;
+    }
+    int ret = sendmmsg(sockfd, msgvec.data(), kNumMessages, 0);
+    if (ret != kNumMessages) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("sendmmsg returned:", ret));
+    }
+    for (int i = 0; i < kNumMessages; ++i) {
+      if (msgvec[i].msg_len != messages[i].size()) {
+        return Status(error::GoogleError::INTERNAL,
+                      "sendmmsg reported an unexpected message length");
+      }
+    }
+
+    // Receive the batch, and check the payloads and source addresses.
+    std::vector<std::vector<char>> buffers(kNumMessages,
+                                           std::vector<char>(64));
+    std::vector<struct sockaddr_in> sources(kNumMessages);
+    for (int i = 0; i < kNumMessages; ++i) {
+      iovs[i].iov_base = buffers[i].data();
+      iovs[i].iov_len = buffers[i].size();
+      memset(&msgvec[i], 0, sizeof(msgvec[i]));
+      msgvec[i].msg_hdr.msg_name = &sources[i];
+      msgvec[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+      msgvec[i].msg_hdr.msg_iov = &iovs[i];
+      msgvec[i].msg_hdr.msg_iovlen = 1;
+    }
+    ret = recvmmsg(sockfd, msgvec.data(), kNumMessages, 0, nullptr);
+    if (ret != kNumMessages) {
+      return Status(static_cast<error::PosixError>(errno),
+                    absl::StrCat("recvmmsg returned:", ret));
+    }
+    for (int i = 0; i < kNumMessages; ++i) {
+      if (std::string(buffers[i].data(), msgvec[i].msg_len) != messages[i]) {
+        return Status(error::GoogleError::INTERNAL,
+                      "Datagram from recvmmsg does not match the message sent");
+      }
+      if (msgvec[i].msg_hdr.msg_namelen != addr_len ||
+          sources[i].sin_port != addr.sin_port) {
+        return Status(error::GoogleError::INTERNAL,
+                      "Source address from recvmmsg does not match");
+      }
+    }
+
+    // Check the single-message path with sendto and recvfrom.
+    const std::string message = "single datagram";
+    if (sendto(sockfd, message.data(), message.size(), 0,
+               reinterpret_cast<struct sockaddr *>(&addr),
+               addr_len) != message.size()) {
+      return Status(static_cast<error::PosixError>(errno), "sendto failed");
+    }
+    char buf[64];
+    struct sockaddr_in source = {};
+    socklen_t source_len = sizeof(source);
+    ssize_t rc = recvfrom(sockfd, buf, sizeof(buf), 0,
+                          reinterpret_cast<struct sockaddr *>(&source),
+                          &source_len);
+    if (rc != message.size() || std::string(buf, rc) != message ||
+        source_len != addr_len || source.sin_port != addr.sin_port) {
+      return Status(static_cast<error::PosixError>(errno),
+                    "recvfrom did not return the datagram sent");
+    }
+    return Status::OkStatus();
+  }
+
   Status RunRlimitNoFileTest(const std::string &path) {
     constexpr int soft_limit = 100;
     constexpr int hard_limit = 200;
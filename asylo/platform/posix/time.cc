@@ -25,13 +25,19 @@
 #include "asylo/platform/arch/include/trusted/host_calls.h"
 #include "asylo/platform/arch/include/trusted/time.h"
 #include "asylo/platform/common/time_util.h"
+#include "asylo/platform/common/tsc_clock.h"
 #include "asylo/platform/core/shared_name.h"
 #include "common/inc/sgx_trts.h"
 
 using asylo::NanosecondsToTimeSpec;
+using asylo::MonotonicClockGuard;
+using asylo::MonotonicClockSource;
 using asylo::NanosecondsToTimeVal;
+using asylo::ReadTsc;
+using asylo::ReadTscClock;
 using asylo::SharedName;
 using asylo::TimeSpecToNanoseconds;
+using asylo::TscClockParameters;
 
 namespace {
 
@@ -49,21 +55,85 @@ std::atomic<int64_t> *GetClockAddressOrDie(const char *name) {
   return static_cast<std::atomic<int64_t> *>(addr);
 }
 
+// Fetches the address of the TSC clock parameters, or returns nullptr if the
+// host does not publish them. Aborts if the returned pointer refers to enclave
+// memory.
+const TscClockParameters *GetTscClockParameters() {
+  void *addr = enc_untrusted_acquire_shared_resource(kAddressName,
+                                                     "clock_tsc_parameters");
+  if (addr && !enc_is_outside_enclave(addr, sizeof(TscClockParameters))) {
+    abort();
+  }
+  return static_cast<const TscClockParameters *>(addr);
+}
+
+// Returns the TSC clock parameters published by the host, or nullptr if the
+// host keeps time with the ticker.
+const TscClockParameters *TscClock() {
+  static const TscClockParameters *params = GetTscClockParameters();
+  return params;
+}
+
+// Reads the TSC clock. Returns false if the host does not publish it or its
+// parameters cannot be read.
+inline bool ReadTscClockIfAvailable(int64_t *monotonic, int64_t *realtime) {
+  const TscClockParameters *params = TscClock();
+  return params && ReadTscClock(*params, ReadTsc(), monotonic, realtime);
+}
+
+// Reads |clock_id| with a host call. Returns false if the host call fails, or
+// if it is made while this thread is already reading a clock from the host,
+// which happens when the host call records its own latency.
+bool ReadHostClock(clockid_t clock_id, int64_t *nanoseconds) {
+  thread_local static bool in_host_call = false;
+  if (in_host_call) {
+    return false;
+  }
+  in_host_call = true;
+  struct timespec time;
+  bool success = enc_untrusted_clock_gettime(clock_id, &time) == 0;
+  in_host_call = false;
+  if (success) {
+    *nanoseconds = TimeSpecToNanoseconds(&time);
+  }
+  return success;
+}
+
 // Returns the value of a monotonic clock as a number of nanoseconds.
+//
+// The clock is read from the TSC if the host publishes it, and otherwise from
+// the ticker. When the TSC cannot be read, the ticker is only refreshed as
+// often as the TSC clock parameters, so the host is asked for the time instead.
+// Aborts if the host rewinds the ticker or its own clock; switches between
+// sources are clamped so that the value never decreases as observed by a
+// single thread.
 inline int64_t MonotonicClock() {
   static std::atomic<int64_t> *clock_monotonic =
       GetClockAddressOrDie("clock_monotonic");
-  thread_local static int64_t last_tick = *clock_monotonic;
-  if (*clock_monotonic < last_tick) abort();
-  last_tick = *clock_monotonic;
-  return *clock_monotonic;
+  thread_local static MonotonicClockGuard guard;
+
+  int64_t monotonic, realtime;
+  if (ReadTscClockIfAvailable(&monotonic, &realtime)) {
+    return guard.Advance(MonotonicClockSource::kTsc, monotonic);
+  }
+  if (TscClock() && ReadHostClock(CLOCK_MONOTONIC, &monotonic)) {
+    return guard.Advance(MonotonicClockSource::kHostCall, monotonic);
+  }
+  return guard.Advance(MonotonicClockSource::kTicker, *clock_monotonic);
 }
 
-// Returns the value of a monotonic clock as a number of nanoseconds.
+// Returns the value of a realtime clock as a number of nanoseconds. Like the
+// host's CLOCK_REALTIME, it may go backwards.
 inline int64_t RealtimeClock() {
   static std::atomic<int64_t> *clock_realtime =
       GetClockAddressOrDie("clock_realtime");
-  return *clock_realtime;
+
+  int64_t monotonic, realtime;
+  if (!ReadTscClockIfAvailable(&monotonic, &realtime) &&
+      !(TscClock() && ReadHostClock(CLOCK_REALTIME, &realtime))) {
+    realtime = *clock_realtime;
+  }
+  return realtime;
 }
 
 // Busy wait with asm("pause").
@@ -0,0 +1,44 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include <sys/timerfd.h>
+
+#include "asylo/platform/posix/io/io_manager.h"
+
+using asylo::io::IOManager;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int timerfd_create(int clockid, int flags) {
+  return IOManager::GetInstance().TimerFdCreate(clockid, flags);
+}
+
+int timerfd_settime(int fd, int flags, const struct itimerspec *new_value,
+                    struct itimerspec *old_value) {
+  return IOManager::GetInstance().TimerFdSetTime(fd, flags, new_value,
+                                                 old_value);
+}
+
+int timerfd_gettime(int fd, struct itimerspec *curr_value) {
+  return IOManager::GetInstance().TimerFdGetTime(fd, curr_value);
+}
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
@@ -34,6 +34,14 @@ ssize_t readv(int fd, const struct iovec *iov, int iovcnt) {
   return IOManager::GetInstance().Readv(fd, iov, iovcnt);
 }
 
+ssize_t preadv(int fd, const struct iovec *iov, int iovcnt, off_t offset) {
+  return IOManager::GetInstance().Preadv(fd, iov, iovcnt, offset);
+}
+
+ssize_t pwritev(int fd, const struct iovec *iov, int iovcnt, off_t offset) {
+  return IOManager::GetInstance().Pwritev(fd, iov, iovcnt, offset);
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -106,6 +106,14 @@ int dup2(int oldfd, int newfd) {
 
 int fsync(int fd) { return IOManager::GetInstance().FSync(fd); }
 
+ssize_t pread(int fd, void *buf, size_t count, off_t offset) {
+  return IOManager::GetInstance().Pread(fd, buf, count, offset);
+}
+
+ssize_t pwrite(int fd, const void *buf, size_t count, off_t offset) {
+  return IOManager::GetInstance().Pwrite(fd, buf, count, offset);
+}
+
 char *getcwd(char *buf, size_t bufsize) {
   asylo::StatusOr<const asylo::EnclaveConfig *> config_result =
       asylo::GetEnclaveConfig();
@@ -23,6 +23,7 @@
 // IO syscall interface constants.
 #include <fcntl.h>
 
+#include <algorithm>
 #include <iomanip>
 
 #include "absl/strings/escaping.h"
@@ -100,6 +101,35 @@ ssize_t write_all(int fd, const void* buf, size_t len) {
   return offset;
 }
 
+// Like write_all, but writes at |file_offset| without using or changing the
+// file offset of |fd|. Returns -1 on failure, or |len| on success.
+ssize_t pwrite_all(int fd, const void* buf, size_t len, off_t file_offset) {
+  size_t bytes_to_write = len;
+  size_t offset = 0;
+
+  while (bytes_to_write > 0) {
+    ssize_t bytes_written;
+    do {
+      bytes_written = enc_untrusted_pwrite(
+          fd, static_cast<const uint8_t*>(buf) + offset, bytes_to_write,
+          file_offset + offset);
+    } while ((bytes_written == -1) && is_transient_error(errno));
+    if (bytes_written == -1) {
+      return -1;
+    }
+
+    bytes_to_write -= bytes_written;
+    offset += bytes_written;
+  }
+
+  // Sanity check.
+  if (offset != len) {
+    return -1;
+  }
+
+  return offset;
+}
+
 // Returns offset to the plaintext buffer associated with the |block_index| of
 // a full block.
 const uint8_t* GetPlaintextBuffer(size_t first_partial_block_bytes_count,
@@ -330,6 +360,24 @@ ssize_t AeadHandler::DecryptAndVerify(int fd, void* buf, size_t count) {
     return -1;
   }
 
+  return DecryptAndVerifyFile(fd, buf, count, logical_offset,
+                              /*move_cursor=*/true);
+}
+
+ssize_t AeadHandler::DecryptAndVerifyAt(int fd, void* buf, size_t count,
+                                        off_t logical_offset) {
+  if (!buf || logical_offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return DecryptAndVerifyFile(fd, buf, count, logical_offset,
+                              /*move_cursor=*/false);
+}
+
+ssize_t AeadHandler::DecryptAndVerifyFile(int fd, void* buf, size_t count,
+                                          off_t logical_offset,
+                                          bool move_cursor) {
   FileControl* file_ctrl;
   std::unique_ptr<absl::MutexLock> file_lock;
   {
@@ -346,12 +394,14 @@ ssize_t AeadHandler::DecryptAndVerify(int fd, void* buf, size_t count) {
     file_lock = absl::make_unique<absl::MutexLock>(&file_ctrl->mu);
   }
 
-  return DecryptAndVerifyInternal(fd, buf, count, *file_ctrl, logical_offset);
+  return DecryptAndVerifyInternal(fd, buf, count, *file_ctrl, logical_offset,
+                                  move_cursor);
 }
 
 ssize_t AeadHandler::DecryptAndVerifyInternal(int fd, void* buf, size_t count,
                                               const FileControl& file_ctrl,
-                                              off_t logical_offset) const {
+                                              off_t logical_offset,
+                                              bool move_cursor) const {
   if (count == 0) {
     return 0;
   }
@@ -387,7 +437,7 @@ ssize_t AeadHandler::DecryptAndVerifyInternal(int fd, void* buf, size_t count,
           : logical_offset;
   const off_t first_physical_block_offset =
       offset_translator_->LogicalToPhysical(first_logical_block_offset);
-  if (first_partial_block_bytes_count > 0) {
+  if (move_cursor && first_partial_block_bytes_count > 0) {
     off_t offset =
         enc_untrusted_lseek(fd, first_physical_block_offset, SEEK_SET);
     if (offset == -1) {
@@ -401,7 +451,10 @@ ssize_t AeadHandler::DecryptAndVerifyInternal(int fd, void* buf, size_t count,
   // that bytes_read is equal to physical_bytes_count. The read was not
   // requested at EOF - checked this above.
   ssize_t bytes_read =
-      enc_untrusted_read(fd, buffer.data(), physical_bytes_count);
+      move_cursor
+          ? enc_untrusted_read(fd, buffer.data(), physical_bytes_count)
+          : enc_untrusted_pread(fd, buffer.data(), physical_bytes_count,
+                                first_physical_block_offset);
   if (bytes_read <= 0) {
     LOG(ERROR) << "Cannot verify data - data has not been read, fd = " << fd;
     return -1;
@@ -416,22 +469,24 @@ ssize_t AeadHandler::DecryptAndVerifyInternal(int fd, void* buf, size_t count,
   }
 
   // Move cursor to the position of the end of the read range.
-  off_t new_cur_logical_offset = logical_offset + count;
-  if (bytes_read != physical_bytes_count) {
-    int64_t blocks_not_read =
-        (physical_bytes_count - bytes_read) / kSecureBlockLength;
-    if (last_partial_block_bytes_count > 0) {
-      new_cur_logical_offset -= last_partial_block_bytes_count;
-      blocks_not_read--;
+  if (move_cursor) {
+    off_t new_cur_logical_offset = logical_offset + count;
+    if (bytes_read != physical_bytes_count) {
+      int64_t blocks_not_read =
+          (physical_bytes_count - bytes_read) / kSecureBlockLength;
+      if (last_partial_block_bytes_count > 0) {
+        new_cur_logical_offset -= last_partial_block_bytes_count;
+        blocks_not_read--;
+      }
+      new_cur_logical_offset -= blocks_not_read * kBlockLength;
+    }
+    const off_t new_cur_physical_offset =
+        offset_translator_->LogicalToPhysical(new_cur_logical_offset);
+    off_t offset = enc_untrusted_lseek(fd, new_cur_physical_offset, SEEK_SET);
+    if (offset == -1) {
+      LOG(ERROR) << "Failed lseek to the end of read range.";
+      return -1;
     }
-    new_cur_logical_offset -= blocks_not_read * kBlockLength;
-  }
-  const off_t new_cur_physical_offset =
-      offset_translator_->LogicalToPhysical(new_cur_logical_offset);
-  off_t offset = enc_untrusted_lseek(fd, new_cur_physical_offset, SEEK_SET);
-  if (offset == -1) {
-    LOG(ERROR) << "Failed lseek to the end of read range.";
-    return -1;
   }
 
   GcmCryptor* cryptor = GetGcmCryptor(file_ctrl);
@@ -604,15 +659,9 @@ bool AeadHandler::ReadFullBlock(const FileControl& file_ctrl,
 
   FdCloser fd_closer(fd, &enc_untrusted_close);
 
-  off_t physical_offset = offset_translator_->LogicalToPhysical(logical_offset);
-  off_t offset = enc_untrusted_lseek(fd, physical_offset, SEEK_SET);
-  if (offset == -1) {
-    LOG(ERROR) << "Failed lseek when reading a full block.";
-    return false;
-  }
-
-  ssize_t bytes_read = DecryptAndVerifyInternal(fd, block->data(), kBlockLength,
-                                                file_ctrl, logical_offset);
+  ssize_t bytes_read =
+      DecryptAndVerifyInternal(fd, block->data(), kBlockLength, file_ctrl,
+                               logical_offset, /*move_cursor=*/false);
   if (bytes_read == -1) {
     return -1;
   }
@@ -635,6 +684,24 @@ ssize_t AeadHandler::EncryptAndPersist(int fd, const void* buf, size_t count) {
     return -1;
   }
 
+  return EncryptAndPersistFile(fd, buf, count, logical_offset,
+                               /*move_cursor=*/true);
+}
+
+ssize_t AeadHandler::EncryptAndPersistAt(int fd, const void* buf, size_t count,
+                                         off_t logical_offset) {
+  if (!buf || logical_offset < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+
+  return EncryptAndPersistFile(fd, buf, count, logical_offset,
+                               /*move_cursor=*/false);
+}
+
+ssize_t AeadHandler::EncryptAndPersistFile(int fd, const void* buf,
+                                           size_t count, off_t logical_offset,
+                                           bool move_cursor) {
   FileControl* file_ctrl;
   std::unique_ptr<absl::MutexLock> file_lock;
   {
@@ -785,7 +852,7 @@ ssize_t AeadHandler::EncryptAndPersist(int fd, const void* buf, size_t count) {
   }
 
   // Move cursor to the first full block to write.
-  if (first_partial_block_bytes_count > 0) {
+  if (move_cursor && first_partial_block_bytes_count > 0) {
     off_t offset =
         enc_untrusted_lseek(fd, first_physical_block_offset, SEEK_SET);
     if (offset == -1) {
@@ -803,7 +870,10 @@ ssize_t AeadHandler::EncryptAndPersist(int fd, const void* buf, size_t count) {
   //    on error or when all data has been written, following the POSIX model -
   //    this may lead to "long" writes when "large" amount of data is written.
   // In this code optimize operation for full writes - i.e. the option #2.
-  ssize_t bytes_written = write_all(fd, buffer.data(), physical_bytes_count);
+  ssize_t bytes_written =
+      move_cursor ? write_all(fd, buffer.data(), physical_bytes_count)
+                  : pwrite_all(fd, buffer.data(), physical_bytes_count,
+                               first_physical_block_offset);
   if (bytes_written != physical_bytes_count) {
     LOG(ERROR) << "Failed to write encrypted data to file, path="
                << file_ctrl->path << ", bytes written = " << bytes_written;
@@ -811,7 +881,7 @@ ssize_t AeadHandler::EncryptAndPersist(int fd, const void* buf, size_t count) {
   }
 
   // Move cursor to the position of the end of the write range.
-  if (last_partial_block_bytes_count > 0) {
+  if (move_cursor && last_partial_block_bytes_count > 0) {
     off_t new_cur_logical_offset = logical_offset + count;
     off_t new_cur_physical_offset =
         offset_translator_->LogicalToPhysical(new_cur_logical_offset);
@@ -837,7 +907,10 @@ ssize_t AeadHandler::EncryptAndPersist(int fd, const void* buf, size_t count) {
     }
   }
 
-  file_ctrl->logical_size = logical_offset + count;
+  // A write inside the file, such as a positioned overwrite, must not shrink
+  // it.
+  file_ctrl->logical_size =
+      std::max<off_t>(file_ctrl->logical_size, logical_offset + count);
 
   if (!UpdateDigest(file_ctrl, *cryptor)) {
     return -1;
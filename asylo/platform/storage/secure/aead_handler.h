@@ -92,6 +92,16 @@ class AeadHandler {
   ssize_t EncryptAndPersist(int fd, const void* buf, size_t count)
       LOCKS_EXCLUDED(mu_);
 
+  // Like DecryptAndVerify, but reads from |logical_offset| instead of from the
+  // cursor associated with |fd|, and does not move the cursor.
+  ssize_t DecryptAndVerifyAt(int fd, void* buf, size_t count,
+                             off_t logical_offset) LOCKS_EXCLUDED(mu_);
+
+  // Like EncryptAndPersist, but writes at |logical_offset| instead of at the
+  // cursor associated with |fd|, and does not move the cursor.
+  ssize_t EncryptAndPersistAt(int fd, const void* buf, size_t count,
+                              off_t logical_offset) LOCKS_EXCLUDED(mu_);
+
   // Frees resources used to assure integrity of an opened file, persists
   // integrity metadata to a designated location on disk, returns false on
   // failure. Does not modify the state of the file descriptor.
@@ -181,12 +191,29 @@ class AeadHandler {
   // not able to retrieve. The caller does not own the instance.
   GcmCryptor* GetGcmCryptor(const FileControl& file_ctrl) const;
 
+  // Implements DecryptAndVerify and DecryptAndVerifyAt. Reads at
+  // |logical_offset|, and if |move_cursor| is true, moves the cursor
+  // associated with |fd| to the end of the range read.
+  ssize_t DecryptAndVerifyFile(int fd, void* buf, size_t count,
+                               off_t logical_offset, bool move_cursor)
+      LOCKS_EXCLUDED(mu_);
+
+  // Implements EncryptAndPersist and EncryptAndPersistAt. Writes at
+  // |logical_offset|, and if |move_cursor| is true, moves the cursor
+  // associated with |fd| to the end of the range written.
+  ssize_t EncryptAndPersistFile(int fd, const void* buf, size_t count,
+                                off_t logical_offset, bool move_cursor)
+      LOCKS_EXCLUDED(mu_);
+
   // Similar to DecryptAndVerify, but is called by internal implementation, and
-  // as such does not take a file lock. The cursor associated with the file
-  // descriptor |fd| is expected to be at the position of |logical_offset|.
+  // as such does not take a file lock. If |move_cursor| is true, the cursor
+  // associated with the file descriptor |fd| is expected to be at the position
+  // of |logical_offset| and is moved to the end of the range read. Otherwise,
+  // the data is read with a positioned read and the cursor is not used.
   ssize_t DecryptAndVerifyInternal(int fd, void* buf, size_t count,
                                    const FileControl& file_ctrl,
-                                   off_t logical_offset) const;
+                                   off_t logical_offset,
+                                   bool move_cursor) const;
 
   // Reads a single full block of a file at a specified logical offset. Returns
   // false on failure.
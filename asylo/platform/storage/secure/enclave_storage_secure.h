@@ -46,6 +46,12 @@ int secure_close(int fd);
 
 off_t secure_lseek(int fd, off_t offset, int whence);
 
+// Reads from the logical |offset| without using or changing the file offset.
+ssize_t secure_pread(int fd, void *buf, size_t count, off_t offset);
+
+// Writes at the logical |offset| without using or changing the file offset.
+ssize_t secure_pwrite(int fd, const void *buf, size_t count, off_t offset);
+
 }  // namespace storage
 }  // namespace platform
 }  // namespace asylo
@@ -0,0 +1,395 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Google Benchmark driver for the enclave boundary and the POSIX layer.
+//
+// If --enclave_path is set, the benchmarks run against the benchmark enclave
+// at that path. Otherwise, the trusted benchmark bodies run in the driver
+// process through a FakeLocalEnclaveClient, which provides a baseline without
+// the cost of the enclave boundary. Benchmark names do not depend on the
+// backend, which is reported in the label of each benchmark instead, so that
+// results can be compared across runs and backends. Pass
+// --benchmark_format=json or --benchmark_out=<file> for machine-readable
+// output.
+
+#include <time.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "asylo/client.h"
+#include "asylo/test/benchmark/benchmark.pb.h"
+#include "asylo/test/benchmark/trusted_benchmark.h"
+#include "asylo/test/util/fake_local_enclave_client.h"
+#include "asylo/util/logging.h"
+#include "asylo/util/status.h"
+#include "gflags/gflags.h"
+
+DEFINE_string(enclave_path, "",
+              "Path to the benchmark enclave. If empty, the benchmark bodies "
+              "run in the driver process through a FakeLocalEnclaveClient");
+DEFINE_bool(use_tsc_clock, false,
+            "Whether enclaves read time from the time-stamp counter");
+DEFINE_int64(untrusted_staging_threshold, -1,
+             "Size at and above which enclave reads and writes are staged "
+             "through pooled untrusted buffers, or 0 to disable staging. If "
+             "negative, the enclave default is used");
+DEFINE_int64(native_stat_cache_ttl_ms, 0,
+             "Time for which enclaves cache the metadata of host files, or 0 "
+             "to disable the cache");
+DEFINE_string(scratch_dir, "/tmp",
+              "Directory for the files written by the file I/O benchmarks");
+
+namespace asylo {
+namespace {
+
+constexpr char kEnclaveName[] = "/benchmark";
+constexpr char kPoolName[] = "/benchmark_pool";
+
+// The size of the enclave pool used by the pool acquisition benchmark.
+constexpr size_t kPoolSize = 4;
+
+// The size of the output buffer of the run channel.
+constexpr size_t kRunChannelBufferSize = 4096;
+
+// Describes a trusted benchmark body and the arguments to run it with.
+struct TrustedBenchmarkSpec {
+  // The name of the body in the TrustedBenchmarkMap.
+  const char *name;
+
+  // The number of operations to run per enclave entry.
+  int64_t operations;
+
+  // The values of BenchmarkInput.argument to run the body with, if any.
+  std::vector<int64_t> arguments;
+
+  // Whether the body is only linked into the enclave.
+  bool enclave_only;
+};
+
+const std::vector<TrustedBenchmarkSpec> &TrustedBenchmarkSpecs() {
+  static const auto *specs = new std::vector<TrustedBenchmarkSpec>({
+      {"HostCall", 1000, {}, false},
+      {"ClockGettime", 1000, {}, false},
+      {"FileWrite", 100, {512, 4096, 65536}, false},
+      {"FileRead", 100, {512, 4096, 65536}, false},
+      {"FileTransfer", 4, {1 << 10, 1 << 14, 1 << 16, 1 << 20, 1 << 24}, false},
+      {"SecureFileWrite", 100, {512, 4096, 65536}, true},
+      {"SecureFileRead", 100, {512, 4096, 65536}, true},
+      {"MutexContention", 100000, {1, 2, 4, 8}, false},
+      {"PipeWakeup", 1000, {0, 1}, false},
+      {"EventFdWakeup", 1000, {0, 1}, false},
+      {"TimerFd", 10000, {1, 64, 512}, false},
+      {"PathStat", 1000, {0, 8, 32}, false},
+      {"NativeStat", 1000, {}, false},
+      {"SocketThroughput", 100, {64, 1024, 16384}, false},
+      {"Datagram", 256, {1, 16, 64}, false},
+      {"EkepHandshake", 1, {}, false},
+      {"IdentityAclEvaluation", 100, {1, 16, 256}, false},
+      {"Seal", 100, {64, 4096}, true},
+      {"SealCached", 100, {64, 4096}, true},
+      {"SealBatch", 10, {16, 64}, true},
+  });
+  return *specs;
+}
+
+// Loads FakeLocalEnclaveClients that run the trusted benchmark bodies in the
+// driver process.
+class FakeBenchmarkLoader : public EnclaveLoader {
+ protected:
+  StatusOr<std::unique_ptr<EnclaveClient>> LoadEnclave(
+      const std::string &name) const override {
+    return std::unique_ptr<EnclaveClient>(
+        new FakeLocalEnclaveClient<TrustedBenchmarkRunner>(
+            absl::make_unique<TrustedBenchmarkRunner>()));
+  }
+};
+
+std::unique_ptr<EnclaveLoader> CreateLoader() {
+  if (FLAGS_enclave_path.empty()) {
+    return absl::make_unique<FakeBenchmarkLoader>();
+  }
+  return absl::make_unique<SimLoader>(FLAGS_enclave_path, /*debug=*/true);
+}
+
+// Returns the label reported with each benchmark, which describes the backend
+// and the trusted clock the benchmarks run with.
+std::string BackendLabel() {
+  return absl::StrCat(FLAGS_enclave_path.empty() ? "fake_local" : "sgx_sim",
+                      FLAGS_use_tsc_clock ? ",tsc_clock" : ",host_clock");
+}
+
+EnclaveInput MakeInput(const std::string &name, int64_t operations,
+                       int64_t argument, const std::string &path) {
+  EnclaveInput input;
+  BenchmarkInput *benchmark = input.MutableExtension(benchmark_input);
+  benchmark->set_name(name);
+  benchmark->set_operations(operations);
+  benchmark->set_argument(argument);
+  benchmark->set_path(path);
+  return input;
+}
+
+// Runs the trusted benchmark body described by |spec| with
+// |spec|->operations operations per entry into the enclave.
+void BM_Trusted(benchmark::State &state, EnclaveClient *client,
+                const TrustedBenchmarkSpec *spec) {
+  int64_t argument = spec->arguments.empty() ? 0 : state.range(0);
+  EnclaveInput input =
+      MakeInput(spec->name, spec->operations, argument,
+                absl::StrCat(FLAGS_scratch_dir, "/benchmark_", spec->name));
+  int64_t bytes_processed = 0;
+  for (auto _ : state) {
+    EnclaveOutput output;
+    Status status = client->EnterAndRun(input, &output);
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+    bytes_processed +=
+        output.GetExtension(benchmark_output).bytes_processed();
+  }
+  state.SetItemsProcessed(state.iterations() * spec->operations);
+  if (bytes_processed > 0) {
+    state.SetBytesProcessed(bytes_processed);
+  }
+  state.SetLabel(BackendLabel());
+}
+
+// Enters the enclave once per iteration without doing any work inside it.
+void BM_EnterAndRun(benchmark::State &state, EnclaveClient *client) {
+  EnclaveInput input = MakeInput("Noop", 1, 0, "");
+  for (auto _ : state) {
+    EnclaveOutput output;
+    Status status = client->EnterAndRun(input, &output);
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(BackendLabel());
+}
+
+// Enters the enclave once per iteration through the run channel of an
+// SGXClient.
+void BM_EnterAndRunWithRunChannel(benchmark::State &state,
+                                  SGXClient *client) {
+  client->EnableRunChannel(kRunChannelBufferSize);
+  BM_EnterAndRun(state, client);
+  client->EnableRunChannel(0);
+}
+
+// Dispatches a batch of state.range(0) inputs per entry into the enclave.
+void BM_EnterAndRunBatch(benchmark::State &state, EnclaveClient *client) {
+  std::vector<EnclaveInput> inputs(state.range(0),
+                                   MakeInput("Noop", 1, 0, ""));
+  std::vector<EnclaveOutput> outputs;
+  std::vector<Status> statuses;
+  for (auto _ : state) {
+    Status status = client->EnterAndRunBatch(inputs, &outputs, &statuses);
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+  state.SetLabel(BackendLabel());
+}
+
+// Loads and initializes state.range(0) enclaves concurrently per iteration.
+// The enclaves are destroyed outside of the timed region.
+void BM_LoadEnclaves(benchmark::State &state, EnclaveManager *manager) {
+  std::unique_ptr<EnclaveLoader> loader = CreateLoader();
+  std::vector<EnclaveLoadSpec> specs(state.range(0));
+  for (size_t i = 0; i < specs.size(); ++i) {
+    specs[i].name = absl::StrCat("/benchmark_load_", i);
+    specs[i].loader = loader.get();
+  }
+
+  for (auto _ : state) {
+    std::vector<Status> statuses = manager->LoadEnclaves(specs);
+
+    state.PauseTiming();
+    Status status = Status::OkStatus();
+    for (size_t i = 0; i < specs.size(); ++i) {
+      if (!statuses[i].ok()) {
+        status = statuses[i];
+        continue;
+      }
+      manager->DestroyEnclave(manager->GetClient(specs[i].name),
+                              EnclaveFinal());
+    }
+    state.ResumeTiming();
+
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * specs.size());
+  state.SetLabel(BackendLabel());
+}
+
+// Takes an enclave from a warm pool per iteration. The enclave is destroyed
+// outside of the timed region, during which the pool loads a replacement in
+// the background.
+void BM_LoadEnclaveFromPool(benchmark::State &state, EnclaveManager *manager) {
+  Status status = manager->CreateEnclavePool(kPoolName, CreateLoader(),
+                                             EnclaveConfig(), kPoolSize);
+  if (!status.ok()) {
+    state.SkipWithError(status.ToString().c_str());
+    return;
+  }
+
+  constexpr char kName[] = "/benchmark_pooled";
+  for (auto _ : state) {
+    status = manager->LoadEnclaveFromPool(kPoolName, kName);
+    if (!status.ok()) {
+      state.SkipWithError(status.ToString().c_str());
+      break;
+    }
+
+    state.PauseTiming();
+    manager->DestroyEnclave(manager->GetClient(kName), EnclaveFinal());
+    state.ResumeTiming();
+  }
+  manager->DestroyEnclavePool(kPoolName, EnclaveFinal());
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(BackendLabel());
+}
+
+// Returns the CPU time used by all threads of the driver process.
+absl::Duration ProcessCpuTime() {
+  struct timespec time;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+  return absl::DurationFromTimespec(time);
+}
+
+// Idles in the driver for state.range(0) milliseconds per iteration and
+// reports the fraction of a host CPU used in the meantime, which is mostly
+// spent by the EnclaveManager thread that keeps the trusted clock. Compare
+// runs with and without --use_tsc_clock.
+void BM_IdleHostCpu(benchmark::State &state) {
+  absl::Duration idle = absl::Milliseconds(state.range(0));
+  absl::Duration cpu_time = absl::ZeroDuration();
+  for (auto _ : state) {
+    absl::Duration start = ProcessCpuTime();
+    absl::SleepFor(idle);
+    cpu_time += ProcessCpuTime() - start;
+  }
+  state.counters["host_cpu"] =
+      absl::FDivDuration(cpu_time, idle * state.iterations());
+  state.SetLabel(BackendLabel());
+}
+
+void RegisterBenchmarks(EnclaveManager *manager, EnclaveClient *client) {
+  benchmark::RegisterBenchmark("EnterAndRun", BM_EnterAndRun, client)
+      ->UseRealTime();
+
+  // The run channel is only implemented by the SGX backend.
+  SGXClient *sgx_client = dynamic_cast<SGXClient *>(client);
+  if (sgx_client) {
+    benchmark::RegisterBenchmark("EnterAndRunWithRunChannel",
+                                 BM_EnterAndRunWithRunChannel, sgx_client)
+        ->UseRealTime();
+  }
+
+  benchmark::RegisterBenchmark("EnterAndRunBatch", BM_EnterAndRunBatch,
+                               client)
+      ->Arg(1)
+      ->Arg(16)
+      ->Arg(64)
+      ->UseRealTime();
+
+  for (const TrustedBenchmarkSpec &spec : TrustedBenchmarkSpecs()) {
+    if (spec.enclave_only && !sgx_client) {
+      continue;
+    }
+    benchmark::internal::Benchmark *benchmark =
+        benchmark::RegisterBenchmark(absl::StrCat("Trusted/", spec.name).c_str(),
+                                     BM_Trusted, client, &spec);
+    for (int64_t argument : spec.arguments) {
+      benchmark->Arg(argument);
+    }
+    benchmark->UseRealTime();
+  }
+
+  benchmark::RegisterBenchmark("IdleHostCpu", BM_IdleHostCpu)
+      ->Arg(1000)
+      ->Iterations(5)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+
+  benchmark::RegisterBenchmark("LoadEnclaves", BM_LoadEnclaves, manager)
+      ->Arg(1)
+      ->Arg(16)
+      ->Arg(64)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+  benchmark::RegisterBenchmark("LoadEnclaveFromPool", BM_LoadEnclaveFromPool,
+                               manager)
+      ->Unit(benchmark::kMillisecond)
+      ->UseRealTime();
+}
+
+}  // namespace
+}  // namespace asylo
+
+int main(int argc, char *argv[]) {
+  ::benchmark::Initialize(&argc, argv);
+  ::google::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/true);
+
+  asylo::EnclaveManager::Configure(
+      asylo::EnclaveManagerOptions().set_use_tsc_clock(FLAGS_use_tsc_clock));
+  auto manager_result = asylo::EnclaveManager::Instance();
+  if (!manager_result.ok()) {
+    LOG(QFATAL) << "EnclaveManager unavailable: " << manager_result.status();
+  }
+  asylo::EnclaveManager *manager = manager_result.ValueOrDie();
+
+  std::unique_ptr<asylo::EnclaveLoader> loader = asylo::CreateLoader();
+  asylo::EnclaveConfig config;
+  if (FLAGS_untrusted_staging_threshold >= 0) {
+    config.set_untrusted_staging_threshold_bytes(
+        FLAGS_untrusted_staging_threshold);
+  }
+  config.set_native_stat_cache_ttl_ms(FLAGS_native_stat_cache_ttl_ms);
+  asylo::Status status =
+      manager->LoadEnclave(asylo::kEnclaveName, *loader, config);
+  if (!status.ok()) {
+    LOG(QFATAL) << "Load " << FLAGS_enclave_path << " failed: " << status;
+  }
+  asylo::EnclaveClient *client = manager->GetClient(asylo::kEnclaveName);
+
+  asylo::RegisterBenchmarks(manager, client);
+  ::benchmark::RunSpecifiedBenchmarks();
+
+  status = manager->DestroyEnclave(client, asylo::EnclaveFinal());
+  if (!status.ok()) {
+    LOG(QFATAL) << "Destroy " << FLAGS_enclave_path << " failed: " << status;
+  }
+  return 0;
+}
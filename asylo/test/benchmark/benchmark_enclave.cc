@@ -0,0 +1,45 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/test/benchmark/trusted_benchmark.h"
+#include "asylo/trusted_application.h"
+
+namespace asylo {
+
+// Runs the trusted benchmark bodies inside an enclave.
+class BenchmarkEnclave : public TrustedApplication {
+ public:
+  Status Initialize(const EnclaveConfig &config) override {
+    return runner_.Initialize(config);
+  }
+
+  Status Run(const EnclaveInput &input, EnclaveOutput *output) override {
+    return runner_.Run(input, output);
+  }
+
+  Status Finalize(const EnclaveFinal &final_input) override {
+    return runner_.Finalize(final_input);
+  }
+
+ private:
+  TrustedBenchmarkRunner runner_;
+};
+
+TrustedApplication *BuildTrustedApplication() { return new BenchmarkEnclave; }
+
+}  // namespace asylo
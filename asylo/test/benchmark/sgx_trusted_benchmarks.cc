@@ -0,0 +1,217 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmark bodies that depend on SGX or on the secure storage layer, and so
+// only run inside an enclave.
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asylo/crypto/util/byte_container_view.h"
+#include "asylo/identity/sealed_secret.pb.h"
+#include "asylo/identity/sgx/sgx_local_secret_sealer.h"
+#include "asylo/test/benchmark/trusted_benchmark.h"
+#include "asylo/util/posix_error_space.h"
+
+namespace asylo {
+namespace {
+
+// The size of each secret sealed by SealBatchBenchmark.
+constexpr size_t kBatchSecretSize = 64;
+
+// The key used by the secure file bodies.
+constexpr uint8_t kSecureFileKey[32] = {0};
+
+// Seals a secret of |input|.argument() bytes to MRENCLAVE per operation.
+class SealBenchmarkBase : public TrustedBenchmark {
+ public:
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::unique_ptr<SgxLocalSecretSealer> sealer = CreateSealer();
+    SealedSecretHeader header;
+    Status status = sealer->SetDefaultHeader(&header);
+    if (!status.ok()) {
+      return status;
+    }
+
+    std::vector<uint8_t> secret(input.argument(), 'a');
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      SealedSecret sealed_secret;
+      status = sealer->Seal(header, /*additional_authenticated_data=*/"",
+                            secret, &sealed_secret);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    output->set_bytes_processed(input.operations() * secret.size());
+    return Status::OkStatus();
+  }
+
+ protected:
+  virtual std::unique_ptr<SgxLocalSecretSealer> CreateSealer() const = 0;
+};
+
+// Seals with a sealer that derives the sealing key for every secret.
+class SealBenchmark : public SealBenchmarkBase {
+ public:
+  std::string Name() const override { return "Seal"; }
+
+ protected:
+  std::unique_ptr<SgxLocalSecretSealer> CreateSealer() const override {
+    return SgxLocalSecretSealer::CreateMrenclaveSecretSealer();
+  }
+};
+
+// Seals with a sealer that caches the sealing keys it derives.
+class SealCachedBenchmark : public SealBenchmarkBase {
+ public:
+  std::string Name() const override { return "SealCached"; }
+
+ protected:
+  std::unique_ptr<SgxLocalSecretSealer> CreateSealer() const override {
+    return SgxLocalSecretSealer::CreateCachingMrenclaveSecretSealer();
+  }
+};
+
+// Seals a batch of |input|.argument() secrets of kBatchSecretSize bytes each
+// to MRENCLAVE per operation.
+class SealBatchBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "SealBatch"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::unique_ptr<SgxLocalSecretSealer> sealer =
+        SgxLocalSecretSealer::CreateMrenclaveSecretSealer();
+    SealedSecretHeader header;
+    Status status = sealer->SetDefaultHeader(&header);
+    if (!status.ok()) {
+      return status;
+    }
+
+    std::vector<uint8_t> secret(kBatchSecretSize, 'a');
+    std::vector<ByteContainerView> secrets(input.argument(),
+                                           ByteContainerView(secret));
+    std::vector<ByteContainerView> additional_authenticated_data(
+        input.argument(), ByteContainerView(""));
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      SealedSecretBatch sealed_batch;
+      status = sealer->SealBatch(header, additional_authenticated_data, secrets,
+                                 &sealed_batch);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    output->set_bytes_processed(input.operations() * secrets.size() *
+                                secret.size());
+    return Status::OkStatus();
+  }
+};
+
+// Opens the file at |path| through the secure storage layer and sets its key.
+// Returns the file descriptor, or -1 on failure.
+int OpenSecureFile(const std::string &path, int flags) {
+  int fd = open(path.c_str(), flags | O_SECURE, 0644);
+  if (fd < 0) {
+    return -1;
+  }
+  struct key_info key;
+  key.length = sizeof(kSecureFileKey);
+  key.data = const_cast<uint8_t *>(kSecureFileKey);
+  if (ioctl(fd, ENCLAVE_STORAGE_SET_KEY, &key) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Writes a block of |input|.argument() bytes to the file at |input|.path()
+// through the secure storage layer per operation.
+class SecureFileWriteBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "SecureFileWrite"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::vector<char> block(input.argument(), 'a');
+    int fd = OpenSecureFile(input.path(), O_CREAT | O_TRUNC | O_RDWR);
+    if (fd < 0) {
+      return Status(static_cast<error::PosixError>(errno), "open failed");
+    }
+    Status status = Status::OkStatus();
+    for (int64_t i = 0; i < input.operations() && status.ok(); ++i) {
+      if (write(fd, block.data(), block.size()) !=
+          static_cast<ssize_t>(block.size())) {
+        status = Status(static_cast<error::PosixError>(errno), "write failed");
+      }
+    }
+    close(fd);
+    output->set_bytes_processed(input.operations() * block.size());
+    return status;
+  }
+};
+
+// Reads a block of |input|.argument() bytes from the start of the file at
+// |input|.path() through the secure storage layer per operation.
+class SecureFileReadBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "SecureFileRead"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::vector<char> block(input.argument(), 'a');
+    int fd = OpenSecureFile(input.path(), O_CREAT | O_TRUNC | O_RDWR);
+    if (fd < 0) {
+      return Status(static_cast<error::PosixError>(errno), "open failed");
+    }
+    Status status = Status::OkStatus();
+    if (write(fd, block.data(), block.size()) !=
+        static_cast<ssize_t>(block.size())) {
+      status = Status(static_cast<error::PosixError>(errno), "write failed");
+    }
+    for (int64_t i = 0; i < input.operations() && status.ok(); ++i) {
+      if (lseek(fd, 0, SEEK_SET) != 0 ||
+          read(fd, block.data(), block.size()) !=
+              static_cast<ssize_t>(block.size())) {
+        status = Status(static_cast<error::PosixError>(errno), "read failed");
+      }
+    }
+    close(fd);
+    output->set_bytes_processed(input.operations() * block.size());
+    return status;
+  }
+};
+
+}  // namespace
+
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, SealBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, SealCachedBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, SealBatchBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     SecureFileWriteBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     SecureFileReadBenchmark);
+
+}  // namespace asylo
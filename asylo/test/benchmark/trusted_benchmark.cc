@@ -0,0 +1,63 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/test/benchmark/trusted_benchmark.h"
+
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "asylo/identity/enclave_assertion_authority_config.pb.h"
+#include "asylo/identity/init.h"
+
+namespace asylo {
+
+Status TrustedBenchmarkRunner::Initialize(const EnclaveConfig &config) {
+  // Assertion authorities are initialized by the TrustedApplication inside an
+  // enclave, but not by a FakeLocalEnclaveClient. Initialization has no effect
+  // after the first successful call.
+  std::vector<EnclaveAssertionAuthorityConfig> authority_configs;
+  return InitializeEnclaveAssertionAuthorities(authority_configs.cbegin(),
+                                               authority_configs.cend());
+}
+
+Status TrustedBenchmarkRunner::Run(const EnclaveInput &input,
+                                   EnclaveOutput *output) {
+  if (!input.HasExtension(benchmark_input)) {
+    return Status(error::GoogleError::INVALID_ARGUMENT,
+                  "Input does not select a benchmark");
+  }
+  const BenchmarkInput &benchmark = input.GetExtension(benchmark_input);
+  auto it = TrustedBenchmarkMap::GetValue(benchmark.name());
+  if (it == TrustedBenchmarkMap::value_end()) {
+    return Status(error::GoogleError::NOT_FOUND,
+                  absl::StrCat("No benchmark named ", benchmark.name()));
+  }
+
+  BenchmarkOutput result;
+  Status status = it->Run(benchmark, &result);
+  if (status.ok() && output) {
+    *output->MutableExtension(benchmark_output) = result;
+  }
+  return status;
+}
+
+Status TrustedBenchmarkRunner::Finalize(const EnclaveFinal &final_input) {
+  return Status::OkStatus();
+}
+
+}  // namespace asylo
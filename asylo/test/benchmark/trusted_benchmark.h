@@ -0,0 +1,75 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef ASYLO_TEST_BENCHMARK_TRUSTED_BENCHMARK_H_
+#define ASYLO_TEST_BENCHMARK_TRUSTED_BENCHMARK_H_
+
+#include <string>
+
+#include "asylo/enclave.pb.h"
+#include "asylo/platform/common/static_map.h"
+#include "asylo/test/benchmark/benchmark.pb.h"
+#include "asylo/util/status.h"
+
+namespace asylo {
+
+// The body of a benchmark that runs inside an enclave. Each body registers
+// itself in the TrustedBenchmarkMap under a stable name, and is selected and
+// parameterized by a BenchmarkInput. A body runs the requested number of
+// operations per call to Run(), so that the cost of entering the enclave can be
+// amortized or measured separately, depending on the benchmark.
+//
+// Bodies must not depend on the backend they run on, so that the same bodies
+// can be run in an enclave and by a FakeLocalEnclaveClient, unless they are
+// linked into the enclave only.
+class TrustedBenchmark {
+ public:
+  virtual ~TrustedBenchmark() = default;
+
+  // Returns the stable name of the benchmark body.
+  virtual std::string Name() const = 0;
+
+  // Runs |input|.operations() operations of the benchmark and reports the
+  // results in |output|.
+  virtual Status Run(const BenchmarkInput &input,
+                     BenchmarkOutput *output) const = 0;
+};
+
+template <>
+struct Namer<TrustedBenchmark> {
+  std::string operator()(const TrustedBenchmark &benchmark) {
+    return benchmark.Name();
+  }
+};
+
+DEFINE_STATIC_MAP_OF_BASE_TYPE(TrustedBenchmarkMap, TrustedBenchmark)
+
+// Runs the benchmark body named by the benchmark_input extension of each
+// EnclaveInput. TrustedBenchmarkRunner implements the interface of the
+// TrustedApplication without depending on it, so that it can be hosted both by
+// an enclave and by a FakeLocalEnclaveClient.
+class TrustedBenchmarkRunner {
+ public:
+  Status Initialize(const EnclaveConfig &config);
+  Status Run(const EnclaveInput &input, EnclaveOutput *output);
+  Status Finalize(const EnclaveFinal &final_input);
+};
+
+}  // namespace asylo
+
+#endif  // ASYLO_TEST_BENCHMARK_TRUSTED_BENCHMARK_H_
@@ -0,0 +1,806 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+// Benchmark bodies that run both inside an enclave and with a
+// FakeLocalEnclaveClient.
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "asylo/grpc/auth/core/client_ekep_handshaker.h"
+#include "asylo/grpc/auth/core/ekep_handshaker.h"
+#include "asylo/grpc/auth/core/ekep_handshaker_util.h"
+#include "asylo/grpc/auth/core/server_ekep_handshaker.h"
+#include "asylo/identity/identity.pb.h"
+#include "asylo/identity/identity_acl.pb.h"
+#include "asylo/identity/identity_acl_evaluator.h"
+#include "asylo/identity/null_identity/null_identity_util.h"
+#include "asylo/test/benchmark/trusted_benchmark.h"
+#include "asylo/util/posix_error_space.h"
+#include "asylo/util/statusor.h"
+
+namespace asylo {
+namespace {
+
+// Returns a Status describing the current value of errno.
+Status LastPosixError(const std::string &operation) {
+  return Status(static_cast<error::PosixError>(errno),
+                absl::StrCat(operation, " failed"));
+}
+
+// Closes a file descriptor when it goes out of scope.
+class ScopedFd {
+ public:
+  explicit ScopedFd(int fd) : fd_(fd) {}
+  ~ScopedFd() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  int get() const { return fd_; }
+
+ private:
+  int fd_;
+};
+
+// Enters the enclave and returns without doing any work. Measures the cost of
+// an enclave entry.
+class NoopBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "Noop"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    return Status::OkStatus();
+  }
+};
+
+// Makes a trivial host call per operation. Measures the cost of an exit from
+// the enclave.
+class HostCallBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "HostCall"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      getppid();
+    }
+    return Status::OkStatus();
+  }
+};
+
+// Reads the monotonic clock once per operation.
+class ClockGettimeBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "ClockGettime"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    struct timespec ts;
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        return LastPosixError("clock_gettime");
+      }
+    }
+    return Status::OkStatus();
+  }
+};
+
+// Writes a block of |input|.argument() bytes to the file at |input|.path() per
+// operation, through the IOManager.
+class FileWriteBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "FileWrite"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::vector<char> block(input.argument(), 'a');
+    ScopedFd fd(open(input.path().c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644));
+    if (fd.get() < 0) {
+      return LastPosixError("open");
+    }
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      if (write(fd.get(), block.data(), block.size()) !=
+          static_cast<ssize_t>(block.size())) {
+        return LastPosixError("write");
+      }
+    }
+    output->set_bytes_processed(input.operations() * block.size());
+    return Status::OkStatus();
+  }
+};
+
+// Reads a block of |input|.argument() bytes from the start of the file at
+// |input|.path() per operation, through the IOManager. Each operation seeks
+// back to the start of the file, so that the file only has to hold one block.
+class FileReadBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "FileRead"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::vector<char> block(input.argument(), 'a');
+    ScopedFd fd(open(input.path().c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644));
+    if (fd.get() < 0) {
+      return LastPosixError("open");
+    }
+    if (write(fd.get(), block.data(), block.size()) !=
+        static_cast<ssize_t>(block.size())) {
+      return LastPosixError("write");
+    }
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      if (lseek(fd.get(), 0, SEEK_SET) != 0) {
+        return LastPosixError("lseek");
+      }
+      if (read(fd.get(), block.data(), block.size()) !=
+          static_cast<ssize_t>(block.size())) {
+        return LastPosixError("read");
+      }
+    }
+    output->set_bytes_processed(input.operations() * block.size());
+    return Status::OkStatus();
+  }
+};
+
+// Writes a block of |input|.argument() bytes to the file at |input|.path() and
+// reads it back per operation, through the IOManager. Used to measure the
+// throughput of large transfers across the enclave boundary.
+class FileTransferBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "FileTransfer"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::vector<char> block(input.argument(), 'a');
+    ScopedFd fd(open(input.path().c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644));
+    if (fd.get() < 0) {
+      return LastPosixError("open");
+    }
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      if (lseek(fd.get(), 0, SEEK_SET) != 0) {
+        return LastPosixError("lseek");
+      }
+      if (write(fd.get(), block.data(), block.size()) !=
+          static_cast<ssize_t>(block.size())) {
+        return LastPosixError("write");
+      }
+      if (lseek(fd.get(), 0, SEEK_SET) != 0) {
+        return LastPosixError("lseek");
+      }
+      size_t received = 0;
+      while (received < block.size()) {
+        ssize_t ret = read(fd.get(), block.data() + received,
+                           block.size() - received);
+        if (ret <= 0) {
+          return LastPosixError("read");
+        }
+        received += ret;
+      }
+    }
+    output->set_bytes_processed(2 * input.operations() * block.size());
+    return Status::OkStatus();
+  }
+};
+
+// State shared by the threads of MutexContentionBenchmark.
+struct MutexContentionState {
+  pthread_mutex_t mutex;
+  int64_t operations_per_thread;
+  int64_t counter;
+};
+
+void *ContendMutex(void *arg) {
+  MutexContentionState *state = static_cast<MutexContentionState *>(arg);
+  for (int64_t i = 0; i < state->operations_per_thread; ++i) {
+    pthread_mutex_lock(&state->mutex);
+    ++state->counter;
+    pthread_mutex_unlock(&state->mutex);
+  }
+  return nullptr;
+}
+
+// Splits |input|.operations() lock and unlock pairs of a single pthread mutex
+// between |input|.argument() threads.
+class MutexContentionBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "MutexContention"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    int64_t num_threads = input.argument() > 0 ? input.argument() : 1;
+    MutexContentionState state;
+    pthread_mutex_init(&state.mutex, nullptr);
+    state.operations_per_thread = input.operations() / num_threads;
+    state.counter = 0;
+
+    std::vector<pthread_t> threads(num_threads);
+    for (pthread_t &thread : threads) {
+      int ret = pthread_create(&thread, nullptr, ContendMutex, &state);
+      if (ret != 0) {
+        errno = ret;
+        return LastPosixError("pthread_create");
+      }
+    }
+    for (pthread_t &thread : threads) {
+      pthread_join(thread, nullptr);
+    }
+    pthread_mutex_destroy(&state.mutex);
+
+    if (state.counter != state.operations_per_thread * num_threads) {
+      return Status(error::GoogleError::INTERNAL, "Lost mutex updates");
+    }
+    return Status::OkStatus();
+  }
+};
+
+// State shared by the threads of PipeWakeupBenchmark.
+struct PipeWakeupState {
+  int ping_fds[2];
+  int pong_fds[2];
+  int64_t operations;
+  bool use_poll;
+};
+
+// Waits until |fd| is readable, using poll() if |use_poll| is true, and reads
+// one byte from it. Returns false on failure.
+bool AwaitByte(int fd, bool use_poll) {
+  if (use_poll) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, -1) != 1) {
+      return false;
+    }
+  }
+  char c;
+  return read(fd, &c, 1) == 1;
+}
+
+void *EchoWakeups(void *arg) {
+  PipeWakeupState *state = static_cast<PipeWakeupState *>(arg);
+  for (int64_t i = 0; i < state->operations; ++i) {
+    if (!AwaitByte(state->ping_fds[0], state->use_poll) ||
+        write(state->pong_fds[1], "b", 1) != 1) {
+      break;
+    }
+  }
+  return nullptr;
+}
+
+// Wakes up a second thread through a pipe and waits for it to respond through
+// another pipe, |input|.operations() times. If |input|.argument() is non-zero,
+// both threads wait for the pipes in poll() before reading them, as an event
+// loop does. Measures the round-trip latency of a cross-thread wakeup.
+class PipeWakeupBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "PipeWakeup"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    PipeWakeupState state;
+    if (pipe(state.ping_fds) != 0) {
+      return LastPosixError("pipe");
+    }
+    ScopedFd ping_read(state.ping_fds[0]);
+    if (pipe(state.pong_fds) != 0) {
+      close(state.ping_fds[1]);
+      return LastPosixError("pipe");
+    }
+    ScopedFd pong_read(state.pong_fds[0]);
+    ScopedFd pong_write(state.pong_fds[1]);
+    state.operations = input.operations();
+    state.use_poll = input.argument() != 0;
+
+    pthread_t thread;
+    int ret = pthread_create(&thread, nullptr, EchoWakeups, &state);
+    if (ret != 0) {
+      close(state.ping_fds[1]);
+      errno = ret;
+      return LastPosixError("pthread_create");
+    }
+    Status status = Status::OkStatus();
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      if (write(state.ping_fds[1], "a", 1) != 1 ||
+          !AwaitByte(state.pong_fds[0], state.use_poll)) {
+        status = LastPosixError("pipe wakeup");
+        break;
+      }
+    }
+
+    // Closing the write end unblocks the echoing thread if the loop failed.
+    close(state.ping_fds[1]);
+    pthread_join(thread, nullptr);
+    return status;
+  }
+};
+
+// State shared by the threads of EventFdWakeupBenchmark.
+struct EventFdWakeupState {
+  int ping_fd;
+  int pong_fd;
+  int64_t operations;
+  bool use_poll;
+};
+
+// Waits until the counter of the eventfd descriptor |fd| is non-zero, using
+// poll() if |use_poll| is true, and resets it. Returns false on failure.
+bool AwaitEvent(int fd, bool use_poll) {
+  if (use_poll) {
+    struct pollfd pfd = {fd, POLLIN, 0};
+    if (poll(&pfd, 1, -1) != 1) {
+      return false;
+    }
+  }
+  eventfd_t value;
+  return eventfd_read(fd, &value) == 0;
+}
+
+void *EchoEvents(void *arg) {
+  EventFdWakeupState *state = static_cast<EventFdWakeupState *>(arg);
+  for (int64_t i = 0; i < state->operations; ++i) {
+    if (!AwaitEvent(state->ping_fd, state->use_poll) ||
+        eventfd_write(state->pong_fd, 1) != 0) {
+      break;
+    }
+  }
+  return nullptr;
+}
+
+// Equivalent of PipeWakeupBenchmark for a pair of eventfd descriptors, which
+// event loops use to wake each other up.
+class EventFdWakeupBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "EventFdWakeup"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    EventFdWakeupState state;
+    // Reads of the semaphore return one wakeup at a time, so the echoing
+    // thread can be released all at once if the benchmark fails.
+    state.ping_fd = eventfd(0, EFD_SEMAPHORE);
+    if (state.ping_fd < 0) {
+      return LastPosixError("eventfd");
+    }
+    ScopedFd ping(state.ping_fd);
+    state.pong_fd = eventfd(0, 0);
+    if (state.pong_fd < 0) {
+      return LastPosixError("eventfd");
+    }
+    ScopedFd pong(state.pong_fd);
+    state.operations = input.operations();
+    state.use_poll = input.argument() != 0;
+
+    pthread_t thread;
+    int ret = pthread_create(&thread, nullptr, EchoEvents, &state);
+    if (ret != 0) {
+      errno = ret;
+      return LastPosixError("pthread_create");
+    }
+    Status status = Status::OkStatus();
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      if (eventfd_write(state.ping_fd, 1) != 0 ||
+          !AwaitEvent(state.pong_fd, state.use_poll)) {
+        status = LastPosixError("eventfd wakeup");
+        break;
+      }
+    }
+    if (!status.ok()) {
+      // Lets the echoing thread run through its remaining iterations.
+      eventfd_write(state.ping_fd, state.operations);
+    }
+    pthread_join(thread, nullptr);
+    return status;
+  }
+};
+
+// Arms |input|.argument() timerfd descriptors with a short one-shot timeout and
+// waits for them in poll(), re-arming each timer as it is read, until
+// |input|.operations() timers have expired. Measures the CPU cost of an event
+// loop servicing many timers.
+class TimerFdBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "TimerFd"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    // The timeout each timer is armed with.
+    constexpr long kTimeoutNanoseconds = 50000;
+    const struct itimerspec timeout = {{0, 0}, {0, kTimeoutNanoseconds}};
+
+    std::vector<std::unique_ptr<ScopedFd>> timers;
+    std::vector<struct pollfd> pfds;
+    for (int64_t i = 0; i < input.argument(); ++i) {
+      int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+      if (fd < 0) {
+        return LastPosixError("timerfd_create");
+      }
+      timers.emplace_back(new ScopedFd(fd));
+      if (timerfd_settime(fd, 0, &timeout, nullptr) != 0) {
+        return LastPosixError("timerfd_settime");
+      }
+      pfds.push_back({fd, POLLIN, 0});
+    }
+
+    int64_t expirations = 0;
+    while (expirations < input.operations()) {
+      int ready = poll(pfds.data(), pfds.size(), -1);
+      if (ready < 0) {
+        return LastPosixError("poll");
+      }
+      for (struct pollfd &pfd : pfds) {
+        if (!(pfd.revents & POLLIN)) {
+          continue;
+        }
+        uint64_t count;
+        if (read(pfd.fd, &count, sizeof(count)) != sizeof(count)) {
+          return LastPosixError("read");
+        }
+        expirations += count;
+        if (timerfd_settime(pfd.fd, 0, &timeout, nullptr) != 0) {
+          return LastPosixError("timerfd_settime");
+        }
+      }
+    }
+    return Status::OkStatus();
+  }
+};
+
+// Calls stat() on /dev/urandom, which is handled inside the enclave, through a
+// path with |input|.argument() redundant "./" and "../" components. Measures
+// the cost of resolving a path to its VirtualPathHandler.
+class PathStatBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "PathStat"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    std::string path = "/dev";
+    for (int64_t i = 0; i < input.argument(); ++i) {
+      absl::StrAppend(&path, i % 2 == 0 ? "/." : "/../dev");
+    }
+    absl::StrAppend(&path, "/urandom");
+
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0) {
+        return LastPosixError("stat");
+      }
+    }
+    return Status::OkStatus();
+  }
+};
+
+// Calls stat() on the file at |input|.path() per operation. The path is
+// forwarded to the host, so this measures the cost of a stat host call, or of a
+// lookup in the native stat cache if the enclave enables it.
+class NativeStatBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "NativeStat"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    {
+      ScopedFd fd(open(input.path().c_str(), O_CREAT | O_WRONLY, 0644));
+      if (fd.get() < 0) {
+        return LastPosixError("open");
+      }
+    }
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      struct stat st;
+      if (stat(input.path().c_str(), &st) != 0) {
+        return LastPosixError("stat");
+      }
+    }
+    return Status::OkStatus();
+  }
+};
+
+// Sends a message of |input|.argument() bytes over a loopback TCP connection
+// and receives it on the other end per operation. Both ends of the connection
+// are driven by the calling thread, so messages must fit in the socket buffers.
+class SocketThroughputBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "SocketThroughput"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    ScopedFd listener(socket(AF_INET, SOCK_STREAM, 0));
+    if (listener.get() < 0) {
+      return LastPosixError("socket");
+    }
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(listener.get(), reinterpret_cast<struct sockaddr *>(&addr),
+             addr_len) != 0 ||
+        listen(listener.get(), 1) != 0 ||
+        getsockname(listener.get(), reinterpret_cast<struct sockaddr *>(&addr),
+                    &addr_len) != 0) {
+      return LastPosixError("listen");
+    }
+
+    ScopedFd client(socket(AF_INET, SOCK_STREAM, 0));
+    if (client.get() < 0 ||
+        connect(client.get(), reinterpret_cast<struct sockaddr *>(&addr),
+                addr_len) != 0) {
+      return LastPosixError("connect");
+    }
+    ScopedFd server(accept(listener.get(), nullptr, nullptr));
+    if (server.get() < 0) {
+      return LastPosixError("accept");
+    }
+
+    std::vector<char> message(input.argument(), 'a');
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      if (write(client.get(), message.data(), message.size()) !=
+          static_cast<ssize_t>(message.size())) {
+        return LastPosixError("write");
+      }
+      size_t received = 0;
+      while (received < message.size()) {
+        ssize_t ret = read(server.get(), message.data() + received,
+                           message.size() - received);
+        if (ret <= 0) {
+          return LastPosixError("read");
+        }
+        received += ret;
+      }
+    }
+    output->set_bytes_processed(input.operations() * message.size());
+    return Status::OkStatus();
+  }
+};
+
+// Sends |input|.operations() 64-byte datagrams over a loopback UDP socket to
+// itself and receives them, in batches of |input|.argument() datagrams. Batches
+// of one datagram use sendto and recvfrom, larger batches use sendmmsg and
+// recvmmsg. Each batch is received before the next one is sent, so that the
+// socket buffer never overflows.
+class DatagramBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "Datagram"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    constexpr size_t kDatagramSize = 64;
+    ScopedFd sockfd(socket(AF_INET, SOCK_DGRAM, 0));
+    if (sockfd.get() < 0) {
+      return LastPosixError("socket");
+    }
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(sockfd.get(), reinterpret_cast<struct sockaddr *>(&addr),
+             addr_len) != 0 ||
+        getsockname(sockfd.get(), reinterpret_cast<struct sockaddr *>(&addr),
+                    &addr_len) != 0) {
+      return LastPosixError("bind");
+    }
+
+    int batch_size = input.argument() > 0 ? input.argument() : 1;
+    std::vector<char> buffers(batch_size * kDatagramSize, 'a');
+    std::vector<struct iovec> iovs(batch_size);
+    std::vector<struct mmsghdr> msgvec(batch_size);
+    for (int i = 0; i < batch_size; ++i) {
+      iovs[i].iov_base = buffers.data() + i * kDatagramSize;
+      iovs[i].iov_len = kDatagramSize;
+      msgvec[i] = {};
+      msgvec[i].msg_hdr.msg_iov = &iovs[i];
+      msgvec[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for (int64_t sent = 0; sent < input.operations(); sent += batch_size) {
+      if (batch_size == 1) {
+        if (sendto(sockfd.get(), buffers.data(), kDatagramSize, 0,
+                   reinterpret_cast<struct sockaddr *>(&addr),
+                   addr_len) != kDatagramSize) {
+          return LastPosixError("sendto");
+        }
+        if (recvfrom(sockfd.get(), buffers.data(), kDatagramSize, 0, nullptr,
+                     nullptr) != kDatagramSize) {
+          return LastPosixError("recvfrom");
+        }
+        continue;
+      }
+
+      for (struct mmsghdr &msg : msgvec) {
+        msg.msg_hdr.msg_name = &addr;
+        msg.msg_hdr.msg_namelen = addr_len;
+      }
+      int ret = sendmmsg(sockfd.get(), msgvec.data(), batch_size, 0);
+      if (ret != batch_size) {
+        return LastPosixError("sendmmsg");
+      }
+      for (struct mmsghdr &msg : msgvec) {
+        msg.msg_hdr.msg_name = nullptr;
+        msg.msg_hdr.msg_namelen = 0;
+      }
+      for (int received = 0; received < batch_size; received += ret) {
+        ret = recvmmsg(sockfd.get(), msgvec.data() + received,
+                       batch_size - received, 0, nullptr);
+        if (ret <= 0) {
+          return LastPosixError("recvmmsg");
+        }
+      }
+    }
+    return Status::OkStatus();
+  }
+};
+
+// Runs a complete EKEP handshake between a client and a server handshaker
+// using null assertions per operation.
+class EkepHandshakeBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "EkepHandshake"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    EkepHandshakerOptions options;
+    options.self_assertions.emplace_back();
+    SetNullAssertionDescription(&options.self_assertions.back());
+    options.accepted_peer_assertions.emplace_back();
+    SetNullAssertionDescription(&options.accepted_peer_assertions.back());
+
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      std::unique_ptr<EkepHandshaker> client =
+          ClientEkepHandshaker::Create(options);
+      std::unique_ptr<EkepHandshaker> server =
+          ServerEkepHandshaker::Create(options);
+      if (!client || !server) {
+        return Status(error::GoogleError::INTERNAL,
+                      "Failed to create EKEP handshakers");
+      }
+      Status status = Handshake(client.get(), server.get());
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status::OkStatus();
+  }
+
+ private:
+  // Exchanges frames between |client| and |server| until both complete the
+  // handshake.
+  static Status Handshake(EkepHandshaker *client, EkepHandshaker *server) {
+    using Result = EkepHandshaker::Result;
+    auto pending = [](Result result) {
+      return result == Result::IN_PROGRESS || result == Result::NOT_ENOUGH_DATA;
+    };
+
+    std::string to_server;
+    std::string to_client;
+    Result client_result = client->NextHandshakeStep(nullptr, 0, &to_server);
+    Result server_result = server->NextHandshakeStep(nullptr, 0, &to_client);
+    while (pending(client_result) || pending(server_result)) {
+      if (pending(server_result) && !to_server.empty()) {
+        std::string incoming = std::move(to_server);
+        to_server.clear();
+        server_result = server->NextHandshakeStep(incoming.data(),
+                                                  incoming.size(), &to_client);
+      } else if (pending(client_result) && !to_client.empty()) {
+        std::string incoming = std::move(to_client);
+        to_client.clear();
+        client_result = client->NextHandshakeStep(incoming.data(),
+                                                  incoming.size(), &to_server);
+      } else {
+        // Neither handshaker has anything left to process.
+        break;
+      }
+    }
+    if (client_result != Result::COMPLETED ||
+        server_result != Result::COMPLETED) {
+      return Status(error::GoogleError::INTERNAL, "EKEP handshake failed");
+    }
+    return Status::OkStatus();
+  }
+};
+
+// Evaluates an ACL of |input|.argument() null identity expectations, of which
+// only the last one matches, per operation.
+class IdentityAclEvaluationBenchmark : public TrustedBenchmark {
+ public:
+  std::string Name() const override { return "IdentityAclEvaluation"; }
+
+  Status Run(const BenchmarkInput &input,
+             BenchmarkOutput *output) const override {
+    EnclaveIdentity identity;
+    SetNullIdentityDescription(identity.mutable_description());
+    identity.set_identity(kNullIdentity);
+
+    int64_t num_expectations = input.argument() > 0 ? input.argument() : 1;
+    IdentityAclPredicate acl;
+    acl.mutable_acl_group()->set_type(IdentityAclGroup::OR);
+    for (int64_t i = 0; i < num_expectations; ++i) {
+      EnclaveIdentity *reference = acl.mutable_acl_group()
+                                       ->add_predicates()
+                                       ->mutable_expectation()
+                                       ->mutable_reference_identity();
+      *reference = identity;
+      if (i + 1 < num_expectations) {
+        reference->set_identity(absl::StrCat("mismatch ", i));
+      }
+    }
+
+    StatusOr<std::unique_ptr<IdentityAclEvaluator>> evaluator_result =
+        IdentityAclEvaluator::Create(acl);
+    if (!evaluator_result.ok()) {
+      return evaluator_result.status();
+    }
+    std::unique_ptr<IdentityAclEvaluator> evaluator =
+        std::move(evaluator_result).ValueOrDie();
+    std::unique_ptr<ParsedEnclaveIdentities> identities =
+        ParsedEnclaveIdentities::Create({identity});
+
+    for (int64_t i = 0; i < input.operations(); ++i) {
+      StatusOr<bool> result = evaluator->Evaluate(*identities);
+      if (!result.ok()) {
+        return result.status();
+      }
+      if (!result.ValueOrDie()) {
+        return Status(error::GoogleError::INTERNAL, "ACL did not match");
+      }
+    }
+    return Status::OkStatus();
+  }
+};
+
+}  // namespace
+
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, NoopBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, HostCallBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     ClockGettimeBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, FileWriteBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, FileReadBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     FileTransferBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     MutexContentionBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     PipeWakeupBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     EventFdWakeupBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, TimerFdBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, PathStatBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, NativeStatBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     SocketThroughputBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap, DatagramBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     EkepHandshakeBenchmark);
+SET_STATIC_MAP_VALUE_OF_DERIVED_TYPE(TrustedBenchmarkMap,
+                                     IdentityAclEvaluationBenchmark);
+
+}  // namespace asylo
@@ -18,6 +18,8 @@
 
 #include "asylo/test/util/fake_local_enclave_client.h"
 
+#include <vector>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include "asylo/test/util/status_matchers.h"
@@ -44,6 +46,27 @@ class TrivialMockEnclave {
   Status status_;
 };
 
+// A mock enclave whose Run method fails on every other call.
+class AlternatingMockEnclave {
+ public:
+  Status Run(const EnclaveInput &input, EnclaveOutput *output) {
+    if (num_calls_++ % 2) {
+      return Status(error::GoogleError::INVALID_ARGUMENT, "test");
+    }
+    return Status::OkStatus();
+  }
+
+  Status Initialize(const EnclaveConfig &config) { return Status::OkStatus(); }
+
+  Status Finalize(const EnclaveFinal &final_input) {
+    return Status::OkStatus();
+  }
+
+ private:
+  // The number of times Run has been called.
+  int num_calls_ = 0;
+};
+
 TEST(FakeLocalEnclaveClientTest, RunReturnsStatus) {
   FakeLocalEnclaveClient<TrivialMockEnclave> client(
       absl::make_unique<TrivialMockEnclave>(
@@ -55,6 +78,27 @@ TEST(FakeLocalEnclaveClientTest, RunReturnsStatus) {
               StatusIs(error::GoogleError::INVALID_ARGUMENT));
 }
 
+TEST(FakeLocalEnclaveClientTest, RunBatchReturnsStatusPerInput) {
+  FakeLocalEnclaveClient<AlternatingMockEnclave> client(
+      absl::make_unique<AlternatingMockEnclave>());
+
+  std::vector<EnclaveInput> inputs(5);
+  std::vector<EnclaveOutput> outputs;
+  std::vector<Status> statuses;
+  ASSERT_THAT(client.EnterAndRunBatch(inputs, &outputs, &statuses), IsOk());
+  ASSERT_EQ(outputs.size(), inputs.size());
+  ASSERT_EQ(statuses.size(), inputs.size());
+  for (size_t i = 0; i < statuses.size(); ++i) {
+    if (i % 2) {
+      EXPECT_THAT(statuses[i], StatusIs(error::GoogleError::INVALID_ARGUMENT));
+    } else {
+      EXPECT_THAT(statuses[i], IsOk());
+    }
+  }
+
+  // Null outputs are permitted.
+  EXPECT_THAT(client.EnterAndRunBatch(inputs, nullptr, nullptr), IsOk());
+}
 
 }  // namespace
 }  // namespace asylo
@@ -25,12 +25,24 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
+
+#ifndef __ASYLO__
+#include <thread>
+#endif  // __ASYLO__
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
 
 namespace asylo {
 
@@ -85,8 +97,267 @@ const std::string get_log_basename() {
   return *log_basename;
 }
 
+// Returns the current CLOCK_MONOTONIC time in nanoseconds.
+int64_t MonotonicNanos() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Writes all of |data| to |fd|, retrying on partial writes. Returns false if
+// the write fails.
+bool WriteFully(int fd, const std::string &data) {
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t result = write(fd, data.data() + written, data.size() - written);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    written += result;
+  }
+  return true;
+}
+
+// Log messages buffered by one thread.
+struct ThreadLogBuffer {
+  absl::Mutex mu;
+  std::string data GUARDED_BY(mu);
+};
+
+// The sink used by LogMessage when buffered logging is enabled. Messages are
+// appended to per-thread buffers, which are written out in batches. The
+// per-thread mutex is only contended while a flush drains the buffer, so the
+// common logging path never waits on other logging threads.
+//
+// Lock order: |write_mu_|, then |registry_mu_|, then ThreadLogBuffer::mu.
+class BufferedLogSink {
+ public:
+  BufferedLogSink(size_t flush_threshold_bytes, int flush_interval_ms)
+      : flush_threshold_bytes_(flush_threshold_bytes),
+        max_buffered_bytes_(flush_threshold_bytes * 4),
+        flush_interval_ns_(static_cast<int64_t>(flush_interval_ms) * 1000000),
+        last_flush_ns_(MonotonicNanos()) {}
+
+  // Buffers |message_text|, and flushes buffers as required by |severity|, the
+  // size of the calling thread's buffer, and the time since the last flush.
+  void Send(const std::string &message_text, LogSeverity severity) {
+    ThreadLogBuffer *buffer = GetThreadBuffer();
+    bool flush_thread_buffer = false;
+    {
+      absl::MutexLock lock(&buffer->mu);
+      if (buffer->data.size() >= max_buffered_bytes_ && severity < ERROR) {
+        // Another thread has held the writer for long enough that this
+        // thread's buffer is full. Drop the message rather than wait.
+        dropped_messages_.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        buffer->data.append(message_text);
+        if (message_text.empty() || message_text.back() != '\n') {
+          buffer->data.push_back('\n');
+        }
+      }
+      flush_thread_buffer = buffer->data.size() >= flush_threshold_bytes_;
+    }
+
+    if (severity >= ERROR) {
+      FlushAll(/*blocking=*/true);
+      return;
+    }
+    if (MonotonicNanos() - last_flush_ns_.load(std::memory_order_relaxed) >=
+        flush_interval_ns_) {
+      FlushAll(/*blocking=*/false);
+    } else if (flush_thread_buffer) {
+      FlushBuffer(buffer);
+    }
+  }
+
+  // Writes out the contents of all thread buffers. If |blocking| is false and
+  // another thread is already writing, returns without flushing.
+  void FlushAll(bool blocking) LOCKS_EXCLUDED(write_mu_, registry_mu_) {
+    if (blocking) {
+      write_mu_.Lock();
+    } else if (!write_mu_.TryLock()) {
+      return;
+    }
+    std::vector<std::shared_ptr<ThreadLogBuffer>> buffers;
+    {
+      absl::MutexLock lock(&registry_mu_);
+      buffers = buffers_;
+    }
+    std::string batch;
+    for (const auto &buffer : buffers) {
+      absl::MutexLock lock(&buffer->mu);
+      batch.append(buffer->data);
+      buffer->data.clear();
+    }
+    WriteBatch(batch);
+    last_flush_ns_.store(MonotonicNanos(), std::memory_order_relaxed);
+    write_mu_.Unlock();
+  }
+
+  uint64_t dropped_messages() const {
+    return dropped_messages_.load(std::memory_order_relaxed);
+  }
+
+  // Flushes all buffers every |flush_interval_ns_|. Never returns.
+  void RunFlusher() {
+    while (true) {
+      struct timespec interval;
+      interval.tv_sec = flush_interval_ns_ / 1000000000;
+      interval.tv_nsec = flush_interval_ns_ % 1000000000;
+      nanosleep(&interval, nullptr);
+      FlushAll(/*blocking=*/true);
+    }
+  }
+
+ private:
+  // Keeps a thread's buffer registered for the lifetime of the thread, and
+  // flushes it when the thread exits.
+  class ThreadBufferHolder {
+   public:
+    ThreadBufferHolder(BufferedLogSink *sink,
+                       std::shared_ptr<ThreadLogBuffer> buffer)
+        : sink_(sink), buffer_(std::move(buffer)) {}
+    ~ThreadBufferHolder() { sink_->Unregister(buffer_); }
+
+    const std::shared_ptr<ThreadLogBuffer> &buffer() const { return buffer_; }
+
+   private:
+    BufferedLogSink *sink_;
+    std::shared_ptr<ThreadLogBuffer> buffer_;
+  };
+
+  // Returns the calling thread's buffer, registering it on first use.
+  ThreadLogBuffer *GetThreadBuffer() LOCKS_EXCLUDED(registry_mu_) {
+#ifdef __ASYLO__
+    // Enclave threads do not run thread-local destructors, so the buffer stays
+    // registered, and is owned by |buffers_|, for the lifetime of the enclave.
+    thread_local ThreadLogBuffer *buffer = nullptr;
+    if (!buffer) {
+      buffer = RegisterThreadBuffer().get();
+    }
+    return buffer;
+#else   // __ASYLO__
+    thread_local std::unique_ptr<ThreadBufferHolder> holder;
+    if (!holder) {
+      holder.reset(new ThreadBufferHolder(this, RegisterThreadBuffer()));
+    }
+    return holder->buffer().get();
+#endif  // __ASYLO__
+  }
+
+  std::shared_ptr<ThreadLogBuffer> RegisterThreadBuffer()
+      LOCKS_EXCLUDED(registry_mu_) {
+    auto buffer = std::make_shared<ThreadLogBuffer>();
+    absl::MutexLock lock(&registry_mu_);
+    buffers_.push_back(buffer);
+    return buffer;
+  }
+
+  // Flushes |buffer| unless another thread is writing.
+  void FlushBuffer(ThreadLogBuffer *buffer) LOCKS_EXCLUDED(write_mu_) {
+    if (!write_mu_.TryLock()) {
+      return;
+    }
+    std::string batch;
+    {
+      absl::MutexLock lock(&buffer->mu);
+      batch.swap(buffer->data);
+    }
+    WriteBatch(batch);
+    write_mu_.Unlock();
+  }
+
+  void Unregister(const std::shared_ptr<ThreadLogBuffer> &buffer)
+      LOCKS_EXCLUDED(write_mu_, registry_mu_) {
+    write_mu_.Lock();
+    std::string batch;
+    {
+      absl::MutexLock lock(&buffer->mu);
+      batch.swap(buffer->data);
+    }
+    WriteBatch(batch);
+    {
+      absl::MutexLock lock(&registry_mu_);
+      buffers_.erase(std::remove(buffers_.begin(), buffers_.end(), buffer),
+                     buffers_.end());
+    }
+    write_mu_.Unlock();
+  }
+
+  // Writes |batch| to the log file and to stdout.
+  void WriteBatch(const std::string &batch) EXCLUSIVE_LOCKS_REQUIRED(write_mu_) {
+    if (batch.empty()) {
+      return;
+    }
+    if (log_fd_ < 0) {
+      std::string log_path = get_log_directory() + get_log_basename();
+      log_fd_ = open(log_path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+      if (log_fd_ < 0) {
+        fprintf(stderr, "Failed to open log file : %s!\n", log_path.c_str());
+      }
+    }
+    if (log_fd_ >= 0 && !WriteFully(log_fd_, batch)) {
+      fprintf(stderr, "Failed to write to log file!\n");
+    }
+    WriteFully(STDOUT_FILENO, batch);
+  }
+
+  const size_t flush_threshold_bytes_;
+  const size_t max_buffered_bytes_;
+  const int64_t flush_interval_ns_;
+
+  std::atomic<int64_t> last_flush_ns_;
+  std::atomic<uint64_t> dropped_messages_{0};
+
+  absl::Mutex write_mu_;
+  int log_fd_ GUARDED_BY(write_mu_) = -1;
+
+  absl::Mutex registry_mu_ ACQUIRED_AFTER(write_mu_);
+  std::vector<std::shared_ptr<ThreadLogBuffer>> buffers_
+      GUARDED_BY(registry_mu_);
+};
+
+// The buffered sink, or nullptr if buffered logging is not enabled. Once set,
+// the sink is never destroyed, since threads may log until the process exits.
+std::atomic<BufferedLogSink *> buffered_log_sink{nullptr};
+
 }  // namespace
 
+bool EnableBufferedLogging(size_t flush_threshold_bytes,
+                           int flush_interval_ms) {
+  if (flush_threshold_bytes == 0 || flush_interval_ms <= 0) {
+    return false;
+  }
+  std::unique_ptr<BufferedLogSink> sink(
+      new BufferedLogSink(flush_threshold_bytes, flush_interval_ms));
+  BufferedLogSink *expected = nullptr;
+  if (!buffered_log_sink.compare_exchange_strong(expected, sink.get())) {
+    return false;
+  }
+  BufferedLogSink *installed_sink = sink.release();
+#ifndef __ASYLO__
+  std::thread([installed_sink] { installed_sink->RunFlusher(); }).detach();
+#else   // __ASYLO__
+  (void)installed_sink;
+#endif  // __ASYLO__
+  return true;
+}
+
+void FlushLogs() {
+  BufferedLogSink *sink = buffered_log_sink.load();
+  if (sink) {
+    sink->FlushAll(/*blocking=*/true);
+  }
+}
+
+uint64_t GetDroppedLogMessageCount() {
+  BufferedLogSink *sink = buffered_log_sink.load();
+  return sink ? sink->dropped_messages() : 0;
+}
+
 bool set_log_directory(const std::string &log_directory) {
   std::string tmp_directory = log_directory;
   if (tmp_directory.empty()) {
@@ -175,10 +446,17 @@ void LogMessage::Init(const char *file, int line, LogSeverity severity) {
   struct timespec time_stamp;
   clock_gettime(CLOCK_REALTIME, &time_stamp);
 
+  // Formatting the local time is expensive, and inside an enclave may require
+  // host calls, so each thread reuses its last result within the same second.
   constexpr int kTimeMessageSize = 22;
-  char buffer[kTimeMessageSize];
-  strftime(buffer, kTimeMessageSize, "%Y-%m-%d %H:%M:%S  ",
-           localtime(&time_stamp.tv_sec));
+  thread_local time_t formatted_seconds = -1;
+  thread_local char buffer[kTimeMessageSize];
+  if (time_stamp.tv_sec != formatted_seconds) {
+    struct tm local_time;
+    localtime_r(&time_stamp.tv_sec, &local_time);
+    strftime(buffer, kTimeMessageSize, "%Y-%m-%d %H:%M:%S  ", &local_time);
+    formatted_seconds = time_stamp.tv_sec;
+  }
   stream() << buffer;
   stream() << LogSeverityNames[severity_] << "  " << filename << " : " << line
            << " : ";
@@ -190,6 +468,19 @@ LogMessage::~LogMessage() {
 }
 
 void LogMessage::SendToLog(const std::string &message_text) {
+  BufferedLogSink *sink = buffered_log_sink.load(std::memory_order_acquire);
+  if (sink) {
+    sink->Send(message_text, severity_);
+    if (severity_ >= ERROR) {
+      fprintf(stderr, "%s\n", message_text.c_str());
+      fflush(stderr);
+    }
+    if (severity_ == FATAL) {
+      abort();
+    }
+    return;
+  }
+
   std::string log_path = get_log_directory() + get_log_basename();
 
   FILE *file = fopen(log_path.c_str(), "ab");
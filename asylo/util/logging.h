@@ -321,6 +321,40 @@ bool EnsureDirectory(const char *path);
 ///        a level equal to or lower than it will be logged.
 bool InitLogging(const char *directory, const char *file_name, int level);
 
+/// Switches logging to a buffered mode that batches log output.
+///
+/// In buffered mode, each thread appends formatted messages to its own buffer.
+/// A thread's buffer is written out in a single batch, through a log file
+/// descriptor that is held open, once it holds `flush_threshold_bytes` bytes or
+/// once `flush_interval_ms` milliseconds have passed since the last flush.
+/// Outside an enclave a background thread also flushes all buffers every
+/// `flush_interval_ms` milliseconds. Inside an enclave, where spawning threads
+/// requires the host, buffers are flushed by logging threads and by FlushLogs().
+///
+/// Logging threads never wait for another thread's flush to complete. If a
+/// thread's buffer reaches four times `flush_threshold_bytes` while another
+/// thread is flushing, further messages from that thread are dropped and
+/// counted by GetDroppedLogMessageCount(). Messages of severity ERROR or higher
+/// flush all buffers synchronously, and a FATAL message is always written
+/// before the program aborts.
+///
+/// \param flush_threshold_bytes The buffer size at which a thread flushes its
+///        buffer. Must be positive.
+/// \param flush_interval_ms The maximum time a message stays buffered while
+///        other messages are logged. Must be positive.
+/// \return True if and only if buffered logging was enabled by this call.
+bool EnableBufferedLogging(size_t flush_threshold_bytes, int flush_interval_ms);
+
+/// Writes out all messages buffered by buffered logging. Does nothing if
+/// buffered logging is not enabled.
+void FlushLogs();
+
+/// Gets the number of log messages dropped by buffered logging because a
+/// thread's buffer was full.
+///
+/// \return The number of dropped log messages.
+uint64_t GetDroppedLogMessageCount();
+
 /// Class representing a log message created by a log macro.
 class LogMessage {
  public:
@@ -0,0 +1,146 @@
+/*
+ *
+ * Copyright 2018 Asylo authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "asylo/util/logging.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "absl/strings/str_cat.h"
+
+namespace asylo {
+namespace {
+
+constexpr char kLogBasename[] = "logging_test";
+
+// Returns the contents of the log file written by this test.
+std::string ReadLogFile() {
+  std::ifstream file(get_log_directory() + kLogBasename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// Returns the number of occurrences of |needle| in |haystack|.
+int CountOccurrences(const std::string &haystack, const std::string &needle) {
+  int count = 0;
+  for (size_t pos = haystack.find(needle); pos != std::string::npos;
+       pos = haystack.find(needle, pos + needle.size())) {
+    ++count;
+  }
+  return count;
+}
+
+class LoggingTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() {
+    const char *tmp_dir = getenv("TEST_TMPDIR");
+    ASSERT_TRUE(InitLogging(tmp_dir ? tmp_dir : "/tmp/", kLogBasename,
+                            /*level=*/0));
+    unlink((get_log_directory() + kLogBasename).c_str());
+
+    // Buffered logging is process-wide, so it is enabled once for all tests.
+    ASSERT_FALSE(EnableBufferedLogging(/*flush_threshold_bytes=*/0,
+                                       /*flush_interval_ms=*/1000));
+    ASSERT_TRUE(EnableBufferedLogging(/*flush_threshold_bytes=*/4096,
+                                      /*flush_interval_ms=*/60000));
+  }
+};
+
+// Verifies that buffered logging can only be enabled once.
+TEST_F(LoggingTest, EnableBufferedLoggingSucceedsOnce) {
+  EXPECT_FALSE(EnableBufferedLogging(/*flush_threshold_bytes=*/4096,
+                                     /*flush_interval_ms=*/1000));
+}
+
+// Verifies that buffered messages reach the log file in order after
+// FlushLogs().
+TEST_F(LoggingTest, FlushLogsWritesBufferedMessages) {
+  constexpr int kNumMessages = 100;
+  for (int i = 0; i < kNumMessages; ++i) {
+    LOG(INFO) << "ordered message " << i << ".";
+  }
+  FlushLogs();
+
+  std::string contents = ReadLogFile();
+  size_t last_pos = 0;
+  for (int i = 0; i < kNumMessages; ++i) {
+    size_t pos = contents.find(absl::StrCat("ordered message ", i, "."));
+    ASSERT_NE(pos, std::string::npos);
+    EXPECT_GE(pos, last_pos);
+    last_pos = pos;
+  }
+  EXPECT_EQ(GetDroppedLogMessageCount(), 0u);
+}
+
+// Verifies that ERROR messages are written without an explicit flush.
+TEST_F(LoggingTest, ErrorMessagesAreFlushedImmediately) {
+  LOG(INFO) << "info before error";
+  LOG(ERROR) << "error message";
+
+  std::string contents = ReadLogFile();
+  EXPECT_NE(contents.find("info before error"), std::string::npos);
+  EXPECT_NE(contents.find("error message"), std::string::npos);
+}
+
+// Verifies that messages logged concurrently from many threads are all
+// written exactly once.
+TEST_F(LoggingTest, MessagesFromManyThreadsAreWritten) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumMessagesPerThread = 200;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([i] {
+      for (int j = 0; j < kNumMessagesPerThread; ++j) {
+        LOG(INFO) << "thread " << i << " message " << j << ".";
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  FlushLogs();
+
+  std::string contents = ReadLogFile();
+  int written = 0;
+  for (int i = 0; i < kNumThreads; ++i) {
+    for (int j = 0; j < kNumMessagesPerThread; ++j) {
+      written += CountOccurrences(
+          contents, absl::StrCat("thread ", i, " message ", j, "."));
+    }
+  }
+  EXPECT_EQ(written + GetDroppedLogMessageCount(),
+            kNumThreads * kNumMessagesPerThread);
+}
+
+// Verifies that a FATAL message is written to the log before the program
+// aborts.
+TEST_F(LoggingTest, FatalMessageIsWrittenBeforeAbort) {
+  EXPECT_DEATH(LOG(FATAL) << "fatal message", "fatal message");
+  EXPECT_NE(ReadLogFile().find("fatal message"), std::string::npos);
+}
+
+}  // namespace
+}  // namespace asylo